@@ -0,0 +1,547 @@
+/**
+ * \file      AesCmac.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     AES-128 CMAC for message authentication.
+ * \details   Computes the CMAC of RFC 4493 with AES-NI, the ARMv8 crypto extensions
+ *            or a constant-time implementation without tables, one message or a
+ *            batch of messages at a time.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AesCmac.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#define AESCMAC_NI
+#endif
+
+#if defined(__aarch64__) &&                                                    \
+    (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#include <arm_neon.h>
+#define AESCMAC_ARMV8
+#endif
+
+namespace
+{
+/// a byte of 1 in every lane of a word of 8 bytes.
+constexpr std::uint64_t LANES_ONE{0x0101010101010101U};
+
+/// the round constants of the key expansion.
+constexpr std::array< std::uint8_t, AES_CMAC::ROUNDS > RCON{
+    {0x01U, 0x02U, 0x04U, 0x08U, 0x10U, 0x20U, 0x40U, 0x80U, 0x1BU, 0x36U}};
+
+/// the reduction of a subkey that is shifted out of 128 bits.
+constexpr std::uint8_t CMAC_RB{0x87U};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Multiplies the 8 bytes of two words in GF(2^8) lane by lane, in
+ * constant time.
+ */
+std::uint64_t gf_multiply(std::uint64_t a, std::uint64_t b) noexcept
+{
+    std::uint64_t product = 0U;
+
+    for (std::size_t bit = 0U; bit < 8U; ++bit)
+    {
+        // every lane with the bit set adds a; a times x is reduced by 0x1B.
+        product ^= a & ((b & LANES_ONE) * 0xFFU);
+        const std::uint64_t carry = ((a >> 7U) & LANES_ONE) * 0x1BU;
+        a = ((a << 1U) & (LANES_ONE * 0xFEU)) ^ carry;
+        b >>= 1U;
+    }
+
+    return product;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Rotates every byte of a word to the left.
+ */
+std::uint64_t rotate_lanes(const std::uint64_t x, const unsigned int n) noexcept
+{
+    return ((x << n) & (LANES_ONE * ((0xFFU << n) & 0xFFU))) |
+           ((x >> (8U - n)) & (LANES_ONE * (0xFFU >> (8U - n))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The S-box for 8 bytes at once: the inverse in GF(2^8) as x^254,
+ * then the affine transformation. No table, so no timing by the cache.
+ */
+std::uint64_t sub_lanes(const std::uint64_t x) noexcept
+{
+    std::uint64_t power = x;
+    std::uint64_t inverse = LANES_ONE;
+
+    // x^254 = x^2 * x^4 * ... * x^128.
+    for (std::size_t i = 0U; i < 7U; ++i)
+    {
+        power = gf_multiply(power, power);
+        inverse = gf_multiply(inverse, power);
+    }
+
+    return inverse ^ rotate_lanes(inverse, 1U) ^ rotate_lanes(inverse, 2U) ^
+           rotate_lanes(inverse, 3U) ^ rotate_lanes(inverse, 4U) ^
+           (LANES_ONE * 0x63U);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief SubBytes of the state.
+ */
+void sub_bytes(std::uint8_t* state) noexcept
+{
+    std::array< std::uint64_t, 2U > words;
+    std::memcpy(words.data(), state, AES_CMAC::BLOCK_SIZE);
+    words[0] = sub_lanes(words[0]);
+    words[1] = sub_lanes(words[1]);
+    std::memcpy(state, words.data(), AES_CMAC::BLOCK_SIZE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief ShiftRows of the state, which is stored column by column.
+ */
+void shift_rows(std::uint8_t* state) noexcept
+{
+    std::array< std::uint8_t, AES_CMAC::BLOCK_SIZE > shifted;
+
+    for (std::size_t column = 0U; column < 4U; ++column)
+    {
+        for (std::size_t row = 0U; row < 4U; ++row)
+        {
+            shifted[(column * 4U) + row] =
+                state[(((column + row) % 4U) * 4U) + row];
+        }
+    }
+
+    std::memcpy(state, shifted.data(), shifted.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Multiplies by x in GF(2^8), in constant time.
+ */
+std::uint8_t xtime(const std::uint8_t a) noexcept
+{
+    return static_cast< std::uint8_t >(
+        (a << 1U) ^ (0x1BU & static_cast< std::uint8_t >(-(a >> 7U))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief MixColumns of the state.
+ */
+void mix_columns(std::uint8_t* state) noexcept
+{
+    for (std::size_t column = 0U; column < 4U; ++column)
+    {
+        std::uint8_t* const c = &state[column * 4U];
+        const std::uint8_t all = c[0] ^ c[1] ^ c[2] ^ c[3];
+        const std::uint8_t first = c[0];
+        c[0] ^= all ^ xtime(c[0] ^ c[1]);
+        c[1] ^= all ^ xtime(c[1] ^ c[2]);
+        c[2] ^= all ^ xtime(c[2] ^ c[3]);
+        c[3] ^= all ^ xtime(c[3] ^ first);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief XORs a block into another one.
+ */
+void xor_block(std::uint8_t* out, const std::uint8_t* in) noexcept
+{
+    for (std::size_t i = 0U; i < AES_CMAC::BLOCK_SIZE; ++i)
+    {
+        out[i] ^= in[i];
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Encrypts a block without AES instructions.
+ */
+void encrypt_portable(const std::uint8_t* round_keys,
+                      std::uint8_t* state) noexcept
+{
+    xor_block(state, round_keys);
+
+    for (std::size_t round = 1U; round <= AES_CMAC::ROUNDS; ++round)
+    {
+        sub_bytes(state);
+        shift_rows(state);
+
+        if (round < AES_CMAC::ROUNDS)
+        {
+            mix_columns(state);
+        }
+
+        xor_block(state, &round_keys[round * AES_CMAC::BLOCK_SIZE]);
+    }
+}
+
+#ifdef AESCMAC_NI
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Encrypts blocks with AES-NI. The rounds of all blocks are
+ * interleaved, so the next block enters the AES unit while the one before
+ * is still in it.
+ */
+__attribute__((target("aes,sse2"))) void
+encrypt_ni(const std::uint8_t* round_keys, AesBlock* blocks,
+           const std::size_t count) noexcept
+{
+    // plain arrays, std::array would drop the alignment of the vectors.
+    __m128i keys[AES_CMAC::ROUNDS + 1U];
+    __m128i states[AES_CMAC::LANES];
+
+    for (std::size_t round = 0U; round <= AES_CMAC::ROUNDS; ++round)
+    {
+        keys[round] = _mm_load_si128(reinterpret_cast< const __m128i* >(
+            &round_keys[round * AES_CMAC::BLOCK_SIZE]));
+    }
+
+    for (std::size_t lane = 0U; lane < count; ++lane)
+    {
+        states[lane] = _mm_xor_si128(
+            _mm_loadu_si128(
+                reinterpret_cast< const __m128i* >(blocks[lane].data())),
+            keys[0]);
+    }
+
+    for (std::size_t round = 1U; round < AES_CMAC::ROUNDS; ++round)
+    {
+        for (std::size_t lane = 0U; lane < count; ++lane)
+        {
+            states[lane] = _mm_aesenc_si128(states[lane], keys[round]);
+        }
+    }
+
+    for (std::size_t lane = 0U; lane < count; ++lane)
+    {
+        states[lane] =
+            _mm_aesenclast_si128(states[lane], keys[AES_CMAC::ROUNDS]);
+        _mm_storeu_si128(reinterpret_cast< __m128i* >(blocks[lane].data()),
+                         states[lane]);
+    }
+}
+#endif
+
+#ifdef AESCMAC_ARMV8
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Encrypts blocks with the ARMv8 crypto extensions, interleaved like
+ * encrypt_ni(). AESE adds the round key before SubBytes and ShiftRows, so
+ * the last key is added alone.
+ */
+void encrypt_armv8(const std::uint8_t* round_keys, AesBlock* blocks,
+                   const std::size_t count) noexcept
+{
+    uint8x16_t keys[AES_CMAC::ROUNDS + 1U];
+    uint8x16_t states[AES_CMAC::LANES];
+
+    for (std::size_t round = 0U; round <= AES_CMAC::ROUNDS; ++round)
+    {
+        keys[round] = vld1q_u8(&round_keys[round * AES_CMAC::BLOCK_SIZE]);
+    }
+
+    for (std::size_t lane = 0U; lane < count; ++lane)
+    {
+        states[lane] = vld1q_u8(blocks[lane].data());
+    }
+
+    for (std::size_t round = 0U; round < (AES_CMAC::ROUNDS - 1U); ++round)
+    {
+        for (std::size_t lane = 0U; lane < count; ++lane)
+        {
+            states[lane] = vaesmcq_u8(vaeseq_u8(states[lane], keys[round]));
+        }
+    }
+
+    for (std::size_t lane = 0U; lane < count; ++lane)
+    {
+        states[lane] = veorq_u8(
+            vaeseq_u8(states[lane], keys[AES_CMAC::ROUNDS - 1U]),
+            keys[AES_CMAC::ROUNDS]);
+        vst1q_u8(blocks[lane].data(), states[lane]);
+    }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Derives a CMAC subkey: shifted left by one bit, reduced by Rb if
+ * a bit is shifted out, in constant time.
+ */
+void derive_subkey(const AesBlock& in, AesBlock& out) noexcept
+{
+    const auto reduce =
+        static_cast< std::uint8_t >(CMAC_RB & -(in[0] >> 7U));
+
+    for (std::size_t i = 0U; i < (AES_CMAC::BLOCK_SIZE - 1U); ++i)
+    {
+        out[i] =
+            static_cast< std::uint8_t >((in[i] << 1U) | (in[i + 1U] >> 7U));
+    }
+
+    out[AES_CMAC::BLOCK_SIZE - 1U] = static_cast< std::uint8_t >(
+        (in[AES_CMAC::BLOCK_SIZE - 1U] << 1U) ^ reduce);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Overwrites memory with zeros, also if it is not read again.
+ */
+void wipe(std::uint8_t* data, const std::size_t size) noexcept
+{
+    volatile std::uint8_t* const bytes = data;
+
+    for (std::size_t i = 0U; i < size; ++i)
+    {
+        bytes[i] = 0U;
+    }
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+AesCmac::AesCmac(const AesKey& key, const AesBackend backend) noexcept
+    : round_keys_{}, k1_{}, k2_{}, backend_{backend}
+{
+    if (backend_ == AesBackend::AUTO)
+    {
+        backend_ = AesBackend::PORTABLE;
+        backend_ = is_supported(AesBackend::ARMV8) ? AesBackend::ARMV8
+                                                   : backend_;
+        backend_ = is_supported(AesBackend::AES_NI) ? AesBackend::AES_NI
+                                                    : backend_;
+    }
+    else if (is_supported(backend_) == false)
+    {
+        backend_ = AesBackend::PORTABLE;
+    }
+
+    // the key expansion of AES-128, the same round keys for all backends.
+    std::memcpy(round_keys_.data(), key.data(), key.size());
+
+    for (std::size_t i = AES_CMAC::KEY_SIZE; i < round_keys_.size(); i += 4U)
+    {
+        std::array< std::uint8_t, 8U > word{};
+        std::memcpy(word.data(), &round_keys_[i - 4U], 4U);
+
+        if ((i % AES_CMAC::KEY_SIZE) == 0U)
+        {
+            // RotWord, SubWord and the round constant.
+            const std::array< std::uint8_t, 4U > rotated{
+                {word[1], word[2], word[3], word[0]}};
+            std::uint64_t lanes = 0U;
+            std::memcpy(&lanes, rotated.data(), rotated.size());
+            lanes = sub_lanes(lanes);
+            std::memcpy(word.data(), &lanes, 4U);
+            word[0] ^= RCON[(i / AES_CMAC::KEY_SIZE) - 1U];
+        }
+
+        for (std::size_t j = 0U; j < 4U; ++j)
+        {
+            round_keys_[i + j] =
+                round_keys_[i + j - AES_CMAC::KEY_SIZE] ^ word[j];
+        }
+    }
+
+    // the subkeys from the encrypted zero block.
+    AesBlock zero{};
+    encrypt(zero.data(), zero.data());
+    derive_subkey(zero, k1_);
+    derive_subkey(k1_, k2_);
+    wipe(zero.data(), zero.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AesCmac::~AesCmac() noexcept
+{
+    wipe(round_keys_.data(), round_keys_.size());
+    wipe(k1_.data(), k1_.size());
+    wipe(k2_.data(), k2_.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AesCmac::encrypt(const std::uint8_t* in, std::uint8_t* out) const noexcept
+{
+    AesBlock block;
+    std::memcpy(block.data(), in, block.size());
+    encrypt_blocks(&block, 1U);
+    std::memcpy(out, block.data(), block.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AesCmac::sign(const std::uint8_t* message, const std::size_t length,
+                   AesBlock& mac) const noexcept
+{
+    sign_batch(&message, &length, 1U, &mac);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AesCmac::sign_batch(const std::uint8_t* const* messages,
+                         const std::size_t* lengths, const std::size_t count,
+                         AesBlock* macs) const noexcept
+{
+    for (std::size_t first = 0U; first < count; first += AES_CMAC::LANES)
+    {
+        const std::size_t lanes = ((count - first) < AES_CMAC::LANES)
+                                      ? (count - first)
+                                      : AES_CMAC::LANES;
+        std::array< AesBlock, AES_CMAC::LANES > work;
+        std::array< std::size_t, AES_CMAC::LANES > active;
+        std::array< std::size_t, AES_CMAC::LANES > blocks;
+        std::size_t max_blocks = 0U;
+
+        // an empty message is one padded block.
+        for (std::size_t lane = 0U; lane < lanes; ++lane)
+        {
+            const std::size_t length = lengths[first + lane];
+            blocks[lane] =
+                (length > 0U)
+                    ? ((length + AES_CMAC::BLOCK_SIZE - 1U) /
+                       AES_CMAC::BLOCK_SIZE)
+                    : 1U;
+            max_blocks =
+                (blocks[lane] > max_blocks) ? blocks[lane] : max_blocks;
+            macs[first + lane].fill(0U);
+        }
+
+        // block by block, the messages that still have one are encrypted
+        // together.
+        for (std::size_t block = 0U; block < max_blocks; ++block)
+        {
+            const std::size_t offset = block * AES_CMAC::BLOCK_SIZE;
+            std::size_t used = 0U;
+
+            for (std::size_t lane = 0U; lane < lanes; ++lane)
+            {
+                const std::uint8_t* const message = messages[first + lane];
+                const std::size_t length = lengths[first + lane];
+
+                if (block >= blocks[lane])
+                {
+                    continue;
+                }
+
+                AesBlock& input = work[used];
+                input = macs[first + lane];
+                const std::size_t rest = length - offset;
+
+                if (rest > AES_CMAC::BLOCK_SIZE)
+                {
+                    xor_block(input.data(), &message[offset]);
+                }
+                else if (rest == AES_CMAC::BLOCK_SIZE)
+                {
+                    // a complete last block.
+                    xor_block(input.data(), &message[offset]);
+                    xor_block(input.data(), k1_.data());
+                }
+                else
+                {
+                    // a padded last block.
+                    AesBlock padded{};
+                    std::memcpy(padded.data(), &message[offset], rest);
+                    padded[rest] = 0x80U;
+                    xor_block(input.data(), padded.data());
+                    xor_block(input.data(), k2_.data());
+                }
+
+                active[used] = first + lane;
+                ++used;
+            }
+
+            encrypt_blocks(work.data(), used);
+
+            for (std::size_t i = 0U; i < used; ++i)
+            {
+                macs[active[i]] = work[i];
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool AesCmac::is_supported(const AesBackend backend) noexcept
+{
+    bool supported = true;
+
+    if (backend == AesBackend::AES_NI)
+    {
+#ifdef AESCMAC_NI
+        supported = __builtin_cpu_supports("aes") != 0;
+#else
+        supported = false;
+#endif
+    }
+    else if (backend == AesBackend::ARMV8)
+    {
+#ifdef AESCMAC_ARMV8
+        supported = true;
+#else
+        supported = false;
+#endif
+    }
+
+    return supported;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AesCmac::encrypt_blocks(AesBlock* blocks, const std::size_t count) const
+    noexcept
+{
+#ifdef AESCMAC_NI
+    if (backend_ == AesBackend::AES_NI)
+    {
+        encrypt_ni(round_keys_.data(), blocks, count);
+        return;
+    }
+#endif
+#ifdef AESCMAC_ARMV8
+    if (backend_ == AesBackend::ARMV8)
+    {
+        encrypt_armv8(round_keys_.data(), blocks, count);
+        return;
+    }
+#endif
+
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+        encrypt_portable(round_keys_.data(), blocks[i].data());
+    }
+}
@@ -0,0 +1,169 @@
+/**
+ * \file      AesCmac.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     AES-128 CMAC for message authentication.
+ * \details   Computes the CMAC of RFC 4493 with AES-NI, the ARMv8 crypto extensions
+ *            or a constant-time implementation without tables, one message or a
+ *            batch of messages at a time.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef AESCMAC_H_
+#define AESCMAC_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Defining a struct that holds the sizes of AES-128 and CMAC.
+ */
+struct AES_CMAC
+{
+    // bytes of a key.
+    static constexpr std::size_t KEY_SIZE{16U};
+    // bytes of a block and of the MAC.
+    static constexpr std::size_t BLOCK_SIZE{16U};
+    // rounds of AES-128.
+    static constexpr std::size_t ROUNDS{10U};
+    // messages of a batch that are encrypted interleaved.
+    static constexpr std::size_t LANES{8U};
+};
+
+/// an AES-128 key.
+using AesKey = std::array< std::uint8_t, AES_CMAC::KEY_SIZE >;
+
+/// a block, a full MAC.
+using AesBlock = std::array< std::uint8_t, AES_CMAC::BLOCK_SIZE >;
+
+/**
+ * \brief The implementations of AES.
+ */
+enum class AesBackend : std::uint8_t
+{
+    AUTO,     ///< the fastest one the CPU supports.
+    AES_NI,   ///< x86 AES-NI instructions.
+    ARMV8,    ///< ARMv8 crypto extensions, if compiled for them.
+    PORTABLE  ///< constant time without tables, on any CPU.
+};
+
+/**
+ * \brief AesCmac computes the AES-128 CMAC of messages (RFC 4493, NIST
+ * SP 800-38B) as SecOC uses it for authenticating PDUs.
+ *
+ * The AES-NI or ARMv8 instructions encrypt a block in a few nanoseconds in
+ * constant time. The portable implementation computes the S-box with
+ * arithmetic in GF(2^8) instead of looking it up in a table, so its timing
+ * does not depend on the key or the data either; it is much slower. For a
+ * batch the blocks of up to AES_CMAC::LANES messages are encrypted
+ * interleaved, which keeps the AES units of the CPU busy while each block
+ * waits for the last round.
+ */
+class AesCmac
+{
+  public:
+    /**
+     * \brief Expands the key and derives the CMAC subkeys.
+     * \param[in] key the key.
+     * \param[in] backend the implementation, a backend the CPU does not
+     * support falls back to PORTABLE.
+     */
+    explicit AesCmac(const AesKey& key,
+                     const AesBackend backend = AesBackend::AUTO) noexcept;
+
+    /**
+     * \brief Wipes the keys.
+     */
+    ~AesCmac() noexcept;
+
+    AesCmac(const AesCmac&) = delete;
+    AesCmac& operator=(const AesCmac&) = delete;
+
+    /**
+     * \brief Encrypts one block.
+     */
+    void encrypt(const std::uint8_t* in, std::uint8_t* out) const noexcept;
+
+    /**
+     * \brief Computes the CMAC of a message.
+     * \param[in] message the message.
+     * \param[in] length the bytes of the message.
+     * \param[out] mac the MAC, truncate it from the front.
+     */
+    void sign(const std::uint8_t* message, const std::size_t length,
+              AesBlock& mac) const noexcept;
+
+    /**
+     * \brief Computes the CMACs of many messages, interleaved.
+     * \param[in] messages the messages.
+     * \param[in] lengths the bytes of each message.
+     * \param[in] count the number of messages.
+     * \param[out] macs a MAC per message.
+     */
+    void sign_batch(const std::uint8_t* const* messages,
+                    const std::size_t* lengths, const std::size_t count,
+                    AesBlock* macs) const noexcept;
+
+    /**
+     * \brief The implementation used.
+     */
+    AesBackend get_backend() const noexcept { return backend_; }
+
+    /**
+     * \brief True if the CPU supports a backend.
+     */
+    static bool is_supported(const AesBackend backend) noexcept;
+
+  private:
+    /**
+     * \brief Encrypts blocks in place, interleaved.
+     * \param[in] count up to AES_CMAC::LANES blocks.
+     */
+    void encrypt_blocks(AesBlock* blocks, const std::size_t count) const
+        noexcept;
+
+    /// the round keys, one per round and the initial one.
+    alignas(16) std::array< std::uint8_t,
+                            (AES_CMAC::ROUNDS + 1U) * AES_CMAC::BLOCK_SIZE >
+        round_keys_;
+
+    /// the subkey for a complete last block.
+    AesBlock k1_;
+
+    /// the subkey for a padded last block.
+    AesBlock k2_;
+
+    /// the implementation used.
+    AesBackend backend_;
+};
+
+#endif // AESCMAC_H_
@@ -0,0 +1,221 @@
+/**
+ * \file      ByteRing.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Fixed size byte ring buffer.
+ * \details   Lock-free ring buffer of bytes for one producer and one consumer.
+ *            ByteRing stores the bytes in a fixed size std::array, nothing is
+ *            allocated. ByteRingView works on memory given, e.g. a big
+ *            buffer on huge pages.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BYTERING_H_
+#define BYTERING_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * \brief ByteRingView is a ring buffer of bytes on memory owned by someone
+ * else. One thread may write while another thread reads without locking.
+ */
+class ByteRingView
+{
+  public:
+    /**
+     * \brief Creates an empty ring on the given memory.
+     * \param[in] memory the storage of the ring, must outlive the ring.
+     * \param[in] size of the memory in bytes. The ring uses the largest
+     * power of two that fits, see get_size(): 12 KiB of memory make a ring
+     * of 8 KiB.
+     */
+    ByteRingView(void* memory, const std::size_t size) noexcept
+        : data_{static_cast< std::uint8_t* >(memory)},
+          size_{floor_power_of_two(size)}, head_{0U}, tail_{0U}
+    {
+    }
+
+    ByteRingView(const ByteRingView&) = delete;
+    ByteRingView& operator=(const ByteRingView&) = delete;
+
+    /**
+     * \brief Writes as many bytes as fit into the ring.
+     * \param[in] data the bytes to write.
+     * \param[in] len number of bytes to write.
+     * \return the number of bytes written.
+     */
+    std::size_t write(const void* data, const std::size_t len) noexcept
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        const std::size_t free_bytes = size_ - (head - tail);
+        const std::size_t to_write = (len < free_bytes) ? len : free_bytes;
+        const std::size_t offset = head & (size_ - 1U);
+        // the part up to the end of the buffer, then the wrapped part.
+        const std::size_t first =
+            ((size_ - offset) < to_write) ? (size_ - offset) : to_write;
+        const auto* bytes = static_cast< const std::uint8_t* >(data);
+        std::memcpy(&data_[offset], bytes, first);
+        std::memcpy(&data_[0], bytes + first, to_write - first);
+        head_.store(head + to_write, std::memory_order_release);
+        return to_write;
+    }
+
+    /**
+     * \brief Reads up to len bytes from the ring.
+     * \param[out] data the buffer to store the bytes to.
+     * \param[in] len maximum number of bytes to read.
+     * \return the number of bytes read.
+     */
+    std::size_t read(void* data, const std::size_t len) noexcept
+    {
+        const std::size_t to_read = peek(data, len);
+        tail_.store(tail_.load(std::memory_order_relaxed) + to_read,
+                    std::memory_order_release);
+        return to_read;
+    }
+
+    /**
+     * \brief Copies up to len bytes from the ring without removing them.
+     * \param[out] data the buffer to store the bytes to.
+     * \param[in] len maximum number of bytes to copy.
+     * \return the number of bytes copied.
+     */
+    std::size_t peek(void* data, const std::size_t len) const noexcept
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t used = head - tail;
+        const std::size_t to_read = (len < used) ? len : used;
+        const std::size_t offset = tail & (size_ - 1U);
+        const std::size_t first =
+            ((size_ - offset) < to_read) ? (size_ - offset) : to_read;
+        auto* bytes = static_cast< std::uint8_t* >(data);
+        std::memcpy(bytes, &data_[offset], first);
+        std::memcpy(bytes + first, &data_[0], to_read - first);
+        return to_read;
+    }
+
+    /**
+     * \brief Removes up to len bytes without copying them.
+     * \return the number of bytes removed.
+     */
+    std::size_t skip(const std::size_t len) noexcept
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t used = head_.load(std::memory_order_acquire) - tail;
+        const std::size_t to_skip = (len < used) ? len : used;
+        tail_.store(tail + to_skip, std::memory_order_release);
+        return to_skip;
+    }
+
+    /**
+     * \brief Number of bytes that can be read.
+     */
+    std::size_t get_used() const noexcept
+    {
+        return head_.load(std::memory_order_acquire) -
+               tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Number of bytes that can be written.
+     */
+    std::size_t get_free() const noexcept { return size_ - get_used(); }
+
+    /**
+     * \brief The size of the ring.
+     */
+    std::size_t get_size() const noexcept { return size_; }
+
+  private:
+    /**
+     * \brief The largest power of two not above size, 0 for 0. The offsets
+     * are masked with size_ - 1.
+     */
+    static std::size_t floor_power_of_two(const std::size_t size) noexcept
+    {
+        std::size_t power = (size > 0U) ? 1U : 0U;
+
+        while ((power > 0U) && (power <= (size / 2U)))
+        {
+            power *= 2U;
+        }
+
+        return power;
+    }
+
+    /// the bytes.
+    std::uint8_t* data_;
+
+    /// number of bytes, a power of two.
+    std::size_t size_;
+
+    /// total number of bytes written, only changed by the writer.
+    std::atomic< std::size_t > head_;
+
+    /// total number of bytes read, only changed by the reader.
+    std::atomic< std::size_t > tail_;
+};
+
+/**
+ * \brief The storage of a ByteRing. It is a base class, so it is constructed
+ * before the ring that works on it.
+ */
+template < std::size_t Size > struct ByteRingStorage
+{
+    /// the bytes.
+    std::array< std::uint8_t, Size > storage_;
+};
+
+/**
+ * \brief ByteRing is a ring buffer of bytes with a fixed size. One thread
+ * may write while another thread reads without locking.
+ * \tparam Size of the buffer in bytes, must be a power of two.
+ */
+template < std::size_t Size >
+class ByteRing : private ByteRingStorage< Size >, public ByteRingView
+{
+  public:
+    /**
+     * \brief Default constructor, the ring is empty.
+     */
+    ByteRing() noexcept : ByteRingView{this->storage_.data(), Size}
+    {
+        static_assert((Size > 0U) && ((Size & (Size - 1U)) == 0U),
+                      "Size must be a power of two!");
+    }
+};
+
+#endif /* BYTERING_H_ */
@@ -0,0 +1,169 @@
+/**
+ * \file      CanContainer.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Container PDUs packing several PDUs into one CAN FD frame.
+ * \details   Transmit side of the container PDU.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef _WIN32
+#error "SocketCAN for Linux OS only."
+#endif
+#include "CanContainer.h"
+
+////////////////////////////////////////////////////////////////////////////////
+CanContainerTx::CanContainerTx(CanSocket& can, const CanIDType container_id,
+                               const std::chrono::microseconds timeout,
+                               const std::size_t trigger_len) noexcept
+    : can_{can}, container_id_{container_id}, timeout_{timeout},
+      trigger_len_{trigger_len}, frame_{}, fill_{0U}, pending_{0U},
+      first_added_{}, frames_sent_{0U}, pdus_sent_{0U}
+{
+    frame_.can_id = container_id_;
+
+    // the container can't be filled above the size of one CAN FD frame.
+    if (trigger_len_ > CAN_FD::DATA_LEN)
+    {
+        trigger_len_ = CAN_FD::DATA_LEN;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanContainerTx::add(const CanIDType pdu_id, const std::uint8_t* data,
+                         const std::uint8_t len) noexcept
+{
+    bool added{false};
+
+    // PDU ID zero is reserved for padding, it must fit into 24 bits and the
+    // PDU must fit into one container.
+    if ((pdu_id != 0U) && (pdu_id <= CAN_CONTAINER::MAX_PDU_ID) &&
+        (len <= CAN_CONTAINER::MAX_PDU_LEN))
+    {
+        const std::size_t needed = CAN_CONTAINER::HEADER_LEN + len;
+        bool space_ok = true;
+
+        // not enough space left: send the current container first.
+        if ((fill_ + needed) > CAN_FD::DATA_LEN)
+        {
+            space_ok = flush();
+        }
+
+        if (space_ok)
+        {
+            if (pending_ == 0U)
+            {
+                first_added_ = Clock::now();
+            }
+
+            // short header in network-byte-order
+            frame_.data[fill_] = static_cast< std::uint8_t >(pdu_id >> 16U);
+            frame_.data[fill_ + 1U] = static_cast< std::uint8_t >(pdu_id >> 8U);
+            frame_.data[fill_ + 2U] = static_cast< std::uint8_t >(pdu_id);
+            frame_.data[fill_ + 3U] = len;
+            fill_ += CAN_CONTAINER::HEADER_LEN;
+            std::memcpy(&frame_.data[fill_], data, len);
+            fill_ += len;
+            ++pending_;
+            added = true;
+
+            // size trigger: the container is full enough to be sent.
+            if (fill_ >= trigger_len_)
+            {
+                added = flush();
+            }
+        }
+    }
+
+    return added;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanContainerTx::poll() noexcept
+{
+    bool poll_ok{true};
+
+    if ((pending_ > 0U) && ((Clock::now() - first_added_) >= timeout_))
+    {
+        poll_ok = flush();
+    }
+
+    return poll_ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanContainerTx::flush() noexcept
+{
+    bool flushed{true};
+
+    if (pending_ > 0U)
+    {
+        // CAN FD only knows some lengths above 8 bytes. Pad the rest with zero
+        // bytes which reads as PDU ID zero on the receiver side.
+        frame_.len = canfd_padded_len(fill_);
+        std::memset(&frame_.data[fill_], 0, frame_.len - fill_);
+        // the frame is sent as it is, no further copy. A container is a CAN
+        // FD frame even if it holds 8 bytes or less.
+        const auto sent = can_.send(frame_, CAN_FD::MTU);
+
+        if (sent > 0)
+        {
+            ++frames_sent_;
+            pdus_sent_ += static_cast< std::uint32_t >(pending_);
+        }
+        else
+        {
+            flushed = false;
+        }
+
+        // the container is discarded on error as well, the PDUs are outdated
+        // by the next cycle anyway.
+        fill_ = 0U;
+        pending_ = 0U;
+    }
+
+    return flushed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t CanContainerTx::get_pending() const noexcept { return pending_; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t CanContainerTx::get_frames_sent() const noexcept
+{
+    return frames_sent_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t CanContainerTx::get_pdus_sent() const noexcept
+{
+    return pdus_sent_;
+}
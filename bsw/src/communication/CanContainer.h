@@ -0,0 +1,307 @@
+/**
+ * \file      CanContainer.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Container PDUs packing several PDUs into one CAN FD frame.
+ * \details   Pending PDUs are packed back to back into one CAN FD frame,
+ *            each one preceded by a short header that holds the PDU ID and
+ *            its length (AUTOSAR container PDU with short header).
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CANCONTAINER_H_
+#define CANCONTAINER_H_
+#ifndef _WIN32
+
+#include "CanSocket.h"
+#include <chrono>
+
+/**
+ * \brief Defining a struct that holds informations about container PDUs.
+ * A contained PDU starts with a short header: 24 bit PDU ID and 8 bit length
+ * in network-byte-order, followed by the PDU data.
+ */
+struct CAN_CONTAINER
+{
+    // The short header has 3 bytes PDU ID and 1 byte length.
+    static constexpr std::size_t HEADER_LEN{4U};
+    // The biggest PDU ID that fits into the short header. ID 0 is reserved
+    // for the padding at the end of a container.
+    static constexpr CanIDType MAX_PDU_ID{0x00FFFFFFU};
+    // The biggest PDU that fits into one container.
+    static constexpr std::size_t MAX_PDU_LEN{CAN_FD::DATA_LEN - HEADER_LEN};
+};
+
+/**
+ * \brief Rounds a payload length up to the next length a CAN FD frame is able
+ * to carry (0..8, 12, 16, 20, 24, 32, 48, 64).
+ * \param[in] len the payload length in bytes.
+ * \return the padded length.
+ */
+constexpr std::uint8_t canfd_padded_len(const std::size_t len) noexcept
+{
+    std::size_t padded{CAN_FD::DATA_LEN};
+
+    if (len <= 8U)
+    {
+        padded = len;
+    }
+    else if (len <= 24U)
+    {
+        // 12, 16, 20 and 24 bytes
+        padded = (len + 3U) & ~static_cast< std::size_t >(3U);
+    }
+    else if (len <= 32U)
+    {
+        padded = 32U;
+    }
+    else if (len <= 48U)
+    {
+        padded = 48U;
+    }
+
+    return static_cast< std::uint8_t >(padded);
+}
+
+/**
+ * \brief CanContainerTx collects PDUs and transmits them packed into one CAN
+ * FD frame with the container CAN ID. The container is sent if it is full or
+ * the oldest PDU in the container waited longer than the configured timeout.
+ */
+class CanContainerTx
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * \brief Creates a container for a CAN socket.
+     * \param[in] can the socket to transmit the container frames with.
+     * \param[in] container_id the CAN ID the container frames are sent with.
+     * \param[in] timeout maximum time a PDU waits in the container until the
+     * container is flushed.
+     * \param[in] trigger_len the container is sent as soon as it holds at least
+     * this number of bytes. Defaults to a completely filled frame.
+     */
+    CanContainerTx(CanSocket& can, const CanIDType container_id,
+                   const std::chrono::microseconds timeout,
+                   const std::size_t trigger_len = CAN_FD::DATA_LEN) noexcept;
+
+    /**
+     * \brief Adds one PDU to the container. If the PDU does not fit into the
+     * remaining space, the current container is sent first.
+     * \param[in] pdu_id ID of the contained PDU (1 .. 0xFFFFFF).
+     * \param[in] data the PDU data.
+     * \param[in] len length of the PDU in bytes.
+     * \return true if the PDU was queued, false if the PDU is invalid or
+     * sending the previous container failed.
+     */
+    bool add(const CanIDType pdu_id, const std::uint8_t* data,
+             const std::uint8_t len) noexcept;
+
+    /**
+     * \brief Adds one PDU given as standard or CAN FD data array.
+     */
+    template < typename CANData >
+    bool add(const CanIDType pdu_id, const CANData& data,
+             const std::uint8_t len) noexcept
+    {
+        static_assert(std::is_same< CanStdData, CANData >::value ||
+                          std::is_same< CanFDData, CANData >::value,
+                      "Must be a standard CAN frame or CAN FD frame.");
+        const auto data_len = static_cast< std::uint8_t >(
+            std::min(static_cast< std::size_t >(len), data.size()));
+        return add(pdu_id, data.data(), data_len);
+    }
+
+    /**
+     * \brief Call this cyclically. Sends the container if the timeout of the
+     * oldest PDU expired.
+     * \return true if nothing had to be sent or sending was successful.
+     */
+    bool poll() noexcept;
+
+    /**
+     * \brief Sends all pending PDUs immediately.
+     * \return true if the container was sent or was empty, false on error.
+     */
+    bool flush() noexcept;
+
+    /**
+     * \brief Number of PDUs waiting in the container.
+     */
+    std::size_t get_pending() const noexcept;
+
+    /**
+     * \brief Number of container frames put on the bus so far.
+     */
+    std::uint32_t get_frames_sent() const noexcept;
+
+    /**
+     * \brief Number of PDUs transmitted within the containers so far.
+     */
+    std::uint32_t get_pdus_sent() const noexcept;
+
+  private:
+    /// socket to transmit with.
+    CanSocket& can_;
+
+    /// CAN ID of the container frame.
+    CanIDType container_id_;
+
+    /// maximum time the oldest PDU waits in the container.
+    Clock::duration timeout_;
+
+    /// fill level that triggers sending.
+    std::size_t trigger_len_;
+
+    /// preallocated container frame, PDUs are packed into its data directly.
+    struct canfd_frame frame_;
+
+    /// number of bytes used in the buffer.
+    std::size_t fill_;
+
+    /// number of PDUs in the buffer.
+    std::size_t pending_;
+
+    /// the time the first PDU was added to the current container.
+    Clock::time_point first_added_;
+
+    /// statistics: container frames sent.
+    std::uint32_t frames_sent_;
+
+    /// statistics: PDUs sent within containers.
+    std::uint32_t pdus_sent_;
+};
+
+/**
+ * \brief CanContainerRx unpacks received container frames and calls a
+ * handler for each of the contained PDUs.
+ */
+class CanContainerRx
+{
+  public:
+    /**
+     * \brief Creates the receiver side of a container.
+     * \param[in] container_id the CAN ID of the container frames.
+     */
+    explicit CanContainerRx(const CanIDType container_id) noexcept
+        : container_id_{container_id}, frame_{}
+    {
+    }
+
+    /**
+     * \brief Unpacks one container.
+     * \tparam Handler callable with the signature
+     * void(CanIDType pdu_id, const std::uint8_t* data, std::uint8_t len).
+     * \param[in] data the data of the container frame.
+     * \param[in] len the length of the container frame.
+     * \param[in] handler called once for every contained PDU.
+     * \return number of PDUs unpacked or -1 if the container is malformed.
+     * PDUs in front of a malformed header have been handed to the handler.
+     */
+    template < typename Handler >
+    static std::int16_t unpack(const std::uint8_t* data, const std::size_t len,
+                               Handler&& handler) noexcept
+    {
+        std::int16_t unpacked{0};
+        std::size_t pos{0U};
+
+        // a header needs at least four bytes. Anything shorter is padding.
+        while ((pos + CAN_CONTAINER::HEADER_LEN) <= len)
+        {
+            const CanIDType pdu_id =
+                (static_cast< CanIDType >(data[pos]) << 16U) |
+                (static_cast< CanIDType >(data[pos + 1U]) << 8U) |
+                static_cast< CanIDType >(data[pos + 2U]);
+            const std::uint8_t pdu_len = data[pos + 3U];
+
+            // PDU ID zero marks the padding at the end of the container.
+            if (pdu_id == 0U)
+            {
+                break;
+            }
+
+            pos += CAN_CONTAINER::HEADER_LEN;
+
+            if ((pos + pdu_len) > len)
+            {
+                // the header points behind the end of the frame.
+                unpacked = -1;
+                break;
+            }
+
+            handler(pdu_id, &data[pos], pdu_len);
+            pos += pdu_len;
+            ++unpacked;
+        }
+
+        return unpacked;
+    }
+
+    /**
+     * \brief Receives one frame from the socket. Container frames are
+     * unpacked; all other frames are handed to the handler as they are.
+     * \param[in] can the socket to read from.
+     * \param[in] handler called for every PDU received.
+     * \return number of PDUs handed to the handler, -1 on error.
+     */
+    template < typename Handler >
+    std::int16_t receive(CanSocket& can, Handler&& handler) noexcept
+    {
+        std::int16_t pdus{-1};
+        const auto received = can.receive(frame_);
+
+        if (received > 0)
+        {
+            if (frame_.can_id == container_id_)
+            {
+                pdus = unpack(frame_.data, frame_.len, handler);
+            }
+            else
+            {
+                handler(frame_.can_id, frame_.data, frame_.len);
+                pdus = 1;
+            }
+        }
+
+        return pdus;
+    }
+
+  private:
+    /// CAN ID of the container frame.
+    CanIDType container_id_;
+
+    /// preallocated receive frame.
+    struct canfd_frame frame_;
+};
+
+#endif // WIN32 detection
+#endif // CANCONTAINER_H_
@@ -0,0 +1,949 @@
+/**
+ * \file      CanLogReader.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Parallel reader of CAN log files.
+ * \details   Splits memory-mapped candump and BLF logs into chunks, decodes the
+ *            chunks on all cores and merges the frames of all files in timestamp
+ *            order.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "CanLogReader.h"
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#ifdef BSW_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+/// nanoseconds per second.
+constexpr std::uint64_t NS_PER_SECOND{1000000000U};
+
+/// BLF: size of the file header up to the start time.
+constexpr std::size_t BLF_FILE_HEADER_SIZE{144U};
+
+/// BLF: offset of the start time (SYSTEMTIME) in the file header.
+constexpr std::size_t BLF_START_OFFSET{40U};
+
+/// BLF: size of the base header every object starts with.
+constexpr std::size_t BLF_BASE_SIZE{16U};
+
+/// BLF: size of the object header version 1, version 2 is bigger.
+constexpr std::size_t BLF_HEADER_V1_SIZE{32U};
+
+/// BLF: size of the object header version 2.
+constexpr std::size_t BLF_HEADER_V2_SIZE{40U};
+
+/// BLF: object types.
+constexpr std::uint32_t BLF_CAN_MESSAGE{1U};
+constexpr std::uint32_t BLF_LOG_CONTAINER{10U};
+constexpr std::uint32_t BLF_CAN_MESSAGE2{86U};
+constexpr std::uint32_t BLF_CAN_FD_MESSAGE{100U};
+constexpr std::uint32_t BLF_CAN_FD_MESSAGE_64{101U};
+
+/// BLF: compression methods of a log container.
+constexpr std::uint16_t BLF_NO_COMPRESSION{0U};
+constexpr std::uint16_t BLF_ZLIB{2U};
+
+/// BLF: the timestamp of an object counts 10 us.
+constexpr std::uint32_t BLF_TIME_TEN_MICS{1U};
+
+/// payload length of the CAN FD DLCs.
+constexpr std::array< std::uint8_t, 16U > DLC_TO_LEN{
+    {0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U}};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Reads a little-endian number.
+ */
+template < typename T > T read_le(const std::uint8_t* data) noexcept
+{
+    T value = 0U;
+
+    for (std::size_t i = sizeof(T); i > 0U; --i)
+    {
+        value = static_cast< T >((value << 8U) | data[i - 1U]);
+    }
+
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The value of a hex digit, -1 if it is none.
+ */
+int hex_value(const char c) noexcept
+{
+    int value = -1;
+
+    if ((c >= '0') && (c <= '9'))
+    {
+        value = c - '0';
+    }
+    else if ((c >= 'a') && (c <= 'f'))
+    {
+        value = c - 'a' + 10;
+    }
+    else if ((c >= 'A') && (c <= 'F'))
+    {
+        value = c - 'A' + 10;
+    }
+
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Decodes one line of candump -l, e.g.
+ * (1436509052.249713) can0 12345678#DEADBEEF or can0 123##1DEADBEEF (FD).
+ * \return false if the line is no frame.
+ */
+bool decode_candump_line(const char* p, const char* const end,
+                         CanLogRecord& record) noexcept
+{
+    std::memset(&record, 0, sizeof(record));
+    bool valid = (p < end) && (*p == '(');
+
+    // the timestamp: seconds and up to nine digits of the fraction.
+    std::uint64_t seconds = 0U;
+    std::uint64_t fraction = 0U;
+    std::uint64_t scale = NS_PER_SECOND;
+    for (++p; valid && (p < end) && (*p >= '0') && (*p <= '9'); ++p)
+    {
+        seconds = (seconds * 10U) + static_cast< std::uint64_t >(*p - '0');
+    }
+    valid = valid && (p < end) && (*p == '.');
+    for (++p; valid && (p < end) && (*p >= '0') && (*p <= '9'); ++p)
+    {
+        if (scale > 1U)
+        {
+            scale /= 10U;
+            fraction += static_cast< std::uint64_t >(*p - '0') * scale;
+        }
+    }
+    valid = valid && (p < end) && (*p == ')');
+    record.timestamp = (seconds * NS_PER_SECOND) + fraction;
+
+    // the interface, can0 is channel 1.
+    for (++p; valid && (p < end) && (*p == ' '); ++p)
+    {
+    }
+    std::uint16_t number = 0U;
+    for (; valid && (p < end) && (*p != ' '); ++p)
+    {
+        number = ((*p >= '0') && (*p <= '9'))
+                     ? static_cast< std::uint16_t >((number * 10U) +
+                                                    (*p - '0'))
+                     : 0U;
+    }
+    record.channel = static_cast< std::uint16_t >(number + 1U);
+
+    // the ID, more than three digits is an extended ID.
+    for (; valid && (p < end) && (*p == ' '); ++p)
+    {
+    }
+    const char* const id_begin = p;
+    canid_t id = 0U;
+    for (; valid && (p < end) && (hex_value(*p) >= 0); ++p)
+    {
+        id = (id << 4U) | static_cast< canid_t >(hex_value(*p));
+    }
+    const auto id_digits = p - id_begin;
+    valid = valid && (id_digits > 0) && (id_digits <= 8) && (p < end) &&
+            (*p == '#');
+    record.frame.can_id =
+        (id_digits > 3) ? ((id & CAN_EFF_MASK) | CAN_EFF_FLAG) : id;
+    ++p;
+
+    std::size_t max_len = CAN_MAX_DLEN;
+    if (valid && (p < end) && (*p == '#'))
+    {
+        // CAN FD: a flags digit, then the data.
+        record.fd = true;
+        max_len = CANFD_MAX_DLEN;
+        const int flags = ((p + 1) < end) ? hex_value(p[1]) : -1;
+        valid = flags >= 0;
+        record.frame.flags = static_cast< std::uint8_t >(
+            ((flags & 0x1) ? CANFD_BRS : 0) | ((flags & 0x2) ? CANFD_ESI : 0));
+        p += 2;
+    }
+    else if (valid && (p < end) && (*p == 'R'))
+    {
+        // a remote frame, optionally with its DLC.
+        record.frame.can_id |= CAN_RTR_FLAG;
+        ++p;
+        const int dlc = (p < end) ? hex_value(*p) : -1;
+        if ((dlc >= 0) && (dlc <= 8))
+        {
+            record.frame.len = static_cast< std::uint8_t >(dlc);
+            ++p;
+        }
+        max_len = 0U;
+    }
+
+    // the data, two digits per byte, dots may separate the bytes.
+    while (valid && (p < end) && (*p != ' ') && (*p != '\r'))
+    {
+        if (*p == '.')
+        {
+            ++p;
+            continue;
+        }
+        const int high = hex_value(*p);
+        const int low = ((p + 1) < end) ? hex_value(p[1]) : -1;
+        valid = (high >= 0) && (low >= 0) && (record.frame.len < max_len);
+        if (valid)
+        {
+            record.frame.data[record.frame.len++] =
+                static_cast< std::uint8_t >((high << 4) | low);
+        }
+        p += 2;
+    }
+
+    // the direction of newer versions: T sent, R received.
+    for (; valid && (p < end) && (*p == ' '); ++p)
+    {
+    }
+    record.tx = valid && (p < end) && (*p == 'T');
+
+    return valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Decodes one BLF object if it is a CAN frame.
+ */
+void decode_blf_object(const std::uint8_t* const object,
+                       const std::uint32_t size, const std::uint32_t type,
+                       const std::uint64_t start,
+                       std::vector< CanLogRecord >& records,
+                       std::uint64_t& errors, std::uint64_t& skipped) noexcept
+{
+    const std::uint16_t header_size = read_le< std::uint16_t >(&object[4]);
+
+    if ((header_size < BLF_HEADER_V1_SIZE) || (header_size > size))
+    {
+        ++errors;
+        return;
+    }
+
+    const std::uint32_t flags = read_le< std::uint32_t >(&object[16]);
+    const std::uint64_t time = read_le< std::uint64_t >(&object[24]);
+    const std::uint8_t* const body = &object[header_size];
+    const std::uint32_t body_size = size - header_size;
+    CanLogRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.timestamp =
+        start + ((flags == BLF_TIME_TEN_MICS) ? (time * 10000U) : time);
+    bool valid = false;
+    std::uint32_t id = 0U;
+    bool rtr = false;
+
+    if (((type == BLF_CAN_MESSAGE) || (type == BLF_CAN_MESSAGE2)) &&
+        (body_size >= 16U))
+    {
+        // channel, flags, DLC, ID, 8 data bytes.
+        record.channel = read_le< std::uint16_t >(&body[0]);
+        record.tx = (body[2] & 0x01U) != 0U;
+        rtr = (body[2] & 0x80U) != 0U;
+        record.frame.len = (body[3] < 8U) ? body[3] : 8U;
+        id = read_le< std::uint32_t >(&body[4]);
+        std::memcpy(record.frame.data, &body[8], rtr ? 0U : record.frame.len);
+        valid = true;
+    }
+    else if ((type == BLF_CAN_FD_MESSAGE) && (body_size >= 84U))
+    {
+        // channel, flags, DLC, ID, frame length, bit count, FD flags, valid
+        // data bytes, 5 reserved, 64 data bytes.
+        record.channel = read_le< std::uint16_t >(&body[0]);
+        record.tx = (body[2] & 0x01U) != 0U;
+        rtr = (body[2] & 0x80U) != 0U;
+        record.fd = (body[13] & 0x01U) != 0U;
+        record.frame.flags = static_cast< std::uint8_t >(
+            ((body[13] & 0x02U) ? CANFD_BRS : 0) |
+            ((body[13] & 0x04U) ? CANFD_ESI : 0));
+        const std::uint8_t dlc = body[3] & 0x0FU;
+        record.frame.len =
+            record.fd ? DLC_TO_LEN[dlc] : ((dlc < 8U) ? dlc : 8U);
+        id = read_le< std::uint32_t >(&body[4]);
+        std::memcpy(record.frame.data, &body[20], rtr ? 0U : record.frame.len);
+        valid = true;
+    }
+    else if ((type == BLF_CAN_FD_MESSAGE_64) && (body_size >= 40U))
+    {
+        // channel, DLC, valid data bytes, TX count, ID, frame length, flags,
+        // bit timings, bit count, direction, ext offset, CRC, then the data.
+        const std::uint32_t fd_flags = read_le< std::uint32_t >(&body[12]);
+        record.channel = body[0];
+        record.tx = body[34] == 1U;
+        rtr = (fd_flags & 0x0010U) != 0U;
+        record.fd = (fd_flags & 0x1000U) != 0U;
+        record.frame.flags = static_cast< std::uint8_t >(
+            ((fd_flags & 0x2000U) ? CANFD_BRS : 0) |
+            ((fd_flags & 0x4000U) ? CANFD_ESI : 0));
+        const std::uint8_t dlc = body[1] & 0x0FU;
+        record.frame.len =
+            record.fd ? DLC_TO_LEN[dlc] : ((dlc < 8U) ? dlc : 8U);
+        id = read_le< std::uint32_t >(&body[4]);
+        const std::uint32_t available = body_size - 40U;
+        const std::uint32_t len =
+            rtr ? 0U
+                : ((record.frame.len < available) ? record.frame.len
+                                                  : available);
+        std::memcpy(record.frame.data, &body[40], len);
+        valid = true;
+    }
+    else if ((type == BLF_CAN_MESSAGE) || (type == BLF_CAN_MESSAGE2) ||
+             (type == BLF_CAN_FD_MESSAGE) || (type == BLF_CAN_FD_MESSAGE_64))
+    {
+        ++errors;
+    }
+    else
+    {
+        ++skipped;
+    }
+
+    if (valid)
+    {
+        // bit 31 marks an extended ID in BLF as on a CAN socket.
+        record.frame.can_id = ((id & CAN_EFF_FLAG) != 0U)
+                                  ? ((id & CAN_EFF_MASK) | CAN_EFF_FLAG)
+                                  : (id & CAN_SFF_MASK);
+        record.frame.can_id |= rtr ? CAN_RTR_FLAG : 0U;
+        records.push_back(record);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The bytes a BLF object takes in the stream: objects are padded to 4
+ * bytes, except CAN_FD_MESSAGE_64.
+ */
+std::size_t blf_stride(const std::uint32_t size,
+                       const std::uint32_t type) noexcept
+{
+    return (type == BLF_CAN_FD_MESSAGE_64) ? size : (size + (size % 4U));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Checks if a BLF object header starts at data.
+ */
+bool is_blf_object(const std::uint8_t* const data,
+                   const std::size_t available) noexcept
+{
+    bool valid = (available >= BLF_BASE_SIZE) &&
+                 (std::memcmp(data, "LOBJ", 4U) == 0);
+
+    if (valid)
+    {
+        const std::uint16_t header_size = read_le< std::uint16_t >(&data[4]);
+        const std::uint16_t version = read_le< std::uint16_t >(&data[6]);
+        const std::uint32_t size = read_le< std::uint32_t >(&data[8]);
+        valid = (((version == 1U) && (header_size == BLF_HEADER_V1_SIZE)) ||
+                 ((version == 2U) && (header_size == BLF_HEADER_V2_SIZE))) &&
+                (size >= header_size) && (size <= CAN_LOG::MAX_OBJECT_SIZE);
+    }
+
+    return valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Finds the first object in the middle of a BLF stream. The object
+ * after it must be one too, or the stream must end before it.
+ * \return the offset of the object, or size if there is none.
+ */
+std::size_t find_blf_object(const std::uint8_t* const data,
+                            const std::size_t size) noexcept
+{
+    std::size_t offset = 0U;
+
+    while (offset < size)
+    {
+        const void* const found =
+            ::memmem(&data[offset], size - offset, "LOBJ", 4U);
+        offset = (found != nullptr)
+                     ? static_cast< std::size_t >(
+                           static_cast< const std::uint8_t* >(found) - data)
+                     : size;
+
+        if ((offset < size) && is_blf_object(&data[offset], size - offset))
+        {
+            const std::uint8_t* const object = &data[offset];
+            const std::size_t next =
+                offset + blf_stride(read_le< std::uint32_t >(&object[8]),
+                                    read_le< std::uint32_t >(&object[12]));
+
+            if ((next + BLF_BASE_SIZE > size) ||
+                is_blf_object(&data[next], size - next))
+            {
+                break;
+            }
+        }
+
+        offset = (offset < size) ? (offset + 1U) : size;
+    }
+
+    return offset;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Decodes the complete objects of a BLF stream.
+ * \return the bytes decoded, the rest is the start of an object that
+ * continues in the next chunk.
+ */
+std::size_t decode_blf_objects(const std::uint8_t* const data,
+                               const std::size_t size,
+                               const std::uint64_t start,
+                               std::vector< CanLogRecord >& records,
+                               std::uint64_t& errors,
+                               std::uint64_t& skipped) noexcept
+{
+    std::size_t offset = 0U;
+
+    while ((size - offset) >= BLF_BASE_SIZE)
+    {
+        const std::uint8_t* const object = &data[offset];
+        const std::uint32_t object_size = read_le< std::uint32_t >(&object[8]);
+        const std::uint32_t type = read_le< std::uint32_t >(&object[12]);
+
+        if ((std::memcmp(object, "LOBJ", 4U) != 0) ||
+            (object_size < BLF_BASE_SIZE) ||
+            (object_size > CAN_LOG::MAX_OBJECT_SIZE))
+        {
+            // skips to the next object.
+            ++errors;
+            offset += 1U + find_blf_object(&object[1], size - offset - 1U);
+        }
+        else if ((offset + blf_stride(object_size, type)) > size)
+        {
+            break;
+        }
+        else
+        {
+            decode_blf_object(object, object_size, type, start, records,
+                              errors, skipped);
+            offset += blf_stride(object_size, type);
+        }
+    }
+
+    return offset;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Sorts the frames of a chunk by timestamp, they mostly are already.
+ */
+void sort_records(std::vector< CanLogRecord >::iterator begin,
+                  std::vector< CanLogRecord >::iterator end) noexcept
+{
+    const auto earlier = [](const CanLogRecord& a, const CanLogRecord& b) {
+        return a.timestamp < b.timestamp;
+    };
+
+    if (std::is_sorted(begin, end, earlier) == false)
+    {
+        std::stable_sort(begin, end, earlier);
+    }
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+CanLogReader::CanLogReader(const std::size_t chunk_size) noexcept
+    : chunk_size_{(chunk_size > 0U) ? chunk_size : 1U}, files_{},
+      file_count_{0U}, pending_{}, heap_{}, horizon_{0U}, errors_{0U},
+      skipped_{0U}, chunks_{0U}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CanLogReader::~CanLogReader() noexcept
+{
+    for (std::size_t i = 0U; i < file_count_; ++i)
+    {
+        if (files_[i].data != nullptr)
+        {
+            munmap(const_cast< std::uint8_t* >(files_[i].data), files_[i].size);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanLogReader::open(const char* path) noexcept
+{
+    bool opened = false;
+    const int fd = (file_count_ < CAN_LOG::MAX_FILES) ? ::open(path, O_RDONLY)
+                                                       : -1;
+    struct stat info;
+
+    if ((fd >= 0) && (fstat(fd, &info) == 0) && (info.st_size > 0))
+    {
+        LogFile& file = files_[file_count_];
+        file.size = static_cast< std::size_t >(info.st_size);
+        void* const data =
+            mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data != MAP_FAILED)
+        {
+            // the workers read the whole file, the kernel may read ahead.
+            static_cast< void >(madvise(data, file.size, MADV_WILLNEED));
+            file.data = static_cast< const std::uint8_t* >(data);
+            ++file_count_;
+
+            if ((file.size >= 4U) && (std::memcmp(file.data, "LOGG", 4U) == 0))
+            {
+                file.format = CanLogFormat::BLF;
+                opened = index_blf(file);
+            }
+            else
+            {
+                file.format = CanLogFormat::CANDUMP;
+                opened = true;
+            }
+        }
+    }
+
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+
+    if (opened == false)
+    {
+        std::cerr << "Could not open the CAN log " << path << ".\n";
+    }
+
+    return opened;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CanLogFormat CanLogReader::get_format(const std::size_t file) const noexcept
+{
+    return (file < file_count_) ? files_[file].format : CanLogFormat::UNKNOWN;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t CanLogReader::get_default_workers() noexcept
+{
+    const unsigned int cores = std::thread::hardware_concurrency();
+    return (cores > 0U) ? cores : 1U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanLogReader::decode_round(const std::size_t workers) noexcept
+{
+    const std::size_t batch = workers * CAN_LOG::CHUNKS_PER_WORKER;
+    const std::size_t first = pending_.size();
+    bool taken = true;
+
+    // the files take turns, so they are decoded up to about the same time.
+    while (taken && ((pending_.size() - first) < batch))
+    {
+        taken = false;
+
+        for (std::size_t f = 0U;
+             (f < file_count_) && ((pending_.size() - first) < batch); ++f)
+        {
+            if ((files_[f].done == false) && (files_[f].format !=
+                                              CanLogFormat::UNKNOWN))
+            {
+                pending_.emplace_back();
+                take_chunk(f, pending_.back());
+                taken = true;
+            }
+        }
+    }
+
+    const std::size_t count = pending_.size() - first;
+
+    if (count > 0U)
+    {
+        // the workers take the next chunk until none is left.
+        std::atomic< std::size_t > next{first};
+        const auto work = [this, &next]() {
+            for (std::size_t i = next++; i < pending_.size(); i = next++)
+            {
+                decode(pending_[i]);
+            }
+        };
+        std::vector< std::thread > threads;
+        const std::size_t extra = ((workers < count) ? workers : count) - 1U;
+        threads.reserve(extra);
+
+        for (std::size_t i = 0U; i < extra; ++i)
+        {
+            threads.emplace_back(work);
+        }
+
+        work();
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        // in file order: objects that span two chunks need both.
+        for (std::size_t i = first; i < pending_.size(); ++i)
+        {
+            Chunk& chunk = pending_[i];
+            LogFile& file = files_[chunk.file];
+
+            if (file.format == CanLogFormat::BLF)
+            {
+                stitch_blf(chunk);
+            }
+
+            if (chunk.records.empty() == false)
+            {
+                const std::uint64_t last = chunk.records.back().timestamp;
+                file.last_timestamp =
+                    (last > file.last_timestamp) ? last : file.last_timestamp;
+            }
+
+            errors_ += chunk.errors;
+            skipped_ += chunk.skipped;
+            ++chunks_;
+        }
+    }
+
+    // the files not done yet may still have frames after their last one.
+    horizon_ = std::numeric_limits< std::uint64_t >::max();
+    for (std::size_t f = 0U; f < file_count_; ++f)
+    {
+        if ((files_[f].done == false) &&
+            (files_[f].last_timestamp < horizon_))
+        {
+            horizon_ = files_[f].last_timestamp;
+        }
+    }
+
+    return count > 0U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanLogReader::take_chunk(const std::size_t file, Chunk& chunk) noexcept
+{
+    LogFile& log = files_[file];
+    chunk.file = file;
+    chunk.begin = log.next;
+
+    if (log.format == CanLogFormat::CANDUMP)
+    {
+        // up to the end of the line the chunk size ends in.
+        std::size_t end = ((log.size - log.next) > chunk_size_)
+                              ? (log.next + chunk_size_)
+                              : log.size;
+        const void* const line_end =
+            (end < log.size) ? std::memchr(&log.data[end], '\n', log.size - end)
+                             : nullptr;
+        end = (line_end != nullptr)
+                  ? static_cast< std::size_t >(
+                        static_cast< const std::uint8_t* >(line_end) -
+                        log.data) +
+                        1U
+                  : log.size;
+        chunk.end = end;
+        log.done = end >= log.size;
+    }
+    else
+    {
+        // whole containers up to the chunk size.
+        std::size_t end = log.next;
+        std::size_t bytes = 0U;
+
+        while ((end < log.segments.size()) &&
+               ((end == log.next) || (bytes < chunk_size_)))
+        {
+            bytes += log.segments[end].size;
+            ++end;
+        }
+
+        chunk.end = end;
+        log.done = end >= log.segments.size();
+    }
+
+    log.next = chunk.end;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanLogReader::decode(Chunk& chunk) const noexcept
+{
+    if (files_[chunk.file].format == CanLogFormat::BLF)
+    {
+        decode_blf(chunk);
+    }
+    else
+    {
+        decode_candump(chunk);
+    }
+
+    sort_records(chunk.records.begin(), chunk.records.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanLogReader::decode_candump(Chunk& chunk) const noexcept
+{
+    const LogFile& file = files_[chunk.file];
+    const char* p = reinterpret_cast< const char* >(&file.data[chunk.begin]);
+    const char* const end =
+        reinterpret_cast< const char* >(&file.data[chunk.end]);
+    // a line of a classic frame has about 40 characters.
+    chunk.records.reserve((chunk.end - chunk.begin) / 32U);
+    CanLogRecord record;
+
+    while (p < end)
+    {
+        const void* const found = std::memchr(p, '\n', end - p);
+        const char* const line_end =
+            (found != nullptr) ? static_cast< const char* >(found) : end;
+
+        // empty lines are skipped.
+        if ((line_end > p) && (*p != '\r'))
+        {
+            if (decode_candump_line(p, line_end, record))
+            {
+                chunk.records.push_back(record);
+            }
+            else
+            {
+                ++chunk.errors;
+            }
+        }
+
+        p = line_end + 1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanLogReader::decode_blf(Chunk& chunk) const noexcept
+{
+    const LogFile& file = files_[chunk.file];
+    std::size_t total = 0U;
+
+    for (std::size_t s = chunk.begin; s < chunk.end; ++s)
+    {
+        const Segment& segment = file.segments[s];
+        total += (segment.compression == BLF_NO_COMPRESSION)
+                     ? segment.size
+                     : segment.uncompressed;
+    }
+
+    // the objects of all containers of the chunk in one stream.
+    std::vector< std::uint8_t > stream(total);
+    std::size_t size = 0U;
+
+    for (std::size_t s = chunk.begin; s < chunk.end; ++s)
+    {
+        const Segment& segment = file.segments[s];
+        const std::uint8_t* const data = &file.data[segment.offset];
+
+        if (segment.compression == BLF_NO_COMPRESSION)
+        {
+            std::memcpy(&stream[size], data, segment.size);
+            size += segment.size;
+        }
+#ifdef BSW_WITH_ZLIB
+        else if (segment.compression == BLF_ZLIB)
+        {
+            uLongf length = segment.uncompressed;
+            const int result =
+                uncompress(&stream[size], &length, data, segment.size);
+            size += (result == Z_OK) ? length : 0U;
+            chunk.errors += (result == Z_OK) ? 0U : 1U;
+        }
+#endif
+        else
+        {
+            ++chunk.errors;
+        }
+    }
+
+    // the first chunk starts with an object, the others may start in the
+    // middle of one.
+    const std::size_t start =
+        (chunk.begin == 0U) ? 0U : find_blf_object(stream.data(), size);
+    chunk.has_start = start < size;
+    chunk.prefix.assign(stream.begin(), stream.begin() + start);
+
+    if (chunk.has_start)
+    {
+        chunk.records.reserve((size - start) / 48U);
+        const std::size_t decoded =
+            decode_blf_objects(&stream[start], size - start, file.start,
+                               chunk.records, chunk.errors, chunk.skipped);
+        chunk.leftover.assign(stream.begin() + start + decoded,
+                              stream.begin() + size);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanLogReader::stitch_blf(Chunk& chunk) noexcept
+{
+    LogFile& file = files_[chunk.file];
+    file.carry.insert(file.carry.end(), chunk.prefix.begin(),
+                      chunk.prefix.end());
+
+    if (chunk.has_start)
+    {
+        // the end of the chunk before and the begin of this one hold whole
+        // objects.
+        const std::size_t sorted = chunk.records.size();
+        const std::size_t decoded =
+            decode_blf_objects(file.carry.data(), file.carry.size(), file.start,
+                               chunk.records, chunk.errors, chunk.skipped);
+        chunk.errors += (decoded < file.carry.size()) ? 1U : 0U;
+
+        if (chunk.records.size() > sorted)
+        {
+            const auto middle =
+                chunk.records.begin() + static_cast< std::ptrdiff_t >(sorted);
+            sort_records(middle, chunk.records.end());
+            const auto earlier = [](const CanLogRecord& a,
+                                    const CanLogRecord& b) {
+                return a.timestamp < b.timestamp;
+            };
+            std::inplace_merge(chunk.records.begin(), middle,
+                               chunk.records.end(), earlier);
+        }
+
+        file.carry.swap(chunk.leftover);
+    }
+
+    // an object cut off by the end of the file.
+    if (file.done && (chunk.end == file.segments.size()) &&
+        (file.carry.size() >= BLF_BASE_SIZE))
+    {
+        ++chunk.errors;
+    }
+
+    chunk.prefix.clear();
+    chunk.leftover.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanLogReader::index_blf(LogFile& file) noexcept
+{
+    const std::uint32_t header_size =
+        (file.size >= BLF_FILE_HEADER_SIZE)
+            ? read_le< std::uint32_t >(&file.data[4])
+            : 0U;
+    const bool valid =
+        (header_size >= BLF_FILE_HEADER_SIZE) && (header_size <= file.size);
+
+    if (valid)
+    {
+        // the start time is a SYSTEMTIME: year, month, day of week, day,
+        // hour, minute, second, milliseconds.
+        const std::uint8_t* const time = &file.data[BLF_START_OFFSET];
+        struct tm start;
+        std::memset(&start, 0, sizeof(start));
+        start.tm_year = read_le< std::uint16_t >(&time[0]) - 1900;
+        start.tm_mon = read_le< std::uint16_t >(&time[2]) - 1;
+        start.tm_mday = read_le< std::uint16_t >(&time[6]);
+        start.tm_hour = read_le< std::uint16_t >(&time[8]);
+        start.tm_min = read_le< std::uint16_t >(&time[10]);
+        start.tm_sec = read_le< std::uint16_t >(&time[12]);
+        const time_t seconds = timegm(&start);
+        file.start = (static_cast< std::uint64_t >(seconds) * NS_PER_SECOND) +
+                     (read_le< std::uint16_t >(&time[14]) * 1000000U);
+
+        // only the object headers are read, the workers read the rest.
+        std::size_t offset = header_size;
+
+        while ((offset + BLF_BASE_SIZE) <= file.size)
+        {
+            const std::uint8_t* const object = &file.data[offset];
+            const std::uint32_t size = read_le< std::uint32_t >(&object[8]);
+            const std::uint32_t type = read_le< std::uint32_t >(&object[12]);
+
+            if ((std::memcmp(object, "LOBJ", 4U) != 0) ||
+                (size < BLF_BASE_SIZE) || ((offset + size) > file.size))
+            {
+                // zeros fill up the end of some files.
+                errors_ += (object[0] != 0U) ? 1U : 0U;
+                break;
+            }
+
+            Segment segment{offset, 0U, 0U, BLF_NO_COMPRESSION};
+
+            if ((type == BLF_LOG_CONTAINER) && (size >= 32U))
+            {
+                // the container header holds the compression and the size.
+                segment.offset = offset + 32U;
+                segment.size = size - 32U;
+                segment.compression = read_le< std::uint16_t >(&object[16]);
+                segment.uncompressed = read_le< std::uint32_t >(&object[24]);
+            }
+            else
+            {
+                // an object outside of a container, with its padding.
+                const std::size_t stride = blf_stride(size, type);
+                segment.size = static_cast< std::uint32_t >(
+                    ((offset + stride) <= file.size) ? stride : size);
+                segment.uncompressed = segment.size;
+            }
+
+            file.segments.push_back(segment);
+            offset += size + (size % 4U);
+        }
+
+        file.done = file.segments.empty();
+    }
+
+    return valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanLogReader::drop_merged() noexcept
+{
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [](const Chunk& chunk) {
+                                      return chunk.next >=
+                                             chunk.records.size();
+                                  }),
+                   pending_.end());
+}
+
+#endif // WIN32 detection
@@ -0,0 +1,367 @@
+/**
+ * \file      CanLogReader.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Parallel reader of CAN log files.
+ * \details   Splits memory-mapped candump and BLF logs into chunks, decodes the
+ *            chunks on all cores and merges the frames of all files in timestamp
+ *            order.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CANLOGREADER_H_
+#define CANLOGREADER_H_
+
+#ifndef _WIN32
+
+#include "CanSocket.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Defining a struct that holds the sizes of the CAN log reader.
+ */
+struct CAN_LOG
+{
+    // bytes of a log file decoded by one task, if not set otherwise.
+    static constexpr std::size_t CHUNK_SIZE{4U * 1024U * 1024U};
+    // log files read at once.
+    static constexpr std::size_t MAX_FILES{16U};
+    // chunks per worker decoded in one round, bounds the memory used.
+    static constexpr std::size_t CHUNKS_PER_WORKER{2U};
+    // biggest BLF object accepted.
+    static constexpr std::uint32_t MAX_OBJECT_SIZE{1024U * 1024U};
+};
+
+/**
+ * \brief The formats of log files.
+ */
+enum class CanLogFormat : std::uint8_t
+{
+    UNKNOWN, ///< the file could not be opened.
+    CANDUMP, ///< text of "candump -l": (1436509052.249713) can0 123#DEADBEEF
+    BLF      ///< binary logging format of Vector.
+};
+
+/**
+ * \brief One frame of a log.
+ */
+struct CanLogRecord
+{
+    /// time of the frame in nanoseconds since the epoch.
+    std::uint64_t timestamp;
+    /// the frame, CAN_EFF_FLAG and CAN_RTR_FLAG in the ID as on a socket.
+    struct canfd_frame frame;
+    /// channel, starting at 1: the BLF channel, can0 of candump is 1.
+    std::uint16_t channel;
+    /// true for a CAN FD frame.
+    bool fd;
+    /// true if the logger sent the frame.
+    bool tx;
+};
+
+/**
+ * \brief CanLogReader reads CAN log files with all cores. Each file is mapped
+ * into memory and split into chunks that can be decoded independently:
+ * candump text at line ends, BLF at its log containers. Workers decode the
+ * chunks in parallel, then the frames of all files are merged in timestamp
+ * order with a k-way merge and handed to the caller.
+ *
+ * The files are read in rounds of a few chunks per worker, so the memory
+ * stays bounded for logs of any length. Each file must be in timestamp order
+ * by itself, as loggers write them; frames of the same time keep their
+ * order.
+ * \code
+ * CanLogReader reader;
+ * reader.open("can0.log");
+ * reader.open("can1.blf");
+ * reader.read([](const CanLogRecord& record) { ... });
+ * \endcode
+ */
+class CanLogReader
+{
+  public:
+    /**
+     * \brief Creates a reader without files.
+     * \param[in] chunk_size bytes of a file decoded by one task.
+     */
+    explicit CanLogReader(
+        const std::size_t chunk_size = CAN_LOG::CHUNK_SIZE) noexcept;
+
+    /**
+     * \brief Unmaps the files.
+     */
+    ~CanLogReader() noexcept;
+
+    CanLogReader(const CanLogReader&) = delete;
+    CanLogReader& operator=(const CanLogReader&) = delete;
+
+    /**
+     * \brief Maps a log file and detects its format.
+     * \return false if the file could not be mapped, has an unknown format
+     * or CAN_LOG::MAX_FILES are open.
+     */
+    bool open(const char* path) noexcept;
+
+    /**
+     * \brief Decodes all files and calls the handler for every frame in
+     * timestamp order.
+     * \param[in] handler called as handler(const CanLogRecord&).
+     * \param[in] workers number of threads, 0 for one per core.
+     * \return the number of frames read.
+     */
+    template < typename Handler >
+    std::uint64_t read(Handler&& handler, std::size_t workers = 0U) noexcept
+    {
+        std::uint64_t frames = 0U;
+        workers = (workers > 0U) ? workers : get_default_workers();
+
+        // the frames up to the horizon are complete in every file.
+        while (decode_round(workers))
+        {
+            frames += merge(std::forward< Handler >(handler), horizon_);
+        }
+
+        frames += merge(std::forward< Handler >(handler),
+                        std::numeric_limits< std::uint64_t >::max());
+        return frames;
+    }
+
+    /**
+     * \brief The format of an open file.
+     */
+    CanLogFormat get_format(const std::size_t file) const noexcept;
+
+    /**
+     * \brief Number of lines or objects that could not be decoded.
+     */
+    std::uint64_t get_errors() const noexcept { return errors_; }
+
+    /**
+     * \brief Number of BLF objects that are no CAN frames, e.g. statistics.
+     */
+    std::uint64_t get_skipped() const noexcept { return skipped_; }
+
+    /**
+     * \brief Number of chunks decoded.
+     */
+    std::uint64_t get_chunks() const noexcept { return chunks_; }
+
+  private:
+    /**
+     * \brief A BLF log container or a top-level object, a part of the stream
+     * of objects.
+     */
+    struct Segment
+    {
+        std::size_t offset;
+        std::uint32_t size;
+        std::uint32_t uncompressed;
+        std::uint16_t compression;
+    };
+
+    /**
+     * \brief A mapped log file.
+     */
+    struct LogFile
+    {
+        const std::uint8_t* data{nullptr};
+        std::size_t size{0U};
+        CanLogFormat format{CanLogFormat::UNKNOWN};
+        /// BLF: the start of the measurement in ns since the epoch.
+        std::uint64_t start{0U};
+        /// BLF: the containers.
+        std::vector< Segment > segments;
+        /// the byte (candump) or segment (BLF) the next chunk starts at.
+        std::size_t next{0U};
+        /// the latest timestamp decoded.
+        std::uint64_t last_timestamp{0U};
+        /// BLF: bytes of an object that continues in the next chunk.
+        std::vector< std::uint8_t > carry;
+        /// true if all chunks are decoded.
+        bool done{false};
+    };
+
+    /**
+     * \brief A part of a file decoded by one worker.
+     */
+    struct Chunk
+    {
+        std::size_t file{0U};
+        /// bytes (candump) or segments (BLF) of the file.
+        std::size_t begin{0U};
+        std::size_t end{0U};
+        /// the frames, sorted by timestamp after decoding.
+        std::vector< CanLogRecord > records;
+        /// the next frame to merge.
+        std::size_t next{0U};
+        /// BLF: the bytes before the first object and after the last one.
+        std::vector< std::uint8_t > prefix;
+        std::vector< std::uint8_t > leftover;
+        /// BLF: false if no object starts in the chunk.
+        bool has_start{false};
+        std::uint64_t errors{0U};
+        std::uint64_t skipped{0U};
+    };
+
+    /**
+     * \brief One worker per core.
+     */
+    static std::size_t get_default_workers() noexcept;
+
+    /**
+     * \brief Decodes the next chunks of all files with the workers and
+     * updates the horizon.
+     * \return false if all files are decoded.
+     */
+    bool decode_round(const std::size_t workers) noexcept;
+
+    /**
+     * \brief Takes the next chunk of a file.
+     */
+    void take_chunk(const std::size_t file, Chunk& chunk) noexcept;
+
+    /**
+     * \brief Decodes a chunk, called by the workers.
+     */
+    void decode(Chunk& chunk) const noexcept;
+
+    /**
+     * \brief Decodes the lines of a candump chunk.
+     */
+    void decode_candump(Chunk& chunk) const noexcept;
+
+    /**
+     * \brief Decodes the containers of a BLF chunk.
+     */
+    void decode_blf(Chunk& chunk) const noexcept;
+
+    /**
+     * \brief Decodes the objects of a BLF chunk that span two chunks.
+     */
+    void stitch_blf(Chunk& chunk) noexcept;
+
+    /**
+     * \brief Reads the header and the containers of a BLF file.
+     */
+    bool index_blf(LogFile& file) noexcept;
+
+    /**
+     * \brief Calls the handler for all frames up to the horizon in timestamp
+     * order and drops the chunks merged completely.
+     * \return the number of frames merged.
+     */
+    template < typename Handler >
+    std::uint64_t merge(Handler&& handler,
+                        const std::uint64_t horizon) noexcept
+    {
+        // a min-heap of the next frame of every chunk, the chunk index breaks
+        // ties so frames of the same time keep the order of the files.
+        using Entry = std::pair< std::uint64_t, std::size_t >;
+        heap_.clear();
+
+        for (std::size_t i = 0U; i < pending_.size(); ++i)
+        {
+            const Chunk& chunk = pending_[i];
+            if (chunk.next < chunk.records.size())
+            {
+                heap_.emplace_back(chunk.records[chunk.next].timestamp, i);
+            }
+        }
+
+        std::make_heap(heap_.begin(), heap_.end(), std::greater< Entry >{});
+        std::uint64_t merged = 0U;
+
+        while ((heap_.empty() == false) && (heap_.front().first <= horizon))
+        {
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater< Entry >{});
+            Chunk& chunk = pending_[heap_.back().second];
+            handler(static_cast< const CanLogRecord& >(
+                chunk.records[chunk.next]));
+            ++chunk.next;
+            ++merged;
+
+            if (chunk.next < chunk.records.size())
+            {
+                heap_.back().first = chunk.records[chunk.next].timestamp;
+                std::push_heap(heap_.begin(), heap_.end(),
+                               std::greater< Entry >{});
+            }
+            else
+            {
+                heap_.pop_back();
+            }
+        }
+
+        drop_merged();
+        return merged;
+    }
+
+    /**
+     * \brief Removes the chunks merged completely.
+     */
+    void drop_merged() noexcept;
+
+    /// bytes of a chunk.
+    std::size_t chunk_size_;
+
+    /// the open files.
+    std::array< LogFile, CAN_LOG::MAX_FILES > files_;
+
+    /// number of open files.
+    std::size_t file_count_;
+
+    /// the chunks decoded but not merged completely, in file order.
+    std::vector< Chunk > pending_;
+
+    /// the heap of merge(), kept to reuse its memory.
+    std::vector< std::pair< std::uint64_t, std::size_t > > heap_;
+
+    /// the frames up to this time are decoded in every file.
+    std::uint64_t horizon_;
+
+    /// lines or objects that could not be decoded.
+    std::uint64_t errors_;
+
+    /// BLF objects that are no CAN frames.
+    std::uint64_t skipped_;
+
+    /// chunks decoded.
+    std::uint64_t chunks_;
+};
+
+#endif // WIN32 detection
+#endif // CANLOGREADER_H_
@@ -0,0 +1,203 @@
+/**
+ * \file      CanSchedule.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Time-triggered CAN transmission from a schedule table.
+ * \details   Every entry of the table is sent at a fixed offset within a cycle.
+ *            Entries sharing an offset are sent together with one system call.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "CanSchedule.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+CanSchedule::CanSchedule(const std::chrono::microseconds cycle) noexcept
+    : cycle_{cycle}, entries_{}, count_{0U}, slot_{},
+      cycle_start_{0}, timing_errors_{}, failed_{}, cycles_{0U}, overruns_{0U}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanSchedule::add(const CanScheduleEntry& entry) noexcept
+{
+    const bool fits = (count_ < entries_.size()) &&
+                      (entry.offset.count() >= 0) && (entry.offset < cycle_) &&
+                      (entry.len <= CANFD_MAX_DLEN);
+
+    if (fits)
+    {
+        // insert behind all entries with the same or an earlier offset.
+        std::size_t index = count_;
+
+        while ((index > 0U) && (entries_[index - 1U].offset > entry.offset))
+        {
+            entries_[index] = entries_[index - 1U];
+            --index;
+        }
+
+        entries_[index] = entry;
+        ++count_;
+        reset();
+    }
+
+    return fits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanSchedule::run_cycle(CanSocket& socket) noexcept
+{
+    bool all_sent = true;
+    const std::chrono::nanoseconds start = now();
+
+    if (cycle_start_.count() == 0)
+    {
+        cycle_start_ = start;
+    }
+    else if ((start - cycle_start_) >= cycle_)
+    {
+        // the caller is late, skip to the cycle that is running now.
+        const auto missed = (start - cycle_start_) / cycle_;
+        cycle_start_ += missed * cycle_;
+        overruns_ += static_cast< std::uint64_t >(missed);
+    }
+
+    std::size_t index = 0U;
+
+    while (index < count_)
+    {
+        const std::chrono::microseconds offset = entries_[index].offset;
+        std::size_t frames = 0U;
+
+        // the payloads are filled before the slot, not in it.
+        while (((index + frames) < count_) &&
+               (entries_[index + frames].offset == offset) &&
+               (frames < slot_.size()))
+        {
+            const CanScheduleEntry& entry = entries_[index + frames];
+            struct canfd_frame& frame = slot_[frames];
+            std::memset(&frame, 0, sizeof(frame));
+            frame.can_id = entry.can_id;
+            frame.len = entry.len;
+
+            if (entry.source != nullptr)
+            {
+                entry.source(entry.context, frame);
+            }
+
+            ++frames;
+        }
+
+        const std::chrono::nanoseconds target = cycle_start_ + offset;
+        wait_until(target);
+        const int sent = socket.send_batch(slot_.data(), frames);
+        const std::chrono::nanoseconds error = now() - target;
+
+        for (std::size_t i = 0U; i < frames; ++i)
+        {
+            if (static_cast< int >(i) < sent)
+            {
+                timing_errors_[index + i].add(error);
+            }
+            else
+            {
+                ++failed_[index + i];
+                all_sent = false;
+            }
+        }
+
+        index += frames;
+    }
+
+    cycle_start_ += cycle_;
+    ++cycles_;
+    return all_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanSchedule::reset() noexcept
+{
+    cycle_start_ = std::chrono::nanoseconds{0};
+    cycles_ = 0U;
+    overruns_ = 0U;
+    failed_.fill(0U);
+
+    for (auto& histogram : timing_errors_)
+    {
+        histogram.clear();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanSchedule::print(std::ostream& out) const noexcept
+{
+    out << "cycles: " << cycles_ << " overruns: " << overruns_ << "\n";
+
+    for (std::size_t i = 0U; i < count_; ++i)
+    {
+        out << "0x" << std::hex << entries_[i].can_id << std::dec << " @ "
+            << entries_[i].offset.count() << "us failed=" << failed_[i]
+            << " error: ";
+        timing_errors_[i].print(out);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanSchedule::wait_until(const std::chrono::nanoseconds time) noexcept
+{
+    const std::chrono::seconds sec =
+        std::chrono::duration_cast< std::chrono::seconds >(time);
+    struct timespec wake_up;
+    wake_up.tv_sec = static_cast< decltype(wake_up.tv_sec) >(sec.count());
+    wake_up.tv_nsec =
+        static_cast< decltype(wake_up.tv_nsec) >((time - sec).count());
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake_up,
+                           nullptr) == EINTR)
+    {
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::chrono::nanoseconds CanSchedule::now() noexcept
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return std::chrono::seconds{time.tv_sec} +
+           std::chrono::nanoseconds{time.tv_nsec};
+}
+
+#endif // WIN32 detection
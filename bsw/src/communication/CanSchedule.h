@@ -0,0 +1,304 @@
+/**
+ * \file      CanSchedule.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Time-triggered CAN transmission from a schedule table.
+ * \details   Every entry of the table is sent at a fixed offset within a cycle.
+ *            Entries sharing an offset are sent together with one system call.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CANSCHEDULE_H_
+#define CANSCHEDULE_H_
+
+#ifndef _WIN32
+
+#include "CanSocket.h"
+#include "LatencyHistogram.h"
+#include "RTTask.h"
+#include <array>
+#include <chrono>
+#include <iostream>
+
+/**
+ * \brief Defining a struct that holds the size of a schedule table.
+ */
+struct CAN_SCHEDULE
+{
+    // number of entries of one schedule table.
+    static constexpr std::size_t MAX_ENTRIES{64U};
+};
+
+/**
+ * \brief Fills the payload of a frame right before its slot. The frame
+ * holds the CAN ID and length of the entry and zeros.
+ */
+using CanPayloadSource = void (*)(void* context, struct canfd_frame& frame);
+
+/**
+ * \brief One entry of a schedule table.
+ */
+struct CanScheduleEntry
+{
+    /// the time from the start of the cycle the frame is sent at.
+    std::chrono::microseconds offset;
+
+    /// the CAN ID including flags (e.g. CAN_EFF_FLAG).
+    CanIDType can_id;
+
+    /// the payload length. Up to 8 bytes are sent as a standard frame
+    /// unless the source sets CANFD_FDF, see can_get_mtu().
+    std::uint8_t len;
+
+    /// fills the payload, nullptr to send zeros.
+    CanPayloadSource source;
+
+    /// handed to the source.
+    void* context;
+};
+
+/**
+ * \brief CanSchedule sends the frames of a schedule table at fixed offsets
+ * within a cycle, like the exclusive windows of TT-CAN. run_cycle() is
+ * called once per cycle, by a CanScheduleTask or an RTTask of its own. It
+ * waits for each slot with an absolute time, so errors do not add up over
+ * the cycle. The timing error of every entry is collected in a histogram:
+ * the time from the planned offset until the socket has taken the frame.
+ */
+class CanSchedule
+{
+  public:
+    /**
+     * \brief Creates an empty table.
+     * \param[in] cycle the length of a cycle.
+     */
+    explicit CanSchedule(const std::chrono::microseconds cycle) noexcept;
+
+    /**
+     * \brief Creates the schedule from a table known at compile-time.
+     * \param[in] cycle the length of a cycle.
+     * \param[in] table the entries, in any order.
+     */
+    template < std::size_t N >
+    CanSchedule(const std::chrono::microseconds cycle,
+                const std::array< CanScheduleEntry, N >& table) noexcept
+        : CanSchedule{cycle}
+    {
+        static_assert(N <= CAN_SCHEDULE::MAX_ENTRIES,
+                      "The schedule table is too big.");
+
+        for (const auto& entry : table)
+        {
+            add(entry);
+        }
+    }
+
+    /**
+     * \brief Adds an entry to the table. Entries with the same offset are
+     * sent in the order they were added.
+     * \return false if the table is full or the offset is not within the
+     * cycle.
+     */
+    bool add(const CanScheduleEntry& entry) noexcept;
+
+    /**
+     * \brief Sends all entries of one cycle. The first call starts the
+     * first cycle, every call after that runs the next cycle. If a call
+     * comes more than a cycle late, the cycles missed are skipped and
+     * counted as overruns.
+     * \param[in] socket the socket to send with.
+     * \return true if all frames of the cycle were sent.
+     */
+    bool run_cycle(CanSocket& socket) noexcept;
+
+    /**
+     * \brief Starts over with the next call of run_cycle() and clears the
+     * statistics.
+     */
+    void reset() noexcept;
+
+    /**
+     * \brief The length of a cycle.
+     */
+    std::chrono::microseconds get_cycle() const noexcept { return cycle_; }
+
+    /**
+     * \brief Number of entries in the table.
+     */
+    std::size_t get_count() const noexcept { return count_; }
+
+    /**
+     * \brief An entry of the table, sorted by offset.
+     */
+    const CanScheduleEntry& get_entry(const std::size_t index) const noexcept
+    {
+        return entries_[index];
+    }
+
+    /**
+     * \brief The timing errors of an entry.
+     */
+    const LatencyHistogram& get_timing_error(const std::size_t index) const
+        noexcept
+    {
+        return timing_errors_[index];
+    }
+
+    /**
+     * \brief Number of frames of an entry the socket did not take.
+     */
+    std::uint32_t get_failed(const std::size_t index) const noexcept
+    {
+        return failed_[index];
+    }
+
+    /**
+     * \brief Number of cycles run.
+     */
+    std::uint64_t get_cycles() const noexcept { return cycles_; }
+
+    /**
+     * \brief Number of cycles skipped because run_cycle() came too late.
+     */
+    std::uint64_t get_overruns() const noexcept { return overruns_; }
+
+    /**
+     * \brief Prints the timing error of every entry.
+     */
+    void print(std::ostream& out) const noexcept;
+
+  private:
+    /**
+     * \brief Sleeps until an absolute time of CLOCK_MONOTONIC.
+     */
+    static void wait_until(const std::chrono::nanoseconds time) noexcept;
+
+    /**
+     * \brief The current time of CLOCK_MONOTONIC.
+     */
+    static std::chrono::nanoseconds now() noexcept;
+
+    /// the length of a cycle.
+    std::chrono::microseconds cycle_;
+
+    /// the entries, sorted by offset.
+    std::array< CanScheduleEntry, CAN_SCHEDULE::MAX_ENTRIES > entries_;
+
+    /// number of entries.
+    std::size_t count_;
+
+    /// the frames of the current slot.
+    std::array< struct canfd_frame, CAN_BATCH::MAX_FRAMES > slot_;
+
+    /// the start of the next cycle, zero before the first one.
+    std::chrono::nanoseconds cycle_start_;
+
+    /// the timing errors per entry.
+    std::array< LatencyHistogram, CAN_SCHEDULE::MAX_ENTRIES > timing_errors_;
+
+    /// frames the socket did not take per entry.
+    std::array< std::uint32_t, CAN_SCHEDULE::MAX_ENTRIES > failed_;
+
+    /// number of cycles run.
+    std::uint64_t cycles_;
+
+    /// number of cycles skipped.
+    std::uint64_t overruns_;
+};
+
+/**
+ * \brief A real-time task that runs a schedule, one cycle per period.
+ * \tparam Priority the real-time priority of the task.
+ * \tparam CycleMicro the cycle of the schedule in microseconds.
+ */
+template < int Priority, long int CycleMicro >
+class CanScheduleTask
+    : public RTTask< CanScheduleTask< Priority, CycleMicro >, Priority,
+                     CycleMicro >
+{
+  public:
+    /**
+     * \brief Creates the task. Call task_entry() to run it.
+     * \param[in] schedule the schedule to run, its cycle must be CycleMicro.
+     * \param[in] socket the socket to send with.
+     */
+    CanScheduleTask(CanSchedule& schedule, CanSocket& socket) noexcept
+        : schedule_(schedule), socket_(socket)
+    {
+    }
+
+    /**
+     * \brief Checks the schedule before the first cycle.
+     */
+    bool pre() noexcept
+    {
+        const bool ok =
+            (schedule_.get_cycle() == std::chrono::microseconds{CycleMicro}) &&
+            socket_.is_can_initialized();
+
+        if (ok == false)
+        {
+            std::cerr << "The schedule does not fit the task.\n";
+        }
+
+        schedule_.reset();
+        return ok;
+    }
+
+    /**
+     * \brief Runs one cycle of the schedule.
+     */
+    bool update() noexcept
+    {
+        schedule_.run_cycle(socket_);
+        return this->m_task_running;
+    }
+
+    /**
+     * \brief Nothing to clean up.
+     */
+    void post() noexcept {}
+
+    /**
+     * \brief Stops the task after the current cycle.
+     */
+    void stop() noexcept { this->m_task_running = false; }
+
+  private:
+    /// the schedule to run.
+    CanSchedule& schedule_;
+
+    /// the socket to send with.
+    CanSocket& socket_;
+};
+
+#endif // WIN32 detection
+#endif // CANSCHEDULE_H_
@@ -42,43 +42,200 @@
 #error "SocketCAN for Linux OS only."
 #endif
 #include "CanSocket.h"
+#include <poll.h>      // waiting after the idle budget of a busy-poll receive
+#include <sys/uio.h>   // iovec for batched I/O
 #include <type_traits> // Checks & decisions at compile-time
 
+#if defined(CANXL_MTU) && !defined(CAN_RAW_XL_VCID_TX_SET)
+// The VCID socket option is part of Linux 6.9. Older kernel headers do not
+// know it, the values are taken from linux/can/raw.h.
+#define CAN_RAW_XL_VCID_OPTS 8
+#define CAN_RAW_XL_VCID_TX_SET 0x01
+#define CAN_RAW_XL_VCID_TX_PASS 0x02
+#define CAN_RAW_XL_VCID_RX_FILTER 0x04
+struct can_raw_vcid_options
+{
+    __u8 flags;
+    __u8 tx_vcid;
+    __u8 rx_vcid;
+    __u8 rx_vcid_mask;
+};
+#endif
+
+// the default idle budget is copied by reference, so it needs a definition.
+constexpr std::chrono::microseconds CAN_POLL::DEFAULT_IDLE_BUDGET;
+
+// the MTUs are chosen by reference in can_get_mtu(), so they need a
+// definition.
+constexpr std::size_t CAN_STD::MTU;
+constexpr std::size_t CAN_FD::MTU;
+
+namespace
+{
 ////////////////////////////////////////////////////////////////////////////////
-std::int8_t CanSocket::receive(CanIDType& can_id, CanFDData& data_ref) noexcept
+/**
+ * \brief Number of bytes a frame occupies on the socket.
+ */
+std::size_t frame_size(const struct canfd_frame& frame) noexcept
 {
-    // Complete length of the CAN frame received
-    std::int8_t can_received{-1};
+    return can_get_mtu(frame);
+}
 
-    if (is_can_initialized() == true)
+#ifdef CANXL_MTU
+////////////////////////////////////////////////////////////////////////////////
+std::size_t frame_size(const CanXLFrame& frame) noexcept
+{
+    // CAN XL frames are written with the actual payload length only.
+    return CANXL_HDR_SIZE + frame.len;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Writes frames to the socket with as few sendmmsg calls as possible.
+ * \return number of frames sent, -1 if nothing was sent.
+ */
+template < typename Frame >
+int send_frames(const SocketHandleType handle, const Frame* frames,
+                const std::size_t count) noexcept
+{
+    std::array< struct mmsghdr, CAN_BATCH::MAX_FRAMES > msgs;
+    std::array< struct iovec, CAN_BATCH::MAX_FRAMES > iov;
+    std::size_t sent{0U};
+    bool send_ok{true};
+
+    while ((sent < count) && send_ok)
     {
-        struct canfd_frame frame;
-        const auto socket = get_socket_handle();
-        const ssize_t nbytes = read(socket, &frame, can_mtu_);
-        can_received = static_cast< std::int8_t >(nbytes);
+        const std::size_t chunk = std::min(count - sent, msgs.size());
 
-        // Check if data is on the socket to receive
-        if (can_received > 0)
+        for (std::size_t i = 0U; i < chunk; ++i)
         {
-            // The id is stored in the var given by ref.
-            can_id = frame.can_id;
-            // Give the data length code to the return val.
-            can_received = static_cast< std::int8_t >(frame.len);
-            // Limit the maximum length
-            const auto data_len = std::min(
-                static_cast< std::size_t >(frame.len), data_ref.size());
-            // Transfer the byte stream into the data structure given by ref.
-            for (std::uint8_t i = 0U; i < data_len; ++i)
+            const Frame& frame = frames[sent + i];
+            iov[i].iov_base = const_cast< Frame* >(&frame);
+            iov[i].iov_len = frame_size(frame);
+            std::memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1U;
+        }
+
+        const int res =
+            sendmmsg(handle, msgs.data(), static_cast< unsigned >(chunk), 0);
+
+        if (res > 0)
+        {
+            sent += static_cast< std::size_t >(res);
+            // the socket buffer is full if not all frames were taken.
+            send_ok = (static_cast< std::size_t >(res) == chunk);
+        }
+        else
+        {
+            send_ok = false;
+        }
+    }
+
+    return (sent > 0U) ? static_cast< int >(sent) : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Reads up to count frames from the socket with one recvmmsg call.
+ * \param[out] sizes the bytes read per frame, may be nullptr.
+ * \return number of frames received, -1 on error.
+ */
+template < typename Frame >
+int receive_frames(const SocketHandleType handle, Frame* frames,
+                   const std::size_t count, std::size_t* sizes) noexcept
+{
+    std::array< struct mmsghdr, CAN_BATCH::MAX_FRAMES > msgs;
+    std::array< struct iovec, CAN_BATCH::MAX_FRAMES > iov;
+    const std::size_t chunk = std::min(count, msgs.size());
+
+    for (std::size_t i = 0U; i < chunk; ++i)
+    {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(Frame);
+        std::memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1U;
+    }
+
+    // wait for the first frame only, then take what is there.
+    const int received = recvmmsg(handle, msgs.data(),
+                                  static_cast< unsigned >(chunk),
+                                  MSG_WAITFORONE, nullptr);
+
+    for (int i = 0; (sizes != nullptr) && (i < received); ++i)
+    {
+        sizes[i] = msgs[static_cast< std::size_t >(i)].msg_len;
+    }
+
+    return received;
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t CanSocket::send(const struct canfd_frame& frame) noexcept
+{
+    return send(frame, can_get_mtu(frame));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t CanSocket::send(const struct canfd_frame& frame,
+                            const std::size_t mtu) noexcept
+{
+    std::int8_t data_sent{-1};
+
+    // First check if the file descriptor for the socket was initialized
+    // and the interface is up and running.
+    if (is_can_initialized())
+    {
+        if ((mtu == CAN_STD::MTU) || (mtu == CAN_FD::MTU))
+        {
+            const auto send_res = write(get_socket_handle(), &frame, mtu);
+            data_sent = static_cast< std::int8_t >(send_res);
+
+            if (data_sent <= 0)
             {
-                data_ref[i] = frame.data[i];
+                std::cerr << "Sending CAN frame failed with error number: "
+                          << errno << "\n";
+                // store the transport layer error number, other layers may
+                // access to do an advanced and application specific error
+                // handling.
+                SetErrorNumber(errno);
+                data_sent = -1;
             }
         }
         else
         {
-            // Error or timeout.
-            can_received = -1;
+            SetErrorNumber(EINVAL);
+        }
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t CanSocket::receive(struct canfd_frame& frame) noexcept
+{
+    std::int8_t can_received{-1};
+
+    if (is_can_initialized() && (receive_mode_ != CanReceiveMode::BLOCKING))
+    {
+        can_received = receive_polling(frame);
+    }
+    else if (is_can_initialized() == true)
+    {
+        // the size read tells whether this is a standard or CAN FD frame.
+        const ssize_t nbytes = read(get_socket_handle(), &frame, CAN_FD::MTU);
+
+        if (nbytes > 0)
+        {
+            can_received = static_cast< std::int8_t >(nbytes);
+        }
+        else
+        {
             last_error_ = errno;
-            std::cerr << "Receive failed: " << errno << "\n";
+            can_received = -1;
         }
     }
 
@@ -86,58 +243,91 @@ std::int8_t CanSocket::receive(CanIDType& can_id, CanFDData& data_ref) noexcept
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template < typename Duration >
-std::int8_t CanSocket::receive(CanIDType& can_id, CanFDData& data_ref,
-                               const Duration&& deadline) noexcept
+std::int8_t CanSocket::receive(struct canfd_frame& frame,
+                               CanFrameInfo& info) noexcept
 {
-    // Complete length of the CAN frame received
     std::int8_t can_received{-1};
 
-    if (is_can_initialized())
+    if (is_can_initialized() == true)
     {
-        // before we go in a blocking read, we will check if there is
-        // activity on the socket.
-        bool event = wait_for(deadline);
+        struct iovec iov;
+        iov.iov_base = &frame;
+        iov.iov_len = CAN_FD::MTU;
+        // room for the kernel timestamp
+        std::array< char, CMSG_SPACE(sizeof(struct timespec)) > control;
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1U;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        const ssize_t nbytes = recvmsg(get_socket_handle(), &msg, 0);
 
-        // check the return value of the select. if there is data to read the
-        // return value of select will be greater than zero.
-        if (event > 0)
+        if (nbytes > 0)
         {
-            struct can_frame frame;
-            const auto handle = get_socket_handle();
-            const auto nbytes = read(handle, &frame, can_mtu_);
             can_received = static_cast< std::int8_t >(nbytes);
+            info.size = can_received;
+            info.confirmed = ((msg.msg_flags & MSG_CONFIRM) != 0);
+            info.kernel_timestamp = false;
 
-            // check if the read from the socket was successful
-            if (can_received > 0)
+            for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+                 cmsg = CMSG_NXTHDR(&msg, cmsg))
             {
-                // The id is stored in the var given by ref.
-                can_id = frame.can_id;
-                // Set the DLC of the CAN frame as return.
-                can_received = (std::int8_t)frame.can_dlc;
-
-                // Transfer the byte stream into the data structure given by
-                // ref.
-                for (std::uint8_t i = 0U; i < frame.can_dlc; ++i)
+                if ((cmsg->cmsg_level == SOL_SOCKET) &&
+                    (cmsg->cmsg_type == SCM_TIMESTAMPNS))
                 {
-                    // Obviously copying data.
-                    data_ref[i] = frame.data[i];
+                    std::memcpy(&info.timestamp, CMSG_DATA(cmsg),
+                                sizeof(info.timestamp));
+                    info.kernel_timestamp = true;
                 }
             }
-            else if (can_received == 0)
-            {
-                // Timeout on zero return
-                std::cerr << "Timeout reached\n";
-                last_error_ = errno;
-                can_received = 0;
-            }
-            else
+
+            // no timestamp from the kernel: the best we have is now.
+            if (info.kernel_timestamp == false)
             {
-                std::cerr << "Receive failed: " << errno << "\n";
-                last_error_ = errno;
-                can_received = -1;
+                clock_gettime(CLOCK_REALTIME, &info.timestamp);
             }
         }
+        else
+        {
+            last_error_ = errno;
+            can_received = -1;
+        }
+    }
+
+    return can_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t CanSocket::receive(CanIDType& can_id, CanFDData& data_ref) noexcept
+{
+    // Complete length of the CAN frame received
+    std::int8_t can_received{-1};
+
+    if (is_can_initialized() == true)
+    {
+        struct canfd_frame frame;
+        const auto nbytes = receive(frame);
+
+        // Check if data is on the socket to receive
+        if (nbytes > 0)
+        {
+            // The id is stored in the var given by ref.
+            can_id = frame.can_id;
+            // Give the data length code to the return val.
+            can_received = static_cast< std::int8_t >(frame.len);
+            // Limit the maximum length
+            const auto data_len = std::min(
+                static_cast< std::size_t >(frame.len), data_ref.size());
+            // Transfer the byte stream into the data structure given by ref.
+            std::memcpy(data_ref.data(), frame.data, data_len);
+        }
+        else
+        {
+            // Error or timeout.
+            can_received = -1;
+            std::cerr << "Receive failed: " << errno << "\n";
+        }
     }
 
     return can_received;
@@ -177,7 +367,12 @@ bool CanSocket::enable_canfd() noexcept
         // get the mtu of the CAN device configured
         const auto mtu = ifr_.ifr_mtu;
 
+        // CAN XL interfaces are able to send CAN FD frames as well.
+#ifdef CANXL_MTU
+        if ((mtu == CANFD_MTU) || (mtu >= static_cast< int >(CANXL_MIN_MTU)))
+#else
         if (mtu == CANFD_MTU)
+#endif
         {
             static constexpr int CANFD_FLAG{1};
             const auto option_set =
@@ -199,6 +394,328 @@ bool CanSocket::enable_canfd() noexcept
     return enabled;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+bool CanSocket::enable_recv_own_msgs(const bool enable) noexcept
+{
+    bool enabled{false};
+    const int flag = enable ? 1 : 0;
+    const auto option_set = setsockopt(get_socket_handle(), SOL_CAN_RAW,
+                                       CAN_RAW_RECV_OWN_MSGS, &flag,
+                                       sizeof(flag));
+
+    if (option_set >= 0)
+    {
+        enabled = true;
+    }
+    else
+    {
+        last_error_ = errno;
+        enabled = false;
+    }
+
+    return enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanSocket::enable_timestamps() noexcept
+{
+    bool enabled{false};
+    static constexpr int TIMESTAMP_FLAG{1};
+    const auto option_set =
+        setsockopt(get_socket_handle(), SOL_SOCKET, SO_TIMESTAMPNS,
+                   &TIMESTAMP_FLAG, sizeof(TIMESTAMP_FLAG));
+
+    if (option_set >= 0)
+    {
+        enabled = true;
+    }
+    else
+    {
+        last_error_ = errno;
+        enabled = false;
+    }
+
+    return enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanSocket::set_receive_mode(
+    const CanReceiveMode mode,
+    const std::chrono::microseconds idle_budget) noexcept
+{
+    const bool polling = (mode != CanReceiveMode::BLOCKING);
+    const bool mode_set = set_blocking(polling == false);
+
+    if (mode_set == true)
+    {
+        // the kernel option is a bonus: vcan has nothing to poll and raising
+        // it above net.core.busy_read needs CAP_NET_ADMIN.
+        const int busy_poll_us = polling ? CAN_POLL::KERNEL_BUSY_POLL_US : 0;
+        static_cast< void >(setsockopt(get_socket_handle(), SOL_SOCKET,
+                                       SO_BUSY_POLL, &busy_poll_us,
+                                       sizeof(busy_poll_us)));
+        receive_mode_ = mode;
+        idle_budget_ = idle_budget;
+        poll_stats_ = CanPollStats{};
+        last_receive_ = std::chrono::steady_clock::time_point{};
+    }
+
+    return mode_set;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t CanSocket::receive_polling(struct canfd_frame& frame) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+    std::int8_t can_received{-1};
+    const Clock::time_point start = Clock::now();
+    bool waiting = true;
+    bool blocked = false;
+
+    if (last_receive_ != Clock::time_point{})
+    {
+        poll_stats_.work_time += start - last_receive_;
+    }
+
+    while (waiting)
+    {
+        const ssize_t nbytes = read(get_socket_handle(), &frame, CAN_FD::MTU);
+
+        if (nbytes > 0)
+        {
+            can_received = static_cast< std::int8_t >(nbytes);
+            ++(blocked ? poll_stats_.blocked_frames : poll_stats_.spin_frames);
+            waiting = false;
+        }
+        else if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            last_error_ = errno;
+            waiting = false;
+        }
+        else if (blocked || ((receive_mode_ == CanReceiveMode::ADAPTIVE) &&
+                             ((Clock::now() - start) >= idle_budget_)))
+        {
+            if (blocked == false)
+            {
+                // the bus is idle: give the core back until the next frame.
+                poll_stats_.spin_time += Clock::now() - start;
+                blocked = true;
+            }
+
+            struct pollfd event;
+            event.fd = get_socket_handle();
+            event.events = POLLIN;
+            event.revents = 0;
+
+            if ((poll(&event, 1U, -1) < 0) && (errno != EINTR))
+            {
+                last_error_ = errno;
+                waiting = false;
+            }
+        }
+    }
+
+    last_receive_ = Clock::now();
+
+    if (blocked == false)
+    {
+        poll_stats_.spin_time += last_receive_ - start;
+    }
+
+    return can_received;
+}
+
+#ifdef CANXL_MTU
+////////////////////////////////////////////////////////////////////////////////
+bool CanSocket::enable_canxl() noexcept
+{
+    bool enabled{false};
+    const auto socket = get_socket_handle();
+    const int info = ioctl(socket, SIOCGIFMTU, &ifr_);
+
+    // the MTU of a CAN XL capable device is at least header + 64 bytes.
+    if ((info >= 0) && (ifr_.ifr_mtu >= static_cast< int >(CANXL_MIN_MTU)))
+    {
+        static constexpr int CANXL_FLAG{1};
+        const auto option_set =
+            setsockopt(socket, SOL_CAN_RAW, CAN_RAW_XL_FRAMES, &CANXL_FLAG,
+                       sizeof(CANXL_FLAG));
+
+        if (option_set >= 0)
+        {
+            enabled = true;
+        }
+        else
+        {
+            last_error_ = errno;
+            enabled = false;
+        }
+    }
+
+    return enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanSocket::set_canxl_vcid(const std::uint8_t tx_vcid,
+                               const std::uint8_t rx_vcid,
+                               const std::uint8_t rx_vcid_mask) noexcept
+{
+    bool vcid_set{false};
+    struct can_raw_vcid_options options;
+    std::memset(&options, 0, sizeof(options));
+    options.flags = CAN_RAW_XL_VCID_TX_SET | CAN_RAW_XL_VCID_RX_FILTER;
+    options.tx_vcid = tx_vcid;
+    options.rx_vcid = rx_vcid;
+    options.rx_vcid_mask = rx_vcid_mask;
+    const auto option_set =
+        setsockopt(get_socket_handle(), SOL_CAN_RAW, CAN_RAW_XL_VCID_OPTS,
+                   &options, sizeof(options));
+
+    if (option_set >= 0)
+    {
+        vcid_set = true;
+    }
+    else
+    {
+        last_error_ = errno;
+        vcid_set = false;
+    }
+
+    return vcid_set;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t CanSocket::send(const CanXLFrame& frame) noexcept
+{
+    std::int16_t data_sent{-1};
+
+    // the kernel drops frames without the XL flag or with a length out of
+    // range. Tell the caller instead of writing rubbish.
+    if ((canxl_is_xl(frame) == false) || (frame.len < CAN_XL::MIN_DATA_LEN) ||
+        (frame.len > CAN_XL::DATA_LEN))
+    {
+        SetErrorNumber(EINVAL);
+    }
+    else if (is_can_initialized())
+    {
+        const auto send_res =
+            write(get_socket_handle(), &frame, frame_size(frame));
+        data_sent = static_cast< std::int16_t >(send_res);
+
+        if (data_sent <= 0)
+        {
+            SetErrorNumber(errno);
+            data_sent = -1;
+        }
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t CanSocket::receive(CanXLFrame& frame) noexcept
+{
+    std::int16_t can_received{-1};
+
+    if (is_can_initialized())
+    {
+        const ssize_t nbytes = read(get_socket_handle(), &frame, CANXL_MTU);
+
+        if (nbytes > 0)
+        {
+            // standard and CAN FD frames may be read on CAN XL sockets, too.
+            // The size tells them apart like receive() of a CAN FD frame.
+            can_received = static_cast< std::int16_t >(nbytes);
+        }
+        else
+        {
+            last_error_ = errno;
+            can_received = -1;
+        }
+    }
+
+    return can_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CanSocket::send_batch(const CanXLFrame* frames,
+                          const std::size_t count) noexcept
+{
+    int sent{-1};
+
+    if (is_can_initialized())
+    {
+        sent = send_frames(get_socket_handle(), frames, count);
+
+        if (sent < 0)
+        {
+            last_error_ = errno;
+        }
+    }
+
+    return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CanSocket::receive_batch(CanXLFrame* frames,
+                             const std::size_t count,
+                             std::size_t* sizes) noexcept
+{
+    int received{-1};
+
+    if (is_can_initialized())
+    {
+        received = receive_frames(get_socket_handle(), frames, count, sizes);
+
+        if (received < 0)
+        {
+            last_error_ = errno;
+        }
+    }
+
+    return received;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+int CanSocket::send_batch(const struct canfd_frame* frames,
+                          const std::size_t count) noexcept
+{
+    int sent{-1};
+
+    if (is_can_initialized())
+    {
+        sent = send_frames(get_socket_handle(), frames, count);
+
+        if (sent < 0)
+        {
+            last_error_ = errno;
+        }
+    }
+
+    return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CanSocket::receive_batch(struct canfd_frame* frames,
+                             const std::size_t count,
+                             std::size_t* sizes) noexcept
+{
+    int received{-1};
+
+    if (is_can_initialized())
+    {
+        received = receive_frames(get_socket_handle(), frames, count, sizes);
+
+        if (received < 0)
+        {
+            last_error_ = errno;
+        }
+    }
+
+    return received;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 bool CanSocket::bind_if_socket() noexcept
 {
@@ -44,12 +44,15 @@
 #include "Socket.h" // uses sockets under Linux
 #include <array>    // rx, tx
 #include <cassert>
+#include <chrono>          // idle budget of the busy-poll receive
 #include <cstring>         // strcopy for interface name
 #include <linux/can.h>     // sockaddr structure, protocols and can_filter
 #include <linux/can/raw.h> // filtering
 #include <net/if.h>        // interface name
 #include <sys/ioctl.h>     // blocking / non-blocking
+#include <time.h>          // timestamps of frames received
 #include <unistd.h>        // write and read for CAN interface
+#include <utility>         // forwarding the deadline
 
 /**
  * \brief Defining a struct that holds informations about standard CAN frames.
@@ -58,6 +61,8 @@ struct CAN_STD
 {
     // the standard CAN frame contains a total maximum of 8 bytes of user data.
     static constexpr std::size_t DATA_LEN{8U};
+    // number of bytes a standard CAN frame occupies on the socket.
+    static constexpr std::size_t MTU{CAN_MTU};
 };
 
 /**
@@ -67,6 +72,56 @@ struct CAN_FD
 {
     // A CAN FD frame contains a total maximum of 64 bytes of user data.
     static constexpr std::size_t DATA_LEN{64U};
+    // number of bytes a CAN FD frame occupies on the socket.
+    static constexpr std::size_t MTU{CANFD_MTU};
+};
+
+/**
+ * \brief Defining a struct that holds informations about batched I/O.
+ */
+struct CAN_BATCH
+{
+    // Maximum number of frames handed to the kernel with one system call.
+    static constexpr std::size_t MAX_FRAMES{32U};
+};
+
+/**
+ * \brief Defining a struct that holds informations about busy-polling.
+ */
+struct CAN_POLL
+{
+    // time an adaptive receive spins before it waits blocking.
+    static constexpr std::chrono::microseconds DEFAULT_IDLE_BUDGET{100};
+    // time the kernel polls the driver per read (SO_BUSY_POLL) in us.
+    static constexpr int KERNEL_BUSY_POLL_US{50};
+};
+
+/**
+ * \brief How receive() waits for the next frame.
+ */
+enum class CanReceiveMode : std::uint8_t
+{
+    BLOCKING = 0U,  ///< sleeps in read() until a frame arrives.
+    BUSY_POLL = 1U, ///< spins on a non-blocking read(), never sleeps.
+    ADAPTIVE = 2U   ///< spins for the idle budget, then sleeps.
+};
+
+/**
+ * \brief Where the time of a busy-polling receiver goes.
+ */
+struct CanPollStats
+{
+    /// time spent spinning without a frame.
+    std::chrono::nanoseconds spin_time{0};
+
+    /// time between the receive calls: the work done with the frames.
+    std::chrono::nanoseconds work_time{0};
+
+    /// frames found while spinning.
+    std::uint64_t spin_frames{0U};
+
+    /// frames received after the idle budget ran out.
+    std::uint64_t blocked_frames{0U};
 };
 
 /// Forward type. You may use these types to declare data packets to send and
@@ -76,6 +131,145 @@ using CanStdData = CanDataType;
 using CanFDData = std::array< std::uint8_t, CAN_FD::DATA_LEN >;
 using CanIDType = canid_t;
 
+/**
+ * \brief Additional information about a frame received.
+ */
+struct CanFrameInfo
+{
+    /// number of bytes read: CAN_STD::MTU or CAN_FD::MTU.
+    std::int8_t size;
+
+    /// true if this is a frame this socket has sent itself and the
+    /// interface confirmed the transmission (MSG_CONFIRM).
+    bool confirmed;
+
+    /// true if the timestamp is taken by the kernel, false if it is taken
+    /// after the read.
+    bool kernel_timestamp;
+
+    /// receive time of the frame (CLOCK_REALTIME).
+    struct timespec timestamp;
+};
+
+/**
+ * \brief Checks if the frame has an extended 29 bit CAN ID (EFF).
+ */
+inline bool can_is_eff(const struct canfd_frame& frame) noexcept
+{
+    return (frame.can_id & CAN_EFF_FLAG) != 0U;
+}
+
+/**
+ * \brief Checks if the frame is a remote transmission request (RTR).
+ */
+inline bool can_is_rtr(const struct canfd_frame& frame) noexcept
+{
+    return (frame.can_id & CAN_RTR_FLAG) != 0U;
+}
+
+/**
+ * \brief Checks if the frame is an error message frame (ERR).
+ */
+inline bool can_is_err(const struct canfd_frame& frame) noexcept
+{
+    return (frame.can_id & CAN_ERR_FLAG) != 0U;
+}
+
+/**
+ * \brief Gets the CAN ID without the EFF, RTR and ERR flags.
+ */
+inline CanIDType can_get_id(const struct canfd_frame& frame) noexcept
+{
+    return can_is_eff(frame) ? (frame.can_id & CAN_EFF_MASK)
+                             : (frame.can_id & CAN_SFF_MASK);
+}
+
+/**
+ * \brief Checks if the data phase of a CAN FD frame uses the bit rate
+ * switch (BRS).
+ */
+inline bool canfd_is_brs(const struct canfd_frame& frame) noexcept
+{
+    return (frame.flags & CANFD_BRS) != 0U;
+}
+
+/**
+ * \brief Checks if the error state indicator of a CAN FD frame is set (ESI).
+ */
+inline bool canfd_is_esi(const struct canfd_frame& frame) noexcept
+{
+    return (frame.flags & CANFD_ESI) != 0U;
+}
+
+#ifndef CANFD_FDF
+// marks a CAN FD frame, part of the kernel headers since Linux 5.14.
+#define CANFD_FDF 0x04
+#endif
+
+/**
+ * \brief The number of bytes a frame occupies on the socket: a frame of up to
+ * 8 bytes without the flags CANFD_FDF, CANFD_BRS and CANFD_ESI is a standard
+ * frame (CAN_STD::MTU), all others are CAN FD frames (CAN_FD::MTU). Set
+ * CANFD_FDF to send a CAN FD frame of up to 8 bytes.
+ */
+inline std::size_t can_get_mtu(const struct canfd_frame& frame) noexcept
+{
+    constexpr std::uint8_t fd_flags = CANFD_FDF | CANFD_BRS | CANFD_ESI;
+    const bool standard =
+        (frame.len <= CAN_STD::DATA_LEN) && ((frame.flags & fd_flags) == 0U);
+    return standard ? CAN_STD::MTU : CAN_FD::MTU;
+}
+
+#ifdef CANXL_MTU
+/**
+ * \brief Defining a struct that holds informations about CAN XL frames.
+ * \remarks CAN XL needs kernel headers of Linux 6.2 or newer.
+ */
+struct CAN_XL
+{
+    // A CAN XL frame contains 1 up to 2048 bytes of user data.
+    static constexpr std::size_t MIN_DATA_LEN{CANXL_MIN_DLEN};
+    static constexpr std::size_t DATA_LEN{CANXL_MAX_DLEN};
+    // The virtual CAN network ID (VCID) is stored in bits 16..23 of the
+    // priority field.
+    static constexpr std::uint32_t VCID_OFFSET{16U};
+    static constexpr std::uint32_t VCID_MASK{0xFFU};
+};
+
+/// A CAN XL frame is sent and received as it is. Set prio, sdt (SDU type),
+/// af (acceptance field), len and data.
+using CanXLFrame = struct canxl_frame;
+
+/**
+ * \brief Sets the virtual CAN network ID of a CAN XL frame.
+ * \param[in,out] frame the frame to modify.
+ * \param[in] vcid the virtual CAN network ID.
+ */
+inline void canxl_set_vcid(CanXLFrame& frame, const std::uint8_t vcid) noexcept
+{
+    frame.prio &= ~(CAN_XL::VCID_MASK << CAN_XL::VCID_OFFSET);
+    frame.prio |= static_cast< canid_t >(vcid) << CAN_XL::VCID_OFFSET;
+}
+
+/**
+ * \brief Gets the virtual CAN network ID of a CAN XL frame.
+ */
+inline std::uint8_t canxl_get_vcid(const CanXLFrame& frame) noexcept
+{
+    return static_cast< std::uint8_t >((frame.prio >> CAN_XL::VCID_OFFSET) &
+                                       CAN_XL::VCID_MASK);
+}
+
+/**
+ * \brief Checks if a frame read from a CAN XL socket is a CAN XL frame. CAN
+ * XL sockets deliver standard and CAN FD frames as well.
+ */
+inline bool canxl_is_xl(const CanXLFrame& frame) noexcept
+{
+    return (frame.flags & CANXL_XLF) != 0U;
+}
+#endif
+
 /**
  * \brief CanSocket is used for sending and receiving standard CAN frames and
  * CAN FD frames.
@@ -90,7 +284,9 @@ class CanSocket : public Socket< CanSocket >
      */
     template < std::size_t N >
     explicit CanSocket(const char (&interface_str)[N]) noexcept
-        : Socket{}, can_init_{false}
+        : Socket{}, can_init_{false}, receive_mode_{CanReceiveMode::BLOCKING},
+          idle_budget_{CAN_POLL::DEFAULT_IDLE_BUDGET}, poll_stats_{},
+          last_receive_{}
     {
         // before we set up the CAN interface, create a socket to send and
         // receive data through.
@@ -175,57 +371,71 @@ class CanSocket : public Socket< CanSocket >
             std::is_same< CanStdData, CANData >::value, struct can_frame,
             struct canfd_frame >::type SelectedFrame;
 
-        // First check if the file descriptor for the socket was initialized
-        // and the interface is up and running.
-        if (is_can_initialized())
-        {
-            // Structure that is given to the POSIX write function.
-            // We have to define CAN-ID, length (DLC) and copy the data to send.
-            struct canfd_frame frame;
-            // clear all to make sure we don't send rubbish.
-            std::memset(&frame, 0, sizeof(SelectedFrame));
-            // set the CAN ID of this message to send
-            frame.can_id = can_id;
-            // check if length is possible for one CAN frame...
-            // limit the length to max DLC of standard CAN or CAN FD
-            frame.len = std::min(static_cast< decltype(data.size()) >(len),
-                                 data.size());
-
-            // copy data into the data field of the frame struct.
-            for (std::uint8_t i = 0U; i < len; ++i)
-            {
-                frame.data[i] = data[i];
-            }
-
-            const auto socket = get_socket_handle();
-            // We need to transmit the size of struct can_frame with a POSIX
-            // write.
-            const auto send_res = write(socket, &frame, sizeof(SelectedFrame));
-            data_sent = static_cast< std::int8_t >(send_res);
-
-            // Check if the desired length was transmitted over the socket.
-            // A maximum of 8 bytes can be transmitted within a CAN message
-            // without using IsoTp.
-            if (data_sent <= 0)
-            {
-                std::cerr << "Sending CAN frame failed with error number: "
-                          << errno << "\n";
-                // store the transport layer error number, other layers may
-                // access to do an advanced and application specific error
-                // handling.
-                SetErrorNumber(errno);
-                data_sent = -1;
-            }
-        }
-        else
-        {
-            // The CAN interface is not initialized correctly.
-            data_sent = -1;
-        }
+        // Structure that is given to the POSIX write function.
+        // We have to define CAN-ID, length (DLC) and copy the data to send.
+        struct canfd_frame frame;
+        frame.can_id = can_id;
+        // check if length is possible for one CAN frame...
+        // limit the length to max DLC of standard CAN or CAN FD
+        frame.len = static_cast< std::uint8_t >(
+            std::min(static_cast< decltype(data.size()) >(len), data.size()));
+        frame.flags = 0U;
+        frame.__res0 = 0U;
+        frame.__res1 = 0U;
+        std::memcpy(frame.data, data.data(), frame.len);
+        // clear the bytes behind the data only to make sure we don't send
+        // rubbish.
+        std::memset(&frame.data[frame.len], 0,
+                    data.size() - static_cast< std::size_t >(frame.len));
+        data_sent = send(frame, sizeof(SelectedFrame));
 
         return data_sent;
     }
 
+    /**
+     * \brief Transmits a caller-owned frame as it is with one write. A frame
+     * of up to 8 bytes without CAN FD flags is sent as a standard CAN frame,
+     * see can_get_mtu().
+     * \param[in] frame the frame to send. The CAN ID may contain the EFF, RTR
+     * and ERR flags, the flags field the CAN FD flags FDF, BRS and ESI.
+     * \return the number of bytes written or -1 on error.
+     */
+    std::int8_t send(const struct canfd_frame& frame) noexcept;
+
+    /**
+     * \brief Transmits a caller-owned frame as it is with one write.
+     * \param[in] frame the frame to send. The CAN ID may contain the EFF, RTR
+     * and ERR flags, the flags field the CAN FD flags BRS and ESI.
+     * \param[in] mtu CAN_FD::MTU to send a CAN FD frame, CAN_STD::MTU to send
+     * a standard CAN frame (the data of a standard frame is limited to 8
+     * bytes).
+     * \return the number of bytes written or -1 on error.
+     */
+    std::int8_t send(const struct canfd_frame& frame,
+                     const std::size_t mtu) noexcept;
+
+    /**
+     * \brief Reads one frame from the socket into a caller-owned frame
+     * without copying (blocking read, or spinning, see set_receive_mode()).
+     * \param[out] frame the frame received. Use the helpers can_is_eff(),
+     * can_is_rtr(), can_is_err(), canfd_is_brs() and canfd_is_esi() to
+     * evaluate the flags.
+     * \return the number of bytes read: CAN_STD::MTU for a standard CAN frame,
+     * CAN_FD::MTU for a CAN FD frame. -1 on error.
+     */
+    std::int8_t receive(struct canfd_frame& frame) noexcept;
+
+    /**
+     * \brief Reads one frame from the socket into a caller-owned frame and
+     * reports whether this is a confirmation of an own transmission and when
+     * it has been received (blocking read).
+     * \param[out] frame the frame received.
+     * \param[out] info size, TX confirmation flag and timestamp of the frame.
+     * \return the number of bytes read or -1 on error.
+     * \see enable_recv_own_msgs(), enable_timestamps()
+     */
+    std::int8_t receive(struct canfd_frame& frame, CanFrameInfo& info) noexcept;
+
     /**
      * \brief Receives a CAN message from the socket and
      * writes the data into an array (blocking read).
@@ -248,7 +458,93 @@ class CanSocket : public Socket< CanSocket >
      */
     template < typename Duration >
     std::int8_t receive(CanIDType& can_id, CanFDData& data_ref,
-                        const Duration&& deadline) noexcept;
+                        const Duration&& deadline) noexcept
+    {
+        // Complete length of the CAN frame received
+        std::int8_t can_received{-1};
+
+        if (is_can_initialized())
+        {
+            // before we go in a blocking read, we will check if there is
+            // activity on the socket.
+            const bool event = wait_for(std::move(deadline));
+
+            if (event)
+            {
+                can_received = receive(can_id, data_ref);
+            }
+            else
+            {
+                // Timeout on zero return
+                can_received = 0;
+            }
+        }
+
+        return can_received;
+    }
+
+    /**
+     * \brief Transmits a number of standard and CAN FD frames with one system
+     * call (sendmmsg). More than CAN_BATCH::MAX_FRAMES frames are split up
+     * into several calls.
+     * \param[in] frames the frames to send. Each goes out as a standard or a
+     * CAN FD frame, see can_get_mtu().
+     * \param[in] count number of frames.
+     * \return the number of frames sent or -1 if nothing was sent.
+     */
+    int send_batch(const struct canfd_frame* frames,
+                   const std::size_t count) noexcept;
+
+    /**
+     * \brief Receives up to count standard and CAN FD frames with one system
+     * call (recvmmsg). Waits for the first frame if the socket is blocking,
+     * then takes all frames pending without waiting.
+     * \param[out] frames the frames received.
+     * \param[in] count maximum number of frames to receive.
+     * \param[out] sizes the number of bytes read per frame: CAN_STD::MTU for
+     * a standard frame, CAN_FD::MTU for a CAN FD frame. May be nullptr.
+     * \return the number of frames received or -1 on error.
+     */
+    int receive_batch(struct canfd_frame* frames, const std::size_t count,
+                      std::size_t* sizes = nullptr) noexcept;
+
+#ifdef CANXL_MTU
+    /**
+     * \brief Transmits one CAN XL frame. Only the header and the len bytes of
+     * payload are written to the socket.
+     * \param[in] frame the frame to send. The flag CANXL_XLF must be set and
+     * the length must be within 1 .. 2048 bytes.
+     * \return the number of bytes written or -1 on error.
+     * \remarks You must call enable_canxl() first.
+     */
+    std::int16_t send(const CanXLFrame& frame) noexcept;
+
+    /**
+     * \brief Receives one frame from a CAN XL socket (blocking read).
+     * \param[out] frame the frame received. Check canxl_is_xl(), standard
+     * and CAN FD frames are read into it as well.
+     * \return the number of bytes read: CAN_STD::MTU or CAN_FD::MTU for a
+     * standard or CAN FD frame, CANXL_HDR_SIZE plus the payload length for a
+     * CAN XL frame, -1 on error.
+     */
+    std::int16_t receive(CanXLFrame& frame) noexcept;
+
+    /**
+     * \brief Transmits a number of CAN XL frames with one system call.
+     * \see send_batch(const struct canfd_frame*, const std::size_t)
+     */
+    int send_batch(const CanXLFrame* frames, const std::size_t count) noexcept;
+
+    /**
+     * \brief Receives up to count frames from a CAN XL socket with one system
+     * call. Check canxl_is_xl() for each frame received.
+     * \param[out] sizes the number of bytes read per frame, see
+     * receive(CanXLFrame&). May be nullptr.
+     * \see receive_batch(struct canfd_frame*, const std::size_t, std::size_t*)
+     */
+    int receive_batch(CanXLFrame* frames, const std::size_t count,
+                      std::size_t* sizes = nullptr) noexcept;
+#endif
 
     /**
      * \brief Create a CAN socket / file descriptor to send and receive.
@@ -268,6 +564,66 @@ class CanSocket : public Socket< CanSocket >
      */
     bool enable_canfd() noexcept;
 
+    /**
+     * \brief Receive the frames sent by this socket as soon as the interface
+     * confirms their transmission. These frames are marked as confirmed.
+     * \param[in] enable true to receive own frames, false to turn it off.
+     * \return true if the option is set.
+     */
+    bool enable_recv_own_msgs(const bool enable) noexcept;
+
+    /**
+     * \brief Let the kernel timestamp every frame received (SO_TIMESTAMPNS).
+     * \return true if the option is set.
+     */
+    bool enable_timestamps() noexcept;
+
+    /**
+     * \brief Selects how receive(frame) and receive(can_id, data) wait for a
+     * frame. BUSY_POLL and ADAPTIVE make the socket non-blocking and ask the
+     * kernel to busy-poll the driver as well (SO_BUSY_POLL), if the driver
+     * supports it and the process may set it. Spinning only pays off on an
+     * isolated core, it keeps the core busy all the time.
+     * \param[in] mode the receive mode.
+     * \param[in] idle_budget time an ADAPTIVE receive spins before it waits
+     * blocking for the next frame.
+     * \return true if the mode is set.
+     */
+    bool set_receive_mode(const CanReceiveMode mode,
+                          const std::chrono::microseconds idle_budget =
+                              CAN_POLL::DEFAULT_IDLE_BUDGET) noexcept;
+
+    /**
+     * \brief The current receive mode.
+     */
+    CanReceiveMode get_receive_mode() const noexcept { return receive_mode_; }
+
+    /**
+     * \brief Spinning time against the time spent on the frames since the
+     * receive mode has been set.
+     */
+    const CanPollStats& get_poll_stats() const noexcept { return poll_stats_; }
+
+#ifdef CANXL_MTU
+    /**
+     * \brief Switch to CAN XL mode. Configure the socket to send and receive
+     * CAN XL frames in addition to standard and CAN FD frames.
+     * \return true if the interface is CAN XL capable and the mode is enabled.
+     */
+    bool enable_canxl() noexcept;
+
+    /**
+     * \brief Configures the virtual CAN network ID of this socket.
+     * \param[in] tx_vcid the VCID written into every CAN XL frame sent.
+     * \param[in] rx_vcid the VCID frames received must have.
+     * \param[in] rx_vcid_mask the bits of rx_vcid to compare. Zero accepts
+     * frames of all virtual CAN networks.
+     * \return true if the option is set, false if not supported (Linux 6.9).
+     */
+    bool set_canxl_vcid(const std::uint8_t tx_vcid, const std::uint8_t rx_vcid,
+                        const std::uint8_t rx_vcid_mask) noexcept;
+#endif
+
   private:
     /**
      * \brief Check if the interface exists and is known to the OS.
@@ -311,6 +667,13 @@ class CanSocket : public Socket< CanSocket >
      */
     bool bind_if_socket() noexcept;
 
+    /**
+     * \brief Spins on the non-blocking socket until a frame is read. In the
+     * mode ADAPTIVE it waits blocking once the idle budget is used up.
+     * \return the number of bytes read or -1 on error.
+     */
+    std::int8_t receive_polling(struct canfd_frame& frame) noexcept;
+
     /// Holds the index of the interface in a struct if
     /// the interface exists. Works as a handle for configuration.
     struct ifreq ifr_;
@@ -323,8 +686,17 @@ class CanSocket : public Socket< CanSocket >
     /// not.
     bool can_init_;
 
-    // determine the MTU with the help of the struct on compile-time
-    static constexpr auto can_mtu_ = sizeof(struct canfd_frame);
+    /// how receive() waits for a frame.
+    CanReceiveMode receive_mode_;
+
+    /// time an adaptive receive spins.
+    std::chrono::nanoseconds idle_budget_;
+
+    /// spinning time against work time.
+    CanPollStats poll_stats_;
+
+    /// when the last polling receive returned, the work starts there.
+    std::chrono::steady_clock::time_point last_receive_;
 };
 
 #endif // WIN32 detection
@@ -0,0 +1,265 @@
+/**
+ * \file      CanTxConfirmation.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Confirmation of CAN transmissions and queue-to-bus latency.
+ * \details   Matching confirmations to the frames in flight.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef _WIN32
+#error "SocketCAN for Linux OS only."
+#endif
+#include "CanTxConfirmation.h"
+
+namespace
+{
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Compares two sequence numbers, taking the wrap-around into account.
+ * \return true if sequence a was given before sequence b.
+ */
+bool is_older(const std::uint32_t a, const std::uint32_t b) noexcept
+{
+    return static_cast< std::int32_t >(a - b) < 0;
+}
+} // namespace
+
+// the size of the table may be bound to a reference, so it needs a
+// definition.
+constexpr std::size_t CAN_TX_CONFIRMATION::MAX_IN_FLIGHT;
+
+////////////////////////////////////////////////////////////////////////////////
+CanTxTracker::CanTxTracker() noexcept
+    : in_flight_{}, statistics_{}, sequence_{0U}, lost_{0U}, unmatched_{0U}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanTxTracker::add(const struct canfd_frame& frame,
+                       const struct timespec& queued) noexcept
+{
+    // take a free entry, or the oldest one if all are in use.
+    InFlight* entry = nullptr;
+
+    for (auto& candidate : in_flight_)
+    {
+        if (candidate.used == false)
+        {
+            entry = &candidate;
+            break;
+        }
+
+        if ((entry == nullptr) || is_older(candidate.sequence, entry->sequence))
+        {
+            entry = &candidate;
+        }
+    }
+
+    if (entry->used)
+    {
+        ++lost_;
+    }
+
+    entry->can_id = frame.can_id;
+    entry->len = frame.len;
+    entry->used = true;
+    entry->sequence = sequence_++;
+    entry->queued = queued;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanTxTracker::match(const struct canfd_frame& frame,
+                         const struct timespec& confirmed,
+                         std::chrono::nanoseconds& latency) noexcept
+{
+    InFlight* oldest = nullptr;
+
+    // frames with the same CAN ID are transmitted in order.
+    for (auto& entry : in_flight_)
+    {
+        if (entry.used && (entry.can_id == frame.can_id) &&
+            (entry.len == frame.len) &&
+            ((oldest == nullptr) ||
+             is_older(entry.sequence, oldest->sequence)))
+        {
+            oldest = &entry;
+        }
+    }
+
+    if (oldest != nullptr)
+    {
+        oldest->used = false;
+        const struct timespec& queued = oldest->queued;
+        latency = std::chrono::seconds{confirmed.tv_sec - queued.tv_sec} +
+                  std::chrono::nanoseconds{confirmed.tv_nsec - queued.tv_nsec};
+
+        // the statistics of this CAN ID, or a free slot for a new one.
+        IdStatistics* stats = nullptr;
+
+        for (auto& candidate : statistics_)
+        {
+            if (candidate.used && (candidate.can_id == frame.can_id))
+            {
+                stats = &candidate;
+                break;
+            }
+
+            if ((candidate.used == false) && (stats == nullptr))
+            {
+                stats = &candidate;
+            }
+        }
+
+        if (stats != nullptr)
+        {
+            stats->used = true;
+            stats->can_id = frame.can_id;
+            stats->histogram.add(latency);
+        }
+    }
+    else
+    {
+        ++unmatched_;
+    }
+
+    return oldest != nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const LatencyHistogram*
+CanTxTracker::get_histogram(const CanIDType can_id) const noexcept
+{
+    const LatencyHistogram* histogram = nullptr;
+
+    for (const auto& stats : statistics_)
+    {
+        if (stats.used && (stats.can_id == can_id))
+        {
+            histogram = &stats.histogram;
+            break;
+        }
+    }
+
+    return histogram;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t CanTxTracker::get_in_flight() const noexcept
+{
+    std::size_t in_flight{0U};
+
+    for (const auto& entry : in_flight_)
+    {
+        if (entry.used)
+        {
+            ++in_flight;
+        }
+    }
+
+    return in_flight;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t CanTxTracker::get_lost() const noexcept { return lost_; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t CanTxTracker::get_unmatched() const noexcept
+{
+    return unmatched_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CanTxTracker::print(std::ostream& out) const noexcept
+{
+    for (const auto& stats : statistics_)
+    {
+        if (stats.used)
+        {
+            out << "CAN ID 0x" << std::hex << stats.can_id << std::dec << ": ";
+            stats.histogram.print(out);
+        }
+    }
+
+    out << "in flight: " << get_in_flight() << ", lost: " << lost_
+        << ", unmatched: " << unmatched_ << "\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CanTxConfirmation::CanTxConfirmation(CanSocket& can) noexcept
+    : can_{can}, enabled_{false}, tracker_{}
+{
+    const bool own_msgs = can_.enable_recv_own_msgs(true);
+    // without kernel timestamps the time of the read is taken.
+    can_.enable_timestamps();
+    enabled_ = own_msgs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanTxConfirmation::is_enabled() const noexcept { return enabled_; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t CanTxConfirmation::send(const struct canfd_frame& frame) noexcept
+{
+    return send(frame, can_get_mtu(frame));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t CanTxConfirmation::send(const struct canfd_frame& frame,
+                                    const std::size_t mtu) noexcept
+{
+    // same clock as the kernel timestamps of the confirmation.
+    struct timespec queued;
+    clock_gettime(CLOCK_REALTIME, &queued);
+    const auto sent = can_.send(frame, mtu);
+
+    // a frame that was not queued is never confirmed.
+    if (sent > 0)
+    {
+        tracker_.add(frame, queued);
+    }
+
+    return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CanTxConfirmation::confirm(const struct canfd_frame& frame,
+                                const CanFrameInfo& info) noexcept
+{
+    std::chrono::nanoseconds latency{0};
+
+    if (info.confirmed)
+    {
+        static_cast< void >(tracker_.match(frame, info.timestamp, latency));
+    }
+
+    return info.confirmed;
+}
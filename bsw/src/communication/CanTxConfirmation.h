@@ -0,0 +1,284 @@
+/**
+ * \file      CanTxConfirmation.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Confirmation of CAN transmissions and queue-to-bus latency.
+ * \details   Frames sent are kept in a small in-flight table until the
+ *            interface loops them back as confirmed (CAN_RAW_RECV_OWN_MSGS).
+ *            The time between send and confirmation is collected per CAN ID.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CANTXCONFIRMATION_H_
+#define CANTXCONFIRMATION_H_
+#ifndef _WIN32
+
+#include "CanSocket.h"
+#include "LatencyHistogram.h"
+#include <array>
+#include <chrono>
+
+/**
+ * \brief Defining a struct that holds the sizes of the confirmation tables.
+ */
+struct CAN_TX_CONFIRMATION
+{
+    // number of transmissions waiting for their confirmation.
+    static constexpr std::size_t MAX_IN_FLIGHT{32U};
+    // number of CAN IDs a latency histogram is kept for.
+    static constexpr std::size_t MAX_IDS{16U};
+};
+
+/**
+ * \brief CanTxTracker keeps the frames sent until they are confirmed and
+ * collects the latency from the send call until the confirmation in a
+ * histogram per CAN ID. It does not need a socket, see CanTxConfirmation.
+ */
+class CanTxTracker
+{
+  public:
+    /**
+     * \brief Creates empty tables.
+     */
+    CanTxTracker() noexcept;
+
+    /**
+     * \brief Remembers a frame sent. If the table is full, the oldest frame
+     * is dropped and counted as lost.
+     * \param[in] frame the frame sent.
+     * \param[in] queued the time of the send call (CLOCK_REALTIME).
+     */
+    void add(const struct canfd_frame& frame,
+             const struct timespec& queued) noexcept;
+
+    /**
+     * \brief Looks up the oldest frame in flight with the CAN ID and length
+     * of the confirmation, removes it and adds the latency to the statistics
+     * of the CAN ID. A confirmation without a frame is counted as unmatched.
+     * \param[in] frame the confirmation received.
+     * \param[in] confirmed the time of the confirmation.
+     * \param[out] latency from the send call until the confirmation.
+     * \return true if a frame matched.
+     */
+    bool match(const struct canfd_frame& frame,
+               const struct timespec& confirmed,
+               std::chrono::nanoseconds& latency) noexcept;
+
+    /**
+     * \brief The latency histogram of one CAN ID.
+     * \param[in] can_id the CAN ID as it is sent, including flags.
+     * \return the histogram or nullptr if nothing was confirmed for this ID.
+     */
+    const LatencyHistogram* get_histogram(const CanIDType can_id) const
+        noexcept;
+
+    /**
+     * \brief Number of frames waiting for their confirmation.
+     */
+    std::size_t get_in_flight() const noexcept;
+
+    /**
+     * \brief Number of frames dropped from the in-flight table without
+     * confirmation, because the table was full.
+     */
+    std::uint32_t get_lost() const noexcept;
+
+    /**
+     * \brief Number of confirmations without a matching frame.
+     */
+    std::uint32_t get_unmatched() const noexcept;
+
+    /**
+     * \brief Prints the latency histograms of all CAN IDs.
+     */
+    void print(std::ostream& out) const noexcept;
+
+  private:
+    /**
+     * \brief A frame sent and not confirmed yet.
+     */
+    struct InFlight
+    {
+        CanIDType can_id;
+        std::uint8_t len;
+        bool used;
+        // to find the oldest of several frames with the same CAN ID.
+        std::uint32_t sequence;
+        struct timespec queued;
+    };
+
+    /**
+     * \brief The latency statistics of one CAN ID.
+     */
+    struct IdStatistics
+    {
+        CanIDType can_id;
+        bool used;
+        LatencyHistogram histogram;
+    };
+
+    /// frames waiting for their confirmation.
+    std::array< InFlight, CAN_TX_CONFIRMATION::MAX_IN_FLIGHT > in_flight_;
+
+    /// latency statistics per CAN ID.
+    std::array< IdStatistics, CAN_TX_CONFIRMATION::MAX_IDS > statistics_;
+
+    /// sequence number of the next frame sent.
+    std::uint32_t sequence_;
+
+    /// frames dropped without confirmation.
+    std::uint32_t lost_;
+
+    /// confirmations without a frame.
+    std::uint32_t unmatched_;
+};
+
+/**
+ * \brief CanTxConfirmation sends frames over a CanSocket and matches the
+ * confirmations of the interface to the frames sent. The latency from the
+ * send call until the frame has been on the bus is collected in a histogram
+ * per CAN ID.
+ * \remarks On real controllers the confirmation is looped back after the
+ * frame has been transmitted on the bus. The kernel timestamp of the
+ * confirmation is used if available.
+ */
+class CanTxConfirmation
+{
+  public:
+    /**
+     * \brief Enables receiving own messages and kernel timestamps on the
+     * socket.
+     * \param[in] can the socket to send with and receive confirmations from.
+     */
+    explicit CanTxConfirmation(CanSocket& can) noexcept;
+
+    /**
+     * \brief Checks if the socket options could be set.
+     */
+    bool is_enabled() const noexcept;
+
+    /**
+     * \brief Sends a frame and remembers it until it is confirmed. The MTU
+     * is chosen by can_get_mtu().
+     * \param[in] frame the frame to send.
+     * \return the number of bytes written or -1 on error.
+     */
+    std::int8_t send(const struct canfd_frame& frame) noexcept;
+
+    /**
+     * \brief Sends a frame and remembers it until it is confirmed.
+     * \param[in] frame the frame to send.
+     * \param[in] mtu CAN_FD::MTU or CAN_STD::MTU
+     * \return the number of bytes written or -1 on error.
+     */
+    std::int8_t send(const struct canfd_frame& frame,
+                     const std::size_t mtu) noexcept;
+
+    /**
+     * \brief Give every frame received on the socket to this method. If it
+     * is a confirmation of a frame sent before the handler is called.
+     * \tparam Handler callable with the signature
+     * void(CanIDType can_id, std::chrono::nanoseconds latency).
+     * \param[in] frame the frame received.
+     * \param[in] info the info received with the frame.
+     * \param[in] handler called on a confirmation matching a frame sent.
+     * \return true if the frame was a confirmation, false if it was sent by
+     * another node and must be processed by the application.
+     */
+    template < typename Handler >
+    bool confirm(const struct canfd_frame& frame, const CanFrameInfo& info,
+                 Handler&& handler) noexcept
+    {
+        std::chrono::nanoseconds latency{0};
+
+        if (info.confirmed && tracker_.match(frame, info.timestamp, latency))
+        {
+            handler(frame.can_id, latency);
+        }
+
+        return info.confirmed;
+    }
+
+    /**
+     * \brief Same as above, without a handler. The latency is collected in
+     * the histograms only.
+     */
+    bool confirm(const struct canfd_frame& frame,
+                 const CanFrameInfo& info) noexcept;
+
+    /**
+     * \brief The latency histogram of one CAN ID, see CanTxTracker.
+     */
+    const LatencyHistogram* get_histogram(const CanIDType can_id) const
+        noexcept
+    {
+        return tracker_.get_histogram(can_id);
+    }
+
+    /**
+     * \brief Number of frames waiting for their confirmation.
+     */
+    std::size_t get_in_flight() const noexcept
+    {
+        return tracker_.get_in_flight();
+    }
+
+    /**
+     * \brief Number of frames dropped without confirmation.
+     */
+    std::uint32_t get_lost() const noexcept { return tracker_.get_lost(); }
+
+    /**
+     * \brief Number of confirmations without a matching frame.
+     */
+    std::uint32_t get_unmatched() const noexcept
+    {
+        return tracker_.get_unmatched();
+    }
+
+    /**
+     * \brief Prints the latency histograms of all CAN IDs.
+     */
+    void print(std::ostream& out) const noexcept { tracker_.print(out); }
+
+  private:
+    /// socket to send with.
+    CanSocket& can_;
+
+    /// whether receiving own messages is enabled.
+    bool enabled_;
+
+    /// the frames in flight and the statistics.
+    CanTxTracker tracker_;
+};
+
+#endif // WIN32 detection
+#endif // CANTXCONFIRMATION_H_
@@ -45,16 +45,20 @@
 #else
 #error "Please #define BYTE_ORDER for your system architecture."
 #endif
+#include <cstddef>
+#include <cstdint>
 
 ////////////////////////////////////////////////////////////////////////////////
-template < typename T, size_t Sz > T swap_bytes(const T& val) noexcept;
+template < typename T, std::size_t Sz > T swap_bytes(const T& val) noexcept;
 
 ////////////////////////////////////////////////////////////////////////////////
 /**
  * \brief template specialization to swap an unsigned byte.
  * \return this will only return the byte again.
  */
-template <> inline uint8 swap_bytes< uint8, 1 >(const uint8& val) noexcept
+template <>
+inline std::uint8_t
+swap_bytes< std::uint8_t, 1 >(const std::uint8_t& val) noexcept
 {
     return val;
 }
@@ -64,9 +68,11 @@ template <> inline uint8 swap_bytes< uint8, 1 >(const uint8& val) noexcept
  * \brief template specialization to swap an unsgined word.
  * \return an unsigned word with swapped bytes.
  */
-template <> inline uint16 swap_bytes< uint16, 2U >(const uint16& val) noexcept
+template <>
+inline std::uint16_t
+swap_bytes< std::uint16_t, 2U >(const std::uint16_t& val) noexcept
 {
-    uint16 temp = 0U;
+    std::uint16_t temp = 0U;
     temp = ((val >> 8U) & 0x00FFU);
     temp |= ((val << 8U) & 0xFFFFU);
     return temp;
@@ -77,9 +83,11 @@ template <> inline uint16 swap_bytes< uint16, 2U >(const uint16& val) noexcept
  * \brief template specialization to swap an unsgined word.
  * \return a signed word with swapped bytes.
  */
-template <> inline sint16 swap_bytes< sint16, 2U >(const sint16& val) noexcept
+template <>
+inline std::int16_t
+swap_bytes< std::int16_t, 2U >(const std::int16_t& val) noexcept
 {
-    sint16 temp = 0;
+    std::int16_t temp = 0;
     temp = ((val >> 8) & 0x00FF);
     temp |= ((val << 8) & 0xFFFF);
     return temp;
@@ -92,9 +100,11 @@ template <> inline sint16 swap_bytes< sint16, 2U >(const sint16& val) noexcept
  * \param[in] val the value to byte-swap
  * \return a byte-swapped unsigned double word
  */
-template <> inline uint32 swap_bytes< uint32, 4 >(const uint32& val) noexcept
+template <>
+inline std::uint32_t
+swap_bytes< std::uint32_t, 4 >(const std::uint32_t& val) noexcept
 {
-    uint32 temp{0UL};
+    std::uint32_t temp{0UL};
     temp = ((val >> 24U) & 0x000000FFUL);  // byte 3 to 0
     temp |= ((val << 24U) & 0xFF000000UL); // byte 0 to 3
     temp |= ((val >> 8U) & 0x0000FF00UL);  // byte 2 to 1
@@ -108,9 +118,11 @@ template <> inline uint32 swap_bytes< uint32, 4 >(const uint32& val) noexcept
  * \param[in] val the value to byte-swap
  * \return a byte-swapped unsigned double word
  */
-template <> inline sint32 swap_bytes< sint32, 4 >(const sint32& val) noexcept
+template <>
+inline std::int32_t
+swap_bytes< std::int32_t, 4 >(const std::int32_t& val) noexcept
 {
-    sint32 temp = 0L;
+    std::int32_t temp = 0L;
     temp = ((val >> 24) & 0x000000FFL);  // byte 3 to 0
     temp |= ((val << 24) & 0xFF000000L); // byte 0 to 3
     temp |= ((val >> 8) & 0x0000FF00L);  // byte 2 to 1
@@ -124,9 +136,11 @@ template <> inline sint32 swap_bytes< sint32, 4 >(const sint32& val) noexcept
  * \param[in] val to swap the bytes
  * \return the swapped value
  */
-template <> inline uint64 swap_bytes< uint64, 8 >(const uint64& val) noexcept
+template <>
+inline std::uint64_t
+swap_bytes< std::uint64_t, 8 >(const std::uint64_t& val) noexcept
 {
-    uint64 temp = 0ULL;
+    std::uint64_t temp = 0ULL;
     temp = ((val >> 56U) & 0x00000000000000FFULL);  // byte 7 to 0
     temp |= ((val << 56U) & 0xFF00000000000000ULL); // byte 0 to 7
     temp |= ((val >> 40U) & 0x000000000000FF00ULL); // byte 6 to 1
@@ -144,9 +158,11 @@ template <> inline uint64 swap_bytes< uint64, 8 >(const uint64& val) noexcept
  * \param[in] val to swap the bytes
  * \return the swapped value
  */
-template <> inline sint64 swap_bytes< sint64, 8 >(const sint64& val) noexcept
+template <>
+inline std::int64_t
+swap_bytes< std::int64_t, 8 >(const std::int64_t& val) noexcept
 {
-    sint64 temp = 0LL;
+    std::int64_t temp = 0LL;
     temp = ((val >> 56U) & 0x00000000000000FFULL);  // byte 7 to 0
     temp |= ((val << 56U) & 0xFF00000000000000ULL); // byte 0 to 7
     temp |= ((val >> 40U) & 0x000000000000FF00ULL); // byte 6 to 1
@@ -160,12 +176,13 @@ template <> inline sint64 swap_bytes< sint64, 8 >(const sint64& val) noexcept
 
 ////////////////////////////////////////////////////////////////////////////////
 template <>
-inline float32 swap_bytes< float32, 4 >(const float32& fval) noexcept
+inline float swap_bytes< float, 4 >(const float& fval) noexcept
 {
-    float32 float_swapped{0.0F};
-    float32 temp = fval;
-    uint8* float_to_convert = reinterpret_cast< uint8* >(&temp);
-    uint8* to_convert = reinterpret_cast< uint8* >(&float_swapped);
+    float float_swapped{0.0F};
+    float temp = fval;
+    std::uint8_t* float_to_convert = reinterpret_cast< std::uint8_t* >(&temp);
+    std::uint8_t* to_convert =
+        reinterpret_cast< std::uint8_t* >(&float_swapped);
     to_convert[0] = float_to_convert[3];
     to_convert[1] = float_to_convert[2];
     to_convert[2] = float_to_convert[1];
@@ -175,12 +192,13 @@ inline float32 swap_bytes< float32, 4 >(const float32& fval) noexcept
 
 ////////////////////////////////////////////////////////////////////////////////
 template <>
-inline float64 swap_bytes< float64, 8 >(const float64& fval) noexcept
+inline double swap_bytes< double, 8 >(const double& fval) noexcept
 {
-    float64 float_swapped{0.0};
-    float64 temp = fval;
-    uint8* float_to_convert = reinterpret_cast< uint8* >(&temp);
-    uint8* to_convert = reinterpret_cast< uint8* >(&float_swapped);
+    double float_swapped{0.0};
+    double temp = fval;
+    std::uint8_t* float_to_convert = reinterpret_cast< std::uint8_t* >(&temp);
+    std::uint8_t* to_convert =
+        reinterpret_cast< std::uint8_t* >(&float_swapped);
     to_convert[0] = float_to_convert[7];
     to_convert[1] = float_to_convert[6];
     to_convert[2] = float_to_convert[5];
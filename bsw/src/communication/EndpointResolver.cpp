@@ -0,0 +1,280 @@
+/**
+ * \file      EndpointResolver.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Resolving host names without blocking the caller.
+ * \details   Host names are resolved by a background thread. The results are
+ *            kept in a table with a time to live. Looking up a name reads the
+ *            table only and never waits for DNS.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "EndpointResolver.h"
+#include <arpa/inet.h>
+#include <cstring>
+#include <netdb.h>
+#include <sys/socket.h>
+
+namespace
+{
+/// an entry taken by a lookup, the name is being written.
+constexpr std::uint8_t CLAIMED{0xFFU};
+
+/// nanoseconds per second.
+constexpr std::int64_t NS_PER_SECOND{1000000000};
+
+/// the background thread checks the table at least this often.
+constexpr std::chrono::milliseconds IDLE_WAIT{100};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The steady clock in nanoseconds.
+ */
+std::int64_t now_ns() noexcept
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The state as stored in the table.
+ */
+constexpr std::uint8_t to_raw(const ResolveState state) noexcept
+{
+    return static_cast< std::uint8_t >(state);
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+EndpointResolver::EndpointResolver() noexcept : running_{true}
+{
+    for (Entry& entry : entries_)
+    {
+        entry.state.store(to_raw(ResolveState::EMPTY));
+        entry.name.fill('\0');
+        entry.address.store(0U);
+        entry.expires.store(0);
+        entry.refresh.store(false);
+    }
+
+    // the table is ready before the thread reads it.
+    thread_ = std::thread{&EndpointResolver::run, this};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+EndpointResolver::~EndpointResolver() noexcept
+{
+    running_ = false;
+    wake_.notify_one();
+
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+ResolveState EndpointResolver::lookup(const char* name,
+                                      std::uint32_t& address) noexcept
+{
+    ResolveState state{ResolveState::FAILED};
+    struct in_addr ip;
+
+    if (name == nullptr)
+    {
+        state = ResolveState::FAILED;
+    }
+    else if (inet_pton(AF_INET, name, &ip) == 1)
+    {
+        // an address needs no table.
+        address = ntohl(ip.s_addr);
+        state = ResolveState::RESOLVED;
+    }
+    else
+    {
+        Entry* entry = find(name);
+
+        if (entry != nullptr)
+        {
+            state = static_cast< ResolveState >(
+                entry->state.load(std::memory_order_acquire));
+
+            if (state == ResolveState::RESOLVED)
+            {
+                address = entry->address.load(std::memory_order_relaxed);
+            }
+
+            // the old result is used until the refresh is done.
+            if ((state != ResolveState::PENDING) &&
+                (now_ns() > entry->expires.load(std::memory_order_relaxed)) &&
+                (entry->refresh.exchange(true) == false))
+            {
+                wake_.notify_one();
+            }
+        }
+    }
+
+    return state;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+ResolveState
+EndpointResolver::wait_for(const char* name, std::uint32_t& address,
+                           const std::chrono::milliseconds timeout) noexcept
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    ResolveState state = lookup(name, address);
+
+    while ((state == ResolveState::PENDING) &&
+           (std::chrono::steady_clock::now() < deadline))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        state = lookup(name, address);
+    }
+
+    return state;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+EndpointResolver::Entry* EndpointResolver::find(const char* name) noexcept
+{
+    Entry* found = nullptr;
+    const std::size_t len = std::strlen(name);
+
+    if ((len > 0U) && (len < RESOLVER::MAX_NAME_LEN))
+    {
+        for (Entry& entry : entries_)
+        {
+            const std::uint8_t state =
+                entry.state.load(std::memory_order_acquire);
+
+            if ((state != to_raw(ResolveState::EMPTY)) && (state != CLAIMED) &&
+                (std::strcmp(entry.name.data(), name) == 0))
+            {
+                found = &entry;
+                break;
+            }
+        }
+
+        // an unknown name takes the first free entry. Entries are never
+        // freed, so a name once written does not change.
+        for (std::size_t i = 0U; (found == nullptr) && (i < entries_.size());
+             ++i)
+        {
+            Entry& entry = entries_[i];
+            std::uint8_t expected = to_raw(ResolveState::EMPTY);
+
+            if (entry.state.compare_exchange_strong(expected, CLAIMED))
+            {
+                std::memcpy(entry.name.data(), name, len + 1U);
+                entry.state.store(to_raw(ResolveState::PENDING),
+                                  std::memory_order_release);
+                wake_.notify_one();
+                found = &entry;
+            }
+        }
+    }
+
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void EndpointResolver::run() noexcept
+{
+    while (running_)
+    {
+        for (Entry& entry : entries_)
+        {
+            const std::uint8_t state =
+                entry.state.load(std::memory_order_acquire);
+
+            if ((state == to_raw(ResolveState::PENDING)) ||
+                (((state == to_raw(ResolveState::RESOLVED)) ||
+                  (state == to_raw(ResolveState::FAILED))) &&
+                 entry.refresh.load()))
+            {
+                resolve(entry);
+            }
+        }
+
+        // a lookup may queue a name right before the wait. It is then picked
+        // up after IDLE_WAIT at the latest.
+        std::unique_lock< std::mutex > lock{mutex_};
+        wake_.wait_for(lock, IDLE_WAIT);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void EndpointResolver::resolve(Entry& entry) noexcept
+{
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+
+    // this blocks, but only the background thread.
+    const int error = getaddrinfo(entry.name.data(), nullptr, &hints, &result);
+
+    if ((error == 0) && (result != nullptr))
+    {
+        const auto* addr =
+            reinterpret_cast< const struct sockaddr_in* >(result->ai_addr);
+        entry.address.store(ntohl(addr->sin_addr.s_addr),
+                            std::memory_order_relaxed);
+        entry.expires.store(now_ns() + (RESOLVER::TTL_SECONDS * NS_PER_SECOND),
+                            std::memory_order_relaxed);
+        entry.state.store(to_raw(ResolveState::RESOLVED),
+                          std::memory_order_release);
+    }
+    else
+    {
+        entry.expires.store(now_ns() + (RESOLVER::NEGATIVE_TTL_SECONDS *
+                                        NS_PER_SECOND),
+                            std::memory_order_relaxed);
+
+        // a name resolved before keeps its last address.
+        if (entry.state.load() != to_raw(ResolveState::RESOLVED))
+        {
+            entry.state.store(to_raw(ResolveState::FAILED),
+                              std::memory_order_release);
+        }
+    }
+
+    if (result != nullptr)
+    {
+        freeaddrinfo(result);
+    }
+
+    entry.refresh.store(false);
+}
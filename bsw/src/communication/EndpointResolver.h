@@ -0,0 +1,176 @@
+/**
+ * \file      EndpointResolver.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Resolving host names without blocking the caller.
+ * \details   Host names are resolved by a background thread. The results are
+ *            kept in a table with a time to live. Looking up a name reads the
+ *            table only and never waits for DNS.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENDPOINTRESOLVER_H_
+#define ENDPOINTRESOLVER_H_
+#ifndef _WIN32
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/**
+ * \brief Defining a struct that holds the size of the name table and the
+ * times to live.
+ */
+struct RESOLVER
+{
+    // number of host names in the table.
+    static constexpr std::size_t MAX_ENTRIES{16U};
+    // longest host name plus the terminating zero.
+    static constexpr std::size_t MAX_NAME_LEN{64U};
+    // a resolved address is looked up again after this time in seconds.
+    // getaddrinfo() does not tell the TTL of the DNS record.
+    static constexpr std::int64_t TTL_SECONDS{60};
+    // a failed name is tried again after this time in seconds.
+    static constexpr std::int64_t NEGATIVE_TTL_SECONDS{5};
+};
+
+/**
+ * \brief The state of a name in the table.
+ */
+enum class ResolveState : std::uint8_t
+{
+    EMPTY,    ///< the entry is not used.
+    PENDING,  ///< the name is being resolved.
+    RESOLVED, ///< the address is known.
+    FAILED    ///< the name could not be resolved.
+};
+
+/**
+ * \brief EndpointResolver resolves host names (IP4) with getaddrinfo() on a
+ * background thread. Lookups read the table with atomics only, so real-time
+ * threads may look up names at any time. A name unknown to the table is
+ * queued and the lookup returns ResolveState::PENDING.
+ * An expired address is still returned while it is refreshed, a connection
+ * never waits for DNS.
+ */
+class EndpointResolver
+{
+  public:
+    /**
+     * \brief Starts the background thread.
+     */
+    EndpointResolver() noexcept;
+
+    /**
+     * \brief Stops the background thread.
+     */
+    ~EndpointResolver() noexcept;
+
+    EndpointResolver(const EndpointResolver&) = delete;
+    EndpointResolver& operator=(const EndpointResolver&) = delete;
+
+    /**
+     * \brief Looks up a host name or an IP4 address in dotted notation
+     * without blocking.
+     * \param[in] name the host name or IP4 address.
+     * \param[out] address the IP4 address in host-byte-order if resolved.
+     * \return RESOLVED if the address is valid, PENDING if the name is being
+     * resolved, FAILED if the name could not be resolved or the table is full.
+     */
+    ResolveState lookup(const char* name, std::uint32_t& address) noexcept;
+
+    /**
+     * \brief Waits until a name is resolved. This blocks, use it at start-up
+     * or in threads that may wait only.
+     * \param[in] name the host name or IP4 address.
+     * \param[out] address the IP4 address in host-byte-order if resolved.
+     * \param[in] timeout the maximum time to wait.
+     * \return the state after waiting.
+     */
+    ResolveState wait_for(const char* name, std::uint32_t& address,
+                          const std::chrono::milliseconds timeout) noexcept;
+
+  private:
+    /**
+     * \brief One host name.
+     */
+    struct Entry
+    {
+        /// the state, the name is valid if it is not EMPTY.
+        std::atomic< std::uint8_t > state;
+        /// the host name, written once before the state is set.
+        std::array< char, RESOLVER::MAX_NAME_LEN > name;
+        /// the address in host-byte-order.
+        std::atomic< std::uint32_t > address;
+        /// when the entry expires in ns of the steady clock.
+        std::atomic< std::int64_t > expires;
+        /// true if the background thread shall resolve the name again.
+        std::atomic< bool > refresh;
+    };
+
+    /**
+     * \brief Finds the entry of a name or takes a free one.
+     * \return the entry or nullptr if the table is full.
+     */
+    Entry* find(const char* name) noexcept;
+
+    /**
+     * \brief The loop of the background thread.
+     */
+    void run() noexcept;
+
+    /**
+     * \brief Resolves one entry with getaddrinfo().
+     */
+    void resolve(Entry& entry) noexcept;
+
+    /// the name table.
+    std::array< Entry, RESOLVER::MAX_ENTRIES > entries_;
+
+    /// false to stop the background thread.
+    std::atomic< bool > running_;
+
+    /// protects the sleep of the background thread only.
+    std::mutex mutex_;
+
+    /// wakes up the background thread if a name is queued.
+    std::condition_variable wake_;
+
+    /// the background thread.
+    std::thread thread_;
+};
+
+#endif // WIN32 detection
+#endif // ENDPOINTRESOLVER_H_
@@ -0,0 +1,291 @@
+/**
+ * \file      EventLoop.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Event loop that services sockets by priority class.
+ * \details   Each priority class has its own epoll instance, all of them are
+ *            registered in one epoll instance to wait for any event. This way a
+ *            class can be checked for ready sockets with a single call.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "EventLoop.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+
+////////////////////////////////////////////////////////////////////////////////
+EventLoop::EventLoop() noexcept
+    : sources_{}, class_epoll_{}, epoll_{get_invalid_alias()}, budget_{},
+      handled_{}, sources_per_class_{}, preemptions_{0U}, running_{true},
+      last_error_{0}, ok_{false}
+{
+    budget_.fill(std::uint32_t{EVENT_LOOP::DEFAULT_BUDGET});
+    class_epoll_.fill(get_invalid_alias());
+    epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+    ok_ = (epoll_ >= 0);
+
+    for (std::size_t i = 0U; (i < class_epoll_.size()) && ok_; ++i)
+    {
+        class_epoll_[i] = ::epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast< std::uint32_t >(i);
+        ok_ = (class_epoll_[i] >= 0) &&
+              (::epoll_ctl(epoll_, EPOLL_CTL_ADD, class_epoll_[i], &event) ==
+               0);
+    }
+
+    if (ok_ == false)
+    {
+        last_error_ = errno;
+        std::cerr << "Creating the event loop failed: " << strerror(errno)
+                  << "\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+EventLoop::~EventLoop() noexcept
+{
+    for (const int class_epoll : class_epoll_)
+    {
+        if (class_epoll >= 0)
+        {
+            ::close(class_epoll);
+        }
+    }
+
+    if (epoll_ >= 0)
+    {
+        ::close(epoll_);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool EventLoop::add(const SocketHandleType handle,
+                    const EventPriority priority, EventHandler handler,
+                    void* context) noexcept
+{
+    const std::size_t priority_class = static_cast< std::size_t >(priority);
+    bool added = false;
+
+    if (ok_ && (handler != nullptr) && (priority_class < EVENT_LOOP::CLASSES))
+    {
+        for (std::size_t i = 0U; i < sources_.size(); ++i)
+        {
+            if (sources_[i].handler == nullptr)
+            {
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.u32 = static_cast< std::uint32_t >(i);
+
+                if (::epoll_ctl(class_epoll_[priority_class], EPOLL_CTL_ADD,
+                                handle, &event) == 0)
+                {
+                    sources_[i].handle = handle;
+                    sources_[i].handler = handler;
+                    sources_[i].context = context;
+                    sources_[i].priority = priority_class;
+                    ++sources_per_class_[priority_class];
+                    added = true;
+                }
+                else
+                {
+                    last_error_ = errno;
+                }
+
+                break;
+            }
+        }
+    }
+
+    return added;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool EventLoop::remove(const SocketHandleType handle) noexcept
+{
+    bool removed = false;
+
+    for (EventSource& source : sources_)
+    {
+        if ((source.handler != nullptr) && (source.handle == handle))
+        {
+            // fails if the socket has been closed already, which removes it
+            // from epoll as well.
+            static_cast< void >(::epoll_ctl(class_epoll_[source.priority],
+                                            EPOLL_CTL_DEL, handle, nullptr));
+            --sources_per_class_[source.priority];
+            source = EventSource{};
+            removed = true;
+            break;
+        }
+    }
+
+    return removed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void EventLoop::set_budget(const EventPriority priority,
+                           const std::uint32_t budget) noexcept
+{
+    const std::size_t priority_class = static_cast< std::size_t >(priority);
+
+    if (priority_class < EVENT_LOOP::CLASSES)
+    {
+        budget_[priority_class] = budget;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int EventLoop::run_once(const int timeout_ms) noexcept
+{
+    int calls = -1;
+    std::array< epoll_event, EVENT_LOOP::CLASSES > events;
+    const int ready = ::epoll_wait(epoll_, events.data(),
+                                   static_cast< int >(events.size()),
+                                   timeout_ms);
+
+    if (ready >= 0)
+    {
+        calls = 0;
+
+        // only a wake-up, the classes are checked in order of priority.
+        for (std::size_t i = 0U; (i < EVENT_LOOP::CLASSES) && (ready > 0);
+             ++i)
+        {
+            calls += service(i);
+        }
+    }
+    else if (errno == EINTR)
+    {
+        calls = 0;
+    }
+    else
+    {
+        last_error_ = errno;
+    }
+
+    return calls;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void EventLoop::run() noexcept
+{
+    while (running_ && (run_once(EVENT_LOOP::WAIT_MS) >= 0))
+    {
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void EventLoop::stop() noexcept { running_ = false; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t EventLoop::get_handled(const EventPriority priority) const
+    noexcept
+{
+    const std::size_t priority_class = static_cast< std::size_t >(priority);
+    std::uint64_t handled = 0U;
+
+    if (priority_class < EVENT_LOOP::CLASSES)
+    {
+        handled = handled_[priority_class];
+    }
+
+    return handled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int EventLoop::service(const std::size_t priority) noexcept
+{
+    std::array< epoll_event, EVENT_LOOP::MAX_EVENTS > events;
+    std::uint32_t budget = budget_[priority];
+    int calls = 0;
+
+    while ((budget > 0U) && (sources_per_class_[priority] > 0U))
+    {
+        const std::uint32_t max_events = EVENT_LOOP::MAX_EVENTS;
+        const int ready = ::epoll_wait(
+            class_epoll_[priority], events.data(),
+            static_cast< int >((budget < max_events) ? budget : max_events),
+            0);
+
+        if (ready <= 0)
+        {
+            break;
+        }
+
+        // level-triggered: a socket with data left is reported again by the
+        // next epoll_wait(), behind the other ready sockets.
+        for (int i = 0; i < ready; ++i)
+        {
+            dispatch(events[static_cast< std::size_t >(i)].data.u32);
+            ++calls;
+            --budget;
+
+            // a batch of a lower class is done, the control class first.
+            if ((priority > 0U) && (sources_per_class_[0U] > 0U))
+            {
+                const int control = service(0U);
+
+                if (control > 0)
+                {
+                    calls += control;
+                    ++preemptions_;
+                }
+            }
+        }
+    }
+
+    return calls;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void EventLoop::dispatch(const std::uint32_t index) noexcept
+{
+    EventSource& source = sources_[index];
+
+    // the source may have been removed by a handler of the same batch.
+    if (source.handler != nullptr)
+    {
+        ++handled_[source.priority];
+
+        if (source.handler(source.context) == false)
+        {
+            static_cast< void >(remove(source.handle));
+        }
+    }
+}
+
+#endif // WIN32 detection
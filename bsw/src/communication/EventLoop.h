@@ -0,0 +1,239 @@
+/**
+ * \file      EventLoop.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Event loop that services sockets by priority class.
+ * \details   Sockets are registered with a priority class. Ready sockets of a
+ *            higher class are serviced first, each class has a budget of handler
+ *            calls per iteration. Between the batches of a lower class the loop
+ *            checks the highest class and serves it first.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENTLOOP_H_
+#define EVENTLOOP_H_
+
+#ifndef _WIN32
+
+#include "Socket.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * \brief Defining a struct that holds informations about the event loop.
+ */
+struct EVENT_LOOP
+{
+    // number of sockets in one loop.
+    static constexpr std::size_t MAX_SOURCES{16U};
+    // number of priority classes, see EventPriority.
+    static constexpr std::size_t CLASSES{3U};
+    // handler calls per class and iteration if not set otherwise.
+    static constexpr std::uint32_t DEFAULT_BUDGET{16U};
+    // ready events fetched with one epoll_wait().
+    static constexpr std::size_t MAX_EVENTS{16U};
+    // run() checks for stop() at least this often.
+    static constexpr int WAIT_MS{100};
+};
+
+/**
+ * \brief The priority classes, CONTROL is serviced first.
+ */
+enum class EventPriority : std::uint8_t
+{
+    CONTROL = 0U, ///< e.g. the CAN socket of a control loop.
+    NORMAL = 1U,  ///< everything else.
+    BULK = 2U     ///< e.g. file transfers, logging.
+};
+
+/**
+ * \brief Called if the socket is ready to read. The handler should service
+ * one batch, e.g. one receive, and return. If there is data left the socket
+ * stays ready and the handler is called again.
+ * \param[in] context the pointer given with add().
+ * \return false to remove the socket from the loop, e.g. on an error.
+ */
+using EventHandler = bool (*)(void* context);
+
+/**
+ * \brief Waits for readable sockets with epoll and calls their handlers by
+ * priority class. A burst on bulk sockets can only delay a control socket by
+ * one handler call, because the loop checks the control class between the
+ * handler calls of lower classes.
+ */
+class EventLoop
+{
+  public:
+    /**
+     * \brief Creates one epoll instance per class and one for all classes.
+     */
+    EventLoop() noexcept;
+
+    /**
+     * \brief Closes the epoll instances. The sockets are not closed.
+     */
+    ~EventLoop() noexcept;
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * \brief Registers a socket.
+     * \param[in] socket a TcpSocket, CanSocket or any other Socket.
+     * \param[in] priority the class of the socket.
+     * \param[in] handler called if the socket is readable.
+     * \param[in] context given to the handler.
+     * \return true if registered, false if the loop is full or epoll failed.
+     */
+    template < typename SocketType >
+    bool add(SocketType& socket, const EventPriority priority,
+             EventHandler handler, void* context) noexcept
+    {
+        return add(socket.get_socket(), priority, handler, context);
+    }
+
+    /**
+     * \brief Registers a file descriptor, see above.
+     */
+    bool add(const SocketHandleType handle, const EventPriority priority,
+             EventHandler handler, void* context) noexcept;
+
+    /**
+     * \brief Removes a socket from the loop.
+     * \return true if it was registered.
+     */
+    bool remove(const SocketHandleType handle) noexcept;
+
+    /**
+     * \brief Sets how many handler calls a class gets per iteration. The
+     * control class gets its budget again each time it preempts a lower
+     * class.
+     */
+    void set_budget(const EventPriority priority,
+                    const std::uint32_t budget) noexcept;
+
+    /**
+     * \brief Waits for ready sockets and services them once by priority.
+     * \param[in] timeout_ms maximum time to wait, -1 waits forever.
+     * \return the number of handler calls, -1 on error.
+     */
+    int run_once(const int timeout_ms) noexcept;
+
+    /**
+     * \brief Services the sockets until stop() is called.
+     */
+    void run() noexcept;
+
+    /**
+     * \brief Lets run() return, may be called from any thread.
+     */
+    void stop() noexcept;
+
+    /**
+     * \brief Number of handler calls of a class.
+     */
+    std::uint64_t get_handled(const EventPriority priority) const noexcept;
+
+    /**
+     * \brief How often the control class was serviced between the handler
+     * calls of a lower class.
+     */
+    std::uint64_t get_preemptions() const noexcept { return preemptions_; }
+
+    /**
+     * \brief The last error of epoll.
+     */
+    int get_last_error() const noexcept { return last_error_; }
+
+    /**
+     * \brief true if the epoll instances have been created.
+     */
+    bool is_ok() const noexcept { return ok_; }
+
+  private:
+    /**
+     * \brief A registered socket.
+     */
+    struct EventSource
+    {
+        SocketHandleType handle{get_invalid_alias()};
+        EventHandler handler{nullptr};
+        void* context{nullptr};
+        std::size_t priority{0U};
+    };
+
+    /**
+     * \brief Calls the handlers of the ready sockets of one class until the
+     * budget is used up or no socket is ready anymore.
+     * \return the number of handler calls.
+     */
+    int service(const std::size_t priority) noexcept;
+
+    /**
+     * \brief Calls the handler of a source and removes the source if the
+     * handler asks for it.
+     */
+    void dispatch(const std::uint32_t index) noexcept;
+
+    /// the registered sockets, the index is the epoll user data.
+    std::array< EventSource, EVENT_LOOP::MAX_SOURCES > sources_;
+
+    /// epoll instance with the sockets of each class.
+    std::array< int, EVENT_LOOP::CLASSES > class_epoll_;
+
+    /// epoll instance with the epoll instances of the classes.
+    int epoll_;
+
+    /// handler calls per class and iteration.
+    std::array< std::uint32_t, EVENT_LOOP::CLASSES > budget_;
+
+    /// handler calls per class.
+    std::array< std::uint64_t, EVENT_LOOP::CLASSES > handled_;
+
+    /// registered sockets per class, empty classes are not checked.
+    std::array< std::size_t, EVENT_LOOP::CLASSES > sources_per_class_;
+
+    /// control class serviced in between.
+    std::uint64_t preemptions_;
+
+    /// run() loops while true.
+    std::atomic< bool > running_;
+
+    /// the last errno of epoll.
+    int last_error_;
+
+    /// all epoll instances have been created.
+    bool ok_;
+};
+
+#endif // WIN32 detection
+#endif // EVENTLOOP_H_
@@ -0,0 +1,293 @@
+/**
+ * \file      Gorilla.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Compression of timestamped float series.
+ * \details   GorillaEncoder packs timestamps with delta-of-delta and values with XOR
+ *            encoding into a packet, as the Gorilla time series database does, and
+ *            GorillaDecoder unpacks them.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Gorilla.h"
+#include <array>
+#include <cstring>
+
+namespace
+{
+/**
+ * \brief A range of delta-of-delta values stored with a prefix and a number
+ * of bits.
+ */
+struct DodRange
+{
+    std::uint64_t prefix;
+    std::size_t prefix_bits;
+    std::size_t bits;
+};
+
+/// the ranges of delta-of-delta values that are stored short.
+constexpr std::array< DodRange, 3U > DOD_RANGES{
+    {{0x2U, 2U, 7U}, {0x6U, 3U, 9U}, {0xEU, 4U, 12U}}};
+
+/// the prefix of a delta-of-delta value stored with all bits.
+constexpr std::uint64_t DOD_FULL_PREFIX{0xFU};
+
+/// the bits of a double, and the leading zeros before any XOR was stored.
+constexpr std::size_t VALUE_BITS{64U};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Sign-extends a value of some bits to 64 bits.
+ */
+std::uint64_t sign_extend(const std::uint64_t value,
+                          const std::size_t bits) noexcept
+{
+    const std::uint64_t sign = std::uint64_t{1U} << (bits - 1U);
+    return (value ^ sign) - sign;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Finds the shortest range of a delta-of-delta value.
+ * \return the range, DOD_RANGES.size() if it needs all bits.
+ */
+std::size_t find_range(const std::uint64_t dod) noexcept
+{
+    const auto value = static_cast< std::int64_t >(dod);
+    std::size_t range = 0U;
+
+    for (; range < DOD_RANGES.size(); ++range)
+    {
+        const std::int64_t limit = std::int64_t{1}
+                                   << (DOD_RANGES[range].bits - 1U);
+
+        if ((value >= -limit) && (value < limit))
+        {
+            break;
+        }
+    }
+
+    return range;
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+GorillaEncoder::GorillaEncoder(PacketView& packet) noexcept
+    : writer_{packet}, timestamp_{0U}, delta_{0U}, value_{0U},
+      leading_{VALUE_BITS}, trailing_{VALUE_BITS}, count_{0U}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GorillaEncoder::append(const std::uint64_t timestamp,
+                            const double value) noexcept
+{
+    std::uint64_t bits = 0U;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    if (count_ == 0U)
+    {
+        if (writer_.get_free_bits() < (2U * GORILLA::FIRST_BITS))
+        {
+            return false;
+        }
+
+        writer_.write(timestamp, GORILLA::FIRST_BITS);
+        writer_.write(bits, GORILLA::FIRST_BITS);
+        timestamp_ = timestamp;
+        value_ = bits;
+        ++count_;
+        return true;
+    }
+
+    // the sizes first, so a point is written completely or not at all.
+    const std::uint64_t delta = timestamp - timestamp_;
+    const std::uint64_t dod = delta - delta_;
+    const std::size_t range = find_range(dod);
+    std::size_t time_bits = 1U;
+
+    if (dod != 0U)
+    {
+        time_bits = (range < DOD_RANGES.size())
+                        ? (DOD_RANGES[range].prefix_bits +
+                           DOD_RANGES[range].bits)
+                        : (4U + VALUE_BITS);
+    }
+
+    const std::uint64_t xored = bits ^ value_;
+    std::size_t leading = 0U;
+    std::size_t trailing = 0U;
+    bool reuse = false;
+    std::size_t value_bits = 1U;
+
+    if (xored != 0U)
+    {
+        leading = static_cast< std::size_t >(__builtin_clzll(xored));
+        leading = (leading > GORILLA::MAX_LEADING) ? GORILLA::MAX_LEADING
+                                                   : leading;
+        trailing = static_cast< std::size_t >(__builtin_ctzll(xored));
+        reuse = (leading >= leading_) && (trailing >= trailing_);
+        value_bits = reuse ? (2U + VALUE_BITS - leading_ - trailing_)
+                           : (2U + GORILLA::LEADING_BITS +
+                              GORILLA::LENGTH_BITS + VALUE_BITS - leading -
+                              trailing);
+    }
+
+    if (writer_.get_free_bits() < (time_bits + value_bits))
+    {
+        return false;
+    }
+
+    if (dod == 0U)
+    {
+        writer_.write(0U, 1U);
+    }
+    else if (range < DOD_RANGES.size())
+    {
+        writer_.write(DOD_RANGES[range].prefix, DOD_RANGES[range].prefix_bits);
+        writer_.write(dod, DOD_RANGES[range].bits);
+    }
+    else
+    {
+        writer_.write(DOD_FULL_PREFIX, 4U);
+        writer_.write(dod, VALUE_BITS);
+    }
+
+    if (xored == 0U)
+    {
+        writer_.write(0U, 1U);
+    }
+    else if (reuse)
+    {
+        writer_.write(0x2U, 2U);
+        writer_.write(xored >> trailing_, VALUE_BITS - leading_ - trailing_);
+    }
+    else
+    {
+        const std::size_t length = VALUE_BITS - leading - trailing;
+        writer_.write(0x3U, 2U);
+        writer_.write(leading, GORILLA::LEADING_BITS);
+        writer_.write(length - 1U, GORILLA::LENGTH_BITS);
+        writer_.write(xored >> trailing, length);
+        leading_ = leading;
+        trailing_ = trailing;
+    }
+
+    timestamp_ = timestamp;
+    delta_ = delta;
+    value_ = bits;
+    ++count_;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void GorillaEncoder::finish() noexcept { writer_.flush(); }
+
+////////////////////////////////////////////////////////////////////////////////
+GorillaDecoder::GorillaDecoder(PacketView& packet,
+                               const std::size_t count) noexcept
+    : reader_{packet}, timestamp_{0U}, delta_{0U}, value_{0U}, leading_{0U},
+      length_{0U}, read_{0U}, count_{count}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool GorillaDecoder::next(std::uint64_t& timestamp, double& value) noexcept
+{
+    if (read_ >= count_)
+    {
+        return false;
+    }
+
+    if (read_ == 0U)
+    {
+        timestamp_ = reader_.read(GORILLA::FIRST_BITS);
+        value_ = reader_.read(GORILLA::FIRST_BITS);
+    }
+    else
+    {
+        std::uint64_t dod = 0U;
+
+        if (reader_.read_bit())
+        {
+            // the number of 1 bits in the prefix tells the range.
+            std::size_t range = 0U;
+
+            while ((range < DOD_RANGES.size()) && reader_.read_bit())
+            {
+                ++range;
+            }
+
+            const std::size_t bits = (range < DOD_RANGES.size())
+                                         ? DOD_RANGES[range].bits
+                                         : VALUE_BITS;
+            dod = (bits < VALUE_BITS) ? sign_extend(reader_.read(bits), bits)
+                                      : reader_.read(bits);
+        }
+
+        delta_ += dod;
+        timestamp_ += delta_;
+
+        if (reader_.read_bit())
+        {
+            if (reader_.read_bit())
+            {
+                leading_ = static_cast< std::size_t >(
+                    reader_.read(GORILLA::LEADING_BITS));
+                length_ = static_cast< std::size_t >(
+                              reader_.read(GORILLA::LENGTH_BITS)) +
+                          1U;
+            }
+
+            // a window must have been read before.
+            if (((leading_ + length_) > VALUE_BITS) || (length_ == 0U))
+            {
+                return false;
+            }
+
+            value_ ^= reader_.read(length_)
+                      << (VALUE_BITS - leading_ - length_);
+        }
+    }
+
+    if (reader_.has_overflow())
+    {
+        return false;
+    }
+
+    ++read_;
+    timestamp = timestamp_;
+    std::memcpy(&value, &value_, sizeof(value));
+
+    return true;
+}
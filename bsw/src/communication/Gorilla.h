@@ -0,0 +1,213 @@
+/**
+ * \file      Gorilla.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Compression of timestamped float series.
+ * \details   GorillaEncoder packs timestamps with delta-of-delta and values with XOR
+ *            encoding into a packet, as the Gorilla time series database does, and
+ *            GorillaDecoder unpacks them.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GORILLA_H_
+#define GORILLA_H_
+
+#include "PacketBits.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Defining a struct that holds the encoding of a Gorilla series.
+ */
+struct GORILLA
+{
+    /// bits of the first timestamp and of the first value.
+    static constexpr std::size_t FIRST_BITS{64U};
+    /// bits of the leading zeros of a XOR value.
+    static constexpr std::size_t LEADING_BITS{5U};
+    /// bits of the length of the meaningful bits of a XOR value, minus 1.
+    static constexpr std::size_t LENGTH_BITS{6U};
+    /// the most leading zeros that can be encoded.
+    static constexpr std::size_t MAX_LEADING{31U};
+    /// the most bits a point takes: the widest timestamp and value.
+    static constexpr std::size_t MAX_POINT_BITS{4U + 64U + 2U + LEADING_BITS +
+                                                LENGTH_BITS + 64U};
+};
+
+/**
+ * \brief GorillaEncoder compresses a series of timestamps and values into a
+ * packet, see "Gorilla: A Fast, Scalable, In-Memory Time Series Database"
+ * (Pelkonen et al., 2015). The first point is stored as it is. Then a
+ * timestamp is stored as the change of its distance to the one before
+ * (delta-of-delta):
+ * \code
+ * 0                      the same distance
+ * 10   + 7 bits          -64 .. 63
+ * 110  + 9 bits          -256 .. 255
+ * 1110 + 12 bits         -2048 .. 2047
+ * 1111 + 64 bits         else
+ * \endcode
+ * A value is stored as the XOR with the value before:
+ * \code
+ * 0                      the same value
+ * 10 + meaningful bits   within the leading and trailing zeros before
+ * 11 + 5 bits leading zeros + 6 bits length - 1 + meaningful bits
+ * \endcode
+ * Unlike Gorilla the last timestamp case has 64 bits, so timestamps of any
+ * unit, e.g. nanoseconds, are stored exactly. Regular timestamps take 1 bit
+ * and slowly changing values a few bits.
+ *
+ * The encoder holds the state of the last point only, the bits go into the
+ * packet as they come. The number of points is not stored, send it along,
+ * e.g. in a header in front of the bits.
+ * \code
+ * Packet< 1024 > packet;
+ * GorillaEncoder encoder{packet};
+ * while (encoder.append(time, value)) { ... }
+ * encoder.finish();
+ * \endcode
+ */
+class GorillaEncoder
+{
+  public:
+    /**
+     * \brief Creates an encoder that appends to a packet.
+     * \param[in] packet the packet, must outlive the encoder.
+     */
+    explicit GorillaEncoder(PacketView& packet) noexcept;
+
+    /**
+     * \brief Appends a point.
+     * \param[in] timestamp in any unit.
+     * \param[in] value the value, any double including NaN.
+     * \return false if the point does not fit into the packet, nothing is
+     * written then. finish() the packet and start a new one.
+     */
+    bool append(const std::uint64_t timestamp, const double value) noexcept;
+
+    /**
+     * \brief Writes the last bits of the series into the packet. No point
+     * may be appended after.
+     */
+    void finish() noexcept;
+
+    /**
+     * \brief The number of points appended.
+     */
+    std::size_t get_count() const noexcept { return count_; }
+
+    /**
+     * \brief The number of bits of the points, without the padding of
+     * finish().
+     */
+    std::size_t get_bits() const noexcept { return writer_.get_bits(); }
+
+  private:
+    /// writes the bits into the packet.
+    PacketBitWriter writer_;
+
+    /// the timestamp before.
+    std::uint64_t timestamp_;
+
+    /// the distance of the timestamp before to the one before it, modulo
+    /// 2^64.
+    std::uint64_t delta_;
+
+    /// the bits of the value before.
+    std::uint64_t value_;
+
+    /// the leading zeros of the last XOR value stored with its bits.
+    std::size_t leading_;
+
+    /// the trailing zeros of the last XOR value stored with its bits.
+    std::size_t trailing_;
+
+    /// the number of points appended.
+    std::size_t count_;
+};
+
+/**
+ * \brief GorillaDecoder reads the points of a GorillaEncoder back.
+ * \code
+ * GorillaDecoder decoder{packet, count};
+ * while (decoder.next(time, value)) { ... }
+ * \endcode
+ */
+class GorillaDecoder
+{
+  public:
+    /**
+     * \brief Creates a decoder that starts at the read position of a packet.
+     * \param[in] packet the packet, must outlive the decoder.
+     * \param[in] count the number of points in the packet.
+     */
+    GorillaDecoder(PacketView& packet, const std::size_t count) noexcept;
+
+    /**
+     * \brief Reads the next point.
+     * \return false after the last point or if the packet ended before.
+     */
+    bool next(std::uint64_t& timestamp, double& value) noexcept;
+
+    /**
+     * \brief Checks if the packet ended before the last point.
+     */
+    bool has_overflow() const noexcept { return reader_.has_overflow(); }
+
+  private:
+    /// reads the bits from the packet.
+    PacketBitReader reader_;
+
+    /// the timestamp before.
+    std::uint64_t timestamp_;
+
+    /// the distance of the timestamp before to the one before it, modulo
+    /// 2^64.
+    std::uint64_t delta_;
+
+    /// the bits of the value before.
+    std::uint64_t value_;
+
+    /// the leading zeros of the last XOR value read with its bits.
+    std::size_t leading_;
+
+    /// the number of meaningful bits of the last XOR value read with its
+    /// bits.
+    std::size_t length_;
+
+    /// the number of points read.
+    std::size_t read_;
+
+    /// the number of points in the packet.
+    std::size_t count_;
+};
+
+#endif // GORILLA_H_
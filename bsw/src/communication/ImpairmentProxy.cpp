@@ -0,0 +1,645 @@
+/**
+ * \file      ImpairmentProxy.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Proxy that forwards TCP or UDP traffic over an impaired link.
+ * \details   Delay, jitter, loss, reordering and a rate limit are applied in user
+ *            space, so applications are tested under the conditions of e.g. a
+ *            cellular link without tc netem and root rights.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ImpairmentProxy.h"
+
+#ifndef _WIN32
+
+#include <cmath>
+#include <new>
+#include <sys/timerfd.h>
+
+////////////////////////////////////////////////////////////////////////////////
+ImpairmentProxy::ImpairmentProxy(const std::uint32_t seed) noexcept
+    : pool_{IMPAIRMENT_PROXY::MAX_PACKETS * sizeof(Packet), true, false},
+      packets_{static_cast< Packet* >(pool_.get_data())}, free_{NONE},
+      wheel_{}, impairments_{}, stats_{}, link_free_at_{}, last_due_{},
+      paused_{{false, false}}, closed_{{false, false}},
+      queue_head_{{NONE, NONE}}, queue_tail_{{NONE, NONE}}, random_{seed},
+      start_{Clock::now()}, loop_{},
+      timer_{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)},
+      timer_armed_{false}, udp_listen_{}, udp_server_{}, udp_client_{},
+      tcp_listen_{}, tcp_server_{}, tcp_{false}, open_{false},
+      running_{false}
+{
+    if (packets_ != nullptr)
+    {
+        // all packets are free, the last one first.
+        for (std::uint32_t i = 0U; i < IMPAIRMENT_PROXY::MAX_PACKETS; ++i)
+        {
+            new (&packets_[i]) Packet{};
+            packets_[i].next_free = free_;
+            free_ = i;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+ImpairmentProxy::~ImpairmentProxy() noexcept
+{
+    if (timer_ >= 0)
+    {
+        static_cast< void >(loop_.remove(timer_));
+        ::close(timer_);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::set_impairment(const ProxyDirection direction,
+                                     const LinkImpairment& impairment) noexcept
+{
+    impairments_[static_cast< std::size_t >(direction)] = impairment;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::open_udp(IpAddress listen_ip,
+                               const std::uint16_t listen_port,
+                               IpAddress server_ip,
+                               const std::uint16_t server_port) noexcept
+{
+    tcp_ = false;
+    open_ = (packets_ != nullptr) && (timer_ >= 0) && loop_.is_ok() &&
+            udp_listen_.bind(listen_ip, listen_port) &&
+            udp_server_.connect(server_ip, server_port) &&
+            loop_.add(timer_, EventPriority::CONTROL, on_timer, this) &&
+            watch(ProxyDirection::UPSTREAM) &&
+            watch(ProxyDirection::DOWNSTREAM);
+
+    if (open_ == false)
+    {
+        std::cerr << "Could not open the UDP proxy.\n";
+    }
+
+    return open_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::open_tcp(IpAddress listen_ip,
+                               const std::uint16_t listen_port,
+                               IpAddress server_ip,
+                               const std::uint16_t server_port) noexcept
+{
+    tcp_ = true;
+    tcp_listen_.reuse_addr();
+    open_ = (packets_ != nullptr) && (timer_ >= 0) && loop_.is_ok() &&
+            tcp_listen_.listen(listen_ip, listen_port) &&
+            tcp_listen_.accept() &&
+            tcp_server_.connect(server_ip, server_port) &&
+            tcp_listen_.m_data.set_blocking(false) &&
+            tcp_server_.set_blocking(false) &&
+            loop_.add(timer_, EventPriority::CONTROL, on_timer, this) &&
+            watch(ProxyDirection::UPSTREAM) &&
+            watch(ProxyDirection::DOWNSTREAM);
+
+    if (open_ == false)
+    {
+        std::cerr << "Could not open the TCP proxy.\n";
+    }
+
+    return open_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int ImpairmentProxy::run_once(const int timeout_ms) noexcept
+{
+    return open_ ? loop_.run_once(timeout_ms) : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::run() noexcept
+{
+    running_ = true;
+
+    while (running_ && open_)
+    {
+        static_cast< void >(run_once(IMPAIRMENT_PROXY::WAIT_MS));
+
+        // a closed TCP peer ends the proxy once its data is forwarded.
+        if (tcp_ && (closed_[0] || closed_[1]) && wheel_.is_empty() &&
+            (queue_head_[0] == NONE) && (queue_head_[1] == NONE))
+        {
+            running_ = false;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::print(std::ostream& out) const noexcept
+{
+    static constexpr const char* NAMES[] = {"upstream", "downstream"};
+
+    for (std::size_t i = 0U; i < stats_.size(); ++i)
+    {
+        out << NAMES[i] << ": forwarded " << stats_[i].forwarded << " ("
+            << stats_[i].bytes << " bytes), lost " << stats_[i].lost
+            << ", reordered " << stats_[i].reordered << ", overflows "
+            << stats_[i].overflows << ", unsent " << stats_[i].unsent
+            << " bytes\n";
+        stats_[i].delay.print(out);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::on_upstream(void* context) noexcept
+{
+    auto* proxy = static_cast< ImpairmentProxy* >(context);
+    return proxy->receive(ProxyDirection::UPSTREAM);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::on_downstream(void* context) noexcept
+{
+    auto* proxy = static_cast< ImpairmentProxy* >(context);
+    return proxy->receive(ProxyDirection::DOWNSTREAM);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::on_timer(void* context) noexcept
+{
+    auto* proxy = static_cast< ImpairmentProxy* >(context);
+    std::uint64_t expirations = 0U;
+    static_cast< void >(
+        ::read(proxy->timer_, &expirations, sizeof(expirations)));
+
+    // the tick that has fully passed, a timer due within it is due now.
+    const auto since_start = std::chrono::duration_cast<
+        std::chrono::microseconds >(Clock::now() - proxy->start_);
+    const auto now = static_cast< std::uint64_t >(since_start.count()) /
+                     IMPAIRMENT_PROXY::TICK_US;
+    proxy->wheel_.advance(
+        now, [proxy](const std::uint32_t index) { proxy->forward(index); });
+
+    // the chunks a peer did not take are tried again on every tick.
+    if (proxy->tcp_)
+    {
+        proxy->flush(ProxyDirection::UPSTREAM);
+        proxy->flush(ProxyDirection::DOWNSTREAM);
+    }
+
+    proxy->update_timer();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::receive(const ProxyDirection direction) noexcept
+{
+    const auto d = static_cast< std::size_t >(direction);
+    bool keep = true;
+    const std::uint32_t index = allocate();
+
+    if ((index == NONE) && tcp_)
+    {
+        // the sender is stopped by the TCP window until a buffer is free.
+        ++stats_[d].overflows;
+        paused_[d] = true;
+        static_cast< void >(loop_.remove(get_source(direction)));
+    }
+    else if (index == NONE)
+    {
+        // a datagram of length 0 is read to drop it.
+        ++stats_[d].overflows;
+        static_cast< void >(read(direction, nullptr, 0U));
+    }
+    else
+    {
+        Packet& packet = packets_[index];
+        const std::int16_t len = read(direction, packet.data.data(),
+                                      IMPAIRMENT_PROXY::PACKET_SIZE);
+
+        if (len > 0)
+        {
+            packet.len = static_cast< std::uint16_t >(len);
+            packet.offset = 0U;
+            packet.direction = direction;
+            packet.received = Clock::now();
+            schedule(index);
+        }
+        else
+        {
+            release(index);
+
+            // the end of a TCP stream or an error other than a spurious wake.
+            if (tcp_ && (len == 0))
+            {
+                closed_[d] = true;
+                keep = false;
+            }
+            else if ((len < 0) && (errno != EAGAIN) && (errno != EINTR))
+            {
+                keep = tcp_ == false;
+            }
+        }
+    }
+
+    return keep;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t ImpairmentProxy::read(const ProxyDirection direction,
+                                   std::uint8_t* data,
+                                   const std::uint16_t len) noexcept
+{
+    std::int16_t received = -1;
+
+    if (direction == ProxyDirection::UPSTREAM)
+    {
+        if (tcp_)
+        {
+            received = tcp_listen_.m_data.receive(data, len);
+        }
+        else
+        {
+            sockaddr_in from{};
+            received = udp_listen_.receive_from(data, len, from);
+
+            // the answers go to the client that sent last.
+            if (received >= 0)
+            {
+                udp_client_ = from;
+            }
+        }
+    }
+    else
+    {
+        received = tcp_ ? tcp_server_.receive(data, len)
+                        : udp_server_.receive(data, len);
+    }
+
+    return received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::schedule(const std::uint32_t index) noexcept
+{
+    Packet& packet = packets_[index];
+    const auto d = static_cast< std::size_t >(packet.direction);
+    const LinkImpairment& impairment = impairments_[d];
+
+    if ((tcp_ == false) && happens(impairment.loss))
+    {
+        ++stats_[d].lost;
+        release(index);
+    }
+    else
+    {
+        std::chrono::microseconds delay = sample_delay(impairment);
+
+        if ((tcp_ == false) && happens(impairment.reorder))
+        {
+            ++stats_[d].reordered;
+            delay = std::chrono::microseconds{0};
+        }
+        else if (tcp_ && happens(impairment.loss))
+        {
+            ++stats_[d].lost;
+            delay += impairment.retransmit;
+        }
+
+        // the link sends one packet after the other at its rate.
+        Clock::time_point departure = packet.received;
+
+        if (impairment.rate != TOKEN_BUCKET::UNLIMITED)
+        {
+            const Clock::time_point start = (link_free_at_[d] > departure)
+                                                ? link_free_at_[d]
+                                                : departure;
+            const std::chrono::nanoseconds serialization{
+                (static_cast< std::uint64_t >(packet.len) * 1000000000U) /
+                impairment.rate};
+            link_free_at_[d] = start + serialization;
+            departure = link_free_at_[d];
+        }
+
+        Clock::time_point due = departure + delay;
+
+        // no chunk of a stream overtakes another.
+        if (tcp_)
+        {
+            due = (due > last_due_[d]) ? due : last_due_[d];
+            last_due_[d] = due;
+        }
+
+        // the wheel holds as many timers as there are packets.
+        static_cast< void >(wheel_.schedule(to_tick(due), index));
+        update_timer();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::forward(const std::uint32_t index) noexcept
+{
+    Packet& packet = packets_[index];
+    const auto d = static_cast< std::size_t >(packet.direction);
+
+    if (tcp_)
+    {
+        // queued behind the chunks the peer did not take yet.
+        packet.next_free = NONE;
+
+        if (queue_tail_[d] == NONE)
+        {
+            queue_head_[d] = index;
+        }
+        else
+        {
+            packets_[queue_tail_[d]].next_free = index;
+        }
+
+        queue_tail_[d] = index;
+        flush(packet.direction);
+    }
+    else
+    {
+        const std::int16_t sent =
+            write(packet.direction, packet.data.data(), packet.len);
+
+        if (sent > 0)
+        {
+            ++stats_[d].forwarded;
+            stats_[d].bytes += static_cast< std::uint64_t >(sent);
+            stats_[d].delay.add(Clock::now() - packet.received);
+        }
+
+        release(index);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::flush(const ProxyDirection direction) noexcept
+{
+    const auto d = static_cast< std::size_t >(direction);
+    bool writable = true;
+
+    while (writable && (queue_head_[d] != NONE))
+    {
+        const std::uint32_t index = queue_head_[d];
+        Packet& packet = packets_[index];
+        const std::int16_t sent =
+            write(direction, &packet.data[packet.offset],
+                  static_cast< std::uint16_t >(packet.len - packet.offset));
+        const int error = (sent < 0) ? errno : 0;
+        bool done = false;
+
+        if (sent > 0)
+        {
+            packet.offset = static_cast< std::uint16_t >(packet.offset + sent);
+            stats_[d].bytes += static_cast< std::uint64_t >(sent);
+            done = packet.offset == packet.len;
+
+            if (done)
+            {
+                ++stats_[d].forwarded;
+                stats_[d].delay.add(Clock::now() - packet.received);
+            }
+            else
+            {
+                // the socket buffer of the peer is full.
+                writable = false;
+            }
+        }
+        else if ((sent == 0) || (error == EAGAIN) || (error == EWOULDBLOCK) ||
+                 (error == EINTR))
+        {
+            writable = false;
+        }
+        else
+        {
+            // the stream is broken: no more data goes this way.
+            if (stats_[d].unsent == 0U)
+            {
+                std::cerr << "Forwarding TCP failed, errno " << error
+                          << ".\n";
+                static_cast< void >(loop_.remove(get_source(direction)));
+            }
+            closed_[d] = true;
+            stats_[d].unsent +=
+                static_cast< std::uint64_t >(packet.len - packet.offset);
+            done = true;
+        }
+
+        if (done)
+        {
+            queue_head_[d] = packet.next_free;
+            if (queue_head_[d] == NONE)
+            {
+                queue_tail_[d] = NONE;
+            }
+            release(index);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t ImpairmentProxy::write(const ProxyDirection direction,
+                                    const std::uint8_t* data,
+                                    const std::uint16_t len) noexcept
+{
+    std::int16_t sent = -1;
+
+    if (direction == ProxyDirection::UPSTREAM)
+    {
+        sent = tcp_ ? tcp_server_.send(data, len)
+                    : udp_server_.send(data, len);
+    }
+    else
+    {
+        sent = tcp_ ? tcp_listen_.m_data.send(data, len)
+                    : udp_listen_.send_to(data, len, udp_client_);
+    }
+
+    return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::chrono::microseconds
+ImpairmentProxy::sample_delay(const LinkImpairment& impairment) noexcept
+{
+    const auto delay = static_cast< double >(impairment.delay.count());
+    const auto jitter = static_cast< double >(impairment.jitter.count());
+    double sample = delay;
+
+    if ((impairment.distribution == DelayDistribution::UNIFORM) &&
+        (jitter > 0.0))
+    {
+        std::uniform_real_distribution< double > uniform{delay - jitter,
+                                                         delay + jitter};
+        sample = uniform(random_);
+    }
+    else if ((impairment.distribution == DelayDistribution::NORMAL) &&
+             (jitter > 0.0))
+    {
+        std::normal_distribution< double > normal{delay, jitter};
+        sample = normal(random_);
+    }
+    else if ((impairment.distribution == DelayDistribution::PARETO) &&
+             (jitter > 0.0))
+    {
+        // scaled so the mean of the tail is the jitter.
+        const double shape = IMPAIRMENT_PROXY::PARETO_SHAPE;
+        std::uniform_real_distribution< double > uniform{0.0, 1.0};
+        const double u = 1.0 - uniform(random_);
+        sample = delay + (jitter * (shape - 1.0) *
+                          (std::pow(u, -1.0 / shape) - 1.0));
+    }
+
+    // a packet does not leave before it arrived.
+    sample = (sample > 0.0) ? sample : 0.0;
+    return std::chrono::microseconds{
+        static_cast< std::chrono::microseconds::rep >(std::llround(sample))};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::happens(const double probability) noexcept
+{
+    bool happened = false;
+
+    // no random number is drawn for impairments that are off.
+    if (probability > 0.0)
+    {
+        std::uniform_real_distribution< double > uniform{0.0, 1.0};
+        happened = uniform(random_) < probability;
+    }
+
+    return happened;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t ImpairmentProxy::to_tick(const Clock::time_point time) const
+    noexcept
+{
+    std::uint64_t tick = 0U;
+
+    if (time > start_)
+    {
+        const auto since_start =
+            std::chrono::duration_cast< std::chrono::nanoseconds >(time -
+                                                                   start_);
+        const std::uint64_t tick_ns = IMPAIRMENT_PROXY::TICK_US * 1000U;
+        tick = (static_cast< std::uint64_t >(since_start.count()) + tick_ns -
+                1U) /
+               tick_ns;
+    }
+
+    return tick;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::update_timer() noexcept
+{
+    const bool arm = (wheel_.is_empty() == false) ||
+                     (queue_head_[0] != NONE) || (queue_head_[1] != NONE);
+
+    if (arm != timer_armed_)
+    {
+        // one tick period while armed, zero stops the timer.
+        struct itimerspec spec
+        {
+        };
+        if (arm)
+        {
+            spec.it_value.tv_nsec = IMPAIRMENT_PROXY::TICK_US * 1000;
+            spec.it_interval.tv_nsec = IMPAIRMENT_PROXY::TICK_US * 1000;
+        }
+
+        if (timerfd_settime(timer_, 0, &spec, nullptr) == 0)
+        {
+            timer_armed_ = arm;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t ImpairmentProxy::allocate() noexcept
+{
+    const std::uint32_t index = free_;
+
+    if (index != NONE)
+    {
+        free_ = packets_[index].next_free;
+    }
+
+    return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ImpairmentProxy::release(const std::uint32_t index) noexcept
+{
+    packets_[index].next_free = free_;
+    free_ = index;
+
+    for (std::size_t d = 0U; d < paused_.size(); ++d)
+    {
+        if (paused_[d])
+        {
+            paused_[d] = false;
+            static_cast< void >(watch(static_cast< ProxyDirection >(d)));
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ImpairmentProxy::watch(const ProxyDirection direction) noexcept
+{
+    const EventHandler handler = (direction == ProxyDirection::UPSTREAM)
+                                     ? on_upstream
+                                     : on_downstream;
+    return loop_.add(get_source(direction), EventPriority::NORMAL, handler,
+                     this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SocketHandleType
+ImpairmentProxy::get_source(const ProxyDirection direction) noexcept
+{
+    SocketHandleType handle = get_invalid_alias();
+
+    if (direction == ProxyDirection::UPSTREAM)
+    {
+        handle = tcp_ ? tcp_listen_.m_data.get_socket()
+                      : udp_listen_.get_socket();
+    }
+    else
+    {
+        handle = tcp_ ? tcp_server_.get_socket() : udp_server_.get_socket();
+    }
+
+    return handle;
+}
+
+#endif // WIN32 detection
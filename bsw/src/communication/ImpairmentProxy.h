@@ -0,0 +1,423 @@
+/**
+ * \file      ImpairmentProxy.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Proxy that forwards TCP or UDP traffic over an impaired link.
+ * \details   Delay, jitter, loss, reordering and a rate limit are applied in user
+ *            space, so applications are tested under the conditions of e.g. a
+ *            cellular link without tc netem and root rights.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef IMPAIRMENTPROXY_H_
+#define IMPAIRMENTPROXY_H_
+
+#ifndef _WIN32
+
+#include "EventLoop.h"
+#include "HugePageBuffer.h"
+#include "LatencyHistogram.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+#include "TimerWheel.h"
+#include "TokenBucket.h"
+#include "UdpSocket.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+/**
+ * \brief Defining a struct that holds the sizes of the impairment proxy.
+ */
+struct IMPAIRMENT_PROXY
+{
+    // packets in flight in both directions.
+    static constexpr std::size_t MAX_PACKETS{512U};
+    // biggest datagram or TCP chunk forwarded at once.
+    static constexpr std::size_t PACKET_SIZE{2048U};
+    // slots of the timer wheel, one tick each.
+    static constexpr std::size_t WHEEL_SLOTS{4096U};
+    // resolution of the delays in microseconds.
+    static constexpr std::uint32_t TICK_US{100U};
+    // run() checks for stop() at least this often.
+    static constexpr int WAIT_MS{100};
+    // shape of the heavy tail of DelayDistribution::PARETO.
+    static constexpr double PARETO_SHAPE{2.5};
+};
+
+/**
+ * \brief How the delay of a packet is spread around the configured delay.
+ */
+enum class DelayDistribution : std::uint8_t
+{
+    CONSTANT, ///< always the delay, the jitter is not used.
+    UNIFORM,  ///< uniform from delay - jitter to delay + jitter.
+    NORMAL,   ///< normal with the delay as mean and the jitter as deviation.
+    PARETO    ///< the delay plus a heavy tail with the jitter as mean.
+};
+
+/**
+ * \brief The direction through the proxy.
+ */
+enum class ProxyDirection : std::uint8_t
+{
+    UPSTREAM = 0U,  ///< from the client to the server.
+    DOWNSTREAM = 1U ///< from the server to the client.
+};
+
+/**
+ * \brief The impairments of one direction.
+ */
+struct LinkImpairment
+{
+    /// delay of every packet.
+    std::chrono::microseconds delay{0};
+    /// spread of the delay, see DelayDistribution.
+    std::chrono::microseconds jitter{0};
+    /// distribution of the delay.
+    DelayDistribution distribution{DelayDistribution::CONSTANT};
+    /// probability that a packet is lost, 0.0 to 1.0.
+    double loss{0.0};
+    /// probability that a datagram skips the delay and overtakes others.
+    double reorder{0.0};
+    /// bytes per second on the link, TOKEN_BUCKET::UNLIMITED for no limit.
+    std::uint64_t rate{TOKEN_BUCKET::UNLIMITED};
+    /// TCP only: time a lost chunk is late, the retransmission.
+    std::chrono::microseconds retransmit{200000};
+};
+
+/**
+ * \brief The statistics of one direction.
+ */
+struct ProxyStats
+{
+    /// packets forwarded.
+    std::uint64_t forwarded{0U};
+    /// bytes forwarded.
+    std::uint64_t bytes{0U};
+    /// datagrams dropped and TCP chunks retransmitted.
+    std::uint64_t lost{0U};
+    /// datagrams that skipped the delay.
+    std::uint64_t reordered{0U};
+    /// datagrams dropped and TCP reads paused for lack of buffers.
+    std::uint64_t overflows{0U};
+    /// TCP bytes not forwarded because sending to the peer failed.
+    std::uint64_t unsent{0U};
+    /// time from receiving until forwarding a packet.
+    LatencyHistogram delay;
+};
+
+/**
+ * \brief ImpairmentProxy forwards the traffic between one client and one
+ * server and impairs it on the way. A packet that arrives gets its delay
+ * from the distribution, waits for the rate of the link (serialization like a
+ * real link) and is forwarded from a timer wheel. All packet buffers are
+ * allocated at construction.
+ *
+ * UDP datagrams may be lost or reordered. TCP is a stream: a lost chunk is
+ * late by the retransmission time, and no chunk overtakes another. If all
+ * buffers are in use, datagrams are dropped and TCP stops reading, so the
+ * sender sees backpressure as on a full link. The TCP sockets do not block:
+ * a chunk the peer does not take at once waits with the chunks behind it
+ * and is sent on the next ticks. If sending fails, the direction is closed,
+ * an error is printed and the bytes left are counted as unsent.
+ * \code
+ * ImpairmentProxy proxy;
+ * LinkImpairment cellular;
+ * cellular.delay = std::chrono::milliseconds{40};
+ * cellular.jitter = std::chrono::milliseconds{10};
+ * cellular.distribution = DelayDistribution::PARETO;
+ * proxy.set_impairment(ProxyDirection::UPSTREAM, cellular);
+ * proxy.set_impairment(ProxyDirection::DOWNSTREAM, cellular);
+ * proxy.open_udp("127.0.0.1", 6000U, "127.0.0.1", 5000U);
+ * proxy.run();
+ * \endcode
+ */
+class ImpairmentProxy
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * \brief Allocates the buffers, the links are not impaired.
+     * \param[in] seed of the random numbers, the same seed gives the same
+     * impairments for the same traffic.
+     */
+    explicit ImpairmentProxy(const std::uint32_t seed = 1U) noexcept;
+
+    /**
+     * \brief Closes the timer.
+     */
+    ~ImpairmentProxy() noexcept;
+
+    ImpairmentProxy(const ImpairmentProxy&) = delete;
+    ImpairmentProxy& operator=(const ImpairmentProxy&) = delete;
+
+    /**
+     * \brief Sets the impairments of one direction, may be called between
+     * run_once() calls.
+     */
+    void set_impairment(const ProxyDirection direction,
+                        const LinkImpairment& impairment) noexcept;
+
+    /**
+     * \brief Forwards UDP: datagrams received on the listen address are sent
+     * to the server, the answers of the server to the client that sent last.
+     * \return false if a socket could not be set up.
+     */
+    bool open_udp(IpAddress listen_ip, const std::uint16_t listen_port,
+                  IpAddress server_ip,
+                  const std::uint16_t server_port) noexcept;
+
+    /**
+     * \brief Forwards TCP: waits for one client on the listen address, then
+     * connects to the server.
+     * \return false if the client or the server could not be connected.
+     */
+    bool open_tcp(IpAddress listen_ip, const std::uint16_t listen_port,
+                  IpAddress server_ip,
+                  const std::uint16_t server_port) noexcept;
+
+    /**
+     * \brief Forwards the packets that arrived and are due.
+     * \param[in] timeout_ms time to wait for a packet or timer.
+     * \return the number of events handled, -1 on an error.
+     */
+    int run_once(const int timeout_ms) noexcept;
+
+    /**
+     * \brief Forwards until stop() is called or a TCP peer closed and all of
+     * its data is forwarded.
+     */
+    void run() noexcept;
+
+    /**
+     * \brief Makes run() return, may be called from another thread.
+     */
+    void stop() noexcept { running_ = false; }
+
+    /**
+     * \brief The statistics of one direction.
+     */
+    const ProxyStats& get_stats(const ProxyDirection direction) const noexcept
+    {
+        return stats_[static_cast< std::size_t >(direction)];
+    }
+
+    /**
+     * \brief Prints the statistics of both directions.
+     */
+    void print(std::ostream& out) const noexcept;
+
+  private:
+    /**
+     * \brief A packet in flight.
+     */
+    struct Packet
+    {
+        std::array< std::uint8_t, IMPAIRMENT_PROXY::PACKET_SIZE > data;
+        Clock::time_point received;
+        std::uint16_t len;
+        /// TCP: bytes the peer has taken already.
+        std::uint16_t offset;
+        ProxyDirection direction;
+        /// the next free packet, or the next one in the send queue.
+        std::uint32_t next_free;
+    };
+
+    /// marks the end of the free list.
+    static constexpr std::uint32_t NONE{0xFFFFFFFFU};
+
+    /**
+     * \brief Event handlers of the loop, the context is the proxy.
+     */
+    static bool on_upstream(void* context) noexcept;
+    static bool on_downstream(void* context) noexcept;
+    static bool on_timer(void* context) noexcept;
+
+    /**
+     * \brief Receives one packet of a direction and schedules it.
+     * \return false if the source is closed or failed.
+     */
+    bool receive(const ProxyDirection direction) noexcept;
+
+    /**
+     * \brief Reads from the source of a direction.
+     */
+    std::int16_t read(const ProxyDirection direction, std::uint8_t* data,
+                      const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Applies the impairments and puts the packet on the wheel.
+     */
+    void schedule(const std::uint32_t index) noexcept;
+
+    /**
+     * \brief Sends a packet that is due to its destination.
+     */
+    void forward(const std::uint32_t index) noexcept;
+
+    /**
+     * \brief TCP: sends the queued chunks of a direction as far as the peer
+     * takes them.
+     */
+    void flush(const ProxyDirection direction) noexcept;
+
+    /**
+     * \brief Sends to the destination of a direction.
+     */
+    std::int16_t write(const ProxyDirection direction,
+                       const std::uint8_t* data,
+                       const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Draws the delay of one packet.
+     */
+    std::chrono::microseconds
+    sample_delay(const LinkImpairment& impairment) noexcept;
+
+    /**
+     * \brief true with the given probability.
+     */
+    bool happens(const double probability) noexcept;
+
+    /**
+     * \brief The tick a time falls into, rounded up.
+     */
+    std::uint64_t to_tick(const Clock::time_point time) const noexcept;
+
+    /**
+     * \brief Starts the periodic timer while packets are in flight, stops it
+     * if the wheel is empty.
+     */
+    void update_timer() noexcept;
+
+    /**
+     * \brief Takes a packet from the free list, NONE if there is none.
+     */
+    std::uint32_t allocate() noexcept;
+
+    /**
+     * \brief Puts a packet back and resumes a paused TCP read.
+     */
+    void release(const std::uint32_t index) noexcept;
+
+    /**
+     * \brief Adds the source of a direction to the loop.
+     */
+    bool watch(const ProxyDirection direction) noexcept;
+
+    /**
+     * \brief The socket handle a direction reads from.
+     */
+    SocketHandleType get_source(const ProxyDirection direction) noexcept;
+
+    /// the packets, allocated once.
+    HugePageBuffer pool_;
+
+    /// the packets in the pool, nullptr if the allocation failed.
+    Packet* packets_;
+
+    /// first free packet.
+    std::uint32_t free_;
+
+    /// the packets in flight by the tick they are due.
+    TimerWheel< IMPAIRMENT_PROXY::WHEEL_SLOTS, IMPAIRMENT_PROXY::MAX_PACKETS >
+        wheel_;
+
+    /// the impairments per direction.
+    std::array< LinkImpairment, 2U > impairments_;
+
+    /// the statistics per direction.
+    std::array< ProxyStats, 2U > stats_;
+
+    /// the time the link of a direction is free to send again.
+    std::array< Clock::time_point, 2U > link_free_at_;
+
+    /// TCP: the time the last chunk of a direction is due.
+    std::array< Clock::time_point, 2U > last_due_;
+
+    /// TCP: reading a direction waits for free buffers.
+    std::array< bool, 2U > paused_;
+
+    /// TCP: the source of a direction is closed.
+    std::array< bool, 2U > closed_;
+
+    /// TCP: the first due chunk of a direction not fully sent.
+    std::array< std::uint32_t, 2U > queue_head_;
+
+    /// TCP: the last due chunk of a direction.
+    std::array< std::uint32_t, 2U > queue_tail_;
+
+    /// the random numbers of all impairments.
+    std::mt19937 random_;
+
+    /// tick 0 of the wheel.
+    Clock::time_point start_;
+
+    /// waits for the sockets and the timer.
+    EventLoop loop_;
+
+    /// timerfd ticking while packets are in flight.
+    int timer_;
+
+    /// true if the timer is ticking.
+    bool timer_armed_;
+
+    /// UDP: the socket the client sends to.
+    UdpSocket udp_listen_;
+
+    /// UDP: the socket connected to the server.
+    UdpSocket udp_server_;
+
+    /// UDP: the client that sent last.
+    sockaddr_in udp_client_;
+
+    /// TCP: accepts the client, m_data is connected to it.
+    TcpServer tcp_listen_;
+
+    /// TCP: connected to the server.
+    TcpClient tcp_server_;
+
+    /// true for TCP, false for UDP.
+    bool tcp_;
+
+    /// true if open_udp() or open_tcp() succeeded.
+    bool open_;
+
+    /// run() loops while true.
+    std::atomic< bool > running_;
+};
+
+#endif // WIN32 detection
+#endif // IMPAIRMENTPROXY_H_
@@ -48,6 +48,12 @@ IpAddress::IpAddress(const char* ip_address) noexcept
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+IpAddress::IpAddress(const std::uint32_t ip_host_byte_order) noexcept
+    : m_address_binary{htonl(ip_host_byte_order)}, m_valid_ip{true}
+{
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 std::uint32_t IpAddress::get_ip_address() const noexcept
 {
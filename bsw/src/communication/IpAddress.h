@@ -58,6 +58,13 @@ class IpAddress
      */
     IpAddress(const char* ip_address) noexcept;
 
+    /**
+     * \brief Construct the address from its binary representation, e.g. as
+     * returned by an EndpointResolver.
+     * \param[in] ip_host_byte_order the IP4 address in host-byte-order
+     */
+    explicit IpAddress(const std::uint32_t ip_host_byte_order) noexcept;
+
     /**
      * Default destructor
      */
@@ -0,0 +1,454 @@
+/**
+ * \file      LoadGenerator.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Synthetic CAN and TCP load for stress tests.
+ * \details   Sends CAN frames and TCP messages as given by a schedule. The send
+ *            times are absolute, late sends are measured and the achieved rates
+ *            are reported next to the requested rates.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LoadGenerator.h"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <time.h>
+
+namespace
+{
+/// nanoseconds per second.
+constexpr std::int64_t NS_PER_SECOND{1000000000};
+
+/// a TCP load with messages pending is checked at least this often.
+constexpr std::int64_t TCP_RETRY_NS{100000};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The monotonic clock in nanoseconds, the clock RTTask sleeps on.
+ */
+std::int64_t now_ns() noexcept
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (static_cast< std::int64_t >(t.tv_sec) * NS_PER_SECOND) + t.tv_nsec;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Sleeps until an absolute time of the monotonic clock.
+ */
+void sleep_until_ns(const std::int64_t time) noexcept
+{
+    struct timespec t;
+    t.tv_sec = static_cast< time_t >(time / NS_PER_SECOND);
+    t.tv_nsec = static_cast< long >(time % NS_PER_SECOND);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Checks if a CAN FD frame is able to carry this payload length.
+ */
+bool is_valid_len(const unsigned long len) noexcept
+{
+    return (len <= 8U) || (len == 12U) || (len == 16U) || (len == 20U) ||
+           (len == 24U) || (len == 32U) || (len == 48U) || (len == 64U);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Reads a number of the schedule, decimal or hex with 0x.
+ * \return false if the token is not a number or bigger than max.
+ */
+bool to_number(const std::string& token, const unsigned long max,
+               unsigned long& value) noexcept
+{
+    char* end = nullptr;
+    value = std::strtoul(token.c_str(), &end, 0);
+    return (token.empty() == false) && (*end == '\0') && (value <= max);
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoadSchedule::parse_line(const std::string& line) noexcept
+{
+    bool valid = false;
+    std::istringstream in{line};
+    std::string type;
+    in >> type;
+
+    if (type.empty() || (type[0] == '#'))
+    {
+        // an empty line or a comment.
+        valid = true;
+    }
+    else if ((type == "can") && (can_count < can.size()))
+    {
+        std::string id, period, len, jitter{"0"}, burst{"1"};
+        in >> id >> period >> len >> jitter >> burst;
+        std::array< unsigned long, 5U > values;
+        valid = to_number(id, CAN_EFF_MASK, values[0]) &&
+                to_number(period, 60000000U, values[1]) && (values[1] > 0U) &&
+                to_number(len, CAN_FD::DATA_LEN, values[2]) &&
+                is_valid_len(values[2]) &&
+                to_number(jitter, values[1], values[3]) &&
+                to_number(burst, 0xFFFFU, values[4]) && (values[4] > 0U);
+
+        if (valid)
+        {
+            CanLoad& load = can[can_count];
+            load.can_id = static_cast< CanIDType >(values[0]);
+            load.period = std::chrono::microseconds{values[1]};
+            load.len = static_cast< std::uint8_t >(values[2]);
+            load.jitter = std::chrono::microseconds{values[3]};
+            load.burst = static_cast< std::uint16_t >(values[4]);
+            ++can_count;
+        }
+    }
+    else if ((type == "tcp") && (tcp_count < tcp.size()))
+    {
+        std::string address, port, rate, size;
+        in >> address >> port >> rate >> size;
+        std::array< unsigned long, 3U > values;
+        valid = (address.empty() == false) &&
+                (address.size() < LOAD_GENERATOR::ADDRESS_LEN) &&
+                to_number(port, 0xFFFFU, values[0]) &&
+                to_number(rate, 1000000U, values[1]) && (values[1] > 0U) &&
+                to_number(size, LOAD_GENERATOR::MAX_TCP_SIZE, values[2]) &&
+                (values[2] > 0U);
+
+        if (valid)
+        {
+            TcpLoad& load = tcp[tcp_count];
+            load.address.fill('\0');
+            std::memcpy(load.address.data(), address.data(), address.size());
+            load.port = static_cast< std::uint16_t >(values[0]);
+            load.rate = static_cast< std::uint32_t >(values[1]);
+            load.size = static_cast< std::uint16_t >(values[2]);
+            ++tcp_count;
+        }
+    }
+
+    return valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoadSchedule::load(std::istream& in) noexcept
+{
+    bool valid = true;
+    std::string line;
+    std::size_t number{0U};
+
+    while (std::getline(in, line))
+    {
+        ++number;
+
+        if (parse_line(line) == false)
+        {
+            std::cerr << "Invalid load in line " << number << ": " << line
+                      << "\n";
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+LoadGenerator::LoadGenerator(CanSocket& can, const LoadSchedule& schedule,
+                             const std::uint32_t seed) noexcept
+    : can_{can}, schedule_{schedule}, random_{(seed != 0U) ? seed : 1U},
+      can_next_{}, can_due_{}, can_stats_{}, tcp_{}, tcp_due_{},
+      tcp_remaining_{}, tcp_stats_{}, tcp_payload_{}, run_time_{0}
+{
+    for (std::size_t i = 0U; i < schedule_.tcp_count; ++i)
+    {
+        const TcpLoad& load = schedule_.tcp[i];
+
+        if (tcp_[i].connect(load.address.data(), load.port))
+        {
+            // a slow server must not delay the other loads.
+            tcp_[i].set_nodelay(true);
+            tcp_[i].set_blocking(false);
+        }
+        else
+        {
+            std::cerr << "Could not connect to " << load.address.data() << ":"
+                      << load.port << "\n";
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoadGenerator::run(const std::chrono::seconds duration) noexcept
+{
+    bool ok = true;
+    // start a bit later so the first sends are not late already.
+    const std::int64_t start = now_ns() + (NS_PER_SECOND / 1000);
+    const std::int64_t end =
+        start + (static_cast< std::int64_t >(duration.count()) * NS_PER_SECOND);
+
+    for (std::size_t i = 0U; i < schedule_.can_count; ++i)
+    {
+        can_next_[i] = start;
+        can_due_[i] = start + next_jitter(schedule_.can[i].jitter);
+    }
+
+    for (std::size_t i = 0U; i < schedule_.tcp_count; ++i)
+    {
+        tcp_due_[i] = start;
+        tcp_remaining_[i] = 0U;
+    }
+
+    std::int64_t now = now_ns();
+
+    while (ok && (now < end))
+    {
+        std::int64_t wake = end;
+
+        for (std::size_t i = 0U; i < schedule_.can_count; ++i)
+        {
+            wake = (can_due_[i] < wake) ? can_due_[i] : wake;
+        }
+
+        for (std::size_t i = 0U; i < schedule_.tcp_count; ++i)
+        {
+            const std::int64_t due = (tcp_remaining_[i] > 0U)
+                                         ? (now + TCP_RETRY_NS)
+                                         : tcp_due_[i];
+            wake = (due < wake) ? due : wake;
+        }
+
+        // absolute sleep: the time spent sending does not add up.
+        sleep_until_ns(wake);
+        now = now_ns();
+        send_can(now);
+        ok = send_tcp(now);
+    }
+
+    run_time_ = now - start;
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LoadGenerator::send_can(const std::int64_t now) noexcept
+{
+    std::array< struct canfd_frame, CAN_BATCH::MAX_FRAMES > frames;
+    std::array< std::size_t, CAN_BATCH::MAX_FRAMES > loads;
+    std::size_t count{0U};
+
+    for (std::size_t i = 0U; i < schedule_.can_count; ++i)
+    {
+        const CanLoad& load = schedule_.can[i];
+        LoadStats& stats = can_stats_[i];
+
+        // a load may be due several times if the generator was too late.
+        while (can_due_[i] <= now)
+        {
+            stats.lateness.add(std::chrono::nanoseconds{now - can_due_[i]});
+
+            for (std::uint16_t frame = 0U; frame < load.burst; ++frame)
+            {
+                // no FD flags: send_batch() puts frames of up to 8 bytes on
+                // the bus as standard frames.
+                struct canfd_frame& out = frames[count];
+                std::memset(&out, 0, sizeof(out));
+                out.can_id = load.can_id;
+
+                if (load.can_id > CAN_SFF_MASK)
+                {
+                    out.can_id |= CAN_EFF_FLAG;
+                }
+
+                out.len = load.len;
+                // a counter in the payload shows lost frames on the bus.
+                std::memcpy(out.data, &stats.requested,
+                            (load.len < sizeof(stats.requested))
+                                ? load.len
+                                : sizeof(stats.requested));
+                loads[count] = i;
+                ++stats.requested;
+                ++count;
+
+                if (count == frames.size())
+                {
+                    const int sent = can_.send_batch(frames.data(), count);
+
+                    for (int f = 0; f < sent; ++f)
+                    {
+                        ++can_stats_[loads[f]].sent;
+                    }
+
+                    count = 0U;
+                }
+            }
+
+            can_next_[i] += std::chrono::duration_cast<
+                                std::chrono::nanoseconds >(load.period)
+                                .count();
+            can_due_[i] = can_next_[i] + next_jitter(load.jitter);
+        }
+    }
+
+    if (count > 0U)
+    {
+        const int sent = can_.send_batch(frames.data(), count);
+
+        for (int f = 0; f < sent; ++f)
+        {
+            ++can_stats_[loads[f]].sent;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoadGenerator::send_tcp(const std::int64_t now) noexcept
+{
+    bool ok = true;
+
+    for (std::size_t i = 0U; i < schedule_.tcp_count; ++i)
+    {
+        const TcpLoad& load = schedule_.tcp[i];
+        LoadStats& stats = tcp_stats_[i];
+
+        while (tcp_due_[i] <= now)
+        {
+            // a message not taken completely yet delays the next one. The
+            // next one is counted as requested but not sent.
+            if (tcp_remaining_[i] == 0U)
+            {
+                stats.lateness.add(std::chrono::nanoseconds{now - tcp_due_[i]});
+                tcp_remaining_[i] = load.size;
+            }
+
+            ++stats.requested;
+            tcp_due_[i] += NS_PER_SECOND / load.rate;
+        }
+
+        if (tcp_remaining_[i] > 0U)
+        {
+            const std::int16_t sent = tcp_[i].send(
+                tcp_payload_.data(),
+                static_cast< std::uint16_t >(tcp_remaining_[i]));
+
+            if (sent > 0)
+            {
+                tcp_remaining_[i] -= static_cast< std::size_t >(sent);
+
+                if (tcp_remaining_[i] == 0U)
+                {
+                    ++stats.sent;
+                }
+            }
+            else if ((sent < 0) && (tcp_[i].get_last_error() != EAGAIN))
+            {
+                std::cerr << "Sending to " << load.address.data()
+                          << " failed.\n";
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int64_t
+LoadGenerator::next_jitter(const std::chrono::microseconds jitter) noexcept
+{
+    std::int64_t delay{0};
+
+    if (jitter.count() > 0)
+    {
+        // xorshift32, good enough for jitter and the same for each seed.
+        random_ ^= random_ << 13U;
+        random_ ^= random_ >> 17U;
+        random_ ^= random_ << 5U;
+        const auto max =
+            std::chrono::duration_cast< std::chrono::nanoseconds >(jitter)
+                .count();
+        delay = static_cast< std::int64_t >(random_ % (max + 1));
+    }
+
+    return delay;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const LoadStats&
+LoadGenerator::get_can_stats(const std::size_t load) const noexcept
+{
+    return can_stats_[load % can_stats_.size()];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const LoadStats&
+LoadGenerator::get_tcp_stats(const std::size_t load) const noexcept
+{
+    return tcp_stats_[load % tcp_stats_.size()];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LoadGenerator::print(std::ostream& out) const noexcept
+{
+    const double seconds =
+        static_cast< double >(run_time_) / static_cast< double >(NS_PER_SECOND);
+
+    for (std::size_t i = 0U; (i < schedule_.can_count) && (seconds > 0.0); ++i)
+    {
+        const CanLoad& load = schedule_.can[i];
+        const double requested = (1000000.0 * load.burst) /
+                                 static_cast< double >(load.period.count());
+        out << "can 0x" << std::hex << load.can_id << std::dec
+            << ": requested " << requested << "/s";
+        print_stats(out, can_stats_[i], seconds);
+    }
+
+    for (std::size_t i = 0U; (i < schedule_.tcp_count) && (seconds > 0.0); ++i)
+    {
+        const TcpLoad& load = schedule_.tcp[i];
+        out << "tcp " << load.address.data() << ":" << load.port
+            << ": requested " << load.rate << "/s";
+        print_stats(out, tcp_stats_[i], seconds);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LoadGenerator::print_stats(std::ostream& out, const LoadStats& stats,
+                                const double seconds) noexcept
+{
+    const LatencyHistogram& lateness = stats.lateness;
+    out << " achieved " << (static_cast< double >(stats.sent) / seconds)
+        << "/s sent " << stats.sent << "/" << stats.requested
+        << " late mean=" << lateness.get_mean().count()
+        << "ns p99=" << lateness.get_percentile(99.0).count()
+        << "ns max=" << lateness.get_max().count() << "ns\n";
+}
@@ -0,0 +1,248 @@
+/**
+ * \file      LoadGenerator.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Synthetic CAN and TCP load for stress tests.
+ * \details   Sends CAN frames and TCP messages as given by a schedule. The send
+ *            times are absolute, late sends are measured and the achieved rates
+ *            are reported next to the requested rates.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOADGENERATOR_H_
+#define LOADGENERATOR_H_
+#ifndef _WIN32
+
+#include "CanSocket.h"
+#include "LatencyHistogram.h"
+#include "TcpClient.h"
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+/**
+ * \brief Defining a struct that holds the limits of a load schedule.
+ */
+struct LOAD_GENERATOR
+{
+    // number of CAN IDs in one schedule.
+    static constexpr std::size_t MAX_CAN_LOADS{32U};
+    // number of TCP connections in one schedule.
+    static constexpr std::size_t MAX_TCP_LOADS{4U};
+    // biggest TCP message.
+    static constexpr std::size_t MAX_TCP_SIZE{4096U};
+    // longest IP4 address in dotted notation plus the terminating zero.
+    static constexpr std::size_t ADDRESS_LEN{16U};
+};
+
+/**
+ * \brief One CAN ID sent periodically.
+ */
+struct CanLoad
+{
+    /// CAN ID, IDs above 0x7FF are sent as extended frames.
+    CanIDType can_id;
+    /// time between two sends.
+    std::chrono::microseconds period;
+    /// payload length. Up to 8 bytes are sent as standard frames, longer
+    /// ones as CAN FD frames, see can_get_mtu().
+    std::uint8_t len;
+    /// each send is delayed randomly by up to this time.
+    std::chrono::microseconds jitter;
+    /// number of frames sent back to back each period.
+    std::uint16_t burst;
+};
+
+/**
+ * \brief One TCP connection sending messages at a given rate.
+ */
+struct TcpLoad
+{
+    /// IP4 address of the server.
+    std::array< char, LOAD_GENERATOR::ADDRESS_LEN > address;
+    /// port of the server.
+    std::uint16_t port;
+    /// messages per second.
+    std::uint32_t rate;
+    /// size of one message in bytes.
+    std::uint16_t size;
+};
+
+/**
+ * \brief LoadSchedule describes the load to generate. It is read from a text
+ * with one load per line:
+ *
+ *     # comment
+ *     can <id> <period us> <len> [<jitter us> [<burst>]]
+ *     tcp <ip4 address> <port> <messages per second> <size>
+ */
+struct LoadSchedule
+{
+    /**
+     * \brief Adds the load of one line of the schedule. Empty lines and
+     * comments are skipped.
+     * \return false if the line is invalid or the schedule is full.
+     */
+    bool parse_line(const std::string& line) noexcept;
+
+    /**
+     * \brief Reads a schedule line by line.
+     * \return false if one of the lines is invalid.
+     */
+    bool load(std::istream& in) noexcept;
+
+    /// the CAN loads.
+    std::array< CanLoad, LOAD_GENERATOR::MAX_CAN_LOADS > can{};
+    /// number of CAN loads.
+    std::size_t can_count{0U};
+    /// the TCP loads.
+    std::array< TcpLoad, LOAD_GENERATOR::MAX_TCP_LOADS > tcp{};
+    /// number of TCP loads.
+    std::size_t tcp_count{0U};
+};
+
+/**
+ * \brief What has been sent for one load.
+ */
+struct LoadStats
+{
+    /// frames or messages due in the schedule.
+    std::uint64_t requested;
+    /// frames or messages sent.
+    std::uint64_t sent;
+    /// time from when a send was due until it was handed to the socket.
+    LatencyHistogram lateness;
+};
+
+/**
+ * \brief LoadGenerator sends the load of a schedule. Like a RTTask it sleeps
+ * until absolute points in time, so late sends do not shift the following
+ * ones. Frames due at the same time are sent as one batch.
+ */
+class LoadGenerator
+{
+  public:
+    /**
+     * \brief Creates the generator and connects the TCP loads.
+     * \param[in] can the socket to send the CAN loads with.
+     * \param[in] schedule the load to generate.
+     * \param[in] seed of the random jitter. The same seed gives the same
+     * jitter.
+     */
+    LoadGenerator(CanSocket& can, const LoadSchedule& schedule,
+                  const std::uint32_t seed = 1U) noexcept;
+
+    /**
+     * \brief Sends the load for the given time.
+     * \return false if a TCP connection failed.
+     */
+    bool run(const std::chrono::seconds duration) noexcept;
+
+    /**
+     * \brief What has been sent for a CAN load.
+     */
+    const LoadStats& get_can_stats(const std::size_t load) const noexcept;
+
+    /**
+     * \brief What has been sent for a TCP load.
+     */
+    const LoadStats& get_tcp_stats(const std::size_t load) const noexcept;
+
+    /**
+     * \brief Prints the requested and achieved rate and the lateness of each
+     * load.
+     */
+    void print(std::ostream& out) const noexcept;
+
+  private:
+    /**
+     * \brief Sends all CAN frames due until now as one batch.
+     */
+    void send_can(const std::int64_t now) noexcept;
+
+    /**
+     * \brief Starts the TCP messages due until now and continues the ones
+     * the socket did not take completely.
+     * \return false if a connection failed.
+     */
+    bool send_tcp(const std::int64_t now) noexcept;
+
+    /**
+     * \brief Prints the achieved rate and the lateness of one load.
+     */
+    static void print_stats(std::ostream& out, const LoadStats& stats,
+                            const double seconds) noexcept;
+
+    /**
+     * \brief A random delay between 0 and jitter.
+     */
+    std::int64_t next_jitter(const std::chrono::microseconds jitter) noexcept;
+
+    /// the socket of the CAN loads.
+    CanSocket& can_;
+
+    /// the load to generate.
+    const LoadSchedule& schedule_;
+
+    /// state of the random numbers (xorshift).
+    std::uint32_t random_;
+
+    /// the start of the current period of each CAN load in ns.
+    std::array< std::int64_t, LOAD_GENERATOR::MAX_CAN_LOADS > can_next_;
+
+    /// the time each CAN load is due in ns, the period start plus jitter.
+    std::array< std::int64_t, LOAD_GENERATOR::MAX_CAN_LOADS > can_due_;
+
+    /// sent frames per CAN load, also the payload of the frames.
+    std::array< LoadStats, LOAD_GENERATOR::MAX_CAN_LOADS > can_stats_;
+
+    /// the connections of the TCP loads.
+    std::array< TcpClient, LOAD_GENERATOR::MAX_TCP_LOADS > tcp_;
+
+    /// the time each TCP load is due in ns.
+    std::array< std::int64_t, LOAD_GENERATOR::MAX_TCP_LOADS > tcp_due_;
+
+    /// bytes of the current message not taken by the socket yet.
+    std::array< std::size_t, LOAD_GENERATOR::MAX_TCP_LOADS > tcp_remaining_;
+
+    /// sent messages per TCP load.
+    std::array< LoadStats, LOAD_GENERATOR::MAX_TCP_LOADS > tcp_stats_;
+
+    /// the payload of the TCP messages.
+    std::array< std::uint8_t, LOAD_GENERATOR::MAX_TCP_SIZE > tcp_payload_;
+
+    /// the time the last run took in ns.
+    std::int64_t run_time_;
+};
+
+#endif // WIN32 detection
+#endif // LOADGENERATOR_H_
@@ -0,0 +1,355 @@
+/**
+ * \file      LoopbackSocket.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     In-memory transport pair with the interface of a TcpSocket.
+ * \details   Two LoopbackSockets are connected by lock-free byte rings. Latency, a
+ *            rate limit and short reads can be injected, so protocol layers are
+ *            benchmarked and tested without the network stack of the kernel.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LoopbackSocket.h"
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LoopbackLink::write(const void* data, const std::size_t len,
+                                const Clock::time_point release) noexcept
+{
+    const std::size_t free_bytes = bytes_.get_free();
+    const std::size_t to_write = (len < free_bytes) ? len : free_bytes;
+    std::size_t written = 0U;
+
+    // bytes without a release time are received right after the bytes before.
+    const bool delayed = (release != Clock::time_point{});
+
+    if ((to_write > 0U) &&
+        ((delayed == false) || (delays_.get_free() >= sizeof(Delay))))
+    {
+        if (delayed)
+        {
+            // the release time is visible before the bytes are.
+            const Delay delay{written_, release.time_since_epoch().count()};
+            delays_.write(&delay, sizeof(delay));
+        }
+
+        written = bytes_.write(data, to_write);
+        written_ += written;
+    }
+
+    return written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LoopbackLink::read(void* data, const std::size_t len) noexcept
+{
+    const std::size_t ready = get_ready();
+    const std::size_t to_read = (len < ready) ? len : ready;
+    const std::size_t read = bytes_.read(data, to_read);
+    read_ += read;
+    return read;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LoopbackLink::get_ready() noexcept
+{
+    // the bytes first: the release times of all of them are visible then.
+    const std::size_t used = bytes_.get_used();
+    std::size_t ready = used;
+    Delay delay;
+
+    while (delays_.peek(&delay, sizeof(delay)) == sizeof(delay))
+    {
+        const Clock::time_point release{Clock::duration{delay.release}};
+
+        if (release <= Clock::now())
+        {
+            delays_.skip(sizeof(delay));
+        }
+        else
+        {
+            // the bytes up to the first delayed one.
+            const auto until = static_cast< std::size_t >(delay.begin - read_);
+            ready = (until < used) ? until : used;
+            break;
+        }
+    }
+
+    return ready;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LoopbackLink::get_free() const noexcept
+{
+    return bytes_.get_free();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+LoopbackLink::Clock::time_point LoopbackLink::get_next_release() const noexcept
+{
+    Delay delay;
+    Clock::time_point release{};
+
+    if (delays_.peek(&delay, sizeof(delay)) == sizeof(delay))
+    {
+        release = Clock::time_point{Clock::duration{delay.release}};
+    }
+
+    return release;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+LoopbackSocket::LoopbackSocket(LoopbackLink& tx, LoopbackLink& rx) noexcept
+    : tx_{tx}, rx_{rx}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+LoopbackSocket::~LoopbackSocket() noexcept { close_socket(); }
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t LoopbackSocket::send(const void* message,
+                                  const std::uint16_t len) noexcept
+{
+    const auto* data = static_cast< const std::uint8_t* >(message);
+    std::int16_t data_sent = -1;
+
+    if (open_ && tx_.is_closed())
+    {
+        last_error_ = EPIPE;
+    }
+    else if (open_ && is_blocking_)
+    {
+        std::size_t sent = 0U;
+        std::uint32_t spins = 0U;
+
+        // like a blocking TCP socket all of the data is sent.
+        while ((sent < len) && (tx_.is_closed() == false))
+        {
+            const std::size_t now_sent = send_some(&data[sent], len - sent);
+            sent += now_sent;
+
+            if ((now_sent == 0U) &&
+                (impairment_.rate != TOKEN_BUCKET::UNLIMITED) &&
+                (tx_.get_free() > 0U))
+            {
+                std::this_thread::sleep_for(rate_limit_.get_delay(len - sent));
+            }
+            else if (now_sent == 0U)
+            {
+                // the peer has to receive first.
+                idle(spins++);
+            }
+        }
+
+        data_sent = static_cast< std::int16_t >(sent);
+
+        if (sent < len)
+        {
+            last_error_ = EPIPE;
+            data_sent = (sent > 0U) ? data_sent : -1;
+        }
+    }
+    else if (open_)
+    {
+        data_sent = static_cast< std::int16_t >(send_some(data, len));
+
+        if ((data_sent == 0) && (len > 0U))
+        {
+            // the link is full or the rate limit is reached.
+            last_error_ = EAGAIN;
+            data_sent = -1;
+        }
+    }
+    else
+    {
+        data_sent = -1;
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t LoopbackSocket::receive(void* message,
+                                     const std::uint16_t len) noexcept
+{
+    std::int16_t data_received = -1;
+
+    if (open_)
+    {
+        if (is_blocking_)
+        {
+            wait_until(Clock::time_point::max());
+        }
+
+        const std::size_t read = rx_.read(message, get_read_size(len));
+        data_received = static_cast< std::int16_t >(read);
+
+        // a closed peer without data left is the end of the stream.
+        if ((read == 0U) && (len > 0U) &&
+            ((rx_.is_closed() && rx_.is_empty()) == false))
+        {
+            last_error_ = EAGAIN;
+            data_received = -1;
+        }
+    }
+
+    return data_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoopbackSocket::set_blocking(const bool blocking) noexcept
+{
+    is_blocking_ = blocking;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LoopbackSocket::set_impairment(
+    const LoopbackImpairment& impairment) noexcept
+{
+    impairment_ = impairment;
+    rate_limit_.set_rate(impairment.rate, impairment.burst);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoopbackSocket::close_socket() noexcept
+{
+    const bool was_open = open_;
+
+    if (open_)
+    {
+        open_ = false;
+        tx_.close();
+        rx_.close();
+    }
+
+    return was_open;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LoopbackSocket::wait_until(const Clock::time_point deadline) noexcept
+{
+    bool ready = false;
+    std::uint32_t spins = 0U;
+
+    while (ready == false)
+    {
+        // closed is checked first, the bytes sent before are visible then.
+        const bool closed = rx_.is_closed();
+        ready = (rx_.get_ready() > 0U) || (closed && rx_.is_empty());
+        const Clock::time_point now = Clock::now();
+
+        if (ready || (now >= deadline))
+        {
+            break;
+        }
+
+        const Clock::time_point release = rx_.get_next_release();
+
+        if (release > now)
+        {
+            // delayed bytes are waiting.
+            std::this_thread::sleep_until((release < deadline) ? release
+                                                               : deadline);
+        }
+        else
+        {
+            idle(spins++);
+        }
+    }
+
+    return ready;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LoopbackSocket::idle(const std::uint32_t spins) noexcept
+{
+    if (spins < LOOPBACK::SPINS)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        const std::uint32_t sleep = LOOPBACK::IDLE_SLEEP;
+        std::this_thread::sleep_for(std::chrono::microseconds{sleep});
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LoopbackSocket::send_some(const std::uint8_t* data,
+                                      const std::size_t len) noexcept
+{
+    const std::size_t free_bytes = tx_.get_free();
+    std::size_t allowed = (len < free_bytes) ? len : free_bytes;
+    const bool limited = (impairment_.rate != TOKEN_BUCKET::UNLIMITED);
+
+    if (limited && (allowed > 0U))
+    {
+        allowed = rate_limit_.take(allowed);
+    }
+
+    const Clock::time_point release =
+        (impairment_.latency.count() > 0) ? (Clock::now() + impairment_.latency)
+                                          : Clock::time_point{};
+    const std::size_t sent = tx_.write(data, allowed, release);
+
+    // tokens of bytes the link did not take are not lost.
+    if (limited && (sent < allowed))
+    {
+        rate_limit_.refund(allowed - sent);
+    }
+
+    return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LoopbackSocket::get_read_size(const std::size_t len) noexcept
+{
+    std::size_t size = len;
+
+    if (impairment_.max_read > 0U)
+    {
+        std::size_t limit = impairment_.max_read;
+
+        if (impairment_.random_reads)
+        {
+            // xorshift32, the same sizes in every run.
+            random_ ^= random_ << 13U;
+            random_ ^= random_ >> 17U;
+            random_ ^= random_ << 5U;
+            limit = 1U + (random_ % limit);
+        }
+
+        size = (size < limit) ? size : limit;
+    }
+
+    return size;
+}
@@ -0,0 +1,363 @@
+/**
+ * \file      LoopbackSocket.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     In-memory transport pair with the interface of a TcpSocket.
+ * \details   Two LoopbackSockets are connected by lock-free byte rings. Latency, a
+ *            rate limit and short reads can be injected, so protocol layers are
+ *            benchmarked and tested without the network stack of the kernel.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOOPBACKSOCKET_H_
+#define LOOPBACKSOCKET_H_
+
+#include "ByteRing.h"
+#include "TokenBucket.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/**
+ * \brief Defining a struct that holds the sizes of the loopback transport.
+ */
+struct LOOPBACK
+{
+    // bytes in flight in one direction.
+    static constexpr std::size_t RING_SIZE{65536U};
+    // bytes of the release times of delayed sends in one direction.
+    static constexpr std::size_t DELAY_RING_SIZE{16384U};
+    // yields of a blocking call before it sleeps, lets a peer on the same
+    // CPU run.
+    static constexpr std::uint32_t SPINS{64U};
+    // sleep of a blocking call after the yields in microseconds.
+    static constexpr std::uint32_t IDLE_SLEEP{1U};
+    // seed of the random read sizes, the same in every run.
+    static constexpr std::uint32_t SEED{0x9E3779B9U};
+};
+
+/**
+ * \brief The impairments of one LoopbackSocket. Latency and rate apply to the
+ * data it sends, the read size to the data it receives.
+ */
+struct LoopbackImpairment
+{
+    /// time from a send until the peer can receive the data.
+    std::chrono::microseconds latency{0};
+    /// bytes per second sent, TOKEN_BUCKET::UNLIMITED for no limit.
+    std::uint64_t rate{TOKEN_BUCKET::UNLIMITED};
+    /// bytes sent at once after the sender was idle.
+    std::size_t burst{TOKEN_BUCKET::DEFAULT_BURST};
+    /// most bytes one receive returns, 0 for no limit.
+    std::uint16_t max_read{0U};
+    /// true if a receive returns a random number of bytes up to max_read.
+    bool random_reads{false};
+};
+
+/**
+ * \brief One direction of a loopback transport: the sent bytes and the times
+ * they may be received at. One thread sends while another thread receives
+ * without locking.
+ */
+class LoopbackLink
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    LoopbackLink() noexcept = default;
+
+    LoopbackLink(const LoopbackLink&) = delete;
+    LoopbackLink& operator=(const LoopbackLink&) = delete;
+
+    /**
+     * \brief Writes up to len bytes, received not before release.
+     * \return the number of bytes written, 0 if the link is full.
+     */
+    std::size_t write(const void* data, const std::size_t len,
+                      const Clock::time_point release) noexcept;
+
+    /**
+     * \brief Reads up to len bytes that are released already.
+     * \return the number of bytes read.
+     */
+    std::size_t read(void* data, const std::size_t len) noexcept;
+
+    /**
+     * \brief Number of bytes that are released already.
+     */
+    std::size_t get_ready() noexcept;
+
+    /**
+     * \brief true if no bytes are in flight, released or not.
+     */
+    bool is_empty() const noexcept { return bytes_.get_used() == 0U; }
+
+    /**
+     * \brief Number of bytes that fit into the link.
+     */
+    std::size_t get_free() const noexcept;
+
+    /**
+     * \brief The time the next delayed bytes are released at,
+     * Clock::time_point{} if there are none.
+     */
+    Clock::time_point get_next_release() const noexcept;
+
+    /**
+     * \brief Marks that one of the sockets is closed.
+     */
+    void close() noexcept { closed_.store(true, std::memory_order_release); }
+
+    /**
+     * \brief true if one of the sockets is closed.
+     */
+    bool is_closed() const noexcept
+    {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+  private:
+    /**
+     * \brief Bytes from begin onwards are received not before release.
+     */
+    struct Delay
+    {
+        std::uint64_t begin;
+        Clock::rep release;
+    };
+
+    /// the bytes in flight.
+    ByteRing< LOOPBACK::RING_SIZE > bytes_;
+
+    /// the release times of delayed bytes, oldest first.
+    ByteRing< LOOPBACK::DELAY_RING_SIZE > delays_;
+
+    /// bytes written in total, only changed by the sender.
+    std::uint64_t written_{0U};
+
+    /// bytes read in total, only changed by the receiver.
+    std::uint64_t read_{0U};
+
+    /// true if one of the sockets is closed.
+    std::atomic< bool > closed_{false};
+};
+
+/**
+ * \brief One end of a loopback transport. It has the send(), receive(),
+ * set_blocking() and wait_for() of a TcpSocket, so a protocol layer written
+ * against this interface runs over memory instead of the network. Errors are
+ * those of a TcpSocket: EAGAIN if a non-blocking call would block, EPIPE on a
+ * send to a closed peer, and a receive of 0 bytes if the peer is closed.
+ * \remarks One thread uses one socket; the two sockets of a pair may be used
+ * by two threads.
+ */
+class LoopbackSocket
+{
+  public:
+    using Clock = LoopbackLink::Clock;
+
+    /**
+     * \brief Creates one end that sends on tx and receives on rx.
+     */
+    LoopbackSocket(LoopbackLink& tx, LoopbackLink& rx) noexcept;
+
+    /**
+     * \brief Closes the socket.
+     */
+    ~LoopbackSocket() noexcept;
+
+    LoopbackSocket(const LoopbackSocket&) = delete;
+    LoopbackSocket& operator=(const LoopbackSocket&) = delete;
+
+    /**
+     * \brief Sends to the peer. A blocking socket waits until all of the
+     * data is sent, a non-blocking one sends what fits and the rate allows.
+     * \param[in] message is the data to send
+     * \param[in] len is the length to send
+     * \return the number of bytes that have been sent or -1 if there is an
+     * error.
+     */
+    std::int16_t send(const void* message, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Receives from the peer. A blocking socket waits until data is
+     * released or the peer is closed.
+     * \param[out] message is the container to store the received data
+     * \param[in] len the length to receive
+     * \return how much data has been received, 0 if the peer is closed, -1 if
+     * there is an error.
+     */
+    std::int16_t receive(void* message, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Waits until data can be received or the peer is closed.
+     * \param[in] deadline Time to wait.
+     * \return true if a receive will not block.
+     */
+    template < typename Duration >
+    bool wait_for(const Duration&& deadline) noexcept
+    {
+        return wait_until(Clock::now() + deadline);
+    }
+
+    /**
+     * \brief Set the socket into blocking or non-blocking mode.
+     * \return true, this does not fail.
+     */
+    bool set_blocking(const bool blocking) noexcept;
+
+    /**
+     * \brief Check if this socket is blocking or non-blocking.
+     */
+    bool is_blocking() const noexcept { return is_blocking_; }
+
+    /**
+     * \brief Sets the latency, rate and read size. Call it from the thread
+     * that uses this socket.
+     */
+    void set_impairment(const LoopbackImpairment& impairment) noexcept;
+
+    /**
+     * \brief The impairments set.
+     */
+    const LoopbackImpairment& get_impairment() const noexcept
+    {
+        return impairment_;
+    }
+
+    /**
+     * \brief Closes the socket, the peer receives 0 bytes afterwards.
+     * \return true if the socket was open.
+     */
+    bool close_socket() noexcept;
+
+    /**
+     * \brief If the socket is open.
+     */
+    bool is_socket_initialized() const noexcept { return open_; }
+
+    /**
+     * \brief Gets the last error, an errno value.
+     */
+    int get_last_error() const noexcept { return last_error_; }
+
+  private:
+    /**
+     * \brief Waits until data can be received or the peer is closed.
+     */
+    bool wait_until(const Clock::time_point deadline) noexcept;
+
+    /**
+     * \brief Gives the CPU to the peer while a blocking call waits.
+     * \param[in] spins number of times waited before.
+     */
+    static void idle(const std::uint32_t spins) noexcept;
+
+    /**
+     * \brief Sends as much as fits into the link and the rate allows.
+     * \return the number of bytes sent.
+     */
+    std::size_t send_some(const std::uint8_t* data,
+                          const std::size_t len) noexcept;
+
+    /**
+     * \brief The number of bytes the next receive returns at most.
+     */
+    std::size_t get_read_size(const std::size_t len) noexcept;
+
+    /// the link to the peer.
+    LoopbackLink& tx_;
+
+    /// the link from the peer.
+    LoopbackLink& rx_;
+
+    /// the impairments of this end.
+    LoopbackImpairment impairment_;
+
+    /// the rate limit of send().
+    TokenBucket rate_limit_;
+
+    /// state of the random read sizes.
+    std::uint32_t random_{LOOPBACK::SEED};
+
+    /// the last errno value.
+    int last_error_{0};
+
+    /// true until the socket is closed.
+    bool open_{true};
+
+    /// Either the socket is in blocking or non-blocking mode.
+    bool is_blocking_{true};
+};
+
+/**
+ * \brief Two connected LoopbackSockets.
+ * \code
+ * LoopbackPair pair;
+ * pair.get_client().send(request, sizeof(request));
+ * pair.get_server().receive(buffer, sizeof(buffer));
+ * \endcode
+ */
+class LoopbackPair
+{
+  public:
+    LoopbackPair() noexcept
+        : client_{to_server_, to_client_}, server_{to_client_, to_server_}
+    {
+    }
+
+    /**
+     * \brief The one end.
+     */
+    LoopbackSocket& get_client() noexcept { return client_; }
+
+    /**
+     * \brief The other end.
+     */
+    LoopbackSocket& get_server() noexcept { return server_; }
+
+  private:
+    /// the data from the client to the server.
+    LoopbackLink to_server_;
+
+    /// the data from the server to the client.
+    LoopbackLink to_client_;
+
+    /// the one end.
+    LoopbackSocket client_;
+
+    /// the other end.
+    LoopbackSocket server_;
+};
+
+#endif /* LOOPBACKSOCKET_H_ */
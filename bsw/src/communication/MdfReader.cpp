@@ -0,0 +1,773 @@
+/**
+ * \file      MdfReader.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Indexed reader of ASAM MDF4 measurement files.
+ * \details   Maps a file into memory, indexes the data blocks of every group by
+ *            their data lists and finds records by time without reading the rest.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MdfReader.h"
+
+#ifndef _WIN32
+
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef BSW_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+/// the header every block starts with: id, reserved, length, link count.
+constexpr std::size_t HEADER_SIZE{24U};
+
+/// the header block follows the identification block.
+constexpr std::uint64_t HD_POSITION{64U};
+
+/// channel types.
+constexpr std::uint8_t CN_MASTER{2U};
+constexpr std::uint8_t CN_VIRTUAL_MASTER{3U};
+
+/// data types.
+constexpr std::uint8_t UINT_LE{0U};
+constexpr std::uint8_t INT_LE{2U};
+constexpr std::uint8_t FLOAT_LE{4U};
+
+/// a channel group of variable length signal data.
+constexpr std::uint16_t CG_VLSD{0x0001U};
+
+/// a channel group of bus events.
+constexpr std::uint16_t CG_BUS_EVENT{0x0002U};
+
+/// a linear conversion.
+constexpr std::uint8_t CC_LINEAR{1U};
+
+/// deflate after transposing the records into columns.
+constexpr std::uint8_t ZIP_TRANSPOSE_DEFLATE{1U};
+
+/// compositions nested deeper are not read.
+constexpr std::size_t MAX_DEPTH{8U};
+
+/// the names of the channels of a CAN_DataFrame, in the order of CanChannel.
+constexpr std::array< const char*, 10U > CAN_NAMES{
+    {"CAN_DataFrame.BusChannel", "CAN_DataFrame.ID", "CAN_DataFrame.IDE",
+     "CAN_DataFrame.DLC", "CAN_DataFrame.Dir", "CAN_DataFrame.EDL",
+     "CAN_DataFrame.BRS", "CAN_DataFrame.ESI", "CAN_DataFrame.DataLength",
+     "CAN_DataFrame.DataBytes"}};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Reads a little-endian number.
+ */
+template < typename T > T read_le(const std::uint8_t* data) noexcept
+{
+    T value = 0U;
+
+    for (std::size_t i = sizeof(T); i > 0U; --i)
+    {
+        value = static_cast< T >((value << 8U) | data[i - 1U]);
+    }
+
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Reads a little-endian double.
+ */
+double read_double(const std::uint8_t* data) noexcept
+{
+    const std::uint64_t bits = read_le< std::uint64_t >(data);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief A link of a block.
+ */
+std::uint64_t get_link(const std::uint8_t* block,
+                       const std::size_t index) noexcept
+{
+    return read_le< std::uint64_t >(&block[HEADER_SIZE + (index * 8U)]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The data of a block, after its links.
+ */
+const std::uint8_t* get_data(const std::uint8_t* block) noexcept
+{
+    return &block[HEADER_SIZE + (read_le< std::uint64_t >(&block[16]) * 8U)];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The size of a block.
+ */
+std::uint64_t get_length(const std::uint8_t* block) noexcept
+{
+    return read_le< std::uint64_t >(&block[8]);
+}
+} // namespace
+
+/// compared by reference, so it needs a definition.
+constexpr std::size_t MDF_READER::NOT_FOUND;
+
+////////////////////////////////////////////////////////////////////////////////
+MdfReader::MdfReader() noexcept
+    : data_{nullptr}, size_{0U}, start_time_{0U}, groups_{}, channels_{},
+      blocks_{}, loaded_block_{MDF_READER::NOT_FOUND}, loaded_data_{nullptr},
+      inflated_{}, transposed_{}, record_{}, inflated_count_{0U}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MdfReader::~MdfReader() noexcept
+{
+    if (data_ != nullptr)
+    {
+        munmap(const_cast< std::uint8_t* >(data_), size_);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MdfReader::open(const char* path) noexcept
+{
+    if (data_ != nullptr)
+    {
+        std::cerr << "MdfReader: a file is open already.\n";
+        return false;
+    }
+
+    const int fd = ::open(path, O_RDONLY);
+    struct stat info;
+
+    if ((fd >= 0) && (fstat(fd, &info) == 0) &&
+        (static_cast< std::uint64_t >(info.st_size) > HD_POSITION))
+    {
+        size_ = static_cast< std::size_t >(info.st_size);
+        void* const data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        data_ = (data != MAP_FAILED) ? static_cast< const std::uint8_t* >(data)
+                                     : nullptr;
+    }
+
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+
+    // finalized or not, version 4.
+    const std::uint8_t* const header =
+        ((data_ != nullptr) &&
+         ((std::memcmp(data_, "MDF     ", 8U) == 0) ||
+          (std::memcmp(data_, "UnFinMF ", 8U) == 0)) &&
+         (read_le< std::uint16_t >(&data_[28]) >= 400U))
+            ? get_block(HD_POSITION, "##HD")
+            : nullptr;
+
+    if (header == nullptr)
+    {
+        std::cerr << "MdfReader: " << path << " is no MDF 4 file.\n";
+        return false;
+    }
+
+    start_time_ = read_le< std::uint64_t >(get_data(header));
+
+    // the chain of data groups, a chain of a loop ends with the file.
+    std::uint64_t link = get_link(header, 0U);
+    for (std::size_t i = 0U; (link != 0U) && (i < (size_ / HEADER_SIZE)); ++i)
+    {
+        const std::uint8_t* const data_group = get_block(link, "##DG");
+
+        if (data_group == nullptr)
+        {
+            break;
+        }
+
+        add_group(data_group);
+        link = get_link(data_group, 0U);
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const char* MdfReader::get_group_name(const std::size_t group) const noexcept
+{
+    return (group < groups_.size()) ? groups_[group].name : "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t MdfReader::find_group(const char* name) const noexcept
+{
+    std::size_t found = MDF_READER::NOT_FOUND;
+
+    for (std::size_t i = 0U;
+         (i < groups_.size()) && (found == MDF_READER::NOT_FOUND); ++i)
+    {
+        found = (std::strcmp(groups_[i].name, name) == 0) ? i : found;
+    }
+
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MdfReader::is_can_group(const std::size_t group) const noexcept
+{
+    return (group < groups_.size()) &&
+           (groups_[group].can[ID] != MDF_READER::NOT_FOUND) &&
+           (groups_[group].can[DATA_LENGTH] != MDF_READER::NOT_FOUND) &&
+           (groups_[group].can[DATA_BYTES] != MDF_READER::NOT_FOUND);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfReader::get_record_count(const std::size_t group) const
+    noexcept
+{
+    return (group < groups_.size()) ? groups_[group].records : 0U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t MdfReader::get_channel_count(const std::size_t group) const
+    noexcept
+{
+    return (group < groups_.size()) ? groups_[group].channel_count : 0U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const char* MdfReader::get_channel_name(const std::size_t group,
+                                        const std::size_t channel) const
+    noexcept
+{
+    return (channel < get_channel_count(group))
+               ? channels_[groups_[group].first_channel + channel].name
+               : "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t MdfReader::find_channel(const std::size_t group,
+                                    const char* name) const noexcept
+{
+    std::size_t found = MDF_READER::NOT_FOUND;
+
+    for (std::size_t i = 0U; (i < get_channel_count(group)) &&
+                             (found == MDF_READER::NOT_FOUND);
+         ++i)
+    {
+        found = (std::strcmp(get_channel_name(group, i), name) == 0) ? i
+                                                                      : found;
+    }
+
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const std::uint8_t* MdfReader::get_record(const std::size_t group,
+                                          const std::uint64_t index) noexcept
+{
+    if (index >= get_record_count(group))
+    {
+        return nullptr;
+    }
+
+    // the data list tells the block that holds the record.
+    const Group& read = groups_[group];
+    const std::uint64_t position = index * read.record_size;
+    const auto begin = blocks_.begin() + read.first_block;
+    const auto end = begin + read.block_count;
+    const auto after = std::upper_bound(
+        begin, end, position, [](const std::uint64_t value,
+                                 const DataBlock& block) {
+            return value < block.offset;
+        });
+    auto block = static_cast< std::size_t >(after - blocks_.begin()) - 1U;
+    const std::uint8_t* data = load_block(block);
+    const std::uint64_t within = position - blocks_[block].offset;
+    const std::uint8_t* record = nullptr;
+
+    if ((data != nullptr) &&
+        ((within + read.record_size) <= blocks_[block].size))
+    {
+        record = &data[within];
+    }
+    else if (data != nullptr)
+    {
+        // the record continues in the next blocks.
+        record_.resize(read.record_size);
+        std::size_t copied = static_cast< std::size_t >(
+            blocks_[block].size - within);
+        std::memcpy(record_.data(), &data[within], copied);
+
+        while ((data != nullptr) && (copied < read.record_size) &&
+               (++block < (read.first_block + read.block_count)))
+        {
+            data = load_block(block);
+            const std::size_t part = static_cast< std::size_t >(
+                std::min< std::uint64_t >(read.record_size - copied,
+                                          blocks_[block].size));
+
+            if (data != nullptr)
+            {
+                std::memcpy(&record_[copied], data, part);
+                copied += part;
+            }
+        }
+
+        record = (copied == read.record_size) ? record_.data() : nullptr;
+    }
+
+    return record;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfReader::get_time(const std::size_t group,
+                                  const std::uint8_t* record) const noexcept
+{
+    const double seconds =
+        ((group < groups_.size()) &&
+         (groups_[group].master != MDF_READER::NOT_FOUND))
+            ? get_value(group, groups_[group].master, record)
+            : 0.0;
+
+    return start_time_ +
+           static_cast< std::uint64_t >(std::llround(seconds * 1e9));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double MdfReader::get_value(const std::size_t group, const std::size_t channel,
+                            const std::uint8_t* record) const noexcept
+{
+    double value = std::numeric_limits< double >::quiet_NaN();
+
+    if ((channel < get_channel_count(group)) && (record != nullptr))
+    {
+        const Group& read = groups_[group];
+        const Channel& decode = channels_[read.first_channel + channel];
+        const std::uint64_t raw = get_raw(read, decode, record);
+
+        if (decode.data_type == UINT_LE)
+        {
+            value = static_cast< double >(raw);
+        }
+        else if ((decode.data_type == INT_LE) && (decode.bit_count > 0U))
+        {
+            // the sign bit is extended.
+            const std::uint64_t sign = std::uint64_t{1U}
+                                       << (decode.bit_count - 1U);
+            value = static_cast< double >(
+                static_cast< std::int64_t >((raw ^ sign) - sign));
+        }
+        else if ((decode.data_type == FLOAT_LE) && (decode.bit_count == 64U))
+        {
+            std::memcpy(&value, &raw, sizeof(value));
+        }
+        else if ((decode.data_type == FLOAT_LE) && (decode.bit_count == 32U))
+        {
+            const auto bits = static_cast< std::uint32_t >(raw);
+            float single;
+            std::memcpy(&single, &bits, sizeof(single));
+            value = static_cast< double >(single);
+        }
+
+        value = decode.offset + (decode.factor * value);
+    }
+
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MdfReader::get_can_frame(const std::size_t group,
+                              const std::uint8_t* record,
+                              CanLogRecord& frame) const noexcept
+{
+    if ((is_can_group(group) == false) || (record == nullptr))
+    {
+        return false;
+    }
+
+    const Group& read = groups_[group];
+    const auto raw = [this, &read, record](const CanChannel channel) {
+        return (read.can[channel] != MDF_READER::NOT_FOUND)
+                   ? get_raw(read,
+                             channels_[read.first_channel + read.can[channel]],
+                             record)
+                   : 0U;
+    };
+
+    std::memset(&frame, 0, sizeof(frame));
+    frame.timestamp = get_time(group, record);
+    frame.channel = static_cast< std::uint16_t >(raw(BUS_CHANNEL));
+    frame.tx = raw(DIR) != 0U;
+    frame.fd = raw(EDL) != 0U;
+    frame.frame.flags =
+        static_cast< std::uint8_t >(((raw(BRS) != 0U) ? CANFD_BRS : 0) |
+                                    ((raw(ESI) != 0U) ? CANFD_ESI : 0));
+    frame.frame.can_id = static_cast< canid_t >(raw(ID)) & CAN_EFF_MASK;
+    frame.frame.can_id |= (raw(IDE) != 0U) ? CAN_EFF_FLAG : 0U;
+
+    // the data bytes are at most as long as the channel.
+    const Channel& data = channels_[read.first_channel + read.can[DATA_BYTES]];
+    const std::uint64_t available =
+        ((data.byte_offset + (data.bit_count / 8U)) <= read.record_size)
+            ? (data.bit_count / 8U)
+            : 0U;
+    const std::uint64_t len = raw(DATA_LENGTH);
+    frame.frame.len = static_cast< std::uint8_t >(
+        std::min< std::uint64_t >(std::min< std::uint64_t >(len, available),
+                                  CANFD_MAX_DLEN));
+    std::memcpy(frame.frame.data, &record[data.byte_offset], frame.frame.len);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfReader::seek(const std::size_t group,
+                              const std::uint64_t time) noexcept
+{
+    // the records of a group are in the order of their time.
+    std::uint64_t low = 0U;
+    std::uint64_t high = get_record_count(group);
+
+    while (low < high)
+    {
+        const std::uint64_t middle = low + ((high - low) / 2U);
+        const std::uint8_t* const record = get_record(group, middle);
+
+        if ((record != nullptr) && (get_time(group, record) < time))
+        {
+            low = middle + 1U;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const std::uint8_t* MdfReader::get_block(const std::uint64_t link,
+                                         const char* id) const noexcept
+{
+    const std::uint8_t* block = nullptr;
+
+    if ((link >= HD_POSITION) && ((link + HEADER_SIZE) <= size_) &&
+        (std::memcmp(&data_[link], id, 4U) == 0))
+    {
+        const std::uint8_t* const found = &data_[link];
+        const std::uint64_t links = read_le< std::uint64_t >(&found[16]);
+        const std::uint64_t length = get_length(found);
+        block = ((length <= (size_ - link)) &&
+                 (links <= ((length - HEADER_SIZE) / 8U)))
+                    ? found
+                    : nullptr;
+    }
+
+    return block;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const char* MdfReader::get_text(const std::uint64_t link) const noexcept
+{
+    const std::uint8_t* block = get_block(link, "##TX");
+    block = (block != nullptr) ? block : get_block(link, "##MD");
+    const char* text = "";
+
+    // the text must end in the block.
+    if ((block != nullptr) &&
+        (std::memchr(get_data(block), 0,
+                     static_cast< std::size_t >(get_length(block) -
+                                                HEADER_SIZE)) != nullptr))
+    {
+        text = reinterpret_cast< const char* >(get_data(block));
+    }
+
+    return text;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MdfReader::add_group(const std::uint8_t* data_group) noexcept
+{
+    const std::uint8_t* const channel_group =
+        get_block(get_link(data_group, 1U), "##CG");
+    const std::uint8_t id_size = get_data(data_group)[0];
+
+    if ((channel_group == nullptr) || (id_size != 0U) ||
+        (get_link(channel_group, 0U) != 0U))
+    {
+        // unsorted groups need to be sorted first.
+        std::cerr << "MdfReader: skipped an unsorted data group.\n";
+        return;
+    }
+
+    const std::uint8_t* const data = get_data(channel_group);
+    const auto flags = read_le< std::uint16_t >(&data[16]);
+
+    if ((flags & CG_VLSD) != 0U)
+    {
+        return;
+    }
+
+    Group group;
+    group.name = get_text(get_link(channel_group, 2U));
+    group.record_size = read_le< std::uint32_t >(&data[24]) +
+                        read_le< std::uint32_t >(&data[28]);
+    group.first_channel = channels_.size();
+    add_channels(get_link(channel_group, 1U), 0U);
+    group.channel_count = channels_.size() - group.first_channel;
+    group.can.fill(MDF_READER::NOT_FOUND);
+
+    for (std::size_t i = 0U; i < group.channel_count; ++i)
+    {
+        const Channel& channel = channels_[group.first_channel + i];
+        group.master = channel.master ? i : group.master;
+
+        for (std::size_t c = 0U; ((flags & CG_BUS_EVENT) != 0U) &&
+                                 (c < CAN_NAMES.size());
+             ++c)
+        {
+            group.can[c] = (std::strcmp(channel.name, CAN_NAMES[c]) == 0)
+                               ? i
+                               : group.can[c];
+        }
+    }
+
+    // the index of the data blocks, the records follow from the data.
+    group.first_block = blocks_.size();
+    const std::uint64_t size = add_blocks(get_link(data_group, 2U), 0U);
+    group.block_count = blocks_.size() - group.first_block;
+    group.records = (group.record_size > 0U) ? (size / group.record_size) : 0U;
+    groups_.push_back(group);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MdfReader::add_channels(std::uint64_t link,
+                             const std::size_t depth) noexcept
+{
+    for (std::size_t i = 0U; (link != 0U) && (i < (size_ / HEADER_SIZE)); ++i)
+    {
+        const std::uint8_t* const block = get_block(link, "##CN");
+
+        if (block == nullptr)
+        {
+            break;
+        }
+
+        const std::uint8_t* const data = get_data(block);
+        Channel channel{get_text(get_link(block, 2U)),
+                        data[2],
+                        read_le< std::uint32_t >(&data[4]),
+                        data[3],
+                        read_le< std::uint32_t >(&data[8]),
+                        0.0,
+                        1.0,
+                        data[0] == CN_MASTER};
+
+        // a linear conversion.
+        const std::uint8_t* const conversion =
+            get_block(get_link(block, 4U), "##CC");
+        if ((conversion != nullptr) && (get_data(conversion)[0] == CC_LINEAR) &&
+            (read_le< std::uint16_t >(&get_data(conversion)[6]) >= 2U))
+        {
+            channel.offset = read_double(&get_data(conversion)[24]);
+            channel.factor = read_double(&get_data(conversion)[32]);
+        }
+
+        if (data[0] != CN_VIRTUAL_MASTER)
+        {
+            channels_.push_back(channel);
+        }
+
+        // the channels of a structure follow the structure.
+        if (depth < MAX_DEPTH)
+        {
+            add_channels(get_link(block, 1U), depth + 1U);
+        }
+
+        link = get_link(block, 0U);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfReader::add_blocks(std::uint64_t link,
+                                    std::uint64_t offset) noexcept
+{
+    const std::uint64_t first = offset;
+    const std::uint8_t* const header = get_block(link, "##HL");
+    link = (header != nullptr) ? get_link(header, 0U) : link;
+
+    for (std::size_t i = 0U; (link != 0U) && (i < (size_ / HEADER_SIZE)); ++i)
+    {
+        const std::uint8_t* const list = get_block(link, "##DL");
+        const std::uint8_t* const raw = get_block(link, "##DT");
+        const std::uint8_t* const deflated = get_block(link, "##DZ");
+
+        if (raw != nullptr)
+        {
+            const std::uint64_t size = get_length(raw) - HEADER_SIZE;
+            blocks_.push_back(DataBlock{link, offset, size});
+            offset += size;
+            link = 0U;
+        }
+        else if ((deflated != nullptr) &&
+                 (std::memcmp(get_data(deflated), "DT", 2U) == 0))
+        {
+            const std::uint64_t size =
+                read_le< std::uint64_t >(&get_data(deflated)[8]);
+            blocks_.push_back(DataBlock{link, offset, size});
+            offset += size;
+            link = 0U;
+        }
+        else if (list != nullptr)
+        {
+            // the blocks of the list, then the next list.
+            const std::uint32_t count =
+                read_le< std::uint32_t >(&get_data(list)[4]);
+            const std::uint64_t links = read_le< std::uint64_t >(&list[16]);
+
+            for (std::uint64_t b = 1U; (b <= count) && (b < links); ++b)
+            {
+                offset += add_blocks(get_link(list, b), offset);
+            }
+
+            link = get_link(list, 0U);
+        }
+        else
+        {
+            std::cerr << "MdfReader: unknown data block.\n";
+            link = 0U;
+        }
+    }
+
+    return offset - first;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const std::uint8_t* MdfReader::load_block(const std::size_t block) noexcept
+{
+    if (block == loaded_block_)
+    {
+        return loaded_data_;
+    }
+
+    const DataBlock& load = blocks_[block];
+    const std::uint8_t* const raw = get_block(load.link, "##DT");
+    loaded_block_ = block;
+    loaded_data_ = (raw != nullptr) ? get_data(raw) : nullptr;
+
+#ifdef BSW_WITH_ZLIB
+    const std::uint8_t* const deflated = get_block(load.link, "##DZ");
+
+    if (deflated != nullptr)
+    {
+        const std::uint8_t* const data = get_data(deflated);
+        const std::uint8_t zip_type = data[2];
+        const auto columns = read_le< std::uint32_t >(&data[4]);
+        const auto compressed = read_le< std::uint64_t >(&data[16]);
+        inflated_.resize(static_cast< std::size_t >(load.size));
+        transposed_.resize(static_cast< std::size_t >(load.size));
+        std::uint8_t* const out = (zip_type == ZIP_TRANSPOSE_DEFLATE)
+                                      ? transposed_.data()
+                                      : inflated_.data();
+        uLongf length = static_cast< uLongf >(load.size);
+        const bool valid =
+            ((compressed + (2U * HEADER_SIZE)) <= get_length(deflated)) &&
+            (uncompress(out, &length, &data[HEADER_SIZE], compressed) ==
+             Z_OK) &&
+            (length == load.size);
+
+        if (valid && (zip_type == ZIP_TRANSPOSE_DEFLATE) && (columns > 0U))
+        {
+            // the rows of the matrix are the records, the rest is not
+            // transposed.
+            const std::size_t rows = length / columns;
+            for (std::size_t row = 0U; row < rows; ++row)
+            {
+                for (std::size_t column = 0U; column < columns; ++column)
+                {
+                    inflated_[(row * columns) + column] =
+                        transposed_[(column * rows) + row];
+                }
+            }
+
+            const std::size_t full = rows * columns;
+            std::memcpy(&inflated_[full], &transposed_[full], length - full);
+        }
+
+        loaded_data_ = valid ? inflated_.data() : nullptr;
+        ++inflated_count_;
+    }
+#endif
+
+    if (loaded_data_ == nullptr)
+    {
+        std::cerr << "MdfReader: could not decode a data block.\n";
+    }
+
+    return loaded_data_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfReader::get_raw(const Group& group, const Channel& channel,
+                                 const std::uint8_t* record) const noexcept
+{
+    // up to 64 bits within the record.
+    const std::size_t bytes = (channel.bit_offset + channel.bit_count + 7U) /
+                              8U;
+    std::uint64_t raw = 0U;
+
+    if ((bytes <= 8U) && ((channel.byte_offset + bytes) <= group.record_size))
+    {
+        for (std::size_t i = bytes; i > 0U; --i)
+        {
+            raw = (raw << 8U) | record[channel.byte_offset + i - 1U];
+        }
+
+        raw >>= channel.bit_offset;
+        raw &= (channel.bit_count < 64U)
+                   ? ((std::uint64_t{1U} << channel.bit_count) - 1U)
+                   : ~std::uint64_t{0U};
+    }
+
+    return raw;
+}
+
+#endif // WIN32 detection
@@ -0,0 +1,368 @@
+/**
+ * \file      MdfReader.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Indexed reader of ASAM MDF4 measurement files.
+ * \details   Maps a file into memory, indexes the data blocks of every group by
+ *            their data lists and finds records by time without reading the rest.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MDFREADER_H_
+#define MDFREADER_H_
+
+#ifndef _WIN32
+
+#include "CanLogReader.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Defining a struct that holds the constants of the MDF reader.
+ */
+struct MDF_READER
+{
+    // a group or channel that is not found.
+    static constexpr std::size_t NOT_FOUND{static_cast< std::size_t >(-1)};
+};
+
+/**
+ * \brief MdfReader reads ASAM MDF 4 files, sorted ones as MdfWriter writes
+ * them. The file is mapped into memory. open() reads the groups, their
+ * channels and the data lists, which tell where each data block lies in the
+ * data of a group. A record is found by its index in the data list, so
+ * seek() finds the first record at a time with a binary search that only
+ * decodes the blocks it looks at. Deflated blocks are inflated one at a time
+ * if zlib is there.
+ *
+ * Channels of unsigned, signed and float numbers in little-endian are
+ * decoded, with a linear conversion if they have one. CAN bus logging groups
+ * are decoded into frames.
+ * \code
+ * MdfReader reader;
+ * reader.open("drive.mf4");
+ * const auto group = reader.find_group("CAN_DataFrame");
+ * reader.read(group, begin, end,
+ *             [&](std::uint64_t time, const std::uint8_t* record) {
+ *                 CanLogRecord frame;
+ *                 reader.get_can_frame(group, record, frame);
+ *             });
+ * \endcode
+ */
+class MdfReader
+{
+  public:
+    /**
+     * \brief Creates a reader without a file.
+     */
+    MdfReader() noexcept;
+
+    /**
+     * \brief Unmaps the file.
+     */
+    ~MdfReader() noexcept;
+
+    MdfReader(const MdfReader&) = delete;
+    MdfReader& operator=(const MdfReader&) = delete;
+
+    /**
+     * \brief Maps a file and reads its groups.
+     * \return false if the file is no MDF 4 file.
+     */
+    bool open(const char* path) noexcept;
+
+    /**
+     * \brief The start of the measurement in ns since the epoch.
+     */
+    std::uint64_t get_start_time() const noexcept { return start_time_; }
+
+    /**
+     * \brief The number of groups that can be read.
+     */
+    std::size_t get_group_count() const noexcept { return groups_.size(); }
+
+    /**
+     * \brief The acquisition name of a group.
+     */
+    const char* get_group_name(const std::size_t group) const noexcept;
+
+    /**
+     * \brief Finds a group by its acquisition name.
+     * \return the group or MDF_READER::NOT_FOUND.
+     */
+    std::size_t find_group(const char* name) const noexcept;
+
+    /**
+     * \brief True if a group holds CAN frames.
+     */
+    bool is_can_group(const std::size_t group) const noexcept;
+
+    /**
+     * \brief The number of records of a group.
+     */
+    std::uint64_t get_record_count(const std::size_t group) const noexcept;
+
+    /**
+     * \brief The number of channels of a group, the master included.
+     */
+    std::size_t get_channel_count(const std::size_t group) const noexcept;
+
+    /**
+     * \brief The name of a channel.
+     */
+    const char* get_channel_name(const std::size_t group,
+                                 const std::size_t channel) const noexcept;
+
+    /**
+     * \brief Finds a channel of a group by its name.
+     * \return the channel or MDF_READER::NOT_FOUND.
+     */
+    std::size_t find_channel(const std::size_t group,
+                             const char* name) const noexcept;
+
+    /**
+     * \brief A record of a group.
+     * \return the record, valid until the next call; nullptr if there is
+     * none or its block could not be decoded.
+     */
+    const std::uint8_t* get_record(const std::size_t group,
+                                   const std::uint64_t index) noexcept;
+
+    /**
+     * \brief The time of a record in ns since the epoch.
+     */
+    std::uint64_t get_time(const std::size_t group,
+                           const std::uint8_t* record) const noexcept;
+
+    /**
+     * \brief The physical value of a channel in a record.
+     * \return the value, NaN if the channel is no number.
+     */
+    double get_value(const std::size_t group, const std::size_t channel,
+                     const std::uint8_t* record) const noexcept;
+
+    /**
+     * \brief Decodes the CAN frame of a record of a CAN group.
+     * \return false if the group is no CAN group.
+     */
+    bool get_can_frame(const std::size_t group, const std::uint8_t* record,
+                       CanLogRecord& frame) const noexcept;
+
+    /**
+     * \brief Finds the first record of a group at or after a time.
+     * \return the index of the record, the record count if there is none.
+     */
+    std::uint64_t seek(const std::size_t group,
+                       const std::uint64_t time) noexcept;
+
+    /**
+     * \brief Calls the handler for the records of a group in a time range.
+     * \param[in] begin the first time, in ns since the epoch.
+     * \param[in] end the time after the last record.
+     * \param[in] handler called as handler(time, record).
+     * \return the number of records read.
+     */
+    template < typename Handler >
+    std::uint64_t read(const std::size_t group, const std::uint64_t begin,
+                       const std::uint64_t end, Handler&& handler) noexcept
+    {
+        std::uint64_t count = 0U;
+        const std::uint64_t records = get_record_count(group);
+
+        for (std::uint64_t i = seek(group, begin); i < records; ++i)
+        {
+            const std::uint8_t* const record = get_record(group, i);
+            const std::uint64_t time =
+                (record != nullptr) ? get_time(group, record) : end;
+
+            if (time >= end)
+            {
+                break;
+            }
+
+            handler(time, record);
+            ++count;
+        }
+
+        return count;
+    }
+
+    /**
+     * \brief The number of deflated blocks inflated so far.
+     */
+    std::uint64_t get_inflated() const noexcept { return inflated_count_; }
+
+  private:
+    /**
+     * \brief The channels of a CAN_DataFrame.
+     */
+    enum CanChannel : std::size_t
+    {
+        BUS_CHANNEL,
+        ID,
+        IDE,
+        DLC,
+        DIR,
+        EDL,
+        BRS,
+        ESI,
+        DATA_LENGTH,
+        DATA_BYTES,
+        CAN_CHANNELS
+    };
+
+    /**
+     * \brief A channel: where it lies in the record and its conversion.
+     */
+    struct Channel
+    {
+        const char* name;
+        std::uint8_t data_type;
+        std::uint32_t byte_offset;
+        std::uint8_t bit_offset;
+        std::uint32_t bit_count;
+        double offset;
+        double factor;
+        bool master;
+    };
+
+    /**
+     * \brief A data block of a group.
+     */
+    struct DataBlock
+    {
+        /// the position of the block in the file.
+        std::uint64_t link;
+        /// the position of its first byte in the data of the group.
+        std::uint64_t offset;
+        /// the bytes of data in the block, inflated.
+        std::uint64_t size;
+    };
+
+    /**
+     * \brief A sorted data group with its channel group.
+     */
+    struct Group
+    {
+        const char* name{""};
+        std::uint32_t record_size{0U};
+        std::uint64_t records{0U};
+        std::size_t first_channel{0U};
+        std::size_t channel_count{0U};
+        std::size_t master{MDF_READER::NOT_FOUND};
+        std::size_t first_block{0U};
+        std::size_t block_count{0U};
+        /// the channels of a CAN_DataFrame, NOT_FOUND if missing.
+        std::array< std::size_t, CAN_CHANNELS > can;
+    };
+
+    /**
+     * \brief A block at a position, checking its id and its length.
+     * \return the block, nullptr if it is no such block.
+     */
+    const std::uint8_t* get_block(const std::uint64_t link,
+                                  const char* id) const noexcept;
+
+    /**
+     * \brief The text of a TX or MD block, an empty text if there is none.
+     */
+    const char* get_text(const std::uint64_t link) const noexcept;
+
+    /**
+     * \brief Reads a data group.
+     */
+    void add_group(const std::uint8_t* data_group) noexcept;
+
+    /**
+     * \brief Reads a list of channels and their compositions.
+     */
+    void add_channels(std::uint64_t link, const std::size_t depth) noexcept;
+
+    /**
+     * \brief Reads the data blocks of a data list, header list or a single
+     * block.
+     * \return the bytes of data of the blocks.
+     */
+    std::uint64_t add_blocks(std::uint64_t link,
+                             std::uint64_t offset) noexcept;
+
+    /**
+     * \brief The data of a block, inflated if it is deflated.
+     * \return the data, nullptr if it could not be decoded.
+     */
+    const std::uint8_t* load_block(const std::size_t block) noexcept;
+
+    /**
+     * \brief The raw bits of a channel in a record.
+     */
+    std::uint64_t get_raw(const Group& group, const Channel& channel,
+                          const std::uint8_t* record) const noexcept;
+
+    /// the mapped file.
+    const std::uint8_t* data_;
+
+    /// the size of the file.
+    std::size_t size_;
+
+    /// the start of the measurement in ns since the epoch.
+    std::uint64_t start_time_;
+
+    /// the groups.
+    std::vector< Group > groups_;
+
+    /// the channels of all groups.
+    std::vector< Channel > channels_;
+
+    /// the data blocks of all groups.
+    std::vector< DataBlock > blocks_;
+
+    /// the block loaded last.
+    std::size_t loaded_block_;
+
+    /// its data.
+    const std::uint8_t* loaded_data_;
+
+    /// the data of the deflated block loaded last.
+    std::vector< std::uint8_t > inflated_;
+
+    /// the deflated data before it is transposed back.
+    std::vector< std::uint8_t > transposed_;
+
+    /// a record that spans two blocks.
+    std::vector< std::uint8_t > record_;
+
+    /// the number of blocks inflated.
+    std::uint64_t inflated_count_;
+};
+
+#endif // WIN32 detection
+#endif // MDFREADER_H_
@@ -0,0 +1,840 @@
+/**
+ * \file      MdfWriter.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Streaming writer of ASAM MDF4 measurement files.
+ * \details   Writes CAN frames as bus logging groups and decoded signals in sorted
+ *            data groups. Full data blocks are written by a thread of their own.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MdfWriter.h"
+
+#ifndef _WIN32
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+#ifdef BSW_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+/// the header every block starts with: id, reserved, length, link count.
+constexpr std::size_t HEADER_SIZE{24U};
+
+/// the identification block at the start of the file.
+constexpr std::size_t ID_SIZE{64U};
+
+/// the header block follows the identification block.
+constexpr std::uint64_t HD_POSITION{64U};
+
+/// room for the header of a deflated block in front of the records.
+constexpr std::size_t DZ_HEADER_SIZE{48U};
+
+/// channel types.
+constexpr std::uint8_t CN_FIXED{0U};
+constexpr std::uint8_t CN_MASTER{2U};
+
+/// the master is the time.
+constexpr std::uint8_t SYNC_TIME{1U};
+
+/// data types.
+constexpr std::uint8_t UINT_LE{0U};
+constexpr std::uint8_t FLOAT_LE{4U};
+constexpr std::uint8_t BYTE_ARRAY{10U};
+
+/// the channel is part of a bus event.
+constexpr std::uint32_t CN_BUS_EVENT{0x400U};
+
+/// the channel group holds bus events without other signals.
+constexpr std::uint16_t CG_BUS_EVENT{0x0006U};
+
+/// a source that is a CAN bus.
+constexpr std::uint8_t SOURCE_BUS{2U};
+constexpr std::uint8_t BUS_CAN{2U};
+
+/// deflate after transposing the records into columns.
+constexpr std::uint8_t ZIP_TRANSPOSE_DEFLATE{1U};
+
+/// the cycle counters are not updated yet.
+constexpr std::uint16_t UNFIN_CYCLE_COUNTERS{0x0001U};
+
+/// the CAN_DataFrame record: time, channel, ID and IDE, flags, length.
+constexpr std::uint32_t CAN_HEADER_SIZE{15U};
+
+/**
+ * \brief A channel of the CAN_DataFrame composition.
+ */
+struct CanChannel
+{
+    const char* name;
+    std::uint8_t data_type;
+    std::uint32_t byte_offset;
+    std::uint8_t bit_offset;
+    std::uint32_t bit_count;
+};
+
+/// the channels of a CAN_DataFrame as ASAM names them for bus logging, the
+/// data bytes follow.
+constexpr std::array< CanChannel, 9U > CAN_CHANNELS{{
+    {"CAN_DataFrame.BusChannel", UINT_LE, 8U, 0U, 8U},
+    {"CAN_DataFrame.ID", UINT_LE, 9U, 0U, 29U},
+    {"CAN_DataFrame.IDE", UINT_LE, 12U, 7U, 1U},
+    {"CAN_DataFrame.DLC", UINT_LE, 13U, 0U, 4U},
+    {"CAN_DataFrame.Dir", UINT_LE, 13U, 4U, 1U},
+    {"CAN_DataFrame.EDL", UINT_LE, 13U, 5U, 1U},
+    {"CAN_DataFrame.BRS", UINT_LE, 13U, 6U, 1U},
+    {"CAN_DataFrame.ESI", UINT_LE, 13U, 7U, 1U},
+    {"CAN_DataFrame.DataLength", UINT_LE, 14U, 0U, 8U},
+}};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Writes a little-endian number.
+ */
+template < typename T > void put(std::uint8_t* out, const T value) noexcept
+{
+    for (std::size_t i = 0U; i < sizeof(T); ++i)
+    {
+        out[i] = static_cast< std::uint8_t >(value >> (8U * i));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Writes a little-endian double.
+ */
+void put_double(std::uint8_t* out, const double value) noexcept
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put(out, bits);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Creates a block with its header, the links and the data zeroed.
+ */
+std::vector< std::uint8_t > make_block(const char* id, const std::size_t links,
+                                       const std::size_t data_size) noexcept
+{
+    std::vector< std::uint8_t > block(HEADER_SIZE + (links * 8U) + data_size,
+                                      0U);
+    std::memcpy(block.data(), id, 4U);
+    put< std::uint64_t >(&block[8], block.size());
+    put< std::uint64_t >(&block[16], links);
+    return block;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Sets a link of a block made by make_block().
+ */
+void put_link(std::vector< std::uint8_t >& block, const std::size_t index,
+              const std::uint64_t link) noexcept
+{
+    put(&block[HEADER_SIZE + (index * 8U)], link);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The data of a block made by make_block().
+ */
+std::uint8_t* get_data(std::vector< std::uint8_t >& block,
+                       const std::size_t links) noexcept
+{
+    return &block[HEADER_SIZE + (links * 8U)];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The smallest DLC for a CAN FD payload length.
+ */
+std::uint8_t get_dlc(const std::uint8_t len) noexcept
+{
+    constexpr std::array< std::uint8_t, 7U > FD_LENGTHS{
+        {12U, 16U, 20U, 24U, 32U, 48U, 64U}};
+    std::uint8_t dlc = (len <= 8U) ? len : 15U;
+
+    for (std::uint8_t i = 0U; (len > 8U) && (i < FD_LENGTHS.size()); ++i)
+    {
+        if (len <= FD_LENGTHS[i])
+        {
+            dlc = static_cast< std::uint8_t >(9U + i);
+            break;
+        }
+    }
+
+    return dlc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Writes all bytes at a position of the file.
+ */
+bool write_all(const int fd, const std::uint8_t* data, std::size_t size,
+               std::uint64_t position) noexcept
+{
+    bool written = true;
+
+    while (written && (size > 0U))
+    {
+        const ssize_t now_written =
+            ::pwrite(fd, data, size, static_cast< off_t >(position));
+        written = now_written > 0;
+
+        if (written)
+        {
+            data += now_written;
+            size -= static_cast< std::size_t >(now_written);
+            position += static_cast< std::uint64_t >(now_written);
+        }
+    }
+
+    return written;
+}
+} // namespace
+
+/// compared by reference, so it needs a definition.
+constexpr std::size_t MDF_WRITER::NO_GROUP;
+
+////////////////////////////////////////////////////////////////////////////////
+MdfWriter::MdfWriter(const std::size_t block_size, const bool deflate) noexcept
+    : fd_{-1}, end_{0U}, allocated_{0U}, start_time_{0U},
+      block_size_{(block_size > 0U) ? block_size : 1U}, deflate_{deflate},
+      groups_{}, last_data_group_{0U}, buffers_{}, free_{}, queue_{},
+      deflated_{}, transposed_{}, mutex_{}, queued_{}, freed_{}, writer_{},
+      stopping_{false}, started_{false}, failed_{false}, stalls_{0U}
+{
+#ifndef BSW_WITH_ZLIB
+    if (deflate_)
+    {
+        std::cerr << "MdfWriter: deflate needs zlib, the data blocks are "
+                     "written uncompressed.\n";
+        deflate_ = false;
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MdfWriter::~MdfWriter() noexcept
+{
+    if (fd_ >= 0)
+    {
+        close();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MdfWriter::open(const char* path, std::uint64_t start_time) noexcept
+{
+    if (fd_ >= 0)
+    {
+        std::cerr << "MdfWriter: a file is open already.\n";
+        return false;
+    }
+
+    fd_ = ::open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+
+    if (fd_ < 0)
+    {
+        std::cerr << "MdfWriter: could not create " << path << ".\n";
+        return false;
+    }
+
+    const auto now = static_cast< std::uint64_t >(
+        std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    start_time_ = start_time;
+    end_ = 0U;
+    allocated_ = 0U;
+    groups_.clear();
+    last_data_group_ = 0U;
+    started_ = false;
+    stopping_ = false;
+    failed_ = false;
+    stalls_ = 0U;
+
+    // the file is marked as unfinalized until close().
+    std::array< std::uint8_t, ID_SIZE > id{};
+    std::memcpy(&id[0], "UnFinMF 4.10    bsw     ", 24U);
+    put< std::uint16_t >(&id[28], 410U);
+    put< std::uint16_t >(&id[60], UNFIN_CYCLE_COUNTERS);
+    append(id.data(), id.size());
+
+    // the header: links to the data groups and the file history.
+    auto header = make_block("##HD", 6U, 32U);
+    put(get_data(header, 6U), start_time_);
+    append(header.data(), header.size());
+
+    const std::uint64_t comment =
+        add_text("##MD", "<FHcomment><TX>created</TX><tool_id>bsw</tool_id>"
+                         "<tool_vendor>embedded-comstack</tool_vendor>"
+                         "<tool_version>1.0</tool_version></FHcomment>");
+    auto history = make_block("##FH", 2U, 16U);
+    put_link(history, 1U, comment);
+    put(get_data(history, 2U), now);
+    set_link(HD_POSITION + HEADER_SIZE + 8U,
+             append(history.data(), history.size()));
+
+    return failed_ == false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t MdfWriter::add_can_group(const bool fd) noexcept
+{
+    if ((fd_ < 0) || started_)
+    {
+        return MDF_WRITER::NO_GROUP;
+    }
+
+    // the channels are linked to the next one, so they are written from the
+    // last one.
+    const std::uint32_t payload = fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+    std::uint64_t next =
+        add_channel("CAN_DataFrame.DataBytes", nullptr, CN_FIXED, BYTE_ARRAY,
+                    CAN_HEADER_SIZE, 0U, payload * 8U, CN_BUS_EVENT, 0U, 0U);
+
+    for (std::size_t i = CAN_CHANNELS.size(); i > 0U; --i)
+    {
+        const CanChannel& channel = CAN_CHANNELS[i - 1U];
+        next = add_channel(channel.name, nullptr, CN_FIXED, channel.data_type,
+                           channel.byte_offset, channel.bit_offset,
+                           channel.bit_count, CN_BUS_EVENT, next, 0U);
+    }
+
+    const std::uint32_t frame_size = CAN_HEADER_SIZE - 8U + payload;
+    next = add_channel("CAN_DataFrame", nullptr, CN_FIXED, BYTE_ARRAY, 8U, 0U,
+                       frame_size * 8U, CN_BUS_EVENT, 0U, next);
+    next = add_channel("Timestamp", "s", CN_MASTER, FLOAT_LE, 0U, 0U, 64U, 0U,
+                       next, 0U);
+
+    // the source tells tools that the group holds CAN frames.
+    auto source = make_block("##SI", 3U, 8U);
+    put_link(source, 0U, add_text("##TX", "CAN"));
+    get_data(source, 3U)[0] = SOURCE_BUS;
+    get_data(source, 3U)[1] = BUS_CAN;
+    const std::uint64_t source_link = append(source.data(), source.size());
+
+    const std::size_t group =
+        add_group("CAN_DataFrame", source_link, CG_BUS_EVENT,
+                  CAN_HEADER_SIZE + payload, next);
+    groups_[group].can = true;
+    groups_[group].fd = fd;
+    return group;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t MdfWriter::add_signal_group(const char* name,
+                                        const MdfSignal* signals,
+                                        const std::size_t count) noexcept
+{
+    if ((fd_ < 0) || started_ || (signals == nullptr))
+    {
+        return MDF_WRITER::NO_GROUP;
+    }
+
+    std::uint64_t next = 0U;
+
+    for (std::size_t i = count; i > 0U; --i)
+    {
+        next = add_channel(signals[i - 1U].name, signals[i - 1U].unit,
+                           CN_FIXED, FLOAT_LE,
+                           static_cast< std::uint32_t >(8U * i), 0U, 64U, 0U,
+                           next, 0U);
+    }
+
+    next = add_channel("time", "s", CN_MASTER, FLOAT_LE, 0U, 0U, 64U, 0U, next,
+                       0U);
+    return add_group(name, 0U, 0U,
+                     static_cast< std::uint32_t >(8U * (count + 1U)), next);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MdfWriter::write_can(const std::size_t group,
+                          const CanLogRecord& record) noexcept
+{
+    if ((group >= groups_.size()) || (groups_[group].can == false))
+    {
+        return false;
+    }
+
+    Group& can = groups_[group];
+    std::uint8_t* const out = get_record(can);
+
+    if (out != nullptr)
+    {
+        const std::uint8_t max_len = can.fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+        const std::uint8_t len =
+            (record.frame.len < max_len) ? record.frame.len : max_len;
+        const bool extended = (record.frame.can_id & CAN_EFF_FLAG) != 0U;
+        const std::uint32_t id =
+            (record.frame.can_id & (extended ? CAN_EFF_MASK : CAN_SFF_MASK)) |
+            (extended ? 0x80000000U : 0U);
+
+        put_double(&out[0], get_seconds(record.timestamp));
+        out[8] = static_cast< std::uint8_t >(record.channel);
+        put(&out[9], id);
+        out[13] = static_cast< std::uint8_t >(
+            get_dlc(len) | (record.tx ? 0x10U : 0U) |
+            (record.fd ? 0x20U : 0U) |
+            ((record.frame.flags & CANFD_BRS) ? 0x40U : 0U) |
+            ((record.frame.flags & CANFD_ESI) ? 0x80U : 0U));
+        out[14] = len;
+        std::memcpy(&out[CAN_HEADER_SIZE], record.frame.data, len);
+        std::memset(&out[CAN_HEADER_SIZE + len], 0, max_len - len);
+        ++can.records;
+    }
+
+    return out != nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MdfWriter::write_signals(const std::size_t group,
+                              const std::uint64_t timestamp,
+                              const double* values) noexcept
+{
+    if ((group >= groups_.size()) || groups_[group].can)
+    {
+        return false;
+    }
+
+    Group& signals = groups_[group];
+    std::uint8_t* const out = get_record(signals);
+
+    if (out != nullptr)
+    {
+        put_double(&out[0], get_seconds(timestamp));
+
+        for (std::uint32_t i = 1U; i < (signals.record_size / 8U); ++i)
+        {
+            put_double(&out[8U * i], values[i - 1U]);
+        }
+
+        ++signals.records;
+    }
+
+    return out != nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MdfWriter::close() noexcept
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+
+    if (started_)
+    {
+        // the blocks not full yet, then the writer thread ends.
+        for (Group& group : groups_)
+        {
+            if (group.buffer != NONE)
+            {
+                submit(group);
+            }
+        }
+
+        {
+            std::lock_guard< std::mutex > lock{mutex_};
+            stopping_ = true;
+        }
+
+        queued_.notify_one();
+        writer_.join();
+    }
+
+    for (const Group& group : groups_)
+    {
+        write_data_list(group);
+        set_link(group.channel_group + HEADER_SIZE + 56U, group.records);
+    }
+
+    // finalized: the file id and the reserved bytes up to the unfinalized
+    // flags, which are cleared.
+    std::array< std::uint8_t, 8U > finalized{};
+    std::memcpy(finalized.data(), "MDF     ", 8U);
+    failed_ = failed_ || (write_all(fd_, finalized.data(), 8U, 0U) == false);
+    set_link(ID_SIZE - 8U, 0U);
+
+    const bool closed = (::close(fd_) == 0) && (failed_ == false);
+    fd_ = -1;
+    buffers_.clear();
+    free_.clear();
+    queue_.clear();
+
+    if (closed == false)
+    {
+        std::cerr << "MdfWriter: writing the file failed.\n";
+    }
+
+    return closed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfWriter::get_records(const std::size_t group) const noexcept
+{
+    return (group < groups_.size()) ? groups_[group].records : 0U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t MdfWriter::add_group(const char* name, const std::uint64_t source,
+                                 const std::uint16_t flags,
+                                 const std::uint32_t record_size,
+                                 const std::uint64_t first_channel) noexcept
+{
+    auto channel_group = make_block("##CG", 6U, 32U);
+    put_link(channel_group, 1U, first_channel);
+    put_link(channel_group, 2U, add_text("##TX", name));
+    put_link(channel_group, 3U, source);
+    std::uint8_t* const data = get_data(channel_group, 6U);
+    put(&data[16], flags);
+    put< std::uint16_t >(&data[18], (flags != 0U) ? '.' : 0U);
+    put(&data[24], record_size);
+
+    Group group;
+    group.channel_group = append(channel_group.data(), channel_group.size());
+    group.record_size = record_size;
+
+    // sorted: one channel group per data group, records without IDs.
+    auto data_group = make_block("##DG", 4U, 8U);
+    put_link(data_group, 1U, group.channel_group);
+    group.data_group = append(data_group.data(), data_group.size());
+    set_link((last_data_group_ > 0U) ? (last_data_group_ + HEADER_SIZE)
+                                     : (HD_POSITION + HEADER_SIZE),
+             group.data_group);
+    last_data_group_ = group.data_group;
+
+    groups_.push_back(group);
+    return groups_.size() - 1U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfWriter::add_channel(
+    const char* name, const char* unit, const std::uint8_t type,
+    const std::uint8_t data_type, const std::uint32_t byte_offset,
+    const std::uint8_t bit_offset, const std::uint32_t bit_count,
+    const std::uint32_t flags, const std::uint64_t next,
+    const std::uint64_t composition) noexcept
+{
+    auto channel = make_block("##CN", 8U, 72U);
+    put_link(channel, 0U, next);
+    put_link(channel, 1U, composition);
+    put_link(channel, 2U, add_text("##TX", name));
+    put_link(channel, 6U, add_text("##TX", unit));
+    std::uint8_t* const data = get_data(channel, 8U);
+    data[0] = type;
+    data[1] = (type == CN_MASTER) ? SYNC_TIME : 0U;
+    data[2] = data_type;
+    data[3] = bit_offset;
+    put(&data[4], byte_offset);
+    put(&data[8], bit_count);
+    put(&data[12], flags);
+    return append(channel.data(), channel.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfWriter::add_text(const char* id, const char* text) noexcept
+{
+    std::uint64_t link = 0U;
+
+    if (text != nullptr)
+    {
+        // zero terminated and padded to 8 bytes.
+        const std::size_t length = std::strlen(text);
+        auto block = make_block(id, 0U, (length + 8U) & ~std::size_t{7U});
+        std::memcpy(get_data(block, 0U), text, length);
+        link = append(block.data(), block.size());
+    }
+
+    return link;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t MdfWriter::append(const std::uint8_t* block,
+                                const std::size_t size) noexcept
+{
+    const std::uint64_t position = end_;
+
+    // allocated ahead in large steps, the size of the file stays.
+    if ((position + size) > allocated_)
+    {
+        const std::uint64_t step =
+            (size > MDF_WRITER::PREALLOCATE) ? size : MDF_WRITER::PREALLOCATE;
+        static_cast< void >(::fallocate(fd_, FALLOC_FL_KEEP_SIZE,
+                                        static_cast< off_t >(allocated_),
+                                        static_cast< off_t >(step)));
+        allocated_ += step;
+    }
+
+    if (write_all(fd_, block, size, position) == false)
+    {
+        failed_ = true;
+    }
+
+    // the blocks start at multiples of 8.
+    end_ = (position + size + 7U) & ~std::uint64_t{7U};
+    return position;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MdfWriter::set_link(const std::uint64_t position,
+                         const std::uint64_t link) noexcept
+{
+    std::array< std::uint8_t, 8U > value;
+    put(value.data(), link);
+
+    if (write_all(fd_, value.data(), value.size(), position) == false)
+    {
+        failed_ = true;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double MdfWriter::get_seconds(const std::uint64_t timestamp) noexcept
+{
+    if (start_time_ == 0U)
+    {
+        // the start time of the header.
+        start_time_ = timestamp;
+        set_link(HD_POSITION + HEADER_SIZE + 48U, start_time_);
+    }
+
+    return static_cast< double >(
+               static_cast< std::int64_t >(timestamp - start_time_)) /
+           1e9;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint8_t* MdfWriter::get_record(Group& group) noexcept
+{
+    if ((fd_ < 0) || failed_)
+    {
+        return nullptr;
+    }
+
+    if (started_ == false)
+    {
+        // the blocks are allocated before the measurement, a record always
+        // fits into an empty one.
+        std::uint32_t max_record = 0U;
+        for (const Group& added : groups_)
+        {
+            max_record = (added.record_size > max_record) ? added.record_size
+                                                          : max_record;
+        }
+
+        const std::size_t capacity = DZ_HEADER_SIZE + block_size_ + max_record;
+        buffers_.resize(groups_.size() + MDF_WRITER::SPARE_BLOCKS);
+        free_.clear();
+        for (std::size_t i = 0U; i < buffers_.size(); ++i)
+        {
+            buffers_[i].data.resize(capacity);
+            free_.push_back(i);
+        }
+        queue_.reserve(buffers_.size());
+
+#ifdef BSW_WITH_ZLIB
+        if (deflate_)
+        {
+            transposed_.resize(capacity);
+            deflated_.resize(DZ_HEADER_SIZE + compressBound(capacity));
+        }
+#endif
+
+        started_ = true;
+        writer_ = std::thread{&MdfWriter::writer_thread, this};
+    }
+
+    if ((group.buffer != NONE) &&
+        ((buffers_[group.buffer].size + group.record_size) > block_size_))
+    {
+        submit(group);
+    }
+
+    if (group.buffer == NONE)
+    {
+        std::unique_lock< std::mutex > lock{mutex_};
+
+        if (free_.empty())
+        {
+            // the disk is behind.
+            ++stalls_;
+            freed_.wait(lock, [this]() { return free_.empty() == false; });
+        }
+
+        group.buffer = free_.back();
+        free_.pop_back();
+        buffers_[group.buffer].group =
+            static_cast< std::size_t >(&group - groups_.data());
+        buffers_[group.buffer].size = 0U;
+    }
+
+    Buffer& buffer = buffers_[group.buffer];
+    std::uint8_t* const record = &buffer.data[DZ_HEADER_SIZE + buffer.size];
+    buffer.size += group.record_size;
+    return record;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MdfWriter::submit(Group& group) noexcept
+{
+    {
+        std::lock_guard< std::mutex > lock{mutex_};
+        queue_.push_back(group.buffer);
+    }
+
+    group.buffer = NONE;
+    queued_.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MdfWriter::writer_thread() noexcept
+{
+    std::unique_lock< std::mutex > lock{mutex_};
+
+    while (true)
+    {
+        queued_.wait(lock, [this]() {
+            return (queue_.empty() == false) || stopping_;
+        });
+
+        if (queue_.empty())
+        {
+            break;
+        }
+
+        const std::size_t index = queue_.front();
+        queue_.erase(queue_.begin());
+        lock.unlock();
+        write_block(buffers_[index]);
+        lock.lock();
+        free_.push_back(index);
+        freed_.notify_one();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MdfWriter::write_block(Buffer& buffer) noexcept
+{
+    Group& group = groups_[buffer.group];
+    std::uint8_t* const records = &buffer.data[DZ_HEADER_SIZE];
+    std::uint64_t position = 0U;
+
+#ifdef BSW_WITH_ZLIB
+    if (deflate_)
+    {
+        // the bytes of the same channel follow each other, they compress
+        // much better than the records.
+        const std::size_t columns = group.record_size;
+        const std::size_t rows = buffer.size / columns;
+        for (std::size_t row = 0U; row < rows; ++row)
+        {
+            for (std::size_t column = 0U; column < columns; ++column)
+            {
+                transposed_[(column * rows) + row] =
+                    records[(row * columns) + column];
+            }
+        }
+
+        uLongf length = deflated_.size() - DZ_HEADER_SIZE;
+        const int result =
+            compress2(&deflated_[DZ_HEADER_SIZE], &length, transposed_.data(),
+                      buffer.size, Z_BEST_SPEED);
+        failed_ = failed_ || (result != Z_OK);
+
+        std::memset(deflated_.data(), 0, DZ_HEADER_SIZE);
+        std::memcpy(&deflated_[0], "##DZ", 4U);
+        put< std::uint64_t >(&deflated_[8], DZ_HEADER_SIZE + length);
+        std::memcpy(&deflated_[HEADER_SIZE], "DT", 2U);
+        deflated_[HEADER_SIZE + 2U] = ZIP_TRANSPOSE_DEFLATE;
+        put(&deflated_[HEADER_SIZE + 4U], group.record_size);
+        put< std::uint64_t >(&deflated_[HEADER_SIZE + 8U], buffer.size);
+        put< std::uint64_t >(&deflated_[HEADER_SIZE + 16U], length);
+        position = append(deflated_.data(), DZ_HEADER_SIZE + length);
+    }
+    else
+#endif
+    {
+        std::uint8_t* const block = &buffer.data[DZ_HEADER_SIZE - HEADER_SIZE];
+        std::memset(block, 0, HEADER_SIZE);
+        std::memcpy(block, "##DT", 4U);
+        put< std::uint64_t >(&block[8], HEADER_SIZE + buffer.size);
+        position = append(block, HEADER_SIZE + buffer.size);
+    }
+
+    group.blocks.push_back(BlockLink{position, group.data_size});
+    group.data_size += buffer.size;
+    buffer.size = 0U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MdfWriter::write_data_list(const Group& group) noexcept
+{
+    const std::size_t count = group.blocks.size();
+    std::uint64_t link = (count > 0U) ? group.blocks.front().link : 0U;
+
+    if ((count > 1U) || (deflate_ && (count > 0U)))
+    {
+        // the list holds the offset of every block in the data, readers find
+        // a record without reading the blocks before.
+        auto list = make_block("##DL", 1U + count, 8U + (8U * count));
+        std::uint8_t* const data = get_data(list, 1U + count);
+        put(&data[4], static_cast< std::uint32_t >(count));
+
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+            put_link(list, 1U + i, group.blocks[i].link);
+            put(&data[8U + (8U * i)], group.blocks[i].offset);
+        }
+
+        link = append(list.data(), list.size());
+
+        if (deflate_)
+        {
+            // a list of deflated blocks starts with a header list.
+            auto header = make_block("##HL", 1U, 8U);
+            put_link(header, 0U, link);
+            get_data(header, 1U)[2] = ZIP_TRANSPOSE_DEFLATE;
+            link = append(header.data(), header.size());
+        }
+    }
+
+    set_link(group.data_group + HEADER_SIZE + 16U, link);
+}
+
+#endif // WIN32 detection
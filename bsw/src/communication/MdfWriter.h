@@ -0,0 +1,367 @@
+/**
+ * \file      MdfWriter.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Streaming writer of ASAM MDF4 measurement files.
+ * \details   Writes CAN frames as bus logging groups and decoded signals in sorted
+ *            data groups. Full data blocks are written by a thread of their own.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MDFWRITER_H_
+#define MDFWRITER_H_
+
+#ifndef _WIN32
+
+#include "CanLogReader.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Defining a struct that holds the sizes of the MDF writer.
+ */
+struct MDF_WRITER
+{
+    // bytes of records in a data block, if not set otherwise.
+    static constexpr std::size_t BLOCK_SIZE{1024U * 1024U};
+    // data blocks in addition to the one each group fills.
+    static constexpr std::size_t SPARE_BLOCKS{4U};
+    // the file is allocated ahead in steps of this size.
+    static constexpr std::uint64_t PREALLOCATE{64U * 1024U * 1024U};
+    // the index of a group that could not be added.
+    static constexpr std::size_t NO_GROUP{static_cast< std::size_t >(-1)};
+};
+
+/**
+ * \brief A decoded signal of a signal group, stored as a double.
+ */
+struct MdfSignal
+{
+    /// the name of the channel.
+    const char* name;
+    /// the unit, nullptr if there is none.
+    const char* unit;
+};
+
+/**
+ * \brief MdfWriter writes an ASAM MDF 4.1 file while it is measured. CAN
+ * frames go to a bus logging group as defined by ASAM for CAN_DataFrame,
+ * decoded signals go to groups of doubles with a time master. Every group is
+ * a data group of its own (a sorted file), so tools read the groups
+ * without sorting the records.
+ *
+ * The records of a group are collected in a data block of a fixed size that
+ * is allocated before the measurement starts. A full block is handed to a
+ * thread that writes it, deflated if set, while the next block fills. The
+ * caller only waits if all blocks are queued because the disk is too slow.
+ * The file is allocated ahead in large steps, so it does not fragment. On
+ * close() the data lists that index the blocks are written and the file is
+ * marked finalized; a file not closed is marked as unfinalized.
+ * \code
+ * MdfWriter writer;
+ * writer.open("drive.mf4");
+ * const auto can = writer.add_can_group();
+ * writer.write_can(can, record);
+ * writer.close();
+ * \endcode
+ */
+class MdfWriter
+{
+  public:
+    /**
+     * \brief Creates a writer without a file.
+     * \param[in] block_size bytes of records in a data block.
+     * \param[in] deflate true to compress the data blocks with transposition
+     * and deflate, needs zlib.
+     */
+    explicit MdfWriter(const std::size_t block_size = MDF_WRITER::BLOCK_SIZE,
+                       const bool deflate = false) noexcept;
+
+    /**
+     * \brief Closes the file.
+     */
+    ~MdfWriter() noexcept;
+
+    MdfWriter(const MdfWriter&) = delete;
+    MdfWriter& operator=(const MdfWriter&) = delete;
+
+    /**
+     * \brief Creates the file and writes its header.
+     * \param[in] path the file.
+     * \param[in] start_time the start of the measurement in ns since the
+     * epoch, 0 for the time of the first record. Timestamps are stored
+     * relative to it.
+     * \return false if the file could not be created.
+     */
+    bool open(const char* path, std::uint64_t start_time = 0U) noexcept;
+
+    /**
+     * \brief Adds a group for CAN frames, before the first record is
+     * written.
+     * \param[in] fd true to store 64 data bytes per frame, else 8.
+     * \return the group, MDF_WRITER::NO_GROUP if it could not be added.
+     */
+    std::size_t add_can_group(const bool fd = true) noexcept;
+
+    /**
+     * \brief Adds a group of signals that are sampled together, before the
+     * first record is written.
+     * \param[in] name the name of the group.
+     * \param[in] signals the signals.
+     * \param[in] count the number of signals.
+     * \return the group, MDF_WRITER::NO_GROUP if it could not be added.
+     */
+    std::size_t add_signal_group(const char* name, const MdfSignal* signals,
+                                 const std::size_t count) noexcept;
+
+    /**
+     * \brief Writes a CAN frame into a CAN group.
+     * \return false if the group is no CAN group or writing failed.
+     */
+    bool write_can(const std::size_t group,
+                   const CanLogRecord& record) noexcept;
+
+    /**
+     * \brief Writes a sample of all signals of a signal group.
+     * \param[in] timestamp the time in ns since the epoch.
+     * \param[in] values one value per signal.
+     * \return false if the group is no signal group or writing failed.
+     */
+    bool write_signals(const std::size_t group, const std::uint64_t timestamp,
+                       const double* values) noexcept;
+
+    /**
+     * \brief Writes the blocks not full yet and the data lists and
+     * finalizes the file.
+     * \return false if writing failed or no file is open.
+     */
+    bool close() noexcept;
+
+    /**
+     * \brief The number of records written to a group.
+     */
+    std::uint64_t get_records(const std::size_t group) const noexcept;
+
+    /**
+     * \brief The number of times the caller waited for a free data block.
+     */
+    std::uint64_t get_stalls() const noexcept { return stalls_; }
+
+  private:
+    /**
+     * \brief A data block in memory: room for the block header, then the
+     * records.
+     */
+    struct Buffer
+    {
+        std::vector< std::uint8_t > data;
+        std::size_t group{0U};
+        std::size_t size{0U};
+    };
+
+    /**
+     * \brief A data block in the file.
+     */
+    struct BlockLink
+    {
+        /// the position of the block in the file.
+        std::uint64_t link;
+        /// the position of its first record in the data of the group.
+        std::uint64_t offset;
+    };
+
+    /**
+     * \brief A data group with one channel group.
+     */
+    struct Group
+    {
+        std::uint64_t data_group{0U};
+        std::uint64_t channel_group{0U};
+        std::uint32_t record_size{0U};
+        std::uint64_t records{0U};
+        /// the buffer the records are written to, NONE before the first.
+        std::size_t buffer{NONE};
+        /// the blocks written, filled by the writer thread.
+        std::vector< BlockLink > blocks;
+        /// the data bytes of the group written.
+        std::uint64_t data_size{0U};
+        bool can{false};
+        bool fd{false};
+    };
+
+    /// no buffer.
+    static constexpr std::size_t NONE{static_cast< std::size_t >(-1)};
+
+    /**
+     * \brief Adds a data group and its channel group.
+     * \return the group.
+     */
+    std::size_t add_group(const char* name, const std::uint64_t source,
+                          const std::uint16_t flags,
+                          const std::uint32_t record_size,
+                          const std::uint64_t first_channel) noexcept;
+
+    /**
+     * \brief Writes a channel and its name and unit.
+     * \return the position of the channel in the file.
+     */
+    std::uint64_t add_channel(const char* name, const char* unit,
+                              const std::uint8_t type,
+                              const std::uint8_t data_type,
+                              const std::uint32_t byte_offset,
+                              const std::uint8_t bit_offset,
+                              const std::uint32_t bit_count,
+                              const std::uint32_t flags,
+                              const std::uint64_t next,
+                              const std::uint64_t composition) noexcept;
+
+    /**
+     * \brief Writes a text block.
+     * \return the position of the block, 0 for nullptr.
+     */
+    std::uint64_t add_text(const char* id, const char* text) noexcept;
+
+    /**
+     * \brief Appends a block to the file, padded to 8 bytes.
+     * \return the position of the block.
+     */
+    std::uint64_t append(const std::uint8_t* block,
+                         const std::size_t size) noexcept;
+
+    /**
+     * \brief Writes a link of a block written before.
+     */
+    void set_link(const std::uint64_t position,
+                  const std::uint64_t link) noexcept;
+
+    /**
+     * \brief The time of a record relative to the start in seconds. The
+     * first record sets the start if it is not set.
+     */
+    double get_seconds(const std::uint64_t timestamp) noexcept;
+
+    /**
+     * \brief Reserves a record in the block of a group, hands full blocks to
+     * the writer thread.
+     * \return the record, nullptr if writing failed.
+     */
+    std::uint8_t* get_record(Group& group) noexcept;
+
+    /**
+     * \brief Hands the block of a group to the writer thread.
+     */
+    void submit(Group& group) noexcept;
+
+    /**
+     * \brief Writes the queued blocks until close().
+     */
+    void writer_thread() noexcept;
+
+    /**
+     * \brief Writes a data block, deflated if set.
+     */
+    void write_block(Buffer& buffer) noexcept;
+
+    /**
+     * \brief Writes the data list of a group and links it.
+     */
+    void write_data_list(const Group& group) noexcept;
+
+    /// the file.
+    int fd_;
+
+    /// the end of the file, owned by the writer thread while it runs.
+    std::uint64_t end_;
+
+    /// the file is allocated up to here.
+    std::uint64_t allocated_;
+
+    /// the start of the measurement in ns since the epoch.
+    std::uint64_t start_time_;
+
+    /// bytes of records in a data block.
+    std::size_t block_size_;
+
+    /// true to deflate the data blocks.
+    bool deflate_;
+
+    /// the groups.
+    std::vector< Group > groups_;
+
+    /// the position of the last data group, 0 before the first.
+    std::uint64_t last_data_group_;
+
+    /// the data blocks in memory.
+    std::vector< Buffer > buffers_;
+
+    /// the buffers free to fill.
+    std::vector< std::size_t > free_;
+
+    /// the buffers to write, in order.
+    std::vector< std::size_t > queue_;
+
+    /// the deflated block, used by the writer thread only.
+    std::vector< std::uint8_t > deflated_;
+
+    /// the transposed records, used by the writer thread only.
+    std::vector< std::uint8_t > transposed_;
+
+    /// protects free_, queue_ and stopping_.
+    std::mutex mutex_;
+
+    /// signals a queued buffer to the writer thread.
+    std::condition_variable queued_;
+
+    /// signals a free buffer to the caller.
+    std::condition_variable freed_;
+
+    /// writes the data blocks.
+    std::thread writer_;
+
+    /// true if the writer thread shall stop after the queue.
+    bool stopping_;
+
+    /// true once the first record is written, no groups can be added.
+    bool started_;
+
+    /// true if a write failed.
+    std::atomic< bool > failed_;
+
+    /// the number of times the caller waited for a free buffer.
+    std::uint64_t stalls_;
+};
+
+#endif // WIN32 detection
+#endif // MDFWRITER_H_
@@ -40,59 +40,33 @@
 #ifndef PACKET_H_
 #define PACKET_H_
 
-#include "Endianess.h" // converting to and from host-byte-order
+#include "Endianness.h" // converting to and from host-byte-order
 #include <array>
 #include <cstring>
+#include <type_traits>
 
 /**
- * \brief Packet class for unified data (network) transport.
- * \tparam Size of the container
+ * \brief PacketView serializes to and deserializes from a byte buffer it does
+ * not own, e.g. a part of a bigger send buffer. Packet is a PacketView with
+ * its own fixed size container.
+ * Values are stored in network-byte-order. Writing or reading beyond the end
+ * of the buffer has no effect and sets the overflow flag.
  */
-template < std::size_t Size > class Packet
+class PacketView
 {
   public:
-    using DataContainer = std::array< uint8, Size >;
-
     /**
-     * \brief Default constructor initializes the write and read position.
+     * \brief Creates a view on a buffer.
+     * \param[in] data the buffer, must outlive the view.
+     * \param[in] capacity the size of the buffer in bytes. To read a message
+     * received this is the length of the message.
      */
-    Packet() noexcept : m_write_pos{0U}, m_read_pos{0U}
+    PacketView(std::uint8_t* data, const std::size_t capacity) noexcept
+        : m_view{data}, m_capacity{capacity}, m_write_pos{0U}, m_read_pos{0U},
+          m_overflow{false}
     {
-        static_assert(Size > 0, "Size must be greater than zero!");
     }
 
-    /**
-     * \brief Default destructor
-     * Nothing to clean up here.
-     */
-    ~Packet() noexcept = default;
-
-    /**
-     * \brief returns the static size of the packet's data to send or receive.
-     * \return the static size.
-     */
-    constexpr std::uint16_t get_size() const noexcept
-    {
-        return static_cast< std::uint16_t >(m_data.size());
-    }
-
-    /**
-     * \brief direct link to the data.
-     */
-    const DataContainer& get_data() const noexcept { return m_data; }
-
-    /**
-     * \brief direct link to the data.
-     */
-    DataContainer& get_data() noexcept { return m_data; }
-
-    /**
-     * \brief the complete packet as a constant reference.
-     */
-    const Packet& get_packet() const noexcept { return *this; }
-
-    Packet& get_packet() noexcept { return *this; }
-
     /**
      * \brief Clearing the indices for a new storage.
      */
@@ -100,51 +74,24 @@ template < std::size_t Size > class Packet
     {
         m_write_pos = 0U;
         m_read_pos = 0U;
+        m_overflow = false;
     }
 
     /**
-     * \brief This method is extremly helpful for returning a type T variable
-     * from the packet without modifying it from a given position.
-     * \tparam T the value type to return
-     * \tparam Position the position at what the value begins.
+     * \brief Number of bytes written into the packet.
      */
-    template < typename T, std::size_t Position > T peek() const noexcept
-    {
-        static_assert(std::is_arithmetic< T >::value,
-                      "Type must be integral or floating point.");
-        static_assert(
-            Position < Size,
-            "The position to read is greater than the actual Packet size.");
-        using MyType = T;
-        MyType data{static_cast< MyType >(0)};
-        const MyType* data_ptr =
-            reinterpret_cast< const MyType* >(&m_data[Position]);
-        data = from_network< MyType >(*data_ptr);
-        return data;
-    }
+    std::size_t get_length() const noexcept { return m_write_pos; }
 
     /**
-     * \brief This will store a value of template parameter T at the given
-     * position into the packet with network-byte-order.
+     * \brief The size of the buffer.
      */
-    template < typename T, std::size_t Position >
-    void store(const T& data) noexcept
-    {
-        static_assert(std::is_arithmetic< T >::value,
-                      "Type must be integral or floating point.");
-        static_assert(
-            Position < Size,
-            "The position to write is greater than the actual Packet size.");
-        using MyType = T;
-        static constexpr auto bytes = sizeof(T);
+    std::size_t get_capacity() const noexcept { return m_capacity; }
 
-        // swap to network-byte-order
-        MyType network_data = to_network< MyType >(data);
-        // we need it byte by byte.
-        const std::uint8_t* data_ptr =
-            reinterpret_cast< const std::uint8_t* >(&network_data);
-        std::memcpy(&m_data[Position], data_ptr, bytes);
-    }
+    /**
+     * \brief Checks if a write or read did not fit into the buffer. The
+     * value was not written or read then.
+     */
+    bool has_overflow() const noexcept { return m_overflow; }
 
     /**
      * \brief Checks if the length of bytes to write is possible.
@@ -155,7 +102,7 @@ template < std::size_t Size > class Packet
     bool is_writable(const std::size_t bytes_to_write) const noexcept
     {
         const auto write_pos_new = m_write_pos + bytes_to_write;
-        return (write_pos_new <= m_data.size()) && (bytes_to_write > 0);
+        return (write_pos_new <= m_capacity) && (bytes_to_write > 0);
     }
 
     /**
@@ -167,7 +114,7 @@ template < std::size_t Size > class Packet
     bool is_readable(const std::size_t bytes_to_read) const noexcept
     {
         const auto read_pos_new = m_read_pos + bytes_to_read;
-        return (read_pos_new <= m_data.size()) && (bytes_to_read > 0);
+        return (read_pos_new <= m_capacity) && (bytes_to_read > 0);
     }
 
     /**
@@ -179,15 +126,17 @@ template < std::size_t Size > class Packet
      */
     template < typename T > void append(const T& data) noexcept
     {
-        static constexpr uint8 bytes_to_write = sizeof(T);
+        static constexpr std::size_t bytes_to_write = sizeof(T);
 
         if (is_writable(bytes_to_write))
         {
-            const std::uint8_t* data_ptr =
-                reinterpret_cast< const std::uint8_t* >(&data);
-            std::memcpy(&m_data[m_write_pos], data_ptr, bytes_to_write);
+            std::memcpy(&m_view[m_write_pos], &data, bytes_to_write);
             m_write_pos += bytes_to_write;
         }
+        else
+        {
+            m_overflow = true;
+        }
     }
 
     /**
@@ -197,17 +146,21 @@ template < std::size_t Size > class Packet
     void append(const char* data) noexcept
     {
         // determine the length of the char array
-        std::uint32_t bytes_to_write =
+        const std::uint32_t bytes_to_write =
             static_cast< std::uint32_t >(std::strlen(data));
 
-        // store the length first
-        *this << bytes_to_write;
-
-        if (is_writable(bytes_to_write))
+        // the length and the characters must fit, else nothing is written.
+        if (is_writable(sizeof(bytes_to_write) + bytes_to_write))
         {
-            std::memcpy(&m_data[m_write_pos], data, bytes_to_write);
+            // store the length first
+            *this << bytes_to_write;
+            std::memcpy(&m_view[m_write_pos], data, bytes_to_write);
             m_write_pos += bytes_to_write;
         }
+        else
+        {
+            m_overflow = true;
+        }
     }
 
     /**
@@ -233,9 +186,8 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the current packet object.
      */
-    Packet& operator>>(bool& data) noexcept
+    PacketView& operator>>(bool& data) noexcept
     {
-        static constexpr uint8 bytes_to_read = sizeof(std::uint8_t);
         std::uint8_t bool_as_num = 0U;
         *this >> bool_as_num;
 
@@ -257,16 +209,9 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the packet object
      */
-    Packet& operator>>(std::uint8_t& data) noexcept
+    PacketView& operator>>(std::uint8_t& data) noexcept
     {
-        static constexpr uint8 bytes_to_read = sizeof(uint8);
-
-        if (is_readable(bytes_to_read))
-        {
-            data = m_data[m_read_pos];
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -276,16 +221,9 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the packet object
      */
-    Packet& operator>>(std::int8_t& data) noexcept
+    PacketView& operator>>(std::int8_t& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(std::int8_t);
-
-        if (is_readable(bytes_to_read))
-        {
-            data = m_data[m_read_pos];
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -295,18 +233,9 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the packet object
      */
-    Packet& operator>>(std::uint16_t& data) noexcept
+    PacketView& operator>>(std::uint16_t& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(std::uint16_t);
-
-        if (is_readable(bytes_to_read))
-        {
-            const std::uint16_t* data_ptr =
-                reinterpret_cast< const std::uint16_t* >(&m_data[m_read_pos]);
-            data = from_network< std::uint16_t >(*data_ptr);
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -316,18 +245,9 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the packet object
      */
-    Packet& operator>>(std::int16_t& data) noexcept
+    PacketView& operator>>(std::int16_t& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(std::int16_t);
-
-        if (is_readable(bytes_to_read))
-        {
-            const std::int16_t* data_ptr =
-                reinterpret_cast< const std::int16_t* >(&m_data[m_read_pos]);
-            data = from_network< sint16 >(*data_ptr);
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -338,18 +258,9 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the packet object
      */
-    Packet& operator>>(std::uint32_t& data) noexcept
+    PacketView& operator>>(std::uint32_t& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(std::uint32_t);
-
-        if (is_readable(bytes_to_read))
-        {
-            const std::uint32_t* data_ptr =
-                reinterpret_cast< const std::uint32_t* >(&m_data[m_read_pos]);
-            data = from_network< uint32 >(*data_ptr);
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -359,18 +270,9 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the packet object
      */
-    Packet& operator>>(std::int32_t& data) noexcept
+    PacketView& operator>>(std::int32_t& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(std::int32_t);
-
-        if (is_readable(bytes_to_read))
-        {
-            const std::int32_t* data_ptr =
-                reinterpret_cast< const std::int32_t* >(&m_data[m_read_pos]);
-            data = from_network< std::int32_t >(*data_ptr);
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -380,18 +282,9 @@ template < std::size_t Size > class Packet
      * data from the container in.
      * \return the packet object
      */
-    Packet& operator>>(std::uint64_t& data) noexcept
+    PacketView& operator>>(std::uint64_t& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(std::uint64_t);
-
-        if (is_readable(bytes_to_read))
-        {
-            const std::uint64_t* data_ptr =
-                reinterpret_cast< const std::uint64_t* >(&m_data[m_read_pos]);
-            data = from_network< std::uint64_t >(*data_ptr);
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -401,18 +294,9 @@ template < std::size_t Size > class Packet
      * packet is stored.
      * \return the packet object.
      */
-    Packet& operator>>(std::int64_t& data) noexcept
+    PacketView& operator>>(std::int64_t& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(std::int64_t);
-
-        if (is_readable(bytes_to_read))
-        {
-            const std::int64_t* data_ptr =
-                reinterpret_cast< const std::int64_t* >(&m_data[m_read_pos]);
-            data = from_network< std::int64_t >(*data_ptr);
-            m_read_pos += bytes_to_read;
-        }
-
+        extract(data);
         return *this;
     }
 
@@ -422,21 +306,12 @@ template < std::size_t Size > class Packet
      * \param[out] data the variable where to store the float32 in.
      * \return this object.
      */
-    Packet& operator>>(float& data) noexcept
+    PacketView& operator>>(float& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(float);
-
-        if (is_readable(bytes_to_read))
-        {
-            std::uint32_t f_as_num =
-                *(reinterpret_cast< std::uint32_t* >(&m_data[m_read_pos]));
-            // first swap the bytes and then convert into a floating point
-            f_as_num = from_network< std::uint32_t >(f_as_num);
-            std::memcpy(&data, &f_as_num, bytes_to_read);
-            // update the read position
-            m_read_pos += bytes_to_read;
-        }
-
+        // first swap the bytes and then convert into a floating point
+        std::uint32_t f_as_num{0U};
+        *this >> f_as_num;
+        std::memcpy(&data, &f_as_num, sizeof(float));
         return *this;
     }
 
@@ -444,20 +319,12 @@ template < std::size_t Size > class Packet
      * \brief Extract a floating point from this packet to host byte order.
      * \param[out] data the variable where to store the float64 in.
      */
-    Packet& operator>>(double& data) noexcept
+    PacketView& operator>>(double& data) noexcept
     {
-        static constexpr auto bytes_to_read = sizeof(double);
-
-        if (is_readable(bytes_to_read))
-        {
-            std::uint64_t f_as_num =
-                *(reinterpret_cast< uint64* >(&m_data[m_read_pos]));
-            // first swap the bytes and then convert into a floating point
-            f_as_num = from_network< std::uint64_t >(f_as_num);
-            std::memcpy(&data, &f_as_num, bytes_to_read);
-            m_read_pos += bytes_to_read; // update the read position
-        }
-
+        // first swap the bytes and then convert into a floating point
+        std::uint64_t f_as_num{0U};
+        *this >> f_as_num;
+        std::memcpy(&data, &f_as_num, sizeof(double));
         return *this;
     }
 
@@ -465,19 +332,23 @@ template < std::size_t Size > class Packet
      * \brief Extract a char array from this packet.
      * \param[out] data the array were to store the C-array in.
      */
-    Packet& operator>>(char* data) noexcept
+    PacketView& operator>>(char* data) noexcept
     {
-        uint32 bytes_to_read = 0U;
+        std::uint32_t bytes_to_read = 0U;
         *this >> bytes_to_read;
 
         if (is_readable(bytes_to_read))
         {
-            std::memcpy(data, &m_data[m_read_pos], bytes_to_read);
+            std::memcpy(data, &m_view[m_read_pos], bytes_to_read);
             // we need to add the char terminator
             data[bytes_to_read] = '\0';
             // update reading position
             m_read_pos += bytes_to_read;
         }
+        else if (bytes_to_read > 0U)
+        {
+            m_overflow = true;
+        }
 
         return *this;
     }
@@ -487,7 +358,7 @@ template < std::size_t Size > class Packet
      * byte order.
      * \param[in] data the unsigned byte to store in the packet.
      */
-    Packet& operator<<(std::uint8_t& data) noexcept
+    PacketView& operator<<(const std::uint8_t data) noexcept
     {
         append< std::uint8_t >(data);
         return *this;
@@ -499,7 +370,7 @@ template < std::size_t Size > class Packet
      * \param[in] data is the rhs and the signed byte to store in the
      * packet.
      */
-    Packet& operator<<(std::int8_t& data) noexcept
+    PacketView& operator<<(const std::int8_t data) noexcept
     {
         append< std::int8_t >(data);
         return *this;
@@ -512,20 +383,11 @@ template < std::size_t Size > class Packet
      * packet.
      * \return the packet object.
      */
-    Packet& operator<<(bool& data) noexcept
+    PacketView& operator<<(const bool data) noexcept
     {
         // forwards to the uint8 operator
-        if (data == true)
-        {
-            std::uint8_t num_as_bool = 1U;
-            *this << num_as_bool;
-        }
-        else
-        {
-            std::uint8_t num_as_bool = 0U;
-            *this << num_as_bool;
-        }
-
+        const std::uint8_t num_as_bool = data ? 1U : 0U;
+        *this << num_as_bool;
         return *this;
     }
 
@@ -535,10 +397,9 @@ template < std::size_t Size > class Packet
      * \param[in] data is the rhs and the unsigned word to store in the
      * packet.
      */
-    Packet& operator<<(std::uint16_t& data) noexcept
+    PacketView& operator<<(const std::uint16_t data) noexcept
     {
-        std::uint16_t network_data = to_network< std::uint16_t >(data);
-        append< std::uint16_t >(network_data);
+        append< std::uint16_t >(to_network< std::uint16_t >(data));
         return *this;
     }
 
@@ -548,10 +409,9 @@ template < std::size_t Size > class Packet
      * \param[in] data is the rhs and the signed word to store in the
      * packet.
      */
-    Packet& operator<<(std::int16_t& data) noexcept
+    PacketView& operator<<(const std::int16_t data) noexcept
     {
-        std::int16_t network_data = to_network< std::int16_t >(data);
-        append< std::int16_t >(network_data);
+        append< std::int16_t >(to_network< std::int16_t >(data));
         return *this;
     }
 
@@ -561,10 +421,9 @@ template < std::size_t Size > class Packet
      * \param[in] data is the rhs and the signed double word to store in the
      * packet.
      */
-    Packet& operator<<(std::uint32_t& data) noexcept
+    PacketView& operator<<(const std::uint32_t data) noexcept
     {
-        std::uint32_t network_data = to_network< std::uint32_t >(data);
-        append< std::uint32_t >(network_data);
+        append< std::uint32_t >(to_network< std::uint32_t >(data));
         return *this;
     }
 
@@ -573,10 +432,9 @@ template < std::size_t Size > class Packet
      * byte order.
      * \param[in] data the signed double word to store in the packet.
      */
-    Packet& operator<<(std::int32_t& data) noexcept
+    PacketView& operator<<(const std::int32_t data) noexcept
     {
-        std::int32_t network_data = to_network< std::int32_t >(data);
-        append< std::uint32_t >(network_data);
+        append< std::int32_t >(to_network< std::int32_t >(data));
         return *this;
     }
 
@@ -585,10 +443,9 @@ template < std::size_t Size > class Packet
      * byte order.
      * \param[in] the unsigned quad word to store in the packet.
      */
-    Packet& operator<<(std::uint64_t& data) noexcept
+    PacketView& operator<<(const std::uint64_t data) noexcept
     {
-        std::uint64_t network_data = to_network< std::uint64_t >(data);
-        append< std::uint64_t >(network_data);
+        append< std::uint64_t >(to_network< std::uint64_t >(data));
         return *this;
     }
 
@@ -597,10 +454,9 @@ template < std::size_t Size > class Packet
      * byte order.
      * \param[in] data the signed quad word to store in the packet.
      */
-    Packet& operator<<(std::int64_t& data) noexcept
+    PacketView& operator<<(const std::int64_t data) noexcept
     {
-        std::int64_t network_data = to_network< std::int64_t >(data);
-        append< std::int64_t >(network_data);
+        append< std::int64_t >(to_network< std::int64_t >(data));
         return *this;
     }
 
@@ -609,13 +465,12 @@ template < std::size_t Size > class Packet
      * byte order.
      * \param[in] data the float to store.
      */
-    Packet& operator<<(float& data) noexcept
+    PacketView& operator<<(const float data) noexcept
     {
         // first we will convert it to an equivalent byte representation.
-        std::uint32_t num_as_float =
-            *(reinterpret_cast< std::uint32_t* >(&data));
-        std::uint32_t network_data = to_network< std::uint32_t >(num_as_float);
-        append< std::uint32_t >(network_data);
+        std::uint32_t num_as_float{0U};
+        std::memcpy(&num_as_float, &data, sizeof(num_as_float));
+        *this << num_as_float;
         return *this;
     }
 
@@ -624,13 +479,12 @@ template < std::size_t Size > class Packet
      * byte order.
      * \param[in] data the double to store
      */
-    Packet& operator<<(double& data) noexcept
+    PacketView& operator<<(const double data) noexcept
     {
         // first we will convert it to an equivalent byte representation.
-        std::uint64_t num_as_float =
-            *(reinterpret_cast< std::uint64_t* >(&data));
-        std::uint64_t network_data = to_network< std::uint64_t >(num_as_float);
-        append< std::uint64_t >(network_data);
+        std::uint64_t num_as_float{0U};
+        std::memcpy(&num_as_float, &data, sizeof(num_as_float));
+        *this << num_as_float;
         return *this;
     }
 
@@ -639,31 +493,180 @@ template < std::size_t Size > class Packet
      * byte order.
      * \param[in] data the C-string to store in the packet
      */
-    Packet& operator<<(const char* data) noexcept
+    PacketView& operator<<(const char* data) noexcept
     {
         append(data);
         return *this;
     }
 
   protected:
+    /**
+     * \brief Points the view to another buffer of the same capacity, e.g.
+     * after the owner of the buffer has been copied.
+     */
+    void rebind(std::uint8_t* data) noexcept { m_view = data; }
+
   private:
-    //! This is the container that holds the data stored via << operator.
-    DataContainer m_data;
+    /**
+     * \brief Reads a value in network-byte-order at the read position. The
+     * bytes are copied, so the value may be unaligned in the buffer.
+     */
+    template < typename T > void extract(T& data) noexcept
+    {
+        static constexpr std::size_t bytes_to_read = sizeof(T);
+
+        if (is_readable(bytes_to_read))
+        {
+            T network_data;
+            std::memcpy(&network_data, &m_view[m_read_pos], bytes_to_read);
+            data = from_network< T >(network_data);
+            m_read_pos += bytes_to_read;
+        }
+        else
+        {
+            m_overflow = true;
+        }
+    }
+
+    //! The buffer that holds the data stored via << operator.
+    std::uint8_t* m_view;
+
+    //! The size of the buffer.
+    std::size_t m_capacity;
 
     //! Current position where data is appended in the packet.
-    std::uint32_t m_write_pos;
+    std::size_t m_write_pos;
 
     //! current position where data is read from, until this packet is
     //! completely read.
-    std::uint32_t m_read_pos;
+    std::size_t m_read_pos;
+
+    //! true if a value did not fit.
+    bool m_overflow;
 };
 
-/*******************************************************************************
- * EXPORTED VARIABLES
- *******************************************************************************/
+/**
+ * \brief The container of a Packet. It is a base class, so it is constructed
+ * before the view that works on it.
+ */
+template < std::size_t Size > struct PacketStorage
+{
+    //! This is the container that holds the data stored via << operator.
+    std::array< std::uint8_t, Size > m_data;
+};
+
+/**
+ * \brief Packet class for unified data (network) transport.
+ * \tparam Size of the container
+ */
+template < std::size_t Size >
+class Packet : private PacketStorage< Size >, public PacketView
+{
+  public:
+    using DataContainer = std::array< std::uint8_t, Size >;
+
+    /**
+     * \brief Default constructor initializes the write and read position.
+     */
+    Packet() noexcept : PacketView{this->m_data.data(), Size}
+    {
+        static_assert(Size > 0, "Size must be greater than zero!");
+    }
+
+    /**
+     * \brief Copies the data and the positions of another packet.
+     */
+    Packet(const Packet& other) noexcept
+        : PacketStorage< Size >(other), PacketView(other)
+    {
+        rebind(this->m_data.data());
+    }
+
+    /**
+     * \brief Copies the data and the positions of another packet.
+     */
+    Packet& operator=(const Packet& other) noexcept
+    {
+        PacketStorage< Size >::operator=(other);
+        PacketView::operator=(other);
+        rebind(this->m_data.data());
+        return *this;
+    }
 
-/*******************************************************************************
- * EXPORTED FUNCTIONS
- *******************************************************************************/
+    /**
+     * \brief Default destructor
+     * Nothing to clean up here.
+     */
+    ~Packet() noexcept = default;
+
+    /**
+     * \brief returns the static size of the packet's data to send or receive.
+     * \return the static size.
+     */
+    constexpr std::uint16_t get_size() const noexcept
+    {
+        return static_cast< std::uint16_t >(Size);
+    }
+
+    /**
+     * \brief direct link to the data.
+     */
+    const DataContainer& get_data() const noexcept { return this->m_data; }
+
+    /**
+     * \brief direct link to the data.
+     */
+    DataContainer& get_data() noexcept { return this->m_data; }
+
+    /**
+     * \brief the complete packet as a constant reference.
+     */
+    const Packet& get_packet() const noexcept { return *this; }
+
+    Packet& get_packet() noexcept { return *this; }
+
+    /**
+     * \brief This method is extremly helpful for returning a type T variable
+     * from the packet without modifying it from a given position.
+     * \tparam T the value type to return
+     * \tparam Position the position at what the value begins.
+     */
+    template < typename T, std::size_t Position > T peek() const noexcept
+    {
+        static_assert(std::is_arithmetic< T >::value,
+                      "Type must be integral or floating point.");
+        static_assert(
+            (Position + sizeof(T)) <= Size,
+            "The position to read is greater than the actual Packet size.");
+        using MyType = T;
+        MyType data{static_cast< MyType >(0)};
+        std::memcpy(&data, &this->m_data[Position], sizeof(MyType));
+        data = from_network< MyType >(data);
+        return data;
+    }
+
+    /**
+     * \brief This will store a value of template parameter T at the given
+     * position into the packet with network-byte-order.
+     */
+    template < typename T, std::size_t Position >
+    void store(const T& data) noexcept
+    {
+        static_assert(std::is_arithmetic< T >::value,
+                      "Type must be integral or floating point.");
+        static_assert(
+            (Position + sizeof(T)) <= Size,
+            "The position to write is greater than the actual Packet size.");
+        using MyType = T;
+        static constexpr auto bytes = sizeof(T);
+
+        // swap to network-byte-order
+        MyType network_data = to_network< MyType >(data);
+        // we need it byte by byte.
+        const std::uint8_t* data_ptr =
+            reinterpret_cast< const std::uint8_t* >(&network_data);
+        std::memcpy(&this->m_data[Position], data_ptr, bytes);
+    }
+};
 
 #endif /* PACKET_H_ */
@@ -0,0 +1,318 @@
+/**
+ * \file      PacketBatch.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Many small messages back to back in one send buffer.
+ * \details   A PacketBatch encodes messages with a length prefix each into one
+ *            preallocated buffer that is sent with a single call. The
+ *            PacketBatchReader walks through the messages of one received buffer.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PACKETBATCH_H_
+#define PACKETBATCH_H_
+
+#include "Packet.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * \brief Framing of the messages in a batch.
+ */
+struct PACKET_BATCH
+{
+    /// every message starts with its length as big-endian 16 bit value.
+    static constexpr std::size_t LENGTH_PREFIX = 2U;
+
+    /// the biggest message the length prefix can describe.
+    static constexpr std::size_t MAX_MESSAGE = 0xFFFFU;
+};
+
+/**
+ * \brief Collects many small messages in one contiguous buffer. Each message
+ * is written with the normal Packet operators through a PacketView on the
+ * free part of the buffer, then the batch goes out with one send.
+ * \tparam Size of the buffer in bytes. The socket sends at most 32767 bytes
+ * at once.
+ */
+template < std::size_t Size > class PacketBatch
+{
+  public:
+    PacketBatch() noexcept : buffer_{}, length_{0U}, sent_{0U}, count_{0U}
+    {
+        static_assert(Size > PACKET_BATCH::LENGTH_PREFIX,
+                      "Size must hold at least one length prefix.");
+        static_assert(Size <= 0x7FFFU,
+                      "Size must be sent with one call of send().");
+    }
+
+    /**
+     * \brief Appends a message. The handler gets a PacketView on the free
+     * space behind the length prefix and writes the message with the
+     * operator <<. If a value did not fit the message is dropped.
+     * \param[in] write is called as write(PacketView&).
+     * \return true if the message was added, false if the batch is full.
+     */
+    template < typename Handler > bool encode(Handler&& write) noexcept
+    {
+        bool added = false;
+
+        if ((length_ + PACKET_BATCH::LENGTH_PREFIX) <= Size)
+        {
+            const std::size_t free_space =
+                Size - length_ - PACKET_BATCH::LENGTH_PREFIX;
+            const std::size_t max_message = PACKET_BATCH::MAX_MESSAGE;
+            PacketView message{
+                &buffer_[length_ + PACKET_BATCH::LENGTH_PREFIX],
+                (free_space < max_message) ? free_space : max_message};
+            write(message);
+
+            if (message.has_overflow() == false)
+            {
+                commit(message.get_length());
+                added = true;
+            }
+        }
+
+        return added;
+    }
+
+    /**
+     * \brief Appends the bytes written into a packet.
+     * \param[in] packet the message, its size is the length written.
+     * \return true if the message was added, false if the batch is full.
+     */
+    template < std::size_t PacketSize >
+    bool add(const Packet< PacketSize >& packet) noexcept
+    {
+        const std::size_t message_length = packet.get_length();
+        bool added = false;
+
+        if ((length_ + PACKET_BATCH::LENGTH_PREFIX + message_length) <= Size)
+        {
+            std::memcpy(&buffer_[length_ + PACKET_BATCH::LENGTH_PREFIX],
+                        packet.get_data().data(), message_length);
+            commit(message_length);
+            added = true;
+        }
+
+        return added;
+    }
+
+    /**
+     * \brief Sends the whole batch with one call of send() and clears it.
+     * A partial send is continued. If the socket would block or fails, the
+     * rest stays in the batch and the next flush() goes on with it.
+     * \param[in] socket anything with send(const void*, std::uint16_t).
+     * \return true if the batch has been sent completely.
+     */
+    template < typename SendSocket > bool flush(SendSocket& socket) noexcept
+    {
+        bool flushed = true;
+
+        while (sent_ < length_)
+        {
+            const auto sent = socket.send(
+                &buffer_[sent_], static_cast< std::uint16_t >(length_ - sent_));
+
+            if (sent <= 0)
+            {
+                flushed = false;
+                break;
+            }
+
+            sent_ += static_cast< std::size_t >(sent);
+        }
+
+        if (flushed == true)
+        {
+            clear();
+        }
+
+        return flushed;
+    }
+
+    /**
+     * \brief Drops all messages.
+     */
+    void clear() noexcept
+    {
+        length_ = 0U;
+        sent_ = 0U;
+        count_ = 0U;
+    }
+
+    /**
+     * \brief Number of messages in the batch.
+     */
+    std::size_t get_count() const noexcept { return count_; }
+
+    /**
+     * \brief Number of bytes in the batch including the length prefixes.
+     */
+    std::size_t get_length() const noexcept { return length_; }
+
+    /**
+     * \brief The encoded batch.
+     */
+    const std::uint8_t* get_data() const noexcept { return buffer_.data(); }
+
+  private:
+    /**
+     * \brief Writes the length prefix of the message behind the current end
+     * and moves the end behind the message.
+     */
+    void commit(const std::size_t message_length) noexcept
+    {
+        buffer_[length_] = static_cast< std::uint8_t >(message_length >> 8U);
+        buffer_[length_ + 1U] = static_cast< std::uint8_t >(message_length);
+        length_ += PACKET_BATCH::LENGTH_PREFIX + message_length;
+        ++count_;
+    }
+
+    /// the preallocated send buffer.
+    std::array< std::uint8_t, Size > buffer_;
+
+    /// bytes used in the buffer.
+    std::size_t length_;
+
+    /// bytes of the buffer already sent by flush().
+    std::size_t sent_;
+
+    /// number of messages in the buffer.
+    std::size_t count_;
+};
+
+/**
+ * \brief Iterates over the messages of a received batch. Only complete
+ * messages are visited. A message cut off at the end of the buffer is left
+ * for the next receive, see get_consumed().
+ */
+class PacketBatchReader
+{
+  public:
+    /**
+     * \brief Visits the messages as PacketView for the operator >>.
+     */
+    class Iterator
+    {
+      public:
+        Iterator(std::uint8_t* data, const std::size_t position) noexcept
+            : data_{data}, position_{position}
+        {
+        }
+
+        PacketView operator*() const noexcept
+        {
+            return PacketView{&data_[position_ + PACKET_BATCH::LENGTH_PREFIX],
+                              get_message_length(&data_[position_])};
+        }
+
+        Iterator& operator++() noexcept
+        {
+            position_ += PACKET_BATCH::LENGTH_PREFIX +
+                         get_message_length(&data_[position_]);
+            return *this;
+        }
+
+        bool operator!=(const Iterator& other) const noexcept
+        {
+            return position_ != other.position_;
+        }
+
+      private:
+        /// the received buffer.
+        std::uint8_t* data_;
+
+        /// the length prefix of the current message.
+        std::size_t position_;
+    };
+
+    /**
+     * \brief Looks up the complete messages in a received buffer.
+     * \param[in] data the received bytes, must outlive the reader.
+     * \param[in] length the number of bytes received.
+     */
+    PacketBatchReader(void* data, const std::size_t length) noexcept
+        : data_{static_cast< std::uint8_t* >(data)}, consumed_{0U}, count_{0U}
+    {
+        while ((consumed_ + PACKET_BATCH::LENGTH_PREFIX) <= length)
+        {
+            const std::size_t next = consumed_ + PACKET_BATCH::LENGTH_PREFIX +
+                                     get_message_length(&data_[consumed_]);
+
+            if (next > length)
+            {
+                break;
+            }
+
+            consumed_ = next;
+            ++count_;
+        }
+    }
+
+    Iterator begin() const noexcept { return Iterator{data_, 0U}; }
+
+    Iterator end() const noexcept { return Iterator{data_, consumed_}; }
+
+    /**
+     * \brief Number of complete messages.
+     */
+    std::size_t get_count() const noexcept { return count_; }
+
+    /**
+     * \brief Bytes of the complete messages. The bytes behind belong to a
+     * message that has not been received completely yet.
+     */
+    std::size_t get_consumed() const noexcept { return consumed_; }
+
+  private:
+    /**
+     * \brief Reads the big-endian length prefix.
+     */
+    static std::size_t get_message_length(const std::uint8_t* prefix) noexcept
+    {
+        return (static_cast< std::size_t >(prefix[0]) << 8U) | prefix[1];
+    }
+
+    /// the received buffer.
+    std::uint8_t* data_;
+
+    /// bytes of complete messages.
+    std::size_t consumed_;
+
+    /// number of complete messages.
+    std::size_t count_;
+};
+
+#endif /* PACKETBATCH_H_ */
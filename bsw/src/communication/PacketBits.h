@@ -0,0 +1,299 @@
+/**
+ * \file      PacketBits.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Bit fields of any width in a packet.
+ * \details   PacketBitWriter packs values of 1 to 64 bits into a PacketView, the
+ *            most significant bit first, and PacketBitReader reads them back.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PACKETBITS_H_
+#define PACKETBITS_H_
+
+#include "Packet.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Defining a struct that holds the sizes of the bit writer and reader.
+ */
+struct PACKET_BITS
+{
+    /// the widest value written or read at once.
+    static constexpr std::size_t MAX_WIDTH = 64U;
+
+    /// bits moved between the packet and the bit buffer at once.
+    static constexpr std::size_t WORD = 32U;
+};
+
+/**
+ * \brief Writes values of any width into a packet, bit by bit with the most
+ * significant bit first. So the bits are in network-byte-order as all other
+ * values of a packet. The bits go into the packet a word at a time, flush()
+ * writes the bits left padded with zeros to a byte.
+ * \code
+ * Packet< 64 > packet;
+ * packet << id;
+ * PacketBitWriter bits{packet};
+ * bits.write(5U, 3U);
+ * bits.flush();
+ * \endcode
+ */
+class PacketBitWriter
+{
+  public:
+    /**
+     * \brief Creates a writer that appends to a packet.
+     * \param[in] packet the packet, must outlive the writer.
+     */
+    explicit PacketBitWriter(PacketView& packet) noexcept
+        : packet_{packet}, buffer_{0U}, buffered_{0U}, written_{0U}
+    {
+    }
+
+    /**
+     * \brief Writes the low bits of a value.
+     * \param[in] value the value, the bits above width are ignored.
+     * \param[in] width the number of bits: 1 to 64.
+     * \return false if the bits did not fit into the packet. Check
+     * get_free_bits() before, the bits written are undefined then.
+     */
+    bool write(const std::uint64_t value, const std::size_t width) noexcept
+    {
+        if (width > PACKET_BITS::WORD)
+        {
+            put(value >> PACKET_BITS::WORD, width - PACKET_BITS::WORD);
+            put(value, PACKET_BITS::WORD);
+        }
+        else
+        {
+            put(value, width);
+        }
+
+        written_ += width;
+        return !packet_.has_overflow();
+    }
+
+    /**
+     * \brief Writes the bits buffered into the packet, padded with zeros to
+     * a full byte.
+     */
+    void flush() noexcept
+    {
+        const std::size_t padding = (8U - (buffered_ % 8U)) % 8U;
+        const std::uint64_t padded = buffer_ << padding;
+
+        for (std::size_t bytes = (buffered_ + padding) / 8U; bytes > 0U;
+             --bytes)
+        {
+            packet_ << static_cast< std::uint8_t >(padded >>
+                                                   (8U * (bytes - 1U)));
+        }
+
+        written_ += padding;
+        buffered_ = 0U;
+    }
+
+    /**
+     * \brief The number of bits that still fit into the packet.
+     */
+    std::size_t get_free_bits() const noexcept
+    {
+        return ((packet_.get_capacity() - packet_.get_length()) * 8U) -
+               buffered_;
+    }
+
+    /**
+     * \brief The number of bits written, with the padding of flush().
+     */
+    std::size_t get_bits() const noexcept { return written_; }
+
+  private:
+    /**
+     * \brief Appends up to a word of bits to the buffer and writes a full
+     * word into the packet. Near the end of the packet the bits go in byte
+     * by byte, so every byte of the packet is used.
+     */
+    void put(const std::uint64_t value, const std::size_t width) noexcept
+    {
+        const std::uint64_t mask = (std::uint64_t{1U} << width) - 1U;
+        buffer_ = (buffer_ << width) | (value & mask);
+        buffered_ += width;
+
+        if (buffered_ >= PACKET_BITS::WORD)
+        {
+            if (packet_.is_writable(sizeof(std::uint32_t)))
+            {
+                buffered_ -= PACKET_BITS::WORD;
+                packet_ << static_cast< std::uint32_t >(buffer_ >> buffered_);
+            }
+            else
+            {
+                for (; buffered_ >= 8U; buffered_ -= 8U)
+                {
+                    packet_ << static_cast< std::uint8_t >(
+                        buffer_ >> (buffered_ - 8U));
+                }
+            }
+        }
+    }
+
+    /// the packet written to.
+    PacketView& packet_;
+
+    /// the bits not written into the packet yet, the last ones lowest.
+    std::uint64_t buffer_;
+
+    /// the number of bits in the buffer, less than a word between writes.
+    std::size_t buffered_;
+
+    /// the number of bits written.
+    std::size_t written_;
+};
+
+/**
+ * \brief Reads values of any width from a packet, written by a
+ * PacketBitWriter. The bits are taken from the packet a word at a time.
+ */
+class PacketBitReader
+{
+  public:
+    /**
+     * \brief Creates a reader that starts at the read position of a packet.
+     * \param[in] packet the packet, must outlive the reader.
+     */
+    explicit PacketBitReader(PacketView& packet) noexcept
+        : packet_{packet}, buffer_{0U}, buffered_{0U}, overflow_{false}
+    {
+    }
+
+    /**
+     * \brief Reads a value.
+     * \param[in] width the number of bits: 1 to 64.
+     * \return the value, 0 if the packet has less bits left. has_overflow()
+     * tells then.
+     */
+    std::uint64_t read(const std::size_t width) noexcept
+    {
+        std::uint64_t value = 0U;
+
+        if (width > PACKET_BITS::WORD)
+        {
+            value = take(width - PACKET_BITS::WORD) << PACKET_BITS::WORD;
+            value |= take(PACKET_BITS::WORD);
+        }
+        else
+        {
+            value = take(width);
+        }
+
+        return value;
+    }
+
+    /**
+     * \brief Reads a single bit.
+     */
+    bool read_bit() noexcept { return take(1U) != 0U; }
+
+    /**
+     * \brief Checks if a read went beyond the end of the packet.
+     */
+    bool has_overflow() const noexcept { return overflow_; }
+
+  private:
+    /**
+     * \brief Takes up to a word of bits from the buffer, fills it up from
+     * the packet before if needed.
+     */
+    std::uint64_t take(const std::size_t width) noexcept
+    {
+        if (buffered_ < width)
+        {
+            fill();
+        }
+
+        std::uint64_t value = 0U;
+
+        if (buffered_ >= width)
+        {
+            buffered_ -= width;
+            const std::uint64_t mask = (std::uint64_t{1U} << width) - 1U;
+            value = (buffer_ >> buffered_) & mask;
+        }
+        else
+        {
+            overflow_ = true;
+        }
+
+        return value;
+    }
+
+    /**
+     * \brief Reads a word from the packet into the buffer, byte by byte
+     * at the end of the packet.
+     */
+    void fill() noexcept
+    {
+        if (packet_.is_readable(sizeof(std::uint32_t)))
+        {
+            std::uint32_t word = 0U;
+            packet_ >> word;
+            buffer_ = (buffer_ << PACKET_BITS::WORD) | word;
+            buffered_ += PACKET_BITS::WORD;
+        }
+        else
+        {
+            while ((buffered_ <= (PACKET_BITS::MAX_WIDTH - 8U)) &&
+                   packet_.is_readable(sizeof(std::uint8_t)))
+            {
+                std::uint8_t byte = 0U;
+                packet_ >> byte;
+                buffer_ = (buffer_ << 8U) | byte;
+                buffered_ += 8U;
+            }
+        }
+    }
+
+    /// the packet read from.
+    PacketView& packet_;
+
+    /// the bits read from the packet, the next ones highest.
+    std::uint64_t buffer_;
+
+    /// the number of bits in the buffer.
+    std::size_t buffered_;
+
+    /// true if a read went beyond the end of the packet.
+    bool overflow_;
+};
+
+#endif // PACKETBITS_H_
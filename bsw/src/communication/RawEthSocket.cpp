@@ -0,0 +1,512 @@
+/**
+ * \file      RawEthSocket.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Raw Ethernet socket (AF_PACKET) with mmap'd RX and TX rings.
+ * \details   The RX ring is handed over block by block (TPACKET_V3), the TX ring
+ *            frame by frame. Both rings are mapped with one mmap().
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RawEthSocket.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+namespace
+{
+/**
+ * \brief Loads a status written by the kernel.
+ */
+std::uint32_t load_acquire(const std::uint32_t* status) noexcept
+{
+    return __atomic_load_n(status, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * \brief Hands a status over to the kernel.
+ */
+void store_release(std::uint32_t* status, const std::uint32_t value) noexcept
+{
+    __atomic_store_n(status, value, __ATOMIC_RELEASE);
+}
+
+/// blocks of the TX ring.
+constexpr std::uint32_t TX_BLOCKS =
+    (RAW_ETH::TX_FRAMES * RAW_ETH::FRAME_SIZE) / RAW_ETH::BLOCK_SIZE;
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+RawEthSocket::RawEthSocket() noexcept
+    : Socket{}, ring_{nullptr}, ring_size_{0U}, rx_block_{0U}, rx_left_{0U},
+      rx_frame_{nullptr}, tx_frame_{0U}, tx_pending_{0U}, interface_{0},
+      mac_{}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RawEthSocket::~RawEthSocket() noexcept
+{
+    if (ring_ != nullptr)
+    {
+        munmap(ring_, ring_size_);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::create() noexcept
+{
+    // protocol 0: nothing is received until bind() sets the EtherType.
+    socket_ = ::socket(AF_PACKET, SOCK_RAW, 0);
+
+    if (socket_ < 0)
+    {
+        last_error_ = errno;
+        std::cerr << "Creating a packet socket failed: " << strerror(errno)
+                  << "\n";
+    }
+
+    return socket_ >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::bind(const char* interface, const std::uint16_t ether_type,
+                        const std::int32_t vlan) noexcept
+{
+    bool bound = false;
+    struct ifreq request;
+    std::memset(&request, 0, sizeof(request));
+    std::strncpy(request.ifr_name, interface, IFNAMSIZ - 1U);
+    interface_ = static_cast< int >(if_nametoindex(interface));
+    const int ignore_outgoing = 1;
+
+    if (interface_ == 0)
+    {
+        std::cerr << "Interface " << interface << " not found.\n";
+        last_error_ = ENODEV;
+    }
+    else if (is_socket_initialized() && setup_rings() &&
+             (ioctl(get_socket_handle(), SIOCGIFHWADDR, &request) == 0) &&
+             (setsockopt(get_socket_handle(), SOL_PACKET,
+                         PACKET_IGNORE_OUTGOING, &ignore_outgoing,
+                         sizeof(ignore_outgoing)) == 0) &&
+             ((vlan == RAW_ETH::NO_VLAN) ||
+              attach_vlan_filter(ether_type,
+                                 static_cast< std::uint16_t >(vlan))))
+    {
+        std::memcpy(mac_.data(), request.ifr_hwaddr.sa_data, mac_.size());
+        struct sockaddr_ll address;
+        std::memset(&address, 0, sizeof(address));
+        address.sll_family = AF_PACKET;
+        // without a VLAN device the kernel drops the tag before it hands
+        // the frame to an EtherType, only ETH_P_ALL still sees it.
+        address.sll_protocol = htons(
+            (vlan == RAW_ETH::NO_VLAN) ? ether_type : std::uint16_t{ETH_P_ALL});
+        address.sll_ifindex = interface_;
+        bound = (::bind(get_socket_handle(),
+                        reinterpret_cast< struct sockaddr* >(&address),
+                        sizeof(address)) == 0);
+    }
+
+    if ((bound == false) && (interface_ != 0))
+    {
+        last_error_ = errno;
+        std::cerr << "Binding the packet socket failed: " << strerror(errno)
+                  << "\n";
+    }
+
+    return bound;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::enable_qdisc_bypass() noexcept
+{
+    const int bypass = 1;
+    const bool enabled =
+        (setsockopt(get_socket_handle(), SOL_PACKET, PACKET_QDISC_BYPASS,
+                    &bypass, sizeof(bypass)) == 0);
+
+    if (enabled == false)
+    {
+        last_error_ = errno;
+    }
+
+    return enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t RawEthSocket::receive(void* frame,
+                                   const std::uint16_t len) noexcept
+{
+    std::int16_t data_received = static_cast< std::int16_t >(wait_rx());
+
+    if (data_received == 0)
+    {
+        std::uint8_t* data = nullptr;
+        RawEthFrameInfo info;
+        const std::uint32_t length = next_rx(data, info);
+
+        if (data != nullptr)
+        {
+            const std::uint32_t copied = (length < len) ? length : len;
+            std::memcpy(frame, data, copied);
+            data_received = static_cast< std::int16_t >(copied);
+            release_rx();
+        }
+    }
+
+    return data_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t RawEthSocket::send(const void* frame,
+                                const std::uint16_t len) noexcept
+{
+    return (copy_tx(frame, len) && flush_tx())
+               ? static_cast< std::int16_t >(len)
+               : std::int16_t{-1};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::enable_txtime(const clockid_t clock,
+                                 const bool deadline_mode) noexcept
+{
+    const bool enabled = TxTime::enable(get_socket_handle(), clock,
+                                        deadline_mode);
+
+    if (enabled == false)
+    {
+        last_error_ = errno;
+    }
+
+    return enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t RawEthSocket::send_at(const void* frame, const std::uint16_t len,
+                                   const std::chrono::nanoseconds launch_time)
+    noexcept
+{
+    return (copy_tx(frame, len) && flush_tx(launch_time))
+               ? static_cast< std::int16_t >(len)
+               : std::int16_t{-1};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::setup_rings() noexcept
+{
+    const int version = TPACKET_V3;
+    struct tpacket_req3 rx;
+    std::memset(&rx, 0, sizeof(rx));
+    rx.tp_block_size = RAW_ETH::BLOCK_SIZE;
+    rx.tp_block_nr = RAW_ETH::RX_BLOCKS;
+    rx.tp_frame_size = RAW_ETH::FRAME_SIZE;
+    rx.tp_frame_nr = (RAW_ETH::BLOCK_SIZE / RAW_ETH::FRAME_SIZE) *
+                     RAW_ETH::RX_BLOCKS;
+    rx.tp_retire_blk_tov = RAW_ETH::RETIRE_TIMEOUT_MS;
+    // the TX ring takes fixed frames, the block timeout must be zero.
+    struct tpacket_req3 tx;
+    std::memset(&tx, 0, sizeof(tx));
+    tx.tp_block_size = RAW_ETH::BLOCK_SIZE;
+    tx.tp_block_nr = TX_BLOCKS;
+    tx.tp_frame_size = RAW_ETH::FRAME_SIZE;
+    tx.tp_frame_nr = RAW_ETH::TX_FRAMES;
+    const int handle = get_socket_handle();
+
+    bool ready =
+        (setsockopt(handle, SOL_PACKET, PACKET_VERSION, &version,
+                    sizeof(version)) == 0) &&
+        (setsockopt(handle, SOL_PACKET, PACKET_RX_RING, &rx, sizeof(rx)) ==
+         0) &&
+        (setsockopt(handle, SOL_PACKET, PACKET_TX_RING, &tx, sizeof(tx)) == 0);
+
+    if (ready)
+    {
+        ring_size_ = std::size_t{RAW_ETH::BLOCK_SIZE} *
+                     (RAW_ETH::RX_BLOCKS + TX_BLOCKS);
+        void* ring = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, handle, 0);
+        ready = (ring != MAP_FAILED);
+        ring_ = ready ? static_cast< std::uint8_t* >(ring) : nullptr;
+    }
+
+    if (ready == false)
+    {
+        last_error_ = errno;
+        std::cerr << "Setting up the packet rings failed: " << strerror(errno)
+                  << "\n";
+    }
+
+    return ready;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::attach_vlan_filter(const std::uint16_t ether_type,
+                                      const std::uint16_t vlan) noexcept
+{
+    // the kernel removes the tag before the filter runs, the ancillary
+    // fields hold it and the inner EtherType.
+    std::array< struct sock_filter, 9U > filter{{
+        {BPF_LD | BPF_W | BPF_ABS, 0U, 0U,
+         static_cast< std::uint32_t >(SKF_AD_OFF + SKF_AD_VLAN_TAG_PRESENT)},
+        {BPF_JMP | BPF_JEQ | BPF_K, 0U, 6U, 1U},
+        {BPF_LD | BPF_W | BPF_ABS, 0U, 0U,
+         static_cast< std::uint32_t >(SKF_AD_OFF + SKF_AD_VLAN_TAG)},
+        {BPF_ALU | BPF_AND | BPF_K, 0U, 0U, 0x0FFFU},
+        {BPF_JMP | BPF_JEQ | BPF_K, 0U, 3U, vlan},
+        {BPF_LD | BPF_W | BPF_ABS, 0U, 0U,
+         static_cast< std::uint32_t >(SKF_AD_OFF + SKF_AD_PROTOCOL)},
+        {BPF_JMP | BPF_JEQ | BPF_K, 0U, 1U, ether_type},
+        {BPF_RET | BPF_K, 0U, 0U, 0xFFFFFFFFU},
+        {BPF_RET | BPF_K, 0U, 0U, 0U},
+    }};
+    struct sock_fprog program;
+    program.len = static_cast< unsigned short >(filter.size());
+    program.filter = filter.data();
+    return setsockopt(get_socket_handle(), SOL_SOCKET, SO_ATTACH_FILTER,
+                      &program, sizeof(program)) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int RawEthSocket::wait_rx() noexcept
+{
+    int waited = 0;
+
+    if ((ring_ == nullptr) || (interface_ == 0))
+    {
+        last_error_ = ENOTCONN;
+        waited = -1;
+    }
+    else if ((rx_left_ == 0U) && is_blocking() &&
+             ((load_acquire(&get_rx_block(rx_block_)->hdr.bh1.block_status) &
+               TP_STATUS_USER) == 0U))
+    {
+        struct pollfd event;
+        event.fd = get_socket_handle();
+        event.events = POLLIN | POLLERR;
+        event.revents = 0;
+
+        if ((poll(&event, 1U, -1) < 0) && (errno != EINTR))
+        {
+            last_error_ = errno;
+            waited = -1;
+        }
+    }
+
+    return waited;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t RawEthSocket::next_rx(std::uint8_t*& data,
+                                    RawEthFrameInfo& info) noexcept
+{
+    std::uint32_t length = 0U;
+    data = nullptr;
+    release_rx();
+
+    if (rx_frame_ == nullptr)
+    {
+        struct tpacket_block_desc* block = get_rx_block(rx_block_);
+
+        if ((load_acquire(&block->hdr.bh1.block_status) & TP_STATUS_USER) !=
+            0U)
+        {
+            rx_left_ = block->hdr.bh1.num_pkts;
+            rx_frame_ = reinterpret_cast< struct tpacket3_hdr* >(
+                reinterpret_cast< std::uint8_t* >(block) +
+                block->hdr.bh1.offset_to_first_pkt);
+        }
+    }
+
+    if (rx_left_ > 0U)
+    {
+        struct tpacket3_hdr* frame = rx_frame_;
+        data = reinterpret_cast< std::uint8_t* >(frame) + frame->tp_mac;
+        length = frame->tp_snaplen;
+        info.length = frame->tp_len;
+        info.vlan_valid = ((frame->tp_status & TP_STATUS_VLAN_VALID) != 0U);
+        info.vlan_tci = info.vlan_valid
+                            ? static_cast< std::uint16_t >(
+                                  frame->hv1.tp_vlan_tci)
+                            : std::uint16_t{0U};
+        info.timestamp.tv_sec = frame->tp_sec;
+        info.timestamp.tv_nsec = frame->tp_nsec;
+        --rx_left_;
+
+        if (rx_left_ > 0U)
+        {
+            rx_frame_ = reinterpret_cast< struct tpacket3_hdr* >(
+                reinterpret_cast< std::uint8_t* >(frame) +
+                frame->tp_next_offset);
+        }
+    }
+
+    return length;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void RawEthSocket::release_rx() noexcept
+{
+    if ((rx_frame_ != nullptr) && (rx_left_ == 0U))
+    {
+        store_release(&get_rx_block(rx_block_)->hdr.bh1.block_status,
+                      TP_STATUS_KERNEL);
+        rx_block_ = (rx_block_ + 1U) % RAW_ETH::RX_BLOCKS;
+        rx_frame_ = nullptr;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint8_t* RawEthSocket::next_tx() noexcept
+{
+    std::uint8_t* data = nullptr;
+
+    if (ring_ != nullptr)
+    {
+        struct tpacket3_hdr* frame = get_tx_frame(tx_frame_);
+        const std::uint32_t status = load_acquire(&frame->tp_status);
+
+        // a frame the kernel rejected is free again as well.
+        if ((status == TP_STATUS_AVAILABLE) ||
+            (status == TP_STATUS_WRONG_FORMAT))
+        {
+            data = reinterpret_cast< std::uint8_t* >(frame) +
+                   RAW_ETH::TX_DATA_OFFSET;
+        }
+    }
+
+    return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void RawEthSocket::submit_tx(const std::uint32_t length) noexcept
+{
+    struct tpacket3_hdr* frame = get_tx_frame(tx_frame_);
+    frame->tp_len = length;
+    frame->tp_snaplen = length;
+    frame->tp_next_offset = 0U;
+    store_release(&frame->tp_status, TP_STATUS_SEND_REQUEST);
+    tx_frame_ = (tx_frame_ + 1U) % RAW_ETH::TX_FRAMES;
+    ++tx_pending_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::copy_tx(const void* frame, const std::uint16_t len) noexcept
+{
+    bool submitted = false;
+    std::uint8_t* data = nullptr;
+
+    if ((len == 0U) ||
+        (len > (RAW_ETH::FRAME_SIZE - RAW_ETH::TX_DATA_OFFSET)))
+    {
+        last_error_ = EMSGSIZE;
+    }
+    else if ((data = next_tx()) == nullptr)
+    {
+        last_error_ = EAGAIN;
+    }
+    else
+    {
+        std::memcpy(data, frame, len);
+        submit_tx(len);
+        submitted = true;
+    }
+
+    return submitted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::flush_tx() noexcept
+{
+    struct msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    return flush_tx(header);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::flush_tx(const std::chrono::nanoseconds launch_time) noexcept
+{
+    struct msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    TxTimeControl control{};
+    TxTime::set_launch_time(header, control, launch_time);
+    return flush_tx(header);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool RawEthSocket::flush_tx(const struct msghdr& header) noexcept
+{
+    bool flushed = true;
+
+    if (tx_pending_ > 0U)
+    {
+        // a blocking socket returns when the frames have been handed over.
+        const ssize_t sent = ::sendmsg(get_socket_handle(), &header,
+                                       is_blocking() ? 0 : MSG_DONTWAIT);
+        tx_pending_ = 0U;
+
+        if ((sent < 0) && (errno != EAGAIN) && (errno != ENOBUFS))
+        {
+            last_error_ = errno;
+            flushed = false;
+        }
+    }
+
+    return flushed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+struct tpacket_block_desc*
+RawEthSocket::get_rx_block(const std::uint32_t block) const noexcept
+{
+    return reinterpret_cast< struct tpacket_block_desc* >(
+        ring_ + (std::size_t{block} * RAW_ETH::BLOCK_SIZE));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+struct tpacket3_hdr*
+RawEthSocket::get_tx_frame(const std::uint32_t frame) const noexcept
+{
+    return reinterpret_cast< struct tpacket3_hdr* >(
+        ring_ + (std::size_t{RAW_ETH::RX_BLOCKS} * RAW_ETH::BLOCK_SIZE) +
+        (std::size_t{frame} * RAW_ETH::FRAME_SIZE));
+}
+
+#endif // WIN32 detection
@@ -0,0 +1,376 @@
+/**
+ * \file      RawEthSocket.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Raw Ethernet socket (AF_PACKET) with mmap'd RX and TX rings.
+ * \details   For custom EtherType protocols on layer 2. Frames are exchanged with
+ *            the kernel through TPACKET_V3 rings, many frames per system call.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RAWETHSOCKET_H_
+#define RAWETHSOCKET_H_
+
+#ifndef _WIN32
+
+#include "Packet.h"
+#include "Socket.h"
+#include "TxTime.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <linux/if_packet.h>
+#include <time.h>
+#include <utility>
+
+/**
+ * \brief Defining a struct that holds informations about the rings of the
+ * raw Ethernet socket.
+ */
+struct RAW_ETH
+{
+    // size of a block of the rings, a multiple of the page size.
+    static constexpr std::uint32_t BLOCK_SIZE{1U << 16U};
+    // blocks of the RX ring.
+    static constexpr std::uint32_t RX_BLOCKS{32U};
+    // size of one TX frame including the ring header.
+    static constexpr std::uint32_t FRAME_SIZE{2048U};
+    // frames of the TX ring.
+    static constexpr std::uint32_t TX_FRAMES{256U};
+    // the kernel hands a block over after this time even if it is not full.
+    static constexpr std::uint32_t RETIRE_TIMEOUT_MS{1U};
+    // maximum number of frames handled per receive_batch().
+    static constexpr std::uint32_t BATCH{64U};
+    // bind() without VLAN filter.
+    static constexpr std::int32_t NO_VLAN{-1};
+    // destination, source and EtherType.
+    static constexpr std::size_t HEADER_LEN{14U};
+    // offset of the frame data in a TX frame of the ring.
+    static constexpr std::size_t TX_DATA_OFFSET{
+        TPACKET_ALIGN(sizeof(struct tpacket3_hdr))};
+};
+
+/// MAC address of an interface.
+using MacAddress = std::array< std::uint8_t, 6U >;
+
+/**
+ * \brief Additional information about a frame received.
+ */
+struct RawEthFrameInfo
+{
+    /// length of the frame on the wire, may be longer than the frame seen.
+    std::uint32_t length{0U};
+
+    /// true if the frame carried a VLAN tag. The kernel removes the tag
+    /// from the frame.
+    bool vlan_valid{false};
+
+    /// the VLAN tag control information: priority and VLAN ID.
+    std::uint16_t vlan_tci{0U};
+
+    /// receive time of the frame (CLOCK_REALTIME).
+    struct timespec timestamp
+    {
+    };
+};
+
+/**
+ * \brief RawEthSocket sends and receives Ethernet frames of one EtherType on
+ * one interface. Received frames are read from an RX ring shared with the
+ * kernel, frames to send are written into a TX ring and sent with one system
+ * call. Needs CAP_NET_RAW.
+ */
+class RawEthSocket : public Socket< RawEthSocket >
+{
+  public:
+    /**
+     * \brief Opens the socket, nothing is received before bind().
+     */
+    RawEthSocket() noexcept;
+
+    /**
+     * \brief Unmaps the rings.
+     */
+    ~RawEthSocket() noexcept;
+
+    RawEthSocket(const RawEthSocket&) = delete;
+    RawEthSocket& operator=(const RawEthSocket&) = delete;
+
+    /**
+     * \brief Sets up the rings and binds the socket to an interface and an
+     * EtherType. Frames sent by the own host are not received.
+     * \param[in] interface the interface name, e.g. "eth0".
+     * \param[in] ether_type the EtherType to receive, e.g. 0x88B5.
+     * \param[in] vlan the VLAN ID to receive. Frames of other VLANs and
+     * untagged frames are dropped in the kernel. NO_VLAN receives untagged
+     * frames and frames of all VLANs.
+     * \return true if bound.
+     */
+    bool bind(const char* interface, const std::uint16_t ether_type,
+              const std::int32_t vlan = RAW_ETH::NO_VLAN) noexcept;
+
+    /**
+     * \brief Sends the frames directly to the driver without the queueing
+     * discipline (PACKET_QDISC_BYPASS). Lower latency, but no traffic
+     * shaping and frames are dropped if the driver queue is full.
+     * \return true if the option is set.
+     */
+    bool enable_qdisc_bypass() noexcept;
+
+    /**
+     * \brief The MAC address of the interface bound to.
+     */
+    const MacAddress& get_mac_address() const noexcept { return mac_; }
+
+    /**
+     * \brief Receives one frame.
+     * \param[out] frame the frame is copied here, starting with the
+     * destination MAC address.
+     * \param[in] len the size of frame, the rest of the frame is cut.
+     * \return the number of bytes copied, 0 if the socket is non-blocking
+     * and nothing is pending, -1 on error.
+     */
+    std::int16_t receive(void* frame, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Hands up to max_frames frames to the handler without copying
+     * them. Waits for the first frame if the socket is blocking.
+     * \param[in] handler called as handler(PacketView& frame,
+     * const RawEthFrameInfo& info). The frame starts with the destination
+     * MAC address and is only valid during the call.
+     * \param[in] max_frames the number of frames to take at most.
+     * \return the number of frames taken, -1 on error.
+     */
+    template < typename Handler >
+    int receive_batch(Handler&& handler,
+                      const std::uint32_t max_frames = RAW_ETH::BATCH) noexcept
+    {
+        int frames = wait_rx();
+        RawEthFrameInfo info;
+
+        while ((frames >= 0) && (static_cast< std::uint32_t >(frames) <
+                                 max_frames))
+        {
+            std::uint8_t* data = nullptr;
+            const std::uint32_t length = next_rx(data, info);
+
+            if (data == nullptr)
+            {
+                break;
+            }
+
+            PacketView frame{data, length};
+            handler(frame, info);
+            ++frames;
+        }
+
+        release_rx();
+        return frames;
+    }
+
+    /**
+     * \brief Sends one complete Ethernet frame.
+     * \return the number of bytes sent, -1 if the TX ring is full (EAGAIN)
+     * or the frame is too big.
+     */
+    std::int16_t send(const void* frame, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Writes up to count Ethernet frames directly into the TX ring
+     * and sends them with one system call.
+     * \param[in] count the number of frames to send.
+     * \param[in] write called as write(PacketView& frame) for each frame.
+     * Only the bytes written are sent.
+     * \return the number of frames sent, -1 on error.
+     */
+    template < typename Handler >
+    int send_batch(const std::uint32_t count, Handler&& write) noexcept
+    {
+        std::uint32_t queued = 0U;
+        std::uint8_t* data = nullptr;
+
+        while ((queued < count) && ((data = next_tx()) != nullptr))
+        {
+            PacketView frame{data, RAW_ETH::FRAME_SIZE -
+                                       RAW_ETH::TX_DATA_OFFSET};
+            write(frame);
+            submit_tx(static_cast< std::uint32_t >(frame.get_length()));
+            ++queued;
+        }
+
+        return flush_tx() ? static_cast< int >(queued) : -1;
+    }
+
+    /**
+     * \brief Turns on sends with a launch time, see TxTime::enable().
+     * \return true if the socket option is set.
+     */
+    bool enable_txtime(const clockid_t clock = CLOCK_TAI,
+                       const bool deadline_mode = false) noexcept;
+
+    /**
+     * \brief Sends one complete Ethernet frame that shall leave the interface
+     * at launch_time. The qdisc (ETF) holds it until then, so cyclic frames
+     * may be queued a few cycles ahead. Without such a qdisc it is sent
+     * right away.
+     * \param[in] launch_time time on the clock given to enable_txtime().
+     * \return the number of bytes sent, -1 on error.
+     */
+    std::int16_t send_at(const void* frame, const std::uint16_t len,
+                         const std::chrono::nanoseconds launch_time) noexcept;
+
+    /**
+     * \brief Reads the reports of frames the qdisc dropped because their
+     * launch time was missed or invalid.
+     * \param[in] handler called as handler(const TxTimeReport&).
+     * \return the number of reports read.
+     */
+    template < typename Handler >
+    int drain_txtime_reports(Handler&& handler) noexcept
+    {
+        return TxTime::drain_reports(get_socket_handle(),
+                                     std::forward< Handler >(handler));
+    }
+
+    /**
+     * \brief Creates the packet socket. Called by the Socket base class.
+     */
+    bool create() noexcept;
+
+  private:
+    /**
+     * \brief Sets the TPACKET_V3 rings up and maps them.
+     */
+    bool setup_rings() noexcept;
+
+    /**
+     * \brief Attaches a socket filter that only lets frames of one VLAN and
+     * one EtherType pass.
+     */
+    bool attach_vlan_filter(const std::uint16_t ether_type,
+                            const std::uint16_t vlan) noexcept;
+
+    /**
+     * \brief Waits for a block of the RX ring if blocking.
+     * \return 0 or -1 on error.
+     */
+    int wait_rx() noexcept;
+
+    /**
+     * \brief Takes the next frame of the RX ring. A block is given back to
+     * the kernel when all of its frames are taken.
+     * \param[out] data the frame, nullptr if none is pending.
+     * \param[out] info the frame information.
+     * \return the length of the frame.
+     */
+    std::uint32_t next_rx(std::uint8_t*& data, RawEthFrameInfo& info) noexcept;
+
+    /**
+     * \brief Gives the current block back to the kernel once all of its
+     * frames have been handled.
+     */
+    void release_rx() noexcept;
+
+    /**
+     * \brief The data of the next free TX frame, nullptr if the ring is full.
+     */
+    std::uint8_t* next_tx() noexcept;
+
+    /**
+     * \brief Marks the TX frame filled by next_tx() to be sent.
+     */
+    void submit_tx(const std::uint32_t length) noexcept;
+
+    /**
+     * \brief Tells the kernel to send the frames submitted.
+     */
+    bool flush_tx() noexcept;
+
+    /**
+     * \brief Hands the submitted frames to the kernel with one launch time
+     * for all of them.
+     */
+    bool flush_tx(const std::chrono::nanoseconds launch_time) noexcept;
+
+    /**
+     * \brief Hands the submitted frames to the kernel with the control
+     * messages of header.
+     */
+    bool flush_tx(const struct msghdr& header) noexcept;
+
+    /**
+     * \brief Copies one frame into the TX ring without sending it.
+     * \return true if the frame was submitted.
+     */
+    bool copy_tx(const void* frame, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief The header of a block of the RX ring.
+     */
+    struct tpacket_block_desc* get_rx_block(const std::uint32_t block) const
+        noexcept;
+
+    /**
+     * \brief The header of a frame of the TX ring.
+     */
+    struct tpacket3_hdr* get_tx_frame(const std::uint32_t frame) const
+        noexcept;
+
+    /// the RX ring followed by the TX ring.
+    std::uint8_t* ring_;
+
+    /// the size of both rings.
+    std::size_t ring_size_;
+
+    /// the block of the RX ring read next.
+    std::uint32_t rx_block_;
+
+    /// frames left in the current block, 0 if the block is not taken yet.
+    std::uint32_t rx_left_;
+
+    /// the next frame in the current block.
+    struct tpacket3_hdr* rx_frame_;
+
+    /// the TX frame written next.
+    std::uint32_t tx_frame_;
+
+    /// frames submitted since the last flush.
+    std::uint32_t tx_pending_;
+
+    /// the interface bound to.
+    int interface_;
+
+    /// the MAC address of the interface.
+    MacAddress mac_;
+};
+
+#endif // WIN32 detection
+#endif // RAWETHSOCKET_H_
@@ -0,0 +1,624 @@
+/**
+ * \file      SecOc.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     SecOC authentication of CAN frames.
+ * \details   Protects CAN frames with a freshness value and a truncated AES-CMAC as
+ *            AUTOSAR SecOC does and verifies received frames, one by one or in
+ *            batches.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _WIN32
+
+#include "SecOc.h"
+#include <cstring>
+
+namespace
+{
+/// the lengths of CAN FD frames above 8 bytes.
+constexpr std::array< std::uint8_t, 7U > FD_LENGTHS{
+    {12U, 16U, 20U, 24U, 32U, 48U, 64U}};
+
+/// the bytes in front of the authentic PDU: the data ID.
+constexpr std::size_t DATA_ID_SIZE{2U};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The shortest CAN FD frame length of at least length bytes.
+ */
+std::size_t frame_length(const std::size_t length) noexcept
+{
+    std::size_t valid = length;
+
+    if (length > CAN_STD::DATA_LEN)
+    {
+        valid = CAN_FD::DATA_LEN + 1U;
+
+        for (const auto fd_length : FD_LENGTHS)
+        {
+            if (fd_length >= length)
+            {
+                valid = fd_length;
+                break;
+            }
+        }
+    }
+
+    return valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Writes the low bytes of a value, the most significant first.
+ */
+void write_be(std::uint8_t* out, const std::uint64_t value,
+              const std::size_t bytes) noexcept
+{
+    for (std::size_t i = 0U; i < bytes; ++i)
+    {
+        out[i] = static_cast< std::uint8_t >(value >> (8U * (bytes - 1U - i)));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Reads a value of some bytes, the most significant first.
+ */
+std::uint64_t read_be(const std::uint8_t* in, const std::size_t bytes) noexcept
+{
+    std::uint64_t value = 0U;
+
+    for (std::size_t i = 0U; i < bytes; ++i)
+    {
+        value = (value << 8U) | in[i];
+    }
+
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief The position of the MAC in a secured frame: behind the authentic
+ * PDU and the freshness value.
+ * \param[in] auth_size the bytes of the data to authenticate.
+ */
+std::size_t mac_offset(const SecOcPdu& pdu,
+                       const std::size_t auth_size) noexcept
+{
+    return auth_size - DATA_ID_SIZE - SECOC::FRESHNESS_SIZE +
+           pdu.freshness_bytes;
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+SecOc::SecOc(const AesKey& key, const AesBackend backend) noexcept
+    : cmac_{key, backend}, pdus_{}, pdu_count_{0U}, auth_{}, macs_{},
+      freshness_{}, base_{}, lanes_{}, frames_{}, counts_{}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool SecOc::add_pdu(const SecOcPdu& pdu) noexcept
+{
+    const std::size_t overhead = pdu.freshness_bytes + pdu.mac_bytes;
+    bool added = false;
+
+    if ((pdu.freshness_bytes > SECOC::FRESHNESS_SIZE) ||
+        (pdu.mac_bytes == 0U) || (pdu.mac_bytes > AES_CMAC::BLOCK_SIZE) ||
+        ((pdu.length + overhead) > CAN_FD::DATA_LEN))
+    {
+        std::cerr << "SecOC PDU " << pdu.can_id << " is invalid.\n";
+    }
+    else if (find(pdu.can_id) < pdu_count_)
+    {
+        std::cerr << "SecOC PDU " << pdu.can_id << " is added already.\n";
+    }
+    else if (pdu_count_ >= SECOC::MAX_PDUS)
+    {
+        std::cerr << "SecOC supports " << SECOC::MAX_PDUS << " PDUs.\n";
+    }
+    else
+    {
+        pdus_[pdu_count_] = PduState{pdu, 0U, 0U};
+        ++pdu_count_;
+        added = true;
+    }
+
+    return added;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool SecOc::protect(const struct canfd_frame& authentic,
+                    struct canfd_frame& secured) noexcept
+{
+    const std::size_t index = find(authentic.can_id);
+    bool prepared = false;
+
+    if (index < pdu_count_)
+    {
+        const SecOcPdu& pdu = pdus_[index].pdu;
+        AuthData& auth = auth_[0U];
+        prepared = prepare(pdus_[index], authentic, auth, secured);
+
+        if (prepared)
+        {
+            cmac_.sign(auth.data.data(), auth.size, macs_[0U]);
+            std::memcpy(&secured.data[mac_offset(pdu, auth.size)],
+                        macs_[0U].data(), pdu.mac_bytes);
+        }
+    }
+
+    return prepared;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t SecOc::protect_batch(const struct canfd_frame* authentic,
+                                 const std::size_t count,
+                                 struct canfd_frame* secured) noexcept
+{
+    std::size_t protected_count = 0U;
+    std::size_t first = 0U;
+
+    while (first < count)
+    {
+        std::array< const std::uint8_t*, SECOC::MAX_BATCH > messages;
+        std::array< std::size_t, SECOC::MAX_BATCH > lengths;
+        std::size_t batch = 0U;
+
+        // the frames are prepared in place, the MACs are added together.
+        for (; (first < count) && (batch < SECOC::MAX_BATCH); ++first)
+        {
+            const std::size_t index = find(authentic[first].can_id);
+            struct canfd_frame& frame = secured[protected_count + batch];
+
+            if ((index < pdu_count_) &&
+                prepare(pdus_[index], authentic[first], auth_[batch], frame))
+            {
+                lanes_[batch] = index;
+                messages[batch] = auth_[batch].data.data();
+                lengths[batch] = auth_[batch].size;
+                ++batch;
+            }
+        }
+
+        cmac_.sign_batch(messages.data(), lengths.data(), batch,
+                         macs_.data());
+
+        for (std::size_t i = 0U; i < batch; ++i)
+        {
+            const SecOcPdu& pdu = pdus_[lanes_[i]].pdu;
+            std::memcpy(
+                &secured[protected_count + i].data[mac_offset(pdu,
+                                                              auth_[i].size)],
+                macs_[i].data(), pdu.mac_bytes);
+        }
+
+        protected_count += batch;
+    }
+
+    return protected_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SecOcResult SecOc::verify(const struct canfd_frame& secured,
+                          struct canfd_frame& authentic) noexcept
+{
+    const SecOcResult result = verify_frame(secured, authentic);
+    ++counts_[static_cast< std::size_t >(result)];
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t SecOc::verify_batch(const struct canfd_frame* secured,
+                                const std::size_t count,
+                                struct canfd_frame* authentic,
+                                SecOcResult* results) noexcept
+{
+    std::size_t authentic_count = 0U;
+
+    for (std::size_t first = 0U; first < count; first += SECOC::MAX_BATCH)
+    {
+        const std::size_t batch = ((count - first) < SECOC::MAX_BATCH)
+                                      ? (count - first)
+                                      : SECOC::MAX_BATCH;
+        std::array< const std::uint8_t*, SECOC::MAX_BATCH > messages;
+        std::array< std::size_t, SECOC::MAX_BATCH > lengths;
+        std::array< std::uint64_t, SECOC::MAX_PDUS > latest;
+        std::size_t signing = 0U;
+
+        for (std::size_t index = 0U; index < pdu_count_; ++index)
+        {
+            latest[index] = pdus_[index].rx_freshness;
+        }
+
+        // each frame is checked as if the frames before it were authentic.
+        for (std::size_t i = 0U; i < batch; ++i)
+        {
+            const struct canfd_frame& frame = secured[first + i];
+            const std::size_t index = find(frame.can_id);
+            lanes_[i] = SECOC::MAX_BATCH;
+
+            if (index < pdu_count_)
+            {
+                base_[i] = latest[index];
+                results[first + i] = check(pdus_[index].pdu, frame, base_[i],
+                                           freshness_[i], auth_[signing]);
+
+                if (results[first + i] == SecOcResult::AUTHENTIC)
+                {
+                    latest[index] = freshness_[i];
+                    messages[signing] = auth_[signing].data.data();
+                    lengths[signing] = auth_[signing].size;
+                    lanes_[i] = signing;
+                    ++signing;
+                }
+            }
+        }
+
+        cmac_.sign_batch(messages.data(), lengths.data(), signing,
+                         macs_.data());
+
+        // accepted in order. A frame checked against a freshness value that
+        // did not become the accepted one is verified again on its own.
+        for (std::size_t i = 0U; i < batch; ++i)
+        {
+            const struct canfd_frame& frame = secured[first + i];
+            const std::size_t index = find(frame.can_id);
+            SecOcResult& result = results[first + i];
+
+            if (index >= pdu_count_)
+            {
+                result = verify_frame(frame, authentic[first + i]);
+            }
+            else if (base_[i] != pdus_[index].rx_freshness)
+            {
+                result = verify_frame(frame, authentic[first + i]);
+            }
+            else if (lanes_[i] < SECOC::MAX_BATCH)
+            {
+                result = accept(pdus_[index], frame, freshness_[i],
+                                auth_[lanes_[i]], macs_[lanes_[i]],
+                                authentic[first + i]);
+            }
+            else
+            {
+                authentic[first + i] = frame;
+                authentic[first + i].len = 0U;
+            }
+
+            authentic_count += (result == SecOcResult::AUTHENTIC) ? 1U : 0U;
+            ++counts_[static_cast< std::size_t >(result)];
+        }
+    }
+
+    return authentic_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int8_t SecOc::send(CanSocket& socket,
+                        const struct canfd_frame& authentic) noexcept
+{
+    struct canfd_frame& secured = frames_[0U];
+    std::int8_t sent = -1;
+
+    if (protect(authentic, secured))
+    {
+        // the MAC may make a standard frame a CAN FD one.
+        sent = socket.send(secured, can_get_mtu(secured));
+    }
+
+    return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int SecOc::send_batch(CanSocket& socket, const struct canfd_frame* authentic,
+                      const std::size_t count) noexcept
+{
+    int sent_count = 0;
+
+    for (std::size_t first = 0U; first < count; first += SECOC::MAX_BATCH)
+    {
+        const std::size_t batch = ((count - first) < SECOC::MAX_BATCH)
+                                      ? (count - first)
+                                      : SECOC::MAX_BATCH;
+        const std::size_t secured =
+            protect_batch(&authentic[first], batch, frames_.data());
+        const int sent = socket.send_batch(frames_.data(), secured);
+        const std::size_t taken =
+            (sent > 0) ? static_cast< std::size_t >(sent) : 0U;
+
+        sent_count += static_cast< int >(taken);
+
+        if (taken < secured)
+        {
+            // the frames not sent are the last ones of their PDUs, a
+            // retry protects them with the same freshness values again.
+            for (std::size_t i = taken; i < secured; ++i)
+            {
+                --pdus_[lanes_[i]].tx_freshness;
+            }
+
+            break;
+        }
+    }
+
+    return ((sent_count == 0) && (count > 0U)) ? -1 : sent_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int SecOc::receive_batch(CanSocket& socket, struct canfd_frame* authentic,
+                         SecOcResult* results, const std::size_t count) noexcept
+{
+    const std::size_t batch =
+        (count < SECOC::MAX_BATCH) ? count : SECOC::MAX_BATCH;
+    const int received = socket.receive_batch(frames_.data(), batch);
+
+    if (received > 0)
+    {
+        verify_batch(frames_.data(), static_cast< std::size_t >(received),
+                     authentic, results);
+    }
+
+    return received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool SecOc::get_freshness(const canid_t can_id, std::uint64_t& tx,
+                          std::uint64_t& rx) const noexcept
+{
+    const std::size_t index = find(can_id);
+
+    if (index < pdu_count_)
+    {
+        tx = pdus_[index].tx_freshness;
+        rx = pdus_[index].rx_freshness;
+    }
+
+    return index < pdu_count_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool SecOc::set_freshness(const canid_t can_id, const std::uint64_t tx,
+                          const std::uint64_t rx) noexcept
+{
+    const std::size_t index = find(can_id);
+
+    if (index < pdu_count_)
+    {
+        pdus_[index].tx_freshness = tx;
+        pdus_[index].rx_freshness = rx;
+    }
+
+    return index < pdu_count_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t SecOc::get_count(const SecOcResult result) const noexcept
+{
+    const auto index = static_cast< std::size_t >(result);
+    return (index < counts_.size()) ? counts_[index] : 0U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t SecOc::find(const canid_t can_id) const noexcept
+{
+    std::size_t index = 0U;
+
+    while ((index < pdu_count_) && (pdus_[index].pdu.can_id != can_id))
+    {
+        ++index;
+    }
+
+    return (index < pdu_count_) ? index : SECOC::MAX_PDUS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool SecOc::prepare(PduState& state, const struct canfd_frame& authentic,
+                    AuthData& auth, struct canfd_frame& secured) noexcept
+{
+    const SecOcPdu& pdu = state.pdu;
+    const std::size_t overhead = pdu.freshness_bytes + pdu.mac_bytes;
+    std::size_t length = pdu.length;
+    std::size_t total = 0U;
+
+    // a PDU of a fixed length is padded behind the MAC, a PDU without one
+    // is padded itself to fill the frame.
+    if (pdu.length > 0U)
+    {
+        total = frame_length(length + overhead);
+    }
+    else
+    {
+        total = frame_length(authentic.len + overhead);
+        length = total - overhead;
+    }
+
+    const bool fits =
+        (authentic.len <= length) && (total <= CAN_FD::DATA_LEN);
+
+    if (fits)
+    {
+        ++state.tx_freshness;
+        secured.can_id = authentic.can_id;
+        secured.len = static_cast< std::uint8_t >(total);
+        secured.flags = authentic.flags;
+        secured.__res0 = 0U;
+        secured.__res1 = 0U;
+        std::memset(secured.data, 0, sizeof(secured.data));
+        std::memcpy(secured.data, authentic.data, authentic.len);
+        write_be(&secured.data[length], state.tx_freshness,
+                 pdu.freshness_bytes);
+
+        write_be(auth.data.data(), pdu.data_id, DATA_ID_SIZE);
+        std::memcpy(&auth.data[DATA_ID_SIZE], secured.data, length);
+        write_be(&auth.data[DATA_ID_SIZE + length], state.tx_freshness,
+                 SECOC::FRESHNESS_SIZE);
+        auth.size = DATA_ID_SIZE + length + SECOC::FRESHNESS_SIZE;
+    }
+
+    return fits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SecOcResult SecOc::check(const SecOcPdu& pdu,
+                         const struct canfd_frame& secured,
+                         const std::uint64_t last, std::uint64_t& freshness,
+                         AuthData& auth) noexcept
+{
+    const std::size_t overhead = pdu.freshness_bytes + pdu.mac_bytes;
+    std::size_t length = pdu.length;
+    SecOcResult result = SecOcResult::MALFORMED;
+
+    if ((length == 0U) && (secured.len >= overhead))
+    {
+        length = secured.len - overhead;
+    }
+
+    if ((secured.len <= CAN_FD::DATA_LEN) &&
+        (secured.len >= (length + overhead)))
+    {
+        const std::uint64_t received =
+            read_be(&secured.data[length], pdu.freshness_bytes);
+        bool fresh = true;
+
+        if (pdu.freshness_bytes == 0U)
+        {
+            // nothing sent: the next value is expected.
+            freshness = last + 1U;
+            fresh = (freshness > last);
+        }
+        else if (pdu.freshness_bytes == SECOC::FRESHNESS_SIZE)
+        {
+            freshness = received;
+            fresh = (freshness > last);
+        }
+        else
+        {
+            // the smallest value above the last one with the low bytes
+            // received.
+            const std::uint64_t step = std::uint64_t{1U}
+                                       << (8U * pdu.freshness_bytes);
+            freshness = (last & ~(step - 1U)) | received;
+
+            if (freshness <= last)
+            {
+                freshness += step;
+                fresh = (freshness > last);
+            }
+        }
+
+        if (!fresh ||
+            ((pdu.window > 0U) && ((freshness - last) > pdu.window)))
+        {
+            result = SecOcResult::REPLAYED;
+        }
+        else
+        {
+            write_be(auth.data.data(), pdu.data_id, DATA_ID_SIZE);
+            std::memcpy(&auth.data[DATA_ID_SIZE], secured.data, length);
+            write_be(&auth.data[DATA_ID_SIZE + length], freshness,
+                     SECOC::FRESHNESS_SIZE);
+            auth.size = DATA_ID_SIZE + length + SECOC::FRESHNESS_SIZE;
+            result = SecOcResult::AUTHENTIC;
+        }
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SecOcResult SecOc::accept(PduState& state, const struct canfd_frame& secured,
+                          const std::uint64_t freshness, const AuthData& auth,
+                          const AesBlock& mac,
+                          struct canfd_frame& authentic) noexcept
+{
+    const std::size_t offset = mac_offset(state.pdu, auth.size);
+    std::uint8_t difference = 0U;
+
+    // every byte is compared, so the time tells nothing about the MAC.
+    for (std::size_t i = 0U; i < state.pdu.mac_bytes; ++i)
+    {
+        difference |= static_cast< std::uint8_t >(secured.data[offset + i] ^
+                                                  mac[i]);
+    }
+
+    SecOcResult result = SecOcResult::MAC_FAILED;
+    authentic = secured;
+    authentic.len = 0U;
+    std::memset(authentic.data, 0, sizeof(authentic.data));
+
+    if (difference == 0U)
+    {
+        state.rx_freshness = freshness;
+        authentic.len = static_cast< std::uint8_t >(
+            auth.size - DATA_ID_SIZE - SECOC::FRESHNESS_SIZE);
+        std::memcpy(authentic.data, secured.data, authentic.len);
+        result = SecOcResult::AUTHENTIC;
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SecOcResult SecOc::verify_frame(const struct canfd_frame& secured,
+                                struct canfd_frame& authentic) noexcept
+{
+    const std::size_t index = find(secured.can_id);
+    SecOcResult result = SecOcResult::NOT_SECURED;
+    authentic = secured;
+
+    if (index < pdu_count_)
+    {
+        // the buffers of a batch are in use while its frames are verified
+        // again.
+        PduState& state = pdus_[index];
+        AuthData auth;
+        std::uint64_t freshness = 0U;
+        result =
+            check(state.pdu, secured, state.rx_freshness, freshness, auth);
+
+        if (result == SecOcResult::AUTHENTIC)
+        {
+            AesBlock mac;
+            cmac_.sign(auth.data.data(), auth.size, mac);
+            result = accept(state, secured, freshness, auth, mac, authentic);
+        }
+        else
+        {
+            authentic.len = 0U;
+        }
+    }
+
+    return result;
+}
+
+#endif // WIN32 detection
@@ -0,0 +1,332 @@
+/**
+ * \file      SecOc.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     SecOC authentication of CAN frames.
+ * \details   Protects CAN frames with a freshness value and a truncated AES-CMAC as
+ *            AUTOSAR SecOC does and verifies received frames, one by one or in
+ *            batches.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SECOC_H_
+#define SECOC_H_
+
+#ifndef _WIN32
+
+#include "AesCmac.h"
+#include "CanSocket.h"
+#include <array>
+#include <cstdint>
+
+/**
+ * \brief Defining a struct that holds the sizes of SecOC.
+ */
+struct SECOC
+{
+    // secured PDUs, each is a CAN ID.
+    static constexpr std::size_t MAX_PDUS{32U};
+    // bytes of the complete freshness value.
+    static constexpr std::size_t FRESHNESS_SIZE{8U};
+    // the data to authenticate: data ID, authentic PDU, complete freshness.
+    static constexpr std::size_t MAX_AUTH_SIZE{2U + CANFD_MAX_DLEN +
+                                               FRESHNESS_SIZE};
+    // frames verified or protected with one batch of MACs.
+    static constexpr std::size_t MAX_BATCH{CAN_BATCH::MAX_FRAMES};
+};
+
+/**
+ * \brief The configuration of a secured PDU.
+ */
+struct SecOcPdu
+{
+    /// the CAN ID as on the socket, with CAN_EFF_FLAG for an extended ID.
+    canid_t can_id;
+    /// the data ID that is authenticated with the PDU.
+    std::uint16_t data_id;
+    /// bytes of the authentic PDU, 0 if they follow from the frame length.
+    std::uint8_t length;
+    /// bytes of the freshness value sent, the low ones: 0 to 8.
+    std::uint8_t freshness_bytes;
+    /// bytes of the MAC sent, the first ones: 1 to 16.
+    std::uint8_t mac_bytes;
+    /// a received freshness value may be ahead of the last one by this
+    /// much at most, 0 for any.
+    std::uint64_t window;
+};
+
+/**
+ * \brief The result of the verification of a frame.
+ */
+enum class SecOcResult : std::uint8_t
+{
+    AUTHENTIC,   ///< the MAC is valid and the freshness value is new.
+    NOT_SECURED, ///< the CAN ID is no secured PDU, the frame is as it is.
+    MALFORMED,   ///< the frame is too short for the PDU.
+    REPLAYED,    ///< the freshness value is not new or too far ahead.
+    MAC_FAILED,  ///< the MAC is wrong.
+    RESULTS
+};
+
+/**
+ * \brief SecOc authenticates CAN frames as AUTOSAR SecOC does. A secured
+ * frame carries the authentic PDU, the low bytes of a freshness counter and
+ * the first bytes of the AES-128 CMAC over the data ID, the PDU and the
+ * complete counter:
+ * \code
+ * | authentic PDU | freshness (truncated) | MAC (truncated) |
+ * \endcode
+ * The sender counts the freshness value up for every frame. The receiver
+ * rebuilds the complete value from the low bytes and the last value it
+ * accepted and accepts a frame only once, so replayed frames fail. The
+ * frame is padded with zeros to a CAN FD length: behind the MAC for a PDU of
+ * a fixed length, else the PDU itself.
+ *
+ * verify_batch() verifies the frames of one receive_batch() with the MACs
+ * computed interleaved, see AesCmac::sign_batch(). The frames of a PDU are
+ * still accepted in order.
+ * \code
+ * SecOc secoc{key};
+ * secoc.add_pdu({0x123U, 0x0042U, 0U, 1U, 3U, 0U});
+ * secoc.send(can, frame);
+ * const int received = secoc.receive_batch(can, frames, results, 32U);
+ * \endcode
+ */
+class SecOc
+{
+  public:
+    /**
+     * \brief Creates SecOC without PDUs.
+     * \param[in] key the key of all PDUs.
+     * \param[in] backend the implementation of AES.
+     */
+    explicit SecOc(const AesKey& key,
+                   const AesBackend backend = AesBackend::AUTO) noexcept;
+
+    /**
+     * \brief Adds a secured PDU, with the freshness values at 0.
+     * \return false if the PDU is invalid, known or SECOC::MAX_PDUS are
+     * added.
+     */
+    bool add_pdu(const SecOcPdu& pdu) noexcept;
+
+    /**
+     * \brief Appends the freshness value and the MAC to a frame.
+     * \param[in] authentic the frame to send.
+     * \param[out] secured the frame with freshness value and MAC.
+     * \return false if the CAN ID is no secured PDU or the frame is too
+     * long for the freshness value and the MAC.
+     */
+    bool protect(const struct canfd_frame& authentic,
+                 struct canfd_frame& secured) noexcept;
+
+    /**
+     * \brief Protects frames with the MACs computed interleaved.
+     * \return the number of frames protected, in order. The frames that
+     * cannot be protected are left out.
+     */
+    std::size_t protect_batch(const struct canfd_frame* authentic,
+                              const std::size_t count,
+                              struct canfd_frame* secured) noexcept;
+
+    /**
+     * \brief Verifies a received frame.
+     * \param[in] secured the frame received.
+     * \param[out] authentic the authentic PDU if the frame is authentic,
+     * the frame as it is if it is not secured, empty else.
+     */
+    SecOcResult verify(const struct canfd_frame& secured,
+                       struct canfd_frame& authentic) noexcept;
+
+    /**
+     * \brief Verifies received frames with the MACs computed interleaved.
+     * \param[out] results the result of each frame.
+     * \return the number of frames that are authentic.
+     */
+    std::size_t verify_batch(const struct canfd_frame* secured,
+                             const std::size_t count,
+                             struct canfd_frame* authentic,
+                             SecOcResult* results) noexcept;
+
+    /**
+     * \brief Protects and sends a frame. A secured frame of up to 8 bytes
+     * goes out as a standard frame unless the authentic frame sets
+     * CANFD_FDF, see can_get_mtu().
+     * \return the bytes written or -1 on error.
+     */
+    std::int8_t send(CanSocket& socket,
+                     const struct canfd_frame& authentic) noexcept;
+
+    /**
+     * \brief Protects and sends frames with one system call per
+     * SECOC::MAX_BATCH frames, each as send() would. Stops at the first
+     * frame the socket does not take: the frames behind it are not sent and
+     * their freshness values are given back.
+     * \return the number of frames sent or -1 if nothing was sent. Frames
+     * that cannot be protected are left out, see protect_batch().
+     */
+    int send_batch(CanSocket& socket, const struct canfd_frame* authentic,
+                   const std::size_t count) noexcept;
+
+    /**
+     * \brief Receives up to count frames with one system call and verifies
+     * them.
+     * \param[out] authentic the frames, see verify().
+     * \param[out] results the result of each frame.
+     * \return the number of frames received or -1 on error.
+     */
+    int receive_batch(CanSocket& socket, struct canfd_frame* authentic,
+                      SecOcResult* results, const std::size_t count) noexcept;
+
+    /**
+     * \brief The freshness value of the last frame protected and the last
+     * frame accepted of a PDU, to store them over a restart.
+     * \return false if the CAN ID is no secured PDU.
+     */
+    bool get_freshness(const canid_t can_id, std::uint64_t& tx,
+                       std::uint64_t& rx) const noexcept;
+
+    /**
+     * \brief Restores the freshness values of a PDU.
+     * \return false if the CAN ID is no secured PDU.
+     */
+    bool set_freshness(const canid_t can_id, const std::uint64_t tx,
+                       const std::uint64_t rx) noexcept;
+
+    /**
+     * \brief The number of frames verified with a result.
+     */
+    std::uint64_t get_count(const SecOcResult result) const noexcept;
+
+    /**
+     * \brief The implementation of AES used.
+     */
+    AesBackend get_backend() const noexcept { return cmac_.get_backend(); }
+
+  private:
+    /**
+     * \brief A secured PDU and its freshness values.
+     */
+    struct PduState
+    {
+        SecOcPdu pdu;
+        std::uint64_t tx_freshness;
+        std::uint64_t rx_freshness;
+    };
+
+    /**
+     * \brief The data to authenticate of a frame.
+     */
+    struct AuthData
+    {
+        std::array< std::uint8_t, SECOC::MAX_AUTH_SIZE > data;
+        std::size_t size;
+    };
+
+    /**
+     * \brief Finds the PDU of a CAN ID.
+     * \return the PDU, SECOC::MAX_PDUS if it is no secured PDU.
+     */
+    std::size_t find(const canid_t can_id) const noexcept;
+
+    /**
+     * \brief Counts the freshness value up and writes the secured frame but
+     * the MAC.
+     * \param[out] auth the data to authenticate.
+     * \return false if the frame is too long.
+     */
+    static bool prepare(PduState& state, const struct canfd_frame& authentic,
+                        AuthData& auth, struct canfd_frame& secured) noexcept;
+
+    /**
+     * \brief Checks a received frame and rebuilds its freshness value.
+     * \param[in] last the freshness value accepted last.
+     * \param[out] freshness the complete freshness value.
+     * \param[out] auth the data to authenticate.
+     */
+    static SecOcResult check(const SecOcPdu& pdu,
+                             const struct canfd_frame& secured,
+                             const std::uint64_t last,
+                             std::uint64_t& freshness,
+                             AuthData& auth) noexcept;
+
+    /**
+     * \brief Compares the MAC of a checked frame in constant time and
+     * accepts it.
+     */
+    static SecOcResult accept(PduState& state,
+                              const struct canfd_frame& secured,
+                              const std::uint64_t freshness,
+                              const AuthData& auth, const AesBlock& mac,
+                              struct canfd_frame& authentic) noexcept;
+
+    /**
+     * \brief Verifies a frame, see verify(), without counting the result.
+     */
+    SecOcResult verify_frame(const struct canfd_frame& secured,
+                             struct canfd_frame& authentic) noexcept;
+
+    /// computes the MACs.
+    AesCmac cmac_;
+
+    /// the secured PDUs.
+    std::array< PduState, SECOC::MAX_PDUS > pdus_;
+
+    /// the number of PDUs.
+    std::size_t pdu_count_;
+
+    /// the data to authenticate of a batch.
+    std::array< AuthData, SECOC::MAX_BATCH > auth_;
+
+    /// the MACs of a batch.
+    std::array< AesBlock, SECOC::MAX_BATCH > macs_;
+
+    /// the freshness values of a batch.
+    std::array< std::uint64_t, SECOC::MAX_BATCH > freshness_;
+
+    /// the freshness value accepted last when a frame of a batch was checked.
+    std::array< std::uint64_t, SECOC::MAX_BATCH > base_;
+
+    /// protect_batch(): the PDU of each frame. verify_batch(): the MAC of
+    /// each frame, SECOC::MAX_BATCH for none.
+    std::array< std::size_t, SECOC::MAX_BATCH > lanes_;
+
+    /// the frames of a batch received or protected.
+    std::array< struct canfd_frame, SECOC::MAX_BATCH > frames_;
+
+    /// the frames verified per result.
+    std::array< std::uint64_t,
+                static_cast< std::size_t >(SecOcResult::RESULTS) >
+        counts_;
+};
+
+#endif // WIN32 detection
+#endif // SECOC_H_
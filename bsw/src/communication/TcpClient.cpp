@@ -82,5 +82,34 @@ bool TcpClient::connect(IpAddress ip_address, const std::uint16_t port) noexcept
     return connected_r;
 }
 
+#ifdef __unix__
+////////////////////////////////////////////////////////////////////////////////
+bool TcpClient::connect(const char* host, const std::uint16_t port,
+                        EndpointResolver& resolver) noexcept
+{
+    bool connected_r = false;
+    std::uint32_t address{0U};
+    const ResolveState state = resolver.lookup(host, address);
+
+    if (state == ResolveState::RESOLVED)
+    {
+        connected_r = connect(IpAddress{address}, port);
+    }
+    else if (state == ResolveState::PENDING)
+    {
+        // try again later, like a non-blocking socket.
+        SetErrorNumber(EAGAIN);
+        connected_r = false;
+    }
+    else
+    {
+        SetErrorNumber(EHOSTUNREACH);
+        connected_r = false;
+    }
+
+    return connected_r;
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 bool TcpClient::disconnect() noexcept { return close_socket(); }
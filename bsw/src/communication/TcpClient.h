@@ -38,6 +38,9 @@
 #ifndef TCPCLIENT_H_
 #define TCPCLIENT_H_
 
+#ifdef __unix__
+#include "EndpointResolver.h"
+#endif
 #include "IpAddress.h"
 #include "TcpSocket.h"
 
@@ -69,6 +72,21 @@ class TcpClient : public TcpSocket
      */
     bool connect(IpAddress ip_address, const std::uint16_t port) noexcept;
 
+#ifdef __unix__
+    /**
+     * \brief Connect to a TCP/IP server given by a host name or an IP4
+     * address. The name is looked up without waiting for DNS.
+     * \param[in] host the host name or IP4 address of the server
+     * \param[in] port the port we want to talk to
+     * \param[in] resolver resolves the host name in the background
+     * \return true if connection is established. false if it fails to
+     * connect, the error is EAGAIN if the name is not resolved yet and
+     * EHOSTUNREACH if the name could not be resolved.
+     */
+    bool connect(const char* host, const std::uint16_t port,
+                 EndpointResolver& resolver) noexcept;
+#endif
+
     /**
      * \brief explicitly close the socket for disconnection.
      * \return true if disconnecting was possible, false if not.
@@ -0,0 +1,416 @@
+/**
+ * \file      TcpMux.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Multiplexing logical streams over one TCP connection.
+ * \details   Several streams share one TcpSocket. Data is sent in chunks with a
+ *            small header. Streams with a higher priority are served first,
+ *            each stream has its own flow-control window.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TcpMux.h"
+#include <cstring>
+
+namespace
+{
+/**
+ * \brief Checks if a non-blocking socket call failed because it would block.
+ */
+bool would_block(const SocketErrorType error) noexcept
+{
+#ifdef _WIN32
+    return error == WSAEWOULDBLOCK;
+#else
+    return (error == EAGAIN) || (error == EWOULDBLOCK);
+#endif
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+TcpMuxStream::TcpMuxStream() noexcept
+    : mux_{nullptr}, credit_{TCP_MUX::BUFFER_SIZE}, consumed_{0U},
+      priority_{TCP_MUX::PRIORITY_HIGHEST}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t TcpMuxStream::send(const void* message,
+                                const std::uint16_t len) noexcept
+{
+    std::int16_t data_sent = -1;
+
+    if ((mux_ != nullptr) && mux_->is_ok())
+    {
+        data_sent = static_cast< std::int16_t >(tx_.write(message, len));
+        // a failed transmit shows up on the next call.
+        static_cast< void >(mux_->transmit());
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t TcpMuxStream::receive(void* message,
+                                   const std::uint16_t len) noexcept
+{
+    std::int16_t data_received = -1;
+
+    if (mux_ != nullptr)
+    {
+        if (rx_.get_used() == 0U)
+        {
+            static_cast< void >(mux_->receive());
+        }
+
+        const std::size_t read = rx_.read(message, len);
+        consumed_ += read;
+
+        // grant the peer more data once half of the buffer is free again.
+        // Granting every few bytes would cost a chunk each time.
+        if (consumed_ >= (TCP_MUX::BUFFER_SIZE / 2U))
+        {
+            static_cast< void >(mux_->transmit());
+        }
+
+        if ((read == 0U) && (mux_->is_ok() == false))
+        {
+            data_received = -1;
+        }
+        else
+        {
+            data_received = static_cast< std::int16_t >(read);
+        }
+    }
+
+    return data_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TcpMuxStream::set_priority(const std::uint8_t priority) noexcept
+{
+    priority_ = priority;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint8_t TcpMuxStream::get_priority() const noexcept { return priority_; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t TcpMuxStream::get_pending() const noexcept
+{
+    return tx_.get_used();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t TcpMuxStream::get_credit() const noexcept { return credit_; }
+
+////////////////////////////////////////////////////////////////////////////////
+TcpMux::TcpMux(TcpSocket& socket) noexcept
+    : socket_{socket}, out_len_{0U}, out_pos_{0U}, in_len_{0U},
+      in_stream_{0U}, in_remaining_{0U}, last_sent_{0U}, ok_{true}
+{
+    for (TcpMuxStream& stream : streams_)
+    {
+        stream.mux_ = this;
+    }
+
+    // one stream must never block the others.
+    if (socket_.set_blocking(false) == false)
+    {
+        std::cerr << "Could not set the socket non-blocking.\n";
+        ok_ = false;
+    }
+
+    // chunks are collected in the out buffer already. Nagle would hold back
+    // small control data and window updates.
+    if (socket_.set_nodelay(true) == false)
+    {
+        std::cerr << "Could not disable the nagle algorithm.\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TcpMuxStream& TcpMux::get_stream(const std::uint8_t id) noexcept
+{
+    return streams_[id % TCP_MUX::MAX_STREAMS];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TcpMux::poll() noexcept
+{
+    // receive first, the peer may have granted more credit.
+    if (receive())
+    {
+        static_cast< void >(transmit());
+    }
+
+    return ok_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TcpMux::transmit() noexcept
+{
+    bool blocked = false;
+
+    while (ok_ && (blocked == false))
+    {
+        if (out_pos_ == out_len_)
+        {
+            out_pos_ = 0U;
+            out_len_ = 0U;
+
+            // window updates first, the peer may be waiting for them.
+            for (std::size_t id = 0U; id < TCP_MUX::MAX_STREAMS; ++id)
+            {
+                TcpMuxStream& stream = streams_[id];
+
+                if (stream.consumed_ >= (TCP_MUX::BUFFER_SIZE / 2U))
+                {
+                    put_header(id, MuxChunk::WINDOW, stream.consumed_);
+                    stream.consumed_ = 0U;
+                }
+            }
+
+            // then one chunk after the other, the stream is picked again for
+            // each chunk.
+            while ((out_len_ + TCP_MUX::HEADER_LEN) < TCP_MUX::OUT_SIZE)
+            {
+                const std::size_t id = pick();
+
+                if (id == TCP_MUX::MAX_STREAMS)
+                {
+                    break;
+                }
+
+                TcpMuxStream& stream = streams_[id];
+                std::size_t len = stream.tx_.get_used();
+                const std::size_t room =
+                    TCP_MUX::OUT_SIZE - out_len_ - TCP_MUX::HEADER_LEN;
+
+                if (len > stream.credit_)
+                {
+                    len = stream.credit_;
+                }
+                if (len > TCP_MUX::MAX_CHUNK)
+                {
+                    len = TCP_MUX::MAX_CHUNK;
+                }
+                if (len > room)
+                {
+                    len = room;
+                }
+
+                put_header(id, MuxChunk::DATA, len);
+                out_len_ += stream.tx_.read(&out_[out_len_], len);
+                stream.credit_ -= len;
+                last_sent_ = id;
+            }
+        }
+
+        if (out_len_ == 0U)
+        {
+            // nothing to send.
+            break;
+        }
+
+        const std::int16_t sent = socket_.send(
+            &out_[out_pos_], static_cast< std::uint16_t >(out_len_ - out_pos_));
+
+        if (sent >= 0)
+        {
+            out_pos_ += static_cast< std::size_t >(sent);
+            // the socket buffer is full if it did not take everything.
+            blocked = (out_pos_ < out_len_);
+        }
+        else if (would_block(socket_.get_last_error()))
+        {
+            blocked = true;
+        }
+        else
+        {
+            std::cerr << "Sending on the multiplexed connection failed.\n";
+            ok_ = false;
+        }
+    }
+
+    return ok_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TcpMux::receive() noexcept
+{
+    bool drained = false;
+    bool closed = false;
+
+    while (ok_ && (drained == false) && (closed == false))
+    {
+        const std::int16_t received =
+            socket_.receive(&in_[in_len_],
+                            static_cast< std::uint16_t >(TCP_MUX::OUT_SIZE -
+                                                         in_len_));
+
+        if (received > 0)
+        {
+            in_len_ += static_cast< std::size_t >(received);
+        }
+        else if (received == 0)
+        {
+            // the data received before the close is still handed out.
+            closed = true;
+        }
+        else if (would_block(socket_.get_last_error()))
+        {
+            drained = true;
+        }
+        else
+        {
+            std::cerr << "Receiving on the multiplexed connection failed.\n";
+            ok_ = false;
+        }
+
+        std::size_t pos = 0U;
+
+        while (ok_ && (pos < in_len_))
+        {
+            if (in_remaining_ > 0U)
+            {
+                // payload goes straight into the ring of the stream.
+                std::size_t len = in_len_ - pos;
+                if (len > in_remaining_)
+                {
+                    len = in_remaining_;
+                }
+
+                if (streams_[in_stream_].rx_.write(&in_[pos], len) != len)
+                {
+                    std::cerr << "The peer ignored the flow control.\n";
+                    ok_ = false;
+                }
+
+                pos += len;
+                in_remaining_ -= len;
+            }
+            else if ((in_len_ - pos) >= TCP_MUX::HEADER_LEN)
+            {
+                ok_ = on_header(&in_[pos]);
+                pos += TCP_MUX::HEADER_LEN;
+            }
+            else
+            {
+                // an incomplete header, wait for the rest.
+                break;
+            }
+        }
+
+        std::memmove(&in_[0], &in_[pos], in_len_ - pos);
+        in_len_ -= pos;
+    }
+
+    if (closed)
+    {
+        std::cerr << "The peer closed the multiplexed connection.\n";
+        ok_ = false;
+    }
+
+    return ok_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TcpMux::is_ok() const noexcept { return ok_; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t TcpMux::pick() noexcept
+{
+    std::size_t best = TCP_MUX::MAX_STREAMS;
+
+    // starting after the last sender gives round robin among streams of the
+    // same priority.
+    for (std::size_t i = 1U; i <= TCP_MUX::MAX_STREAMS; ++i)
+    {
+        const std::size_t id = (last_sent_ + i) % TCP_MUX::MAX_STREAMS;
+        const TcpMuxStream& stream = streams_[id];
+
+        if ((stream.tx_.get_used() > 0U) && (stream.credit_ > 0U))
+        {
+            if ((best == TCP_MUX::MAX_STREAMS) ||
+                (stream.priority_ < streams_[best].priority_))
+            {
+                best = id;
+            }
+        }
+    }
+
+    return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TcpMux::put_header(const std::size_t id, const MuxChunk type,
+                        const std::size_t len) noexcept
+{
+    out_[out_len_] = static_cast< std::uint8_t >(id);
+    out_[out_len_ + 1U] = static_cast< std::uint8_t >(type);
+    out_[out_len_ + 2U] = static_cast< std::uint8_t >(len >> 8U);
+    out_[out_len_ + 3U] = static_cast< std::uint8_t >(len);
+    out_len_ += TCP_MUX::HEADER_LEN;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TcpMux::on_header(const std::uint8_t* header) noexcept
+{
+    bool valid = false;
+    const std::size_t id = header[0];
+    const std::size_t len =
+        (static_cast< std::size_t >(header[2]) << 8U) | header[3];
+
+    if (id < TCP_MUX::MAX_STREAMS)
+    {
+        TcpMuxStream& stream = streams_[id];
+
+        if (header[1] == static_cast< std::uint8_t >(MuxChunk::DATA))
+        {
+            valid = (len > 0U) && (len <= TCP_MUX::MAX_CHUNK);
+            in_stream_ = id;
+            in_remaining_ = len;
+        }
+        else if (header[1] == static_cast< std::uint8_t >(MuxChunk::WINDOW))
+        {
+            stream.credit_ += len;
+            valid = (stream.credit_ <= TCP_MUX::BUFFER_SIZE);
+        }
+    }
+
+    if (valid == false)
+    {
+        std::cerr << "Invalid chunk on the multiplexed connection.\n";
+    }
+
+    return valid;
+}
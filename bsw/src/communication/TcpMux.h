@@ -0,0 +1,254 @@
+/**
+ * \file      TcpMux.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Multiplexing logical streams over one TCP connection.
+ * \details   Several streams share one TcpSocket. Data is sent in chunks with a
+ *            small header. Streams with a higher priority are served first,
+ *            each stream has its own flow-control window.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TCPMUX_H_
+#define TCPMUX_H_
+
+#include "ByteRing.h"
+#include "TcpSocket.h"
+#include <array>
+
+/**
+ * \brief Defining a struct that holds informations about the multiplexer.
+ * Each chunk starts with a header: 1 byte stream ID, 1 byte type and 2 bytes
+ * length in network-byte-order.
+ */
+struct TCP_MUX
+{
+    // number of streams over one connection.
+    static constexpr std::size_t MAX_STREAMS{4U};
+    // size of the chunk header.
+    static constexpr std::size_t HEADER_LEN{4U};
+    // maximum payload of one chunk. Higher priority data may preempt lower
+    // priority data after each chunk.
+    static constexpr std::size_t MAX_CHUNK{512U};
+    // send and receive buffer per stream, also the flow-control window.
+    static constexpr std::size_t BUFFER_SIZE{4096U};
+    // buffer for the data handed to the socket at once.
+    static constexpr std::size_t OUT_SIZE{2048U};
+    // highest priority. The bigger the number, the lower the priority.
+    static constexpr std::uint8_t PRIORITY_HIGHEST{0U};
+};
+
+/**
+ * \brief The types of chunks.
+ */
+enum class MuxChunk : std::uint8_t
+{
+    DATA = 0U,  ///< payload of a stream.
+    WINDOW = 1U ///< the receiver grants the sender more bytes, no payload.
+};
+
+class TcpMux;
+
+/**
+ * \brief One logical stream of a TcpMux. It is used like a non-blocking
+ * TcpSocket.
+ */
+class TcpMuxStream
+{
+  public:
+    /**
+     * \brief Creates an unbound stream. Use TcpMux::get_stream() to get one
+     * that is bound to a connection.
+     */
+    TcpMuxStream() noexcept;
+
+    /**
+     * \brief Queues data to send on this stream and starts sending.
+     * \param[in] message is the data to send
+     * \param[in] len is the length to send
+     * \return the number of bytes queued, 0 if the send buffer is full and -1
+     * if the connection failed.
+     */
+    std::int16_t send(const void* message, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Receives data of this stream.
+     * \param[out] message the container to store the received data
+     * \param[in] len the maximum length to receive
+     * \return how much data has been received, 0 if nothing is there and -1
+     * if the connection failed.
+     */
+    std::int16_t receive(void* message, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Sets the priority of this stream. 0 is the highest.
+     */
+    void set_priority(const std::uint8_t priority) noexcept;
+
+    /**
+     * \brief The priority of this stream.
+     */
+    std::uint8_t get_priority() const noexcept;
+
+    /**
+     * \brief Number of bytes waiting to be sent.
+     */
+    std::size_t get_pending() const noexcept;
+
+    /**
+     * \brief Number of bytes the peer accepts before it grants more.
+     */
+    std::size_t get_credit() const noexcept;
+
+  private:
+    friend class TcpMux;
+
+    /// the multiplexer this stream belongs to.
+    TcpMux* mux_;
+
+    /// data to send.
+    ByteRing< TCP_MUX::BUFFER_SIZE > tx_;
+
+    /// data received.
+    ByteRing< TCP_MUX::BUFFER_SIZE > rx_;
+
+    /// bytes the peer accepts.
+    std::size_t credit_;
+
+    /// bytes read by the application and not granted to the peer yet.
+    std::size_t consumed_;
+
+    /// the priority, 0 is the highest.
+    std::uint8_t priority_;
+};
+
+/**
+ * \brief TcpMux multiplexes TCP_MUX::MAX_STREAMS streams over one connected
+ * TcpSocket. The socket is switched to non-blocking mode.
+ */
+class TcpMux
+{
+  public:
+    /**
+     * \brief Creates the multiplexer on a connected socket.
+     * \param[in] socket the connected socket, e.g. a TcpClient or the data
+     * socket of a TcpServer.
+     */
+    explicit TcpMux(TcpSocket& socket) noexcept;
+
+    /**
+     * \brief One of the streams.
+     * \param[in] id the stream ID, 0 .. TCP_MUX::MAX_STREAMS - 1
+     */
+    TcpMuxStream& get_stream(const std::uint8_t id) noexcept;
+
+    /**
+     * \brief Sends pending data and receives what is there without blocking.
+     * Call this cyclically or when the socket is readable.
+     * \return false if the connection failed or the peer violated the
+     * protocol.
+     */
+    bool poll() noexcept;
+
+    /**
+     * \brief Sends as much pending data as the socket takes. Streams with a
+     * higher priority are served first, streams with the same priority in
+     * turn.
+     * \return false if the connection failed.
+     */
+    bool transmit() noexcept;
+
+    /**
+     * \brief Receives what is there and distributes it to the streams.
+     * \return false if the connection failed or the peer violated the
+     * protocol.
+     */
+    bool receive() noexcept;
+
+    /**
+     * \brief Checks if the connection is still fine.
+     */
+    bool is_ok() const noexcept;
+
+  private:
+    /**
+     * \brief The stream to send the next chunk from.
+     * \return the stream index or TCP_MUX::MAX_STREAMS if nothing is to send.
+     */
+    std::size_t pick() noexcept;
+
+    /**
+     * \brief Writes a chunk header to the out buffer.
+     */
+    void put_header(const std::size_t id, const MuxChunk type,
+                    const std::size_t len) noexcept;
+
+    /**
+     * \brief Hands one received chunk header to the streams.
+     * \return false if the header is invalid.
+     */
+    bool on_header(const std::uint8_t* header) noexcept;
+
+    /// the connected socket.
+    TcpSocket& socket_;
+
+    /// the streams.
+    std::array< TcpMuxStream, TCP_MUX::MAX_STREAMS > streams_;
+
+    /// the chunks handed to the socket at once.
+    std::array< std::uint8_t, TCP_MUX::OUT_SIZE > out_;
+
+    /// number of bytes in the out buffer.
+    std::size_t out_len_;
+
+    /// number of bytes of the out buffer the socket has taken.
+    std::size_t out_pos_;
+
+    /// the received bytes not processed yet.
+    std::array< std::uint8_t, TCP_MUX::OUT_SIZE > in_;
+
+    /// number of bytes in the in buffer.
+    std::size_t in_len_;
+
+    /// the stream the current payload belongs to.
+    std::size_t in_stream_;
+
+    /// bytes of payload of the current chunk still to receive.
+    std::size_t in_remaining_;
+
+    /// the stream that sent last, for the round robin.
+    std::size_t last_sent_;
+
+    /// false after a connection error or protocol violation.
+    bool ok_;
+};
+
+#endif /* TCPMUX_H_ */
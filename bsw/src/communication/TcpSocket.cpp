@@ -38,6 +38,12 @@
 
 #include "TcpSocket.h"
 #include <netinet/tcp.h>
+#include <thread>
+#ifdef __linux__
+#include <array>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 TcpSocket::TcpSocket() noexcept : Socket{}
@@ -70,32 +76,101 @@ bool TcpSocket::create() noexcept
 std::int16_t TcpSocket::send(const void* message,
                              const std::uint16_t len) noexcept
 {
-    const bool socket_open = is_socket_initialized();
     std::int16_t data_sent = -1;
 
-    // sending only makes sense if at least the socket is open.
-    if (socket_open)
+    // sending only makes sense if at least the socket is open, the tokens
+    // of the rate limit are taken for an open socket only.
+    if (is_socket_initialized())
     {
+        data_sent = (rate_limit_ != nullptr) ? send_limited(message, len)
+                                             : send_data(message, len);
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t TcpSocket::send_limited(const void* message,
+                                     const std::uint16_t len) noexcept
+{
+    const auto* bytes = static_cast< const std::uint8_t* >(message);
+    std::uint16_t total = 0U;
+    std::int16_t data_sent = 0;
+
+    // a blocking socket sends all bytes, the bucket allows a part at a time.
+    do
+    {
+        const std::uint16_t rest = len - total;
+        const std::uint16_t allowed = take_tokens(rest);
+
+        if ((allowed > 0U) || (rest == 0U))
+        {
+            data_sent = send_data(&bytes[total], allowed);
+
+            // tokens of bytes the socket did not take are not lost.
+            if (data_sent < static_cast< std::int16_t >(allowed))
+            {
+                const std::int16_t taken = (data_sent > 0) ? data_sent : 0;
+                rate_limit_->refund(
+                    static_cast< std::size_t >(allowed - taken));
+            }
+        }
+        else
+        {
+            // the rate limit is reached, the same as a full socket buffer.
 #ifdef _WIN32
-        const char* msg = static_cast< const char* >(message);
-#elif defined(__unix__)
-        const void* msg = message;
-#endif
-        const SocketHandleType& handle = get_socket_handle();
-#ifdef _WIN32
-        data_sent = ::send(handle, msg, len, 0);
-#elif defined(__unix__)
-        data_sent = ::send(handle, msg, len, MSG_NOSIGNAL);
+            SetErrorNumber(WSAEWOULDBLOCK);
+#else
+            SetErrorNumber(EAGAIN);
 #endif
+            data_sent = -1;
+        }
 
-        if (data_sent < 0)
+        if (data_sent > 0)
         {
-            SetErrorNumber(errno);
+            total = static_cast< std::uint16_t >(total + data_sent);
         }
+    } while ((data_sent > 0) && (total < len) && is_blocking());
+
+    // bytes already sent are reported, an error only if nothing was sent.
+    return (total > 0U) ? static_cast< std::int16_t >(total) : data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t TcpSocket::send_data(const void* message,
+                                  const std::uint16_t len) noexcept
+{
+    std::int16_t data_sent = -1;
+#ifdef _WIN32
+    const char* msg = static_cast< const char* >(message);
+#elif defined(__unix__)
+    const void* msg = message;
+#endif
+    const SocketHandleType& handle = get_socket_handle();
+#ifdef _WIN32
+    data_sent = ::send(handle, msg, len, 0);
+#elif defined(__linux__)
+    // the check costs one branch for sockets without TX timestamps.
+    if ((tx_timestamps_ != nullptr) && tx_timestamps_->is_sample_due())
+    {
+        data_sent = send_sampled(msg, len);
     }
     else
     {
-        data_sent = -1;
+        data_sent = ::send(handle, msg, len, MSG_NOSIGNAL);
+    }
+
+    if ((tx_timestamps_ != nullptr) && (data_sent > 0))
+    {
+        tx_bytes_ += static_cast< std::uint32_t >(data_sent);
+    }
+#elif defined(__unix__)
+    data_sent = ::send(handle, msg, len, MSG_NOSIGNAL);
+#endif
+
+    if (data_sent < 0)
+    {
+        SetErrorNumber(errno);
     }
 
     return data_sent;
@@ -124,6 +199,14 @@ std::int16_t TcpSocket::receive(void* message, const std::uint16_t len) noexcept
         {
             SetErrorNumber(errno);
         }
+
+#ifdef __linux__
+        // the reports are waiting in the error queue.
+        if ((tx_timestamps_ != nullptr) && tx_timestamps_->has_pending())
+        {
+            drain_tx_timestamps();
+        }
+#endif
     }
     else
     {
@@ -154,3 +237,199 @@ bool TcpSocket::set_nodelay(const bool option) noexcept
 
     return success;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+void TcpSocket::enable_rate_limit(TokenBucket& bucket) noexcept
+{
+    rate_limit_ = &bucket;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TcpSocket::disable_rate_limit() noexcept { rate_limit_ = nullptr; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint16_t TcpSocket::take_tokens(const std::uint16_t len) noexcept
+{
+    auto allowed = static_cast< std::uint16_t >(rate_limit_->take(len));
+
+    // a blocking socket blocks until at least a part may be sent.
+    while ((allowed == 0U) && (len > 0U) && is_blocking())
+    {
+        std::this_thread::sleep_for(rate_limit_->get_delay(len));
+        allowed = static_cast< std::uint16_t >(rate_limit_->take(len));
+    }
+
+    return allowed;
+}
+
+#ifdef __linux__
+////////////////////////////////////////////////////////////////////////////////
+bool TcpSocket::enable_tx_timestamps(TcpTxTimestamps& timestamps) noexcept
+{
+    bool success{false};
+    // only the reporting is set up here. What to record is requested per
+    // sampled send with a control message.
+    const int flags = SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID |
+                      SOF_TIMESTAMPING_OPT_TSONLY;
+    const int result = setsockopt(get_socket_handle(), SOL_SOCKET,
+                                  SO_TIMESTAMPING, &flags, sizeof(flags));
+
+    if (result >= 0)
+    {
+        tx_timestamps_ = &timestamps;
+        tx_bytes_ = 0U;
+        success = true;
+    }
+    else
+    {
+        SetErrorNumber(errno);
+        success = false;
+    }
+
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TcpSocket::disable_tx_timestamps() noexcept
+{
+    const int flags = 0;
+    setsockopt(get_socket_handle(), SOL_SOCKET, SO_TIMESTAMPING, &flags,
+               sizeof(flags));
+    tx_timestamps_ = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t TcpSocket::send_sampled(const void* message,
+                                     const std::uint16_t len) noexcept
+{
+    struct iovec iov;
+    iov.iov_base = const_cast< void* >(message);
+    iov.iov_len = len;
+    std::array< char, CMSG_SPACE(sizeof(std::uint32_t)) > control{};
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1U;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    // record the timestamps of this send only.
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SO_TIMESTAMPING;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint32_t));
+    const std::uint32_t record = SOF_TIMESTAMPING_TX_SCHED |
+                                 SOF_TIMESTAMPING_TX_SOFTWARE |
+                                 SOF_TIMESTAMPING_TX_ACK;
+    std::memcpy(CMSG_DATA(cmsg), &record, sizeof(record));
+
+    struct timespec sent;
+    clock_gettime(CLOCK_REALTIME, &sent);
+    const auto data_sent = static_cast< std::int16_t >(
+        ::sendmsg(get_socket_handle(), &msg, MSG_NOSIGNAL));
+
+    if (data_sent > 0)
+    {
+        // the kernel reports the offset of the last byte of this send.
+        const std::uint32_t key = TcpTxTimestamps::get_key(
+            tx_bytes_, static_cast< std::uint32_t >(data_sent));
+        tx_timestamps_->add_sample(key, sent);
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t TcpSocket::drain_tx_timestamps() noexcept
+{
+    std::int16_t reports{0};
+
+    if (tx_timestamps_ != nullptr)
+    {
+        for (;;)
+        {
+            std::array< char, 256U > control;
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_control = control.data();
+            msg.msg_controllen = control.size();
+            const auto res = ::recvmsg(get_socket_handle(), &msg,
+                                       MSG_ERRQUEUE | MSG_DONTWAIT);
+
+            if (res < 0)
+            {
+                // EAGAIN: the error queue is empty.
+                break;
+            }
+
+            const struct scm_timestamping* stamps = nullptr;
+            const struct sock_extended_err* error = nullptr;
+
+            for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+                 cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if ((cmsg->cmsg_level == SOL_SOCKET) &&
+                    (cmsg->cmsg_type == SCM_TIMESTAMPING))
+                {
+                    stamps = reinterpret_cast< const struct scm_timestamping* >(
+                        CMSG_DATA(cmsg));
+                }
+                else if (((cmsg->cmsg_level == SOL_IP) &&
+                          (cmsg->cmsg_type == IP_RECVERR)) ||
+                         ((cmsg->cmsg_level == SOL_IPV6) &&
+                          (cmsg->cmsg_type == IPV6_RECVERR)))
+                {
+                    error = reinterpret_cast< const struct sock_extended_err* >(
+                        CMSG_DATA(cmsg));
+                }
+            }
+
+            if ((stamps != nullptr) && (error != nullptr) &&
+                (error->ee_origin == SO_EE_ORIGIN_TIMESTAMPING))
+            {
+                TxStage stage{TxStage::SOFTWARE};
+
+                if (error->ee_info == SCM_TSTAMP_SCHED)
+                {
+                    stage = TxStage::SCHED;
+                }
+                else if (error->ee_info == SCM_TSTAMP_ACK)
+                {
+                    stage = TxStage::ACK;
+                }
+
+                // the software timestamp is always in the first field.
+                tx_timestamps_->add_report(error->ee_data, stage,
+                                           stamps->ts[0]);
+                ++reports;
+            }
+        }
+    }
+
+    return reports;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TcpSocket::set_max_pacing_rate(const std::uint64_t rate) noexcept
+{
+    bool success{false};
+    // all bits set turns pacing off.
+    const std::uint64_t pacing_rate =
+        (rate == TOKEN_BUCKET::UNLIMITED) ? ~std::uint64_t{0U} : rate;
+    const int result =
+        setsockopt(get_socket_handle(), SOL_SOCKET, SO_MAX_PACING_RATE,
+                   &pacing_rate, sizeof(pacing_rate));
+
+    if (result >= 0)
+    {
+        success = true;
+    }
+    else
+    {
+        SetErrorNumber(errno);
+        success = false;
+    }
+
+    return success;
+}
+#endif
@@ -47,6 +47,8 @@
 #endif
 
 #include "Socket.h"
+#include "TcpTxTimestamps.h"
+#include "TokenBucket.h"
 
 /**
  * \brief Concrete class for a Ethernet TCP/IP communication.
@@ -99,6 +101,102 @@ class TcpSocket : public Socket< TcpSocket >
      * successful or not.
      */
     bool set_nodelay(const bool option) noexcept;
+
+    /**
+     * \brief Limits the data rate of send() with a token bucket. A blocking
+     * socket waits for tokens until all bytes are sent, a non-blocking socket
+     * returns -1 with the error EAGAIN (like a full socket buffer) and sends
+     * less than asked if only a part is allowed. Use TokenBucket::get_delay()
+     * to find out when to try again.
+     * \param[in] bucket holds the rate, may be changed at runtime. Must
+     * outlive the socket or be detached with disable_rate_limit().
+     */
+    void enable_rate_limit(TokenBucket& bucket) noexcept;
+
+    /**
+     * \brief Sends without a rate limit again.
+     */
+    void disable_rate_limit() noexcept;
+
+#ifdef __linux__
+    /**
+     * \brief Turns on TX timestamps (SO_TIMESTAMPING) for sampled sends. The
+     * kernel reports when the data of a sampled send entered the packet
+     * scheduler, was passed to the driver and was acknowledged by the peer.
+     * Sends that are not sampled take the usual path.
+     * \param[in] timestamps decides which sends are sampled and collects the
+     * latencies. Must outlive the socket or be detached with
+     * disable_tx_timestamps().
+     * \return true if the socket option is set.
+     * \remarks Enable this after the connection is established, the byte
+     * counting of the reports starts here.
+     */
+    bool enable_tx_timestamps(TcpTxTimestamps& timestamps) noexcept;
+
+    /**
+     * \brief Turns off TX timestamps.
+     */
+    void disable_tx_timestamps() noexcept;
+
+    /**
+     * \brief Reads all TX timestamps reported on the error queue of the socket
+     * without blocking. This is done on every receive() as long as sampled
+     * sends wait for their reports. Call it yourself if you do not receive.
+     * \return the number of reports read.
+     */
+    std::int16_t drain_tx_timestamps() noexcept;
+
+    /**
+     * \brief Paces the data of this socket in the kernel (SO_MAX_PACING_RATE).
+     * The kernel spreads the packets over time instead of sending them in
+     * bursts. This works best with the fq qdisc on the interface, else TCP
+     * paces itself. May be changed at any time.
+     * \param[in] rate in bytes per second, TOKEN_BUCKET::UNLIMITED for no
+     * limit.
+     * \return true if the socket option is set.
+     */
+    bool set_max_pacing_rate(const std::uint64_t rate) noexcept;
+#endif
+
+  private:
+    /**
+     * \brief Sends with the rate limit. A blocking socket waits for tokens
+     * until all bytes are sent, a non-blocking socket sends the part the
+     * bucket allows.
+     */
+    std::int16_t send_limited(const void* message,
+                              const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Sends on the open socket without a rate limit.
+     */
+    std::int16_t send_data(const void* message,
+                           const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Takes tokens for a send from the rate limit. Waits for tokens
+     * if the socket is blocking.
+     * \return the number of bytes that may be sent, 0 if none.
+     */
+    std::uint16_t take_tokens(const std::uint16_t len) noexcept;
+
+    /// the rate limit of send(), nullptr if disabled.
+    TokenBucket* rate_limit_{nullptr};
+
+#ifdef __linux__
+    /**
+     * \brief Sends with a control message that requests the TX timestamps
+     * for this send.
+     */
+    std::int16_t send_sampled(const void* message,
+                              const std::uint16_t len) noexcept;
+
+    /// the statistics of sampled sends, nullptr if disabled.
+    TcpTxTimestamps* tx_timestamps_{nullptr};
+
+    /// bytes sent since TX timestamps were enabled (OPT_ID key).
+    std::uint32_t tx_bytes_{0U};
+#endif
 };
 
 #endif /* TCPSOCKET_H_ */
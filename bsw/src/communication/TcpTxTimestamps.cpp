@@ -0,0 +1,133 @@
+/**
+ * \file      TcpTxTimestamps.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Statistics of TX timestamps of sampled TCP sends.
+ * \details   Matching the kernel reports to the sampled sends.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TcpTxTimestamps.h"
+
+////////////////////////////////////////////////////////////////////////////////
+TcpTxTimestamps::TcpTxTimestamps(const std::uint32_t sample_every) noexcept
+    : sample_every_{(sample_every > 0U) ? sample_every : 1U}, sends_{0U},
+      samples_{}, next_{0U}, pending_{0U}, dropped_{0U}, histograms_{},
+      messages_{}, next_message_{0U}, message_count_{0U}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TcpTxTimestamps::add_sample(const std::uint32_t key,
+                                 const struct timespec& sent) noexcept
+{
+    Sample& sample = samples_[next_];
+    next_ = (next_ + 1U) % samples_.size();
+
+    if (sample.used)
+    {
+        // the oldest sample never got its ACK.
+        ++dropped_;
+    }
+    else
+    {
+        ++pending_;
+    }
+
+    sample.key = key;
+    sample.used = true;
+    sample.sent = sent;
+    sample.latency.fill(std::chrono::nanoseconds{-1});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TcpTxTimestamps::add_report(const std::uint32_t key, const TxStage stage,
+                                 const struct timespec& stamp) noexcept
+{
+    bool matched{false};
+
+    for (auto& sample : samples_)
+    {
+        if (sample.used && (sample.key == key))
+        {
+            const auto latency =
+                std::chrono::seconds{stamp.tv_sec - sample.sent.tv_sec} +
+                std::chrono::nanoseconds{stamp.tv_nsec - sample.sent.tv_nsec};
+            histograms_[static_cast< std::size_t >(stage)].add(latency);
+            sample.latency[static_cast< std::size_t >(stage)] = latency;
+
+            // the ACK is the last report of a send.
+            if (stage == TxStage::ACK)
+            {
+                sample.used = false;
+                --pending_;
+                messages_[next_message_] =
+                    TxMessageLatency{sample.key, sample.latency};
+                next_message_ = (next_message_ + 1U) % messages_.size();
+
+                if (message_count_ < messages_.size())
+                {
+                    ++message_count_;
+                }
+            }
+
+            matched = true;
+            break;
+        }
+    }
+
+    return matched;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const LatencyHistogram&
+TcpTxTimestamps::get_histogram(const TxStage stage) const noexcept
+{
+    return histograms_[static_cast< std::size_t >(stage)];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t TcpTxTimestamps::get_dropped() const noexcept
+{
+    return dropped_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TcpTxTimestamps::print(std::ostream& out) const noexcept
+{
+    out << "send -> sched: ";
+    get_histogram(TxStage::SCHED).print(out);
+    out << "send -> software: ";
+    get_histogram(TxStage::SOFTWARE).print(out);
+    out << "send -> ack: ";
+    get_histogram(TxStage::ACK).print(out);
+    out << "dropped samples: " << dropped_ << "\n";
+}
@@ -0,0 +1,224 @@
+/**
+ * \file      TcpTxTimestamps.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Statistics of TX timestamps of sampled TCP sends.
+ * \details   Keeps the sampled sends of a TcpSocket until the kernel reported
+ *            when the data entered the packet scheduler, left the stack and was
+ *            acknowledged by the peer. The latency of each stage is collected.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TCPTXTIMESTAMPS_H_
+#define TCPTXTIMESTAMPS_H_
+
+#include "LatencyHistogram.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <time.h>
+
+/**
+ * \brief Defining a struct that holds the size of the table of samples.
+ */
+struct TCP_TX_TIMESTAMPS
+{
+    // number of sampled sends waiting for their timestamps.
+    static constexpr std::size_t MAX_PENDING{16U};
+    // number of acknowledged sends kept until drain_messages().
+    static constexpr std::size_t MAX_MESSAGES{16U};
+};
+
+/**
+ * \brief The stages of a send the kernel reports a timestamp for.
+ */
+enum class TxStage : std::uint8_t
+{
+    SCHED,    ///< data entered the packet scheduler (qdisc).
+    SOFTWARE, ///< data was passed to the network driver.
+    ACK       ///< all data was acknowledged by the peer.
+};
+
+/**
+ * \brief The latencies of one sampled send.
+ */
+struct TxMessageLatency
+{
+    /// the byte offset of the last byte sent (OPT_ID key).
+    std::uint32_t key;
+
+    /// time from the send call to each stage, indexed by TxStage. Negative
+    /// if the kernel did not report the stage.
+    std::array< std::chrono::nanoseconds, 3U > latency;
+};
+
+/**
+ * \brief TcpTxTimestamps decides which sends are sampled and collects the
+ * latency from the send call to each stage in a histogram. The latencies of
+ * each acknowledged send are kept until drain_messages().
+ */
+class TcpTxTimestamps
+{
+  public:
+    /**
+     * \brief Creates the statistics.
+     * \param[in] sample_every every n-th send is sampled. 1 samples all sends.
+     */
+    explicit TcpTxTimestamps(const std::uint32_t sample_every = 100U) noexcept;
+
+    /**
+     * \brief Counts a send and checks if it shall be sampled.
+     */
+    bool is_sample_due() noexcept
+    {
+        ++sends_;
+        return (sends_ % sample_every_) == 0U;
+    }
+
+    /**
+     * \brief The OPT_ID key the kernel reports for a send: the byte offset
+     * of its last byte. It wraps around after 4 GiB like the counter of the
+     * kernel.
+     * \param[in] bytes_before the bytes sent before since the reporting
+     * was turned on.
+     * \param[in] sent the bytes of this send, at least 1.
+     */
+    static std::uint32_t get_key(const std::uint32_t bytes_before,
+                                 const std::uint32_t sent) noexcept
+    {
+        return bytes_before + sent - 1U;
+    }
+
+    /**
+     * \brief Remembers a sampled send.
+     * \param[in] key the byte offset of the last byte sent (OPT_ID).
+     * \param[in] sent the time of the send call (CLOCK_REALTIME).
+     */
+    void add_sample(const std::uint32_t key,
+                    const struct timespec& sent) noexcept;
+
+    /**
+     * \brief Adds a timestamp reported by the kernel.
+     * \param[in] key the byte offset the report is for.
+     * \param[in] stage the stage reported.
+     * \param[in] stamp the timestamp of the stage.
+     * \return true if a sampled send matched the report.
+     */
+    bool add_report(const std::uint32_t key, const TxStage stage,
+                    const struct timespec& stamp) noexcept;
+
+    /**
+     * \brief Checks if there are sampled sends waiting for reports.
+     */
+    bool has_pending() const noexcept { return pending_ > 0U; }
+
+    /**
+     * \brief The latency histogram of one stage.
+     */
+    const LatencyHistogram& get_histogram(const TxStage stage) const noexcept;
+
+    /**
+     * \brief Hands the latencies of the sends acknowledged since the last
+     * call to handler(const TxMessageLatency&), the oldest first. Only the
+     * last TCP_TX_TIMESTAMPS::MAX_MESSAGES are kept.
+     * \return the number of sends handed over.
+     */
+    template < typename Handler >
+    std::size_t drain_messages(Handler&& handler) noexcept
+    {
+        const std::size_t count = message_count_;
+        std::size_t index =
+            (next_message_ + messages_.size() - count) % messages_.size();
+
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+            handler(static_cast< const TxMessageLatency& >(messages_[index]));
+            index = (index + 1U) % messages_.size();
+        }
+
+        message_count_ = 0U;
+        return count;
+    }
+
+    /**
+     * \brief Number of samples dropped before the ACK was reported.
+     */
+    std::uint32_t get_dropped() const noexcept;
+
+    /**
+     * \brief Prints the histograms of all stages.
+     */
+    void print(std::ostream& out) const noexcept;
+
+  private:
+    /**
+     * \brief One sampled send.
+     */
+    struct Sample
+    {
+        std::uint32_t key;
+        bool used;
+        struct timespec sent;
+        std::array< std::chrono::nanoseconds, 3U > latency;
+    };
+
+    /// every n-th send is sampled.
+    std::uint32_t sample_every_;
+
+    /// number of sends counted.
+    std::uint32_t sends_;
+
+    /// sampled sends, written round robin.
+    std::array< Sample, TCP_TX_TIMESTAMPS::MAX_PENDING > samples_;
+
+    /// next sample to write.
+    std::size_t next_;
+
+    /// number of samples waiting.
+    std::size_t pending_;
+
+    /// samples overwritten before the ACK was reported.
+    std::uint32_t dropped_;
+
+    /// latency histogram per stage.
+    std::array< LatencyHistogram, 3U > histograms_;
+
+    /// acknowledged sends, written round robin.
+    std::array< TxMessageLatency, TCP_TX_TIMESTAMPS::MAX_MESSAGES > messages_;
+
+    /// next acknowledged send to write.
+    std::size_t next_message_;
+
+    /// number of acknowledged sends not drained yet.
+    std::size_t message_count_;
+};
+
+#endif /* TCPTXTIMESTAMPS_H_ */
@@ -0,0 +1,161 @@
+/**
+ * \file      TokenBucket.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Token bucket limiting the data rate of a sender.
+ * \details   The bucket fills with the configured rate up to the burst size. A
+ *            send takes tokens for its bytes and waits if there are not enough.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TokenBucket.h"
+
+namespace
+{
+/// nanoseconds per second.
+constexpr std::uint64_t NS_PER_SECOND{1000000000U};
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+TokenBucket::TokenBucket(const std::uint64_t rate,
+                         const std::size_t burst) noexcept
+    : rate_{rate}, burst_{burst}, empty_at_{Clock::now()}, limited_{0U}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TokenBucket::set_rate(const std::uint64_t rate,
+                           const std::size_t burst) noexcept
+{
+    rate_ = rate;
+    burst_ = burst;
+
+    // the bytes sent at the old rate count at the new rate from now on.
+    // Limit the debt so a lower rate does not stall the sender for long.
+    if (rate_ != TOKEN_BUCKET::UNLIMITED)
+    {
+        const Clock::time_point now = Clock::now();
+
+        if (empty_at_ > (now + to_time(burst_)))
+        {
+            empty_at_ = now + to_time(burst_);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t TokenBucket::get_rate() const noexcept { return rate_; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t TokenBucket::take(const std::size_t len) noexcept
+{
+    std::size_t granted = len;
+
+    if (rate_ != TOKEN_BUCKET::UNLIMITED)
+    {
+        const Clock::time_point now = Clock::now();
+
+        // an idle bucket does not collect more than the burst.
+        if (empty_at_ < now)
+        {
+            empty_at_ = now;
+        }
+
+        const std::chrono::nanoseconds available_time =
+            (now + to_time(burst_)) - empty_at_;
+        std::size_t available{0U};
+
+        if (available_time.count() > 0)
+        {
+            available = static_cast< std::size_t >(
+                (static_cast< std::uint64_t >(available_time.count()) * rate_) /
+                NS_PER_SECOND);
+        }
+
+        if (granted > available)
+        {
+            granted = available;
+            ++limited_;
+        }
+
+        empty_at_ += to_time(granted);
+    }
+
+    return granted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TokenBucket::refund(const std::size_t len) noexcept
+{
+    if (rate_ != TOKEN_BUCKET::UNLIMITED)
+    {
+        empty_at_ -= to_time(len);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::chrono::nanoseconds
+TokenBucket::get_delay(const std::size_t len) const noexcept
+{
+    std::chrono::nanoseconds delay{0};
+
+    if (rate_ != TOKEN_BUCKET::UNLIMITED)
+    {
+        const std::size_t bytes = (len < burst_) ? len : burst_;
+        const Clock::time_point now = Clock::now();
+        const Clock::time_point empty_at = (empty_at_ < now) ? now : empty_at_;
+        // len bytes may be sent once the bucket is empty no later than
+        // burst - len bytes from now.
+        const Clock::time_point ready =
+            empty_at - to_time(burst_) + to_time(bytes);
+
+        if (ready > now)
+        {
+            delay = ready - now;
+        }
+    }
+
+    return delay;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t TokenBucket::get_limited() const noexcept { return limited_; }
+
+////////////////////////////////////////////////////////////////////////////////
+std::chrono::nanoseconds
+TokenBucket::to_time(const std::size_t len) const noexcept
+{
+    // round up, else small sends would exceed the rate.
+    const std::uint64_t ns =
+        ((static_cast< std::uint64_t >(len) * NS_PER_SECOND) + rate_ - 1U) /
+        rate_;
+    return std::chrono::nanoseconds{static_cast< std::int64_t >(ns)};
+}
@@ -0,0 +1,135 @@
+/**
+ * \file      TokenBucket.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Token bucket limiting the data rate of a sender.
+ * \details   The bucket fills with the configured rate up to the burst size. A
+ *            send takes tokens for its bytes and waits if there are not enough.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TOKENBUCKET_H_
+#define TOKENBUCKET_H_
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * \brief Defining a struct that holds the defaults of the token bucket.
+ */
+struct TOKEN_BUCKET
+{
+    // bytes that may be sent at once after the sender was idle.
+    static constexpr std::size_t DEFAULT_BURST{16384U};
+    // rate meaning no limit.
+    static constexpr std::uint64_t UNLIMITED{0U};
+};
+
+/**
+ * \brief TokenBucket limits the average data rate of a sender. It is
+ * implemented as a virtual scheduling algorithm: instead of counting tokens
+ * the bucket keeps the time at which it would be empty, so no cyclic refill is
+ * needed.
+ */
+class TokenBucket
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * \brief Creates the bucket, it is full.
+     * \param[in] rate in bytes per second, TOKEN_BUCKET::UNLIMITED for no
+     * limit.
+     * \param[in] burst maximum number of bytes sent at once.
+     */
+    explicit TokenBucket(
+        const std::uint64_t rate = TOKEN_BUCKET::UNLIMITED,
+        const std::size_t burst = TOKEN_BUCKET::DEFAULT_BURST) noexcept;
+
+    /**
+     * \brief Changes the rate, may be called at any time.
+     * \param[in] rate in bytes per second, TOKEN_BUCKET::UNLIMITED for no
+     * limit.
+     * \param[in] burst maximum number of bytes sent at once.
+     */
+    void
+    set_rate(const std::uint64_t rate,
+             const std::size_t burst = TOKEN_BUCKET::DEFAULT_BURST) noexcept;
+
+    /**
+     * \brief The rate in bytes per second.
+     */
+    std::uint64_t get_rate() const noexcept;
+
+    /**
+     * \brief Takes tokens for up to len bytes.
+     * \param[in] len number of bytes to send.
+     * \return the number of bytes that may be sent now, 0 if the bucket is
+     * empty.
+     */
+    std::size_t take(const std::size_t len) noexcept;
+
+    /**
+     * \brief Puts back the tokens of bytes that were taken but not sent.
+     */
+    void refund(const std::size_t len) noexcept;
+
+    /**
+     * \brief The time until len bytes may be sent at once. A len bigger than
+     * the burst size is limited to the burst size.
+     */
+    std::chrono::nanoseconds get_delay(const std::size_t len) const noexcept;
+
+    /**
+     * \brief Number of take() calls that got less than asked for.
+     */
+    std::uint32_t get_limited() const noexcept;
+
+  private:
+    /**
+     * \brief The time it takes to send len bytes at the rate.
+     */
+    std::chrono::nanoseconds to_time(const std::size_t len) const noexcept;
+
+    /// bytes per second.
+    std::uint64_t rate_;
+
+    /// maximum number of bytes sent at once.
+    std::size_t burst_;
+
+    /// the time the bucket is empty at. Bytes sent move it forward.
+    Clock::time_point empty_at_;
+
+    /// take() calls that got less than asked for.
+    std::uint32_t limited_;
+};
+
+#endif /* TOKENBUCKET_H_ */
@@ -0,0 +1,277 @@
+/**
+ * \file      TxTime.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Time-based transmission (SO_TXTIME) shared by the UDP and raw Ethernet sockets.
+ * \details   The ETF qdisc is set up over rtnetlink, so the tc tool is not
+ *            needed.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TxTime.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <linux/errqueue.h>
+#include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
+#include <linux/netlink.h>
+#include <linux/pkt_sched.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+namespace
+{
+/**
+ * \brief Appends an attribute to a netlink message.
+ * \return the attribute, to close a nested attribute later.
+ */
+struct rtattr* add_attribute(struct nlmsghdr* header, const std::uint16_t type,
+                             const void* data, const std::size_t length)
+{
+    struct rtattr* attribute = reinterpret_cast< struct rtattr* >(
+        reinterpret_cast< std::uint8_t* >(header) +
+        NLMSG_ALIGN(header->nlmsg_len));
+    attribute->rta_type = type;
+    attribute->rta_len = static_cast< unsigned short >(RTA_LENGTH(length));
+
+    if (length > 0U)
+    {
+        std::memcpy(RTA_DATA(attribute), data, length);
+    }
+
+    header->nlmsg_len = NLMSG_ALIGN(header->nlmsg_len) +
+                        RTA_ALIGN(attribute->rta_len);
+    return attribute;
+}
+
+/**
+ * \brief Checks if a control message carries a socket error.
+ */
+bool is_error_message(const struct cmsghdr* cmsg)
+{
+    return ((cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR)) ||
+           ((cmsg->cmsg_level == SOL_IPV6) &&
+            (cmsg->cmsg_type == IPV6_RECVERR)) ||
+           ((cmsg->cmsg_level == SOL_PACKET) &&
+            (cmsg->cmsg_type == PACKET_TX_TIMESTAMP));
+}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+std::chrono::nanoseconds TxTime::now(const clockid_t clock) noexcept
+{
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return std::chrono::seconds{time.tv_sec} +
+           std::chrono::nanoseconds{time.tv_nsec};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TxTime::enable(const int handle, const clockid_t clock,
+                    const bool deadline_mode) noexcept
+{
+    struct sock_txtime config;
+    config.clockid = clock;
+    config.flags = SOF_TXTIME_REPORT_ERRORS;
+
+    if (deadline_mode)
+    {
+        config.flags |= SOF_TXTIME_DEADLINE_MODE;
+    }
+
+    return setsockopt(handle, SOL_SOCKET, SO_TXTIME, &config,
+                      sizeof(config)) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TxTime::set_launch_time(struct msghdr& message, TxTimeControl& control,
+                             const std::chrono::nanoseconds launch_time)
+    noexcept
+{
+    message.msg_control = control.data();
+    message.msg_controllen = TX_TIME::CONTROL_SIZE;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint64_t));
+    const auto time = static_cast< std::uint64_t >(launch_time.count());
+    std::memcpy(CMSG_DATA(cmsg), &time, sizeof(time));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int TxTime::read_report(const int handle, TxTimeReport& report) noexcept
+{
+    int result = -1;
+    // the error queue returns the frame as well, its content is not needed.
+    std::array< std::uint8_t, 64U > data;
+    std::array< std::uint64_t, 32U > control;
+    struct iovec iov;
+    iov.iov_base = data.data();
+    iov.iov_len = data.size();
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1U;
+    message.msg_control = control.data();
+    message.msg_controllen = sizeof(control);
+
+    if (::recvmsg(handle, &message, MSG_ERRQUEUE | MSG_DONTWAIT) >= 0)
+    {
+        result = 0;
+
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            const struct sock_extended_err* error =
+                reinterpret_cast< const struct sock_extended_err* >(
+                    CMSG_DATA(cmsg));
+
+            if (is_error_message(cmsg) &&
+                (error->ee_origin == SO_EE_ORIGIN_TXTIME))
+            {
+                // the launch time is split into ee_data (high) and ee_info.
+                report.launch_time = std::chrono::nanoseconds{
+                    static_cast< std::int64_t >(
+                        (static_cast< std::uint64_t >(error->ee_data) << 32U) |
+                        error->ee_info)};
+                report.error = (error->ee_code == SO_EE_CODE_TXTIME_MISSED)
+                                   ? TxTimeError::MISSED
+                                   : TxTimeError::INVALID_PARAM;
+                result = 1;
+            }
+        }
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TxTime::configure_etf(const char* interface, const std::uint32_t parent,
+                           const std::int32_t delta_ns,
+                           const bool deadline_mode,
+                           const bool offload) noexcept
+{
+    struct tc_etf_qopt options;
+    std::memset(&options, 0, sizeof(options));
+    options.delta = delta_ns;
+    options.clockid = CLOCK_TAI;
+    options.flags = (deadline_mode ? TC_ETF_DEADLINE_MODE_ON : 0U) |
+                    (offload ? TC_ETF_OFFLOAD_ON : 0U);
+    return change_qdisc(RTM_NEWQDISC, NLM_F_CREATE | NLM_F_REPLACE, interface,
+                        parent, &options);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TxTime::remove_qdisc(const char* interface,
+                          const std::uint32_t parent) noexcept
+{
+    return change_qdisc(RTM_DELQDISC, 0U, interface, parent, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TxTime::change_qdisc(const std::uint16_t type, const std::uint16_t flags,
+                          const char* interface, const std::uint32_t parent,
+                          const void* options) noexcept
+{
+    bool changed = false;
+    std::array< std::uint32_t, 64U > request{};
+    struct nlmsghdr* header = reinterpret_cast< struct nlmsghdr* >(
+        request.data());
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(struct tcmsg));
+    header->nlmsg_type = type;
+    header->nlmsg_flags =
+        static_cast< std::uint16_t >(NLM_F_REQUEST | NLM_F_ACK | flags);
+    header->nlmsg_seq = 1U;
+    struct tcmsg* qdisc = static_cast< struct tcmsg* >(NLMSG_DATA(header));
+    qdisc->tcm_family = AF_UNSPEC;
+    qdisc->tcm_ifindex = static_cast< int >(if_nametoindex(interface));
+    qdisc->tcm_parent = parent;
+
+    if (options != nullptr)
+    {
+        add_attribute(header, TCA_KIND, "etf", sizeof("etf"));
+        struct rtattr* nested = add_attribute(header, TCA_OPTIONS, nullptr, 0U);
+        add_attribute(header, TCA_ETF_PARMS, options,
+                      sizeof(struct tc_etf_qopt));
+        nested->rta_len = static_cast< unsigned short >(
+            reinterpret_cast< std::uint8_t* >(header) + header->nlmsg_len -
+            reinterpret_cast< std::uint8_t* >(nested));
+    }
+
+    const int handle = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC,
+                                NETLINK_ROUTE);
+
+    if ((qdisc->tcm_ifindex != 0) && (handle >= 0) &&
+        (::send(handle, header, header->nlmsg_len, 0) >= 0))
+    {
+        std::array< std::uint32_t, 256U > answer;
+        const ssize_t length = ::recv(handle, answer.data(), sizeof(answer), 0);
+        const struct nlmsghdr* reply =
+            reinterpret_cast< const struct nlmsghdr* >(answer.data());
+
+        if ((length >= static_cast< ssize_t >(NLMSG_LENGTH(
+                           sizeof(struct nlmsgerr)))) &&
+            (reply->nlmsg_type == NLMSG_ERROR))
+        {
+            const int error =
+                static_cast< const struct nlmsgerr* >(NLMSG_DATA(reply))->error;
+            changed = (error == 0);
+            errno = -error;
+        }
+    }
+    else if (qdisc->tcm_ifindex == 0)
+    {
+        errno = ENODEV;
+    }
+
+    if (changed == false)
+    {
+        std::cerr << "Changing the qdisc of " << interface
+                  << " failed: " << strerror(errno) << "\n";
+    }
+
+    if (handle >= 0)
+    {
+        const int error = errno;
+        ::close(handle);
+        errno = error;
+    }
+
+    return changed;
+}
+
+#endif // WIN32 detection
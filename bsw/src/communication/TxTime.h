@@ -0,0 +1,198 @@
+/**
+ * \file      TxTime.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     Time-based transmission (SO_TXTIME) shared by the UDP and raw Ethernet sockets.
+ * \details   A send carries the time the frame shall leave the interface. The ETF
+ *            qdisc holds the frame until then, the error queue reports missed times.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TXTIME_H_
+#define TXTIME_H_
+
+#ifndef _WIN32
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <sys/socket.h>
+#include <time.h>
+
+/**
+ * \brief Defining a struct that holds the constants of timed sends.
+ */
+struct TX_TIME
+{
+    // control message space for one launch time.
+    static constexpr std::size_t CONTROL_SIZE{
+        CMSG_SPACE(sizeof(std::uint64_t))};
+
+    // the ETF qdisc dequeues a frame this long before its launch time.
+    static constexpr std::int32_t ETF_DELTA_NS{300000};
+
+    // the root of the qdisc tree of an interface (TC_H_ROOT).
+    static constexpr std::uint32_t ROOT{0xFFFFFFFFU};
+};
+
+/**
+ * \brief Buffer for the control message of a timed send.
+ */
+using TxTimeControl =
+    std::array< std::uint64_t,
+                (TX_TIME::CONTROL_SIZE + sizeof(std::uint64_t) - 1U) /
+                    sizeof(std::uint64_t) >;
+
+/**
+ * \brief Why the qdisc dropped a timed frame.
+ */
+enum class TxTimeError : std::uint8_t
+{
+    INVALID_PARAM, ///< the clock or the launch time did not fit the qdisc.
+    MISSED         ///< the frame was dequeued after its launch time.
+};
+
+/**
+ * \brief A frame the qdisc dropped, read from the error queue.
+ */
+struct TxTimeReport
+{
+    /// the launch time the frame was sent with.
+    std::chrono::nanoseconds launch_time{0};
+
+    /// why it was dropped.
+    TxTimeError error{TxTimeError::MISSED};
+};
+
+/**
+ * \brief Helpers for sockets sending with a launch time, and for setting up
+ * the ETF (earliest TxTime first) qdisc that enforces it.
+ */
+class TxTime
+{
+  public:
+    /**
+     * \brief The current time of a clock, as used for launch times.
+     */
+    static std::chrono::nanoseconds now(const clockid_t clock) noexcept;
+
+    /**
+     * \brief Turns on SO_TXTIME with error reports for a socket.
+     * \param[in] handle the socket.
+     * \param[in] clock the clock of the launch times. ETF takes CLOCK_TAI
+     * only, any other clock than CLOCK_MONOTONIC needs CAP_NET_ADMIN.
+     * \param[in] deadline_mode true to send as soon as possible, with the
+     * launch time being the latest time.
+     * \return true if the socket option is set.
+     */
+    static bool enable(const int handle, const clockid_t clock,
+                       const bool deadline_mode) noexcept;
+
+    /**
+     * \brief Attaches the control message with a launch time to a message.
+     * \param[in,out] message gets msg_control and msg_controllen.
+     * \param[in] control the buffer, must live until the message is sent.
+     * \param[in] launch_time the time the frame shall be sent.
+     */
+    static void set_launch_time(struct msghdr& message, TxTimeControl& control,
+                                const std::chrono::nanoseconds launch_time)
+        noexcept;
+
+    /**
+     * \brief Reads one message of the error queue without blocking.
+     * \return 1 if it was a report of a timed send, 0 if it was another
+     * message, -1 if the error queue is empty.
+     */
+    static int read_report(const int handle, TxTimeReport& report) noexcept;
+
+    /**
+     * \brief Reads all reports of dropped timed sends.
+     * \param[in] handler called as handler(const TxTimeReport&).
+     * \return the number of reports read.
+     */
+    template < typename Handler >
+    static int drain_reports(const int handle, Handler&& handler) noexcept
+    {
+        int reports = 0;
+        int result = 0;
+        TxTimeReport report;
+
+        while ((result = read_report(handle, report)) >= 0)
+        {
+            if (result > 0)
+            {
+                handler(static_cast< const TxTimeReport& >(report));
+                ++reports;
+            }
+        }
+
+        return reports;
+    }
+
+    /**
+     * \brief Adds or replaces an ETF qdisc (needs CAP_NET_ADMIN). It is the
+     * same as "tc qdisc replace dev <interface> parent <parent> etf".
+     * \param[in] interface the network interface.
+     * \param[in] parent the class the qdisc is attached to, usually one TX
+     * queue class of mqprio or taprio, or TX_TIME::ROOT.
+     * \param[in] delta_ns how long before its launch time a frame leaves the
+     * qdisc; covers the time through the driver.
+     * \param[in] deadline_mode true to send frames as soon as possible.
+     * \param[in] offload true to let the NIC hold the frames until their
+     * launch time (i210 and similar). Without it the kernel wakes up.
+     * \return true if the kernel accepted it.
+     */
+    static bool configure_etf(const char* interface, const std::uint32_t parent,
+                              const std::int32_t delta_ns,
+                              const bool deadline_mode,
+                              const bool offload) noexcept;
+
+    /**
+     * \brief Removes the qdisc from a parent, like "tc qdisc del".
+     * \return true if the kernel removed it.
+     */
+    static bool remove_qdisc(const char* interface,
+                             const std::uint32_t parent) noexcept;
+
+  private:
+    /**
+     * \brief Sends a qdisc request to the kernel over rtnetlink and waits
+     * for the acknowledgement.
+     * \param[in] options the ETF parameters, nullptr to delete.
+     */
+    static bool change_qdisc(const std::uint16_t type,
+                             const std::uint16_t flags, const char* interface,
+                             const std::uint32_t parent,
+                             const void* options) noexcept;
+};
+
+#endif // WIN32 detection
+#endif // TXTIME_H_
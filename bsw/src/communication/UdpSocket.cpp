@@ -0,0 +1,200 @@
+/**
+ * \file      UdpSocket.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     UDP socket for datagrams to one peer, with timed sends.
+ * \details   Datagrams are sent to the peer given by connect(). On Linux a send
+ *            may carry a launch time (SO_TXTIME).
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UdpSocket.h"
+
+#ifndef _WIN32
+
+#include <cstring>
+#include <netinet/in.h>
+
+////////////////////////////////////////////////////////////////////////////////
+UdpSocket::UdpSocket() noexcept : Socket{}
+{
+    // call the base class opening the socket.
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool UdpSocket::create() noexcept
+{
+    socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    return socket_ >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool UdpSocket::bind(IpAddress ip_address, const std::uint16_t port) noexcept
+{
+    struct sockaddr_in address;
+    ip_address.create_address_struct(ip_address.get_ip_address(), port,
+                                     address);
+    const bool bound =
+        (::bind(get_socket_handle(),
+                reinterpret_cast< struct sockaddr* >(&address),
+                sizeof(address)) == 0);
+
+    if (bound == false)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return bound;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool UdpSocket::connect(IpAddress ip_address, const std::uint16_t port) noexcept
+{
+    struct sockaddr_in address;
+    ip_address.create_address_struct(ip_address.get_ip_address(), port,
+                                     address);
+    const bool connected =
+        (::connect(get_socket_handle(),
+                   reinterpret_cast< struct sockaddr* >(&address),
+                   sizeof(address)) == 0);
+
+    if (connected == false)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return connected;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t UdpSocket::send(const void* message,
+                             const std::uint16_t len) noexcept
+{
+    const auto data_sent = static_cast< std::int16_t >(
+        ::send(get_socket_handle(), message, len, MSG_NOSIGNAL));
+
+    if (data_sent < 0)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t UdpSocket::receive(void* message, const std::uint16_t len) noexcept
+{
+    const auto data_received =
+        static_cast< std::int16_t >(::recv(get_socket_handle(), message, len,
+                                           is_blocking() ? 0 : MSG_DONTWAIT));
+
+    if (data_received < 0)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return data_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t UdpSocket::send_to(const void* message, const std::uint16_t len,
+                                const sockaddr_in& to) noexcept
+{
+    const auto data_sent = static_cast< std::int16_t >(
+        ::sendto(get_socket_handle(), message, len, MSG_NOSIGNAL,
+                 reinterpret_cast< const sockaddr* >(&to), sizeof(to)));
+
+    if (data_sent < 0)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t UdpSocket::receive_from(void* message, const std::uint16_t len,
+                                     sockaddr_in& from) noexcept
+{
+    socklen_t from_len = sizeof(from);
+    const auto data_received = static_cast< std::int16_t >(::recvfrom(
+        get_socket_handle(), message, len, is_blocking() ? 0 : MSG_DONTWAIT,
+        reinterpret_cast< sockaddr* >(&from), &from_len));
+
+    if (data_received < 0)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return data_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool UdpSocket::enable_txtime(const clockid_t clock,
+                              const bool deadline_mode) noexcept
+{
+    const bool enabled = TxTime::enable(get_socket_handle(), clock,
+                                        deadline_mode);
+
+    if (enabled == false)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t UdpSocket::send_at(const void* message, const std::uint16_t len,
+                                const std::chrono::nanoseconds launch_time)
+    noexcept
+{
+    struct iovec iov;
+    iov.iov_base = const_cast< void* >(message);
+    iov.iov_len = len;
+    struct msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1U;
+    TxTimeControl control{};
+    TxTime::set_launch_time(header, control, launch_time);
+    const auto data_sent = static_cast< std::int16_t >(
+        ::sendmsg(get_socket_handle(), &header, MSG_NOSIGNAL));
+
+    if (data_sent < 0)
+    {
+        SetErrorNumber(errno);
+    }
+
+    return data_sent;
+}
+
+#endif // WIN32 detection
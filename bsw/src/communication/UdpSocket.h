@@ -0,0 +1,144 @@
+/**
+ * \file      UdpSocket.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     UDP socket for datagrams to one peer, with timed sends.
+ * \details   Datagrams are sent to the peer given by connect(). On Linux a send
+ *            may carry a launch time (SO_TXTIME).
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef UDPSOCKET_H_
+#define UDPSOCKET_H_
+
+#ifndef _WIN32
+
+#include "IpAddress.h"
+#include "Socket.h"
+#include "TxTime.h"
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+/**
+ * \brief Concrete class for a UDP/IP communication.
+ */
+class UdpSocket : public Socket< UdpSocket >
+{
+  public:
+    /**
+     * \brief Default constructor
+     */
+    UdpSocket() noexcept;
+
+    /**
+     * \brief Default destructor
+     */
+    ~UdpSocket() noexcept = default;
+
+    /**
+     * \brief Binds the socket to a local address and port to receive on.
+     * \return true if the socket is bound.
+     */
+    bool bind(IpAddress ip_address, const std::uint16_t port) noexcept;
+
+    /**
+     * \brief Sets the peer send() and send_at() send to. Only datagrams of
+     * this peer are received afterwards.
+     * \return true if the peer is set.
+     */
+    bool connect(IpAddress ip_address, const std::uint16_t port) noexcept;
+
+    /**
+     * \brief Sends one datagram to the peer.
+     * \return the number of bytes sent or -1 if there is an error.
+     */
+    std::int16_t send(const void* message, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Receives one datagram.
+     * \return the number of bytes received or -1 if there is an error.
+     */
+    std::int16_t receive(void* message, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Sends one datagram to the given address instead of the peer.
+     * \return the number of bytes sent or -1 if there is an error.
+     */
+    std::int16_t send_to(const void* message, const std::uint16_t len,
+                         const sockaddr_in& to) noexcept;
+
+    /**
+     * \brief Receives one datagram and the address it came from.
+     * \return the number of bytes received or -1 if there is an error.
+     */
+    std::int16_t receive_from(void* message, const std::uint16_t len,
+                              sockaddr_in& from) noexcept;
+
+    /**
+     * \brief Turns on sends with a launch time, see TxTime::enable().
+     * \return true if the socket option is set.
+     */
+    bool enable_txtime(const clockid_t clock = CLOCK_TAI,
+                       const bool deadline_mode = false) noexcept;
+
+    /**
+     * \brief Sends one datagram to the peer that shall leave the interface
+     * at launch_time. The qdisc (ETF) holds it until then, so it may be
+     * queued well ahead of time. Without such a qdisc it is sent right away.
+     * \param[in] launch_time time on the clock given to enable_txtime().
+     * \return the number of bytes sent or -1 if there is an error.
+     */
+    std::int16_t send_at(const void* message, const std::uint16_t len,
+                         const std::chrono::nanoseconds launch_time) noexcept;
+
+    /**
+     * \brief Reads the reports of datagrams the qdisc dropped because their
+     * launch time was missed or invalid.
+     * \param[in] handler called as handler(const TxTimeReport&).
+     * \return the number of reports read.
+     */
+    template < typename Handler >
+    int drain_txtime_reports(Handler&& handler) noexcept
+    {
+        return TxTime::drain_reports(get_socket_handle(),
+                                     std::forward< Handler >(handler));
+    }
+
+    /**
+     * \brief Create a UDP socket; This method is called by the base class.
+     * \return true if the socket is created.
+     */
+    bool create() noexcept;
+};
+
+#endif // WIN32 detection
+#endif // UDPSOCKET_H_
@@ -0,0 +1,652 @@
+/**
+ * \file      XdpSocket.cpp
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     AF_XDP socket for high-rate UDP receive and raw frame transmit.
+ * \details   The XDP program is assembled from a few BPF instructions at run time,
+ *            so neither libbpf nor a BPF compiler is needed.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "XdpSocket.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+/**
+ * \brief Loads a value written by the kernel.
+ */
+std::uint32_t load_acquire(const std::uint32_t* index) noexcept
+{
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * \brief Publishes a value to the kernel.
+ */
+void store_release(std::uint32_t* index, const std::uint32_t value) noexcept
+{
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief The bpf() system call, glibc has no wrapper.
+ */
+int bpf(const int command, union bpf_attr& attr) noexcept
+{
+    return static_cast< int >(syscall(__NR_bpf, command, &attr, sizeof(attr)));
+}
+
+/**
+ * \brief Assembles an XDP program that redirects frames to an XSKMAP with
+ * the RX queue as key. With a port only IPv4 frames without options that
+ * carry UDP to this port are redirected, everything else passes to the
+ * kernel.
+ */
+class XdpProgram
+{
+  public:
+    XdpProgram(const int map, const std::uint16_t port) noexcept
+        : insns_{}, count_{0U}, pass_{}, jumps_{0U}
+    {
+        // r4 = rx_queue_index, r2 = data, r3 = data_end
+        add(BPF_LDX | BPF_W | BPF_MEM, 4, 1, 16, 0);
+        add(BPF_LDX | BPF_W | BPF_MEM, 2, 1, 0, 0);
+        add(BPF_LDX | BPF_W | BPF_MEM, 3, 1, 4, 0);
+
+        if (port != 0U)
+        {
+            // the verifier needs the bounds check before any access.
+            add(BPF_ALU64 | BPF_MOV | BPF_X, 5, 2, 0, 0);
+            add(BPF_ALU64 | BPF_ADD | BPF_K, 5, 0, 0,
+                static_cast< std::int32_t >(XDP::UDP_OFFSET));
+            jump_to_pass(BPF_JMP | BPF_JGT | BPF_X, 5, 3, 0);
+            // loaded as they are in memory: compare with network-byte-order
+            check(BPF_H, 12, htons(0x0800U));
+            check(BPF_B, 14, 0x45);
+            check(BPF_B, 23, IPPROTO_UDP);
+            check(BPF_H, 36, htons(port));
+        }
+
+        // return bpf_redirect_map(map, rx_queue_index, XDP_PASS)
+        add(BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0, map);
+        add(0, 0, 0, 0, 0);
+        add(BPF_ALU64 | BPF_MOV | BPF_X, 2, 4, 0, 0);
+        add(BPF_ALU64 | BPF_MOV | BPF_K, 3, 0, 0, XDP_PASS);
+        add(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+        add(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+        // pass: return XDP_PASS
+        for (std::size_t i = 0U; i < jumps_; ++i)
+        {
+            insns_[pass_[i]].off =
+                static_cast< std::int16_t >(count_ - pass_[i] - 1U);
+        }
+
+        add(BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, XDP_PASS);
+        add(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+    }
+
+    const struct bpf_insn* get_insns() const noexcept { return insns_.data(); }
+
+    std::uint32_t get_count() const noexcept
+    {
+        return static_cast< std::uint32_t >(count_);
+    }
+
+  private:
+    void add(const int code, const int dst, const int src, const int off,
+             const std::int32_t imm) noexcept
+    {
+        struct bpf_insn& insn = insns_[count_++];
+        insn.code = static_cast< std::uint8_t >(code);
+        insn.dst_reg = static_cast< std::uint8_t >(dst) & 0x0FU;
+        insn.src_reg = static_cast< std::uint8_t >(src) & 0x0FU;
+        insn.off = static_cast< std::int16_t >(off);
+        insn.imm = imm;
+    }
+
+    void jump_to_pass(const int code, const int dst, const int src,
+                      const std::int32_t imm) noexcept
+    {
+        pass_[jumps_++] = count_;
+        add(code, dst, src, 0, imm);
+    }
+
+    /// r5 = *(data + offset); if r5 != value goto pass
+    void check(const int size, const int offset,
+               const std::int32_t value) noexcept
+    {
+        add(BPF_LDX | size | BPF_MEM, 5, 2, offset, 0);
+        jump_to_pass(BPF_JMP | BPF_JNE | BPF_K, 5, 0, value);
+    }
+
+    std::array< struct bpf_insn, 32U > insns_;
+    std::size_t count_;
+    std::array< std::size_t, 8U > pass_;
+    std::size_t jumps_;
+};
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+XdpSocket::XdpSocket() noexcept
+    : Socket{}, umem_{XDP::FRAMES * XDP::FRAME_SIZE}, fill_{}, completion_{},
+      rx_{}, tx_{}, fill_producer_{0U}, tx_producer_{0U}, tx_free_{},
+      tx_free_count_{0U}, program_{-1}, map_{-1}, link_{-1}, received_{0U},
+      dropped_{0U}, zero_copy_{false}
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+XdpSocket::~XdpSocket() noexcept
+{
+    for (const int handle : {link_, program_, map_})
+    {
+        if (handle >= 0)
+        {
+            ::close(handle);
+        }
+    }
+
+    for (const XdpRing* ring : {&fill_, &completion_, &rx_, &tx_})
+    {
+        if (ring->map != nullptr)
+        {
+            munmap(ring->map, ring->map_size);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool XdpSocket::create() noexcept
+{
+    socket_ = ::socket(AF_XDP, SOCK_RAW, 0);
+
+    if (socket_ < 0)
+    {
+        last_error_ = errno;
+        std::cerr << "Creating an AF_XDP socket failed: " << strerror(errno)
+                  << "\n";
+    }
+
+    return socket_ >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool XdpSocket::bind(const char* interface, const std::uint16_t port,
+                     const std::uint32_t queue) noexcept
+{
+    bool bound = false;
+    const unsigned int interface_index = if_nametoindex(interface);
+
+    if (interface_index == 0U)
+    {
+        std::cerr << "Interface " << interface << " not found.\n";
+        last_error_ = ENODEV;
+    }
+    else if (is_socket_initialized() && (umem_.get_data() != nullptr) &&
+             setup_rings())
+    {
+        struct sockaddr_xdp address;
+        std::memset(&address, 0, sizeof(address));
+        address.sxdp_family = AF_XDP;
+        address.sxdp_ifindex = interface_index;
+        address.sxdp_queue_id = queue;
+        address.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+        zero_copy_ = (::bind(get_socket_handle(),
+                             reinterpret_cast< struct sockaddr* >(&address),
+                             sizeof(address)) == 0);
+
+        if (zero_copy_ == false)
+        {
+            // the driver does not support zero-copy, e.g. veth.
+            address.sxdp_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+            bound = (::bind(get_socket_handle(),
+                            reinterpret_cast< struct sockaddr* >(&address),
+                            sizeof(address)) == 0);
+        }
+        else
+        {
+            bound = true;
+        }
+
+        if (bound == false)
+        {
+            last_error_ = errno;
+            std::cerr << "Binding the AF_XDP socket failed: "
+                      << strerror(errno) << "\n";
+        }
+        else
+        {
+            bound = attach_program(interface_index, port, queue);
+        }
+    }
+
+    return bound;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t XdpSocket::receive(void* message, const std::uint16_t len) noexcept
+{
+    std::uint32_t index = 0U;
+    std::int16_t data_received = -1;
+    bool taken = false;
+
+    // frames that are no UDP frames are skipped.
+    while (taken == false)
+    {
+        const int available = peek_rx(1U, index);
+        taken = (available <= 0);
+
+        if (available > 0)
+        {
+            const xdp_desc& desc = rx_descriptor(index);
+            XdpFrameInfo info;
+            PacketView payload{nullptr, 0U};
+            taken = parse_udp(get_frame(desc.addr), desc.len, payload, info);
+
+            if (taken)
+            {
+                const std::uint16_t copied =
+                    (info.payload_length < len) ? info.payload_length : len;
+                std::memcpy(message, get_frame(desc.addr) + XDP::UDP_OFFSET,
+                            copied);
+                data_received = static_cast< std::int16_t >(copied);
+            }
+            else
+            {
+                ++dropped_;
+            }
+
+            recycle(desc.addr);
+            release_rx(1);
+        }
+        else if (available == 0)
+        {
+            last_error_ = EAGAIN;
+        }
+    }
+
+    return data_received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::int16_t XdpSocket::send(const void* frame,
+                             const std::uint16_t len) noexcept
+{
+    std::int16_t data_sent = -1;
+    reclaim_tx();
+
+    if ((len > XDP::FRAME_SIZE) || (len == 0U))
+    {
+        last_error_ = EMSGSIZE;
+    }
+    else if ((tx_free_count_ == 0U) || (tx_ring_space() == 0U))
+    {
+        last_error_ = EAGAIN;
+    }
+    else
+    {
+        const std::uint64_t address = tx_free_[--tx_free_count_];
+        std::memcpy(get_frame(address), frame, len);
+        submit_tx(address, len);
+        kick_tx();
+        data_sent = static_cast< std::int16_t >(len);
+    }
+
+    return data_sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool XdpSocket::parse_udp(std::uint8_t* frame, const std::uint32_t length,
+                          PacketView& payload, XdpFrameInfo& info) noexcept
+{
+    bool udp = false;
+
+    // Ethernet type IPv4, IP version 4 without options, protocol UDP.
+    if ((length >= XDP::UDP_OFFSET) && (frame[12] == 0x08U) &&
+        (frame[13] == 0x00U) && (frame[14] == 0x45U) &&
+        (frame[23] == IPPROTO_UDP))
+    {
+        const std::uint32_t udp_length =
+            (static_cast< std::uint32_t >(frame[38]) << 8U) | frame[39];
+
+        // the UDP length covers header and payload, Ethernet may pad.
+        if ((udp_length >= 8U) && ((34U + udp_length) <= length))
+        {
+            std::uint32_t source = 0U;
+            std::memcpy(&source, &frame[26], sizeof(source));
+            info.source = IpAddress{ntohl(source)};
+            info.source_port = static_cast< std::uint16_t >(
+                (static_cast< std::uint32_t >(frame[34]) << 8U) | frame[35]);
+            info.destination_port = static_cast< std::uint16_t >(
+                (static_cast< std::uint32_t >(frame[36]) << 8U) | frame[37]);
+            info.payload_length = static_cast< std::uint16_t >(udp_length - 8U);
+            info.frame_length = length;
+            payload = PacketView{&frame[XDP::UDP_OFFSET], info.payload_length};
+            udp = true;
+        }
+    }
+
+    return udp;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool XdpSocket::setup_rings() noexcept
+{
+    struct xdp_umem_reg umem;
+    std::memset(&umem, 0, sizeof(umem));
+    umem.addr = reinterpret_cast< std::uint64_t >(umem_.get_data());
+    umem.len = std::uint64_t{XDP::FRAMES} * XDP::FRAME_SIZE;
+    umem.chunk_size = XDP::FRAME_SIZE;
+    const int handle = get_socket_handle();
+    const int ring_size = XDP::RING_SIZE;
+    struct xdp_mmap_offsets offsets;
+    socklen_t offsets_size = sizeof(offsets);
+
+    bool ready =
+        (setsockopt(handle, SOL_XDP, XDP_UMEM_REG, &umem, sizeof(umem)) ==
+         0) &&
+        (setsockopt(handle, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size,
+                    sizeof(ring_size)) == 0) &&
+        (setsockopt(handle, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size,
+                    sizeof(ring_size)) == 0) &&
+        (setsockopt(handle, SOL_XDP, XDP_RX_RING, &ring_size,
+                    sizeof(ring_size)) == 0) &&
+        (setsockopt(handle, SOL_XDP, XDP_TX_RING, &ring_size,
+                    sizeof(ring_size)) == 0) &&
+        (getsockopt(handle, SOL_XDP, XDP_MMAP_OFFSETS, &offsets,
+                    &offsets_size) == 0);
+
+    ready = ready &&
+            map_ring(fill_, offsets.fr, XDP_UMEM_PGOFF_FILL_RING,
+                     sizeof(std::uint64_t)) &&
+            map_ring(completion_, offsets.cr, XDP_UMEM_PGOFF_COMPLETION_RING,
+                     sizeof(std::uint64_t)) &&
+            map_ring(rx_, offsets.rx, XDP_PGOFF_RX_RING, sizeof(xdp_desc)) &&
+            map_ring(tx_, offsets.tx, XDP_PGOFF_TX_RING, sizeof(xdp_desc));
+
+    if (ready)
+    {
+        // the first half of the UMEM is handed to the driver to receive into.
+        std::uint64_t* fill = static_cast< std::uint64_t* >(fill_.descriptors);
+
+        for (std::uint32_t i = 0U; i < (XDP::FRAMES / 2U); ++i)
+        {
+            fill[i & fill_.mask] = std::uint64_t{i} * XDP::FRAME_SIZE;
+        }
+
+        fill_producer_ = XDP::FRAMES / 2U;
+        store_release(fill_.producer, fill_producer_);
+
+        for (std::uint32_t i = 0U; i < (XDP::FRAMES / 2U); ++i)
+        {
+            tx_free_[i] =
+                std::uint64_t{(XDP::FRAMES / 2U) + i} * XDP::FRAME_SIZE;
+        }
+
+        tx_free_count_ = XDP::FRAMES / 2U;
+    }
+    else
+    {
+        last_error_ = errno;
+        std::cerr << "Setting up the AF_XDP rings failed: " << strerror(errno)
+                  << "\n";
+    }
+
+    return ready;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool XdpSocket::map_ring(XdpRing& ring, const xdp_ring_offset& offset,
+                         const std::uint64_t page_offset,
+                         const std::size_t descriptor_size) noexcept
+{
+    const std::size_t size = offset.desc + (XDP::RING_SIZE * descriptor_size);
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, get_socket_handle(),
+                     static_cast< off_t >(page_offset));
+    bool mapped = false;
+
+    if (map != MAP_FAILED)
+    {
+        std::uint8_t* base = static_cast< std::uint8_t* >(map);
+        ring.map = map;
+        ring.map_size = size;
+        ring.producer =
+            reinterpret_cast< std::uint32_t* >(base + offset.producer);
+        ring.consumer =
+            reinterpret_cast< std::uint32_t* >(base + offset.consumer);
+        ring.flags = reinterpret_cast< std::uint32_t* >(base + offset.flags);
+        ring.descriptors = base + offset.desc;
+        mapped = true;
+    }
+
+    return mapped;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool XdpSocket::attach_program(const unsigned int interface,
+                               const std::uint16_t port,
+                               const std::uint32_t queue) noexcept
+{
+    union bpf_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(std::uint32_t);
+    attr.value_size = sizeof(std::int32_t);
+    attr.max_entries = queue + 1U;
+    map_ = bpf(BPF_MAP_CREATE, attr);
+
+    if (map_ >= 0)
+    {
+        const XdpProgram program{map_, port};
+        std::array< char, 4096U > log{};
+        static const char LICENSE[] = "Dual BSD/GPL";
+        std::memset(&attr, 0, sizeof(attr));
+        attr.prog_type = BPF_PROG_TYPE_XDP;
+        attr.insns = reinterpret_cast< std::uint64_t >(program.get_insns());
+        attr.insn_cnt = program.get_count();
+        attr.license = reinterpret_cast< std::uint64_t >(LICENSE);
+        attr.log_buf = reinterpret_cast< std::uint64_t >(log.data());
+        attr.log_size = static_cast< std::uint32_t >(log.size());
+        attr.log_level = 1U;
+        program_ = bpf(BPF_PROG_LOAD, attr);
+
+        if (program_ < 0)
+        {
+            std::cerr << "Loading the XDP program failed:\n"
+                      << log.data() << "\n";
+        }
+    }
+
+    if (program_ >= 0)
+    {
+        const std::int32_t handle = get_socket_handle();
+        std::memset(&attr, 0, sizeof(attr));
+        attr.map_fd = static_cast< std::uint32_t >(map_);
+        attr.key = reinterpret_cast< std::uint64_t >(&queue);
+        attr.value = reinterpret_cast< std::uint64_t >(&handle);
+
+        if (bpf(BPF_MAP_UPDATE_ELEM, attr) == 0)
+        {
+            // native XDP in the driver first, the generic hook otherwise.
+            for (const std::uint32_t mode :
+                 {std::uint32_t{XDP_FLAGS_DRV_MODE},
+                  std::uint32_t{XDP_FLAGS_SKB_MODE}})
+            {
+                std::memset(&attr, 0, sizeof(attr));
+                attr.link_create.prog_fd =
+                    static_cast< std::uint32_t >(program_);
+                attr.link_create.target_ifindex = interface;
+                attr.link_create.attach_type = BPF_XDP;
+                attr.link_create.flags = mode;
+                link_ = bpf(BPF_LINK_CREATE, attr);
+
+                if (link_ >= 0)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (link_ < 0)
+    {
+        last_error_ = errno;
+        std::cerr << "Attaching the XDP program failed: " << strerror(errno)
+                  << "\n";
+    }
+
+    return link_ >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int XdpSocket::peek_rx(const std::uint32_t max_frames,
+                       std::uint32_t& index) noexcept
+{
+    index = *rx_.consumer;
+    std::uint32_t available = load_acquire(rx_.producer) - index;
+    int frames = 0;
+
+    if ((available == 0U) && is_blocking())
+    {
+        struct pollfd event;
+        event.fd = get_socket_handle();
+        event.events = POLLIN;
+        event.revents = 0;
+
+        if ((poll(&event, 1U, -1) < 0) && (errno != EINTR))
+        {
+            last_error_ = errno;
+            frames = -1;
+        }
+
+        available = load_acquire(rx_.producer) - index;
+    }
+    else if ((available == 0U) &&
+             ((load_acquire(fill_.flags) & XDP_RING_NEED_WAKEUP) != 0U))
+    {
+        // the driver waits for us to tell it about the fill ring.
+        static_cast< void >(recvfrom(get_socket_handle(), nullptr, 0U,
+                                     MSG_DONTWAIT, nullptr, nullptr));
+    }
+
+    if (frames == 0)
+    {
+        frames = static_cast< int >((available < max_frames) ? available
+                                                             : max_frames);
+    }
+
+    return frames;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void XdpSocket::release_rx(const int count) noexcept
+{
+    if (count > 0)
+    {
+        store_release(fill_.producer, fill_producer_);
+        store_release(rx_.consumer,
+                      *rx_.consumer + static_cast< std::uint32_t >(count));
+        received_ += static_cast< std::uint64_t >(count);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void XdpSocket::recycle(const std::uint64_t address) noexcept
+{
+    // there are as many RX frames as fill ring entries, there is always room.
+    static_cast< std::uint64_t* >(
+        fill_.descriptors)[fill_producer_ & fill_.mask] = address;
+    ++fill_producer_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void XdpSocket::reclaim_tx() noexcept
+{
+    const std::uint32_t producer = load_acquire(completion_.producer);
+    std::uint32_t consumer = *completion_.consumer;
+    const std::uint64_t* completed =
+        static_cast< const std::uint64_t* >(completion_.descriptors);
+
+    while (consumer != producer)
+    {
+        tx_free_[tx_free_count_++] = completed[consumer & completion_.mask];
+        ++consumer;
+    }
+
+    store_release(completion_.consumer, consumer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint32_t XdpSocket::tx_ring_space() const noexcept
+{
+    return XDP::RING_SIZE - (tx_producer_ - load_acquire(tx_.consumer));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void XdpSocket::submit_tx(const std::uint64_t address,
+                          const std::uint32_t length) noexcept
+{
+    xdp_desc& desc =
+        static_cast< xdp_desc* >(tx_.descriptors)[tx_producer_ & tx_.mask];
+    desc.addr = address;
+    desc.len = length;
+    desc.options = 0U;
+    ++tx_producer_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void XdpSocket::kick_tx() noexcept
+{
+    store_release(tx_.producer, tx_producer_);
+
+    // copy mode sends on the system call only, zero-copy drivers ask for it.
+    if ((zero_copy_ == false) ||
+        ((load_acquire(tx_.flags) & XDP_RING_NEED_WAKEUP) != 0U))
+    {
+        static_cast< void >(sendto(get_socket_handle(), nullptr, 0U,
+                                   MSG_DONTWAIT, nullptr, 0U));
+    }
+}
+
+#endif // WIN32 detection
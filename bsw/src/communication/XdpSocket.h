@@ -0,0 +1,389 @@
+/**
+ * \file      XdpSocket.h
+ * \author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * \brief     AF_XDP socket for high-rate UDP receive and raw frame transmit.
+ * \details   Frames are exchanged with the driver through a UMEM and four rings
+ *            (fill, completion, RX, TX) without the kernel UDP stack. A small XDP
+ *            program redirects the UDP frames of one port to the socket.
+ * \copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef XDPSOCKET_H_
+#define XDPSOCKET_H_
+
+#ifndef _WIN32
+
+#include "HugePageBuffer.h"
+#include "IpAddress.h"
+#include "Packet.h"
+#include "Socket.h"
+#include <array>
+#include <cstdint>
+#include <linux/if_xdp.h>
+#include <poll.h>
+
+/**
+ * \brief Defining a struct that holds informations about AF_XDP sockets.
+ */
+struct XDP
+{
+    // size of one frame in the UMEM, holds one Ethernet frame.
+    static constexpr std::uint32_t FRAME_SIZE{2048U};
+    // frames in the UMEM. The first half is for RX, the second for TX.
+    static constexpr std::uint32_t FRAMES{4096U};
+    // descriptors per ring, a power of two.
+    static constexpr std::uint32_t RING_SIZE{2048U};
+    // maximum number of frames handled per receive_batch() or send_batch().
+    static constexpr std::uint32_t BATCH{64U};
+    // Ethernet, IPv4 without options and UDP header.
+    static constexpr std::size_t UDP_OFFSET{14U + 20U + 8U};
+};
+
+/**
+ * \brief Where a UDP frame received came from.
+ */
+struct XdpFrameInfo
+{
+    /// IPv4 source address.
+    IpAddress source{std::uint32_t{0U}};
+
+    /// UDP source port.
+    std::uint16_t source_port{0U};
+
+    /// UDP destination port.
+    std::uint16_t destination_port{0U};
+
+    /// length of the UDP payload.
+    std::uint16_t payload_length{0U};
+
+    /// length of the Ethernet frame.
+    std::uint32_t frame_length{0U};
+};
+
+/**
+ * \brief One of the four rings shared with the kernel. The producer and
+ * consumer indices run freely, the mask maps them into the ring.
+ */
+struct XdpRing
+{
+    std::uint32_t* producer{nullptr};
+    std::uint32_t* consumer{nullptr};
+    std::uint32_t* flags{nullptr};
+    void* descriptors{nullptr};
+    void* map{nullptr};
+    std::size_t map_size{0U};
+    std::uint32_t mask{XDP::RING_SIZE - 1U};
+};
+
+/**
+ * \brief XdpSocket receives UDP frames and sends Ethernet frames through an
+ * AF_XDP socket bound to one queue of an interface. The driver writes the
+ * frames into the UMEM directly (zero-copy) if it supports it, else the
+ * kernel copies them (e.g. veth).
+ */
+class XdpSocket : public Socket< XdpSocket >
+{
+  public:
+    /**
+     * \brief Opens the AF_XDP socket and allocates the UMEM.
+     */
+    XdpSocket() noexcept;
+
+    /**
+     * \brief Detaches the XDP program and unmaps the rings.
+     */
+    ~XdpSocket() noexcept;
+
+    XdpSocket(const XdpSocket&) = delete;
+    XdpSocket& operator=(const XdpSocket&) = delete;
+
+    /**
+     * \brief Binds the socket to a queue of an interface and attaches an XDP
+     * program that redirects the UDP frames of the port to it. All other
+     * frames go to the kernel as before. Needs CAP_NET_ADMIN and CAP_BPF.
+     * \param[in] interface the interface name, e.g. "eth0".
+     * \param[in] port the UDP destination port, 0 redirects all frames.
+     * \param[in] queue the RX queue of the interface. Steer the sensor
+     * traffic to it, e.g. with "ethtool -N".
+     * \return true if bound and the program is attached.
+     */
+    bool bind(const char* interface, const std::uint16_t port,
+              const std::uint32_t queue = 0U) noexcept;
+
+    /**
+     * \brief Receives one UDP payload, like a UDP socket.
+     * \param[out] message the payload is copied here.
+     * \param[in] len the size of message, the rest of the payload is cut.
+     * \return the number of bytes copied, -1 on error or with EAGAIN if
+     * the socket is non-blocking and nothing is pending.
+     */
+    std::int16_t receive(void* message, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Hands up to max_frames UDP payloads to the handler without
+     * copying them. Waits for the first frame if the socket is blocking.
+     * \param[in] handler called as handler(PacketView& payload,
+     * const XdpFrameInfo& info) for each UDP frame. The payload is only
+     * valid during the call.
+     * \param[in] max_frames the number of frames to take at most.
+     * \return the number of frames taken, -1 on error.
+     */
+    template < typename Handler >
+    int receive_batch(Handler&& handler,
+                      const std::uint32_t max_frames = XDP::BATCH) noexcept
+    {
+        std::uint32_t index = 0U;
+        const int available = peek_rx(max_frames, index);
+
+        for (int i = 0; i < available; ++i)
+        {
+            const xdp_desc& desc =
+                rx_descriptor(index + static_cast< std::uint32_t >(i));
+            std::uint8_t* frame = get_frame(desc.addr);
+            XdpFrameInfo info;
+            PacketView payload{nullptr, 0U};
+
+            if (parse_udp(frame, desc.len, payload, info))
+            {
+                handler(payload, info);
+            }
+            else
+            {
+                ++dropped_;
+            }
+
+            recycle(desc.addr);
+        }
+
+        release_rx(available);
+        return available;
+    }
+
+    /**
+     * \brief Sends one complete Ethernet frame.
+     * \return the number of bytes queued, -1 if no TX frame is free (EAGAIN)
+     * or the frame is too big.
+     */
+    std::int16_t send(const void* frame, const std::uint16_t len) noexcept;
+
+    /**
+     * \brief Writes up to count Ethernet frames directly into the UMEM and
+     * sends them with one system call.
+     * \param[in] count the number of frames to send.
+     * \param[in] write called as write(PacketView& frame) for each frame.
+     * Only the bytes written are sent, a frame left empty is not sent and
+     * goes back to the free frames.
+     * \return the number of frames queued.
+     */
+    template < typename Handler >
+    int send_batch(const std::uint32_t count, Handler&& write) noexcept
+    {
+        std::uint32_t queued = 0U;
+        std::uint32_t written = 0U;
+        reclaim_tx();
+
+        while ((written < count) && (tx_free_count_ > 0U) &&
+               (tx_ring_space() > 0U))
+        {
+            const std::uint64_t address = tx_free_[--tx_free_count_];
+            PacketView frame{get_frame(address), XDP::FRAME_SIZE};
+            write(frame);
+            ++written;
+
+            if (frame.get_length() > 0U)
+            {
+                submit_tx(address,
+                          static_cast< std::uint32_t >(frame.get_length()));
+                ++queued;
+            }
+            else
+            {
+                tx_free_[tx_free_count_++] = address;
+            }
+        }
+
+        kick_tx();
+        return static_cast< int >(queued);
+    }
+
+    /**
+     * \brief Creates the AF_XDP socket. Called by the Socket base class.
+     */
+    bool create() noexcept;
+
+    /**
+     * \brief Decodes an Ethernet frame with an IPv4 header without options
+     * and a UDP header.
+     * \param[in] frame the Ethernet frame.
+     * \param[in] length the length of the frame.
+     * \param[out] payload a view on the UDP payload.
+     * \param[out] info addresses and ports.
+     * \return true if this is a complete UDP frame.
+     */
+    static bool parse_udp(std::uint8_t* frame, const std::uint32_t length,
+                          PacketView& payload, XdpFrameInfo& info) noexcept;
+
+    /**
+     * \brief true if the driver writes into the UMEM directly.
+     */
+    bool is_zero_copy() const noexcept { return zero_copy_; }
+
+    /**
+     * \brief Number of frames received.
+     */
+    std::uint64_t get_received() const noexcept { return received_; }
+
+    /**
+     * \brief Number of frames received that were no UDP frames.
+     */
+    std::uint64_t get_dropped() const noexcept { return dropped_; }
+
+  private:
+    /**
+     * \brief Registers the UMEM, sizes and maps the rings.
+     */
+    bool setup_rings() noexcept;
+
+    /**
+     * \brief Maps one ring into the process.
+     */
+    bool map_ring(XdpRing& ring, const xdp_ring_offset& offset,
+                  const std::uint64_t page_offset,
+                  const std::size_t descriptor_size) noexcept;
+
+    /**
+     * \brief Loads the XDP program, stores the socket in its map and
+     * attaches it to the interface.
+     */
+    bool attach_program(const unsigned int interface, const std::uint16_t port,
+                        const std::uint32_t queue) noexcept;
+
+    /**
+     * \brief Looks for received frames, waits for one if blocking.
+     * \param[out] index the first descriptor.
+     * \return the number of frames, at most max_frames, -1 on error.
+     */
+    int peek_rx(const std::uint32_t max_frames, std::uint32_t& index) noexcept;
+
+    /**
+     * \brief A descriptor of the RX ring.
+     */
+    const xdp_desc& rx_descriptor(const std::uint32_t index) const noexcept
+    {
+        return static_cast< const xdp_desc* >(
+            rx_.descriptors)[index & rx_.mask];
+    }
+
+    /**
+     * \brief Gives the RX descriptors back to the kernel and publishes the
+     * frames recycled into the fill ring.
+     */
+    void release_rx(const int count) noexcept;
+
+    /**
+     * \brief Gives a frame back to the fill ring, so the driver can receive
+     * into it again.
+     */
+    void recycle(const std::uint64_t address) noexcept;
+
+    /**
+     * \brief Takes the frames sent from the completion ring.
+     */
+    void reclaim_tx() noexcept;
+
+    /**
+     * \brief Free descriptors in the TX ring.
+     */
+    std::uint32_t tx_ring_space() const noexcept;
+
+    /**
+     * \brief Puts a frame into the TX ring.
+     */
+    void submit_tx(const std::uint64_t address,
+                   const std::uint32_t length) noexcept;
+
+    /**
+     * \brief Publishes the TX descriptors and wakes up the kernel.
+     */
+    void kick_tx() noexcept;
+
+    /**
+     * \brief A frame of the UMEM.
+     */
+    std::uint8_t* get_frame(const std::uint64_t address) const noexcept
+    {
+        return static_cast< std::uint8_t* >(umem_.get_data()) + address;
+    }
+
+    /// the frames shared with the driver.
+    HugePageBuffer umem_;
+
+    /// frames given to the driver to receive into.
+    XdpRing fill_;
+
+    /// frames the driver has sent.
+    XdpRing completion_;
+
+    /// frames received.
+    XdpRing rx_;
+
+    /// frames to send.
+    XdpRing tx_;
+
+    /// producer index of the fill ring, published by release_rx().
+    std::uint32_t fill_producer_;
+
+    /// producer index of the TX ring, published by kick_tx().
+    std::uint32_t tx_producer_;
+
+    /// frames of the TX half of the UMEM that are free.
+    std::array< std::uint64_t, XDP::FRAMES / 2U > tx_free_;
+
+    /// number of free TX frames.
+    std::uint32_t tx_free_count_;
+
+    /// the XDP program, the map with the socket and the link to the
+    /// interface. Closing the link detaches the program.
+    int program_;
+    int map_;
+    int link_;
+
+    /// frames received and dropped.
+    std::uint64_t received_;
+    std::uint64_t dropped_;
+
+    /// the driver supports zero-copy.
+    bool zero_copy_;
+};
+
+#endif // WIN32 detection
+#endif // XDPSOCKET_H_
@@ -0,0 +1,367 @@
+/**
+ * @file      HugePageBuffer.h
+ * @author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * @brief     Big buffers on huge pages.
+ * @details   Allocates a buffer with MAP_HUGETLB or transparent huge pages,
+ *            prefaults and locks it. Falls back to normal pages and reports the
+ *            page size actually obtained.
+ * @version   1.0
+ * @copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HUGEPAGEBUFFER_H_
+#define HUGEPAGEBUFFER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * \brief Defining a struct that holds the sizes of huge pages.
+ */
+struct HUGE_PAGE
+{
+    // the huge page size if /proc does not tell (x86-64, ARM with LPAE).
+    static constexpr std::size_t DEFAULT_SIZE{2U * 1024U * 1024U};
+};
+
+/**
+ * \brief The kind of pages a HugePageBuffer got.
+ */
+enum class PageKind : std::uint8_t
+{
+    NONE,        ///< the allocation failed.
+    NORMAL,      ///< normal pages, huge pages were not available.
+    TRANSPARENT, ///< transparent huge pages (madvise).
+    HUGETLB      ///< huge pages reserved in the huge page pool (MAP_HUGETLB).
+};
+
+/**
+ * \brief HugePageBuffer is a big buffer allocated once at start-up. Huge pages
+ * need fewer TLB entries, which reduces TLB misses on buffers of many MiB.
+ * The pages are tried in this order:
+ * 1. MAP_HUGETLB, needs pages in the pool (vm.nr_hugepages),
+ * 2. transparent huge pages with madvise(MADV_HUGEPAGE),
+ * 3. normal pages.
+ * All pages are touched (prefaulted) and locked into RAM (mlock), so the
+ * real-time path does not take page faults.
+ */
+class HugePageBuffer
+{
+  public:
+    /**
+     * \brief Allocates the buffer.
+     * \param[in] size the size in bytes. It is rounded up to full pages.
+     * \param[in] huge_pages false to use normal pages only, e.g. to compare.
+     * \param[in] lock true to lock the buffer into RAM.
+     */
+    explicit HugePageBuffer(const std::size_t size,
+                            const bool huge_pages = true,
+                            const bool lock = true) noexcept
+        : data_{nullptr}, size_{0U}, kind_{PageKind::NONE}, page_size_{0U},
+          locked_{false}
+    {
+        if (huge_pages)
+        {
+            allocate_hugetlb(size);
+
+            if (kind_ == PageKind::NONE)
+            {
+                allocate_transparent(size);
+            }
+        }
+
+        if (kind_ == PageKind::NONE)
+        {
+            allocate_normal(size);
+        }
+
+        if (kind_ != PageKind::NONE)
+        {
+            // touch every page now instead of in the real-time path.
+            std::memset(data_, 0, size_);
+
+            if (kind_ == PageKind::TRANSPARENT)
+            {
+                check_transparent();
+            }
+
+            if (lock)
+            {
+                locked_ = (mlock(data_, size_) == 0);
+
+                if (locked_ == false)
+                {
+                    std::cerr << "Could not lock the buffer, check "
+                                 "RLIMIT_MEMLOCK.\n";
+                }
+            }
+        }
+        else
+        {
+            std::cerr << "Could not allocate " << size << " bytes.\n";
+        }
+    }
+
+    /**
+     * \brief Releases the buffer.
+     */
+    ~HugePageBuffer() noexcept
+    {
+        if (data_ != nullptr)
+        {
+            munmap(data_, size_);
+        }
+    }
+
+    HugePageBuffer(const HugePageBuffer&) = delete;
+    HugePageBuffer& operator=(const HugePageBuffer&) = delete;
+
+    /**
+     * \brief The buffer, nullptr if the allocation failed.
+     */
+    void* get_data() const noexcept { return data_; }
+
+    /**
+     * \brief The size of the buffer, rounded up to full pages.
+     */
+    std::size_t get_size() const noexcept { return size_; }
+
+    /**
+     * \brief The kind of pages the buffer got.
+     */
+    PageKind get_page_kind() const noexcept { return kind_; }
+
+    /**
+     * \brief The size of the pages the buffer got.
+     */
+    std::size_t get_page_size() const noexcept { return page_size_; }
+
+    /**
+     * \brief Checks if the buffer is locked into RAM.
+     */
+    bool is_locked() const noexcept { return locked_; }
+
+    /**
+     * \brief Prints the size, the pages obtained and if the buffer is locked.
+     */
+    void print(std::ostream& out) const noexcept
+    {
+        static constexpr const char* KINDS[] = {"none", "normal",
+                                                "transparent huge", "hugetlb"};
+        out << size_ << " bytes on " << KINDS[static_cast< int >(kind_)]
+            << " pages of " << page_size_ << " bytes"
+            << (locked_ ? ", locked\n" : ", not locked\n");
+    }
+
+  private:
+    /**
+     * \brief Rounds a size up to full pages.
+     */
+    static std::size_t round_up(const std::size_t size,
+                                const std::size_t page) noexcept
+    {
+        return ((size + page - 1U) / page) * page;
+    }
+
+    /**
+     * \brief Reads a size in kB from a line of a file in /proc, e.g.
+     * "Hugepagesize: 2048 kB".
+     * \return the size in bytes or 0 if the line is not found.
+     */
+    static std::size_t read_kb(const char* file, const char* key,
+                               const void* from = nullptr,
+                               const void* to = nullptr) noexcept
+    {
+        std::size_t bytes{0U};
+        FILE* proc = std::fopen(file, "r");
+
+        if (proc != nullptr)
+        {
+            char line[256];
+            // only the lines of the mapping from..to count if given.
+            bool in_range = (from == nullptr);
+
+            while (std::fgets(line, sizeof(line), proc) != nullptr)
+            {
+                unsigned long start{0U};
+                unsigned long end{0U};
+                unsigned long kb{0U};
+
+                if ((from != nullptr) &&
+                    (std::sscanf(line, "%lx-%lx ", &start, &end) == 2))
+                {
+                    in_range =
+                        (start <= reinterpret_cast< unsigned long >(from)) &&
+                        (end >= reinterpret_cast< unsigned long >(to));
+                }
+                else if (in_range &&
+                         (std::strncmp(line, key, std::strlen(key)) == 0) &&
+                         (std::sscanf(line + std::strlen(key), " %lu", &kb) ==
+                          1))
+                {
+                    bytes += kb * 1024U;
+                }
+            }
+
+            std::fclose(proc);
+        }
+
+        return bytes;
+    }
+
+    /**
+     * \brief Tries pages of the huge page pool.
+     */
+    void allocate_hugetlb(const std::size_t size) noexcept
+    {
+#ifdef MAP_HUGETLB
+        std::size_t page = read_kb("/proc/meminfo", "Hugepagesize:");
+        page = (page > 0U) ? page : HUGE_PAGE::DEFAULT_SIZE;
+        const std::size_t len = round_up(size, page);
+        void* data = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (data != MAP_FAILED)
+        {
+            data_ = data;
+            size_ = len;
+            page_size_ = page;
+            kind_ = PageKind::HUGETLB;
+        }
+#else
+        static_cast< void >(size);
+#endif
+    }
+
+    /**
+     * \brief Tries transparent huge pages. The buffer is aligned to the huge
+     * page size, else the kernel can not use huge pages for it.
+     */
+    void allocate_transparent(const std::size_t size) noexcept
+    {
+#ifdef MADV_HUGEPAGE
+        const std::size_t page = HUGE_PAGE::DEFAULT_SIZE;
+        const std::size_t len = round_up(size, page);
+        // map one huge page more to find an aligned start in it.
+        void* data = mmap(nullptr, len + page, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (data != MAP_FAILED)
+        {
+            auto* raw = static_cast< std::uint8_t* >(data);
+            const auto address = reinterpret_cast< std::uintptr_t >(raw);
+            const std::size_t head = (page - (address % page)) % page;
+            // give back what is not needed in front of and behind the buffer.
+            if (head > 0U)
+            {
+                munmap(raw, head);
+            }
+
+            munmap(raw + head + len, page - head);
+
+            data_ = raw + head;
+            size_ = len;
+
+            if (madvise(data_, size_, MADV_HUGEPAGE) == 0)
+            {
+                page_size_ = page;
+                kind_ = PageKind::TRANSPARENT;
+            }
+            else
+            {
+                // transparent huge pages are not supported.
+                page_size_ = static_cast< std::size_t >(sysconf(_SC_PAGESIZE));
+                kind_ = PageKind::NORMAL;
+            }
+        }
+#else
+        static_cast< void >(size);
+#endif
+    }
+
+    /**
+     * \brief Takes normal pages.
+     */
+    void allocate_normal(const std::size_t size) noexcept
+    {
+        const auto page = static_cast< std::size_t >(sysconf(_SC_PAGESIZE));
+        const std::size_t len = round_up(size, page);
+        void* data = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (data != MAP_FAILED)
+        {
+            data_ = data;
+            size_ = len;
+            page_size_ = page;
+            kind_ = PageKind::NORMAL;
+        }
+    }
+
+    /**
+     * \brief madvise() is a hint only. Checks if the kernel actually used huge
+     * pages for the buffer after it was touched.
+     */
+    void check_transparent() noexcept
+    {
+        const std::size_t huge =
+            read_kb("/proc/self/smaps", "AnonHugePages:", data_,
+                    static_cast< std::uint8_t* >(data_) + size_);
+
+        if (huge == 0U)
+        {
+            page_size_ = static_cast< std::size_t >(sysconf(_SC_PAGESIZE));
+            kind_ = PageKind::NORMAL;
+        }
+    }
+
+    /// the buffer.
+    void* data_;
+
+    /// the size of the buffer in bytes.
+    std::size_t size_;
+
+    /// the pages obtained.
+    PageKind kind_;
+
+    /// the size of the pages obtained.
+    std::size_t page_size_;
+
+    /// true if the buffer is locked into RAM.
+    bool locked_;
+};
+
+#endif /* HUGEPAGEBUFFER_H_ */
@@ -0,0 +1,228 @@
+/**
+ * @file      LatencyHistogram.h
+ * @author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * @brief     Latency histogram with logarithmic buckets.
+ * @details   Collects latencies in power-of-two buckets of nanoseconds with
+ *            constant memory and constant time per sample.
+ * @version   1.0
+ * @copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+
+/**
+ * \brief LatencyHistogram counts latencies in buckets. Bucket i holds the
+ * latencies from 2^i ns up to 2^(i+1) ns, bucket 0 includes zero. The last
+ * bucket holds everything above.
+ */
+class LatencyHistogram
+{
+  public:
+    /// number of buckets: the last one starts at about 1 s.
+    static constexpr std::size_t BUCKETS{31U};
+
+    /**
+     * \brief Default constructor, the histogram is empty.
+     */
+    LatencyHistogram() noexcept { clear(); }
+
+    /**
+     * \brief Adds one latency sample.
+     * \param[in] latency the latency to add. Negative values count as zero.
+     */
+    void add(const std::chrono::nanoseconds latency) noexcept
+    {
+        const std::int64_t ns = (latency.count() > 0) ? latency.count() : 0;
+        ++buckets_[bucket_of(static_cast< std::uint64_t >(ns))];
+        ++count_;
+        sum_ += ns;
+
+        if (ns < min_)
+        {
+            min_ = ns;
+        }
+
+        if (ns > max_)
+        {
+            max_ = ns;
+        }
+    }
+
+    /**
+     * \brief Removes all samples.
+     */
+    void clear() noexcept
+    {
+        buckets_.fill(0U);
+        count_ = 0U;
+        sum_ = 0;
+        min_ = std::numeric_limits< std::int64_t >::max();
+        max_ = 0;
+    }
+
+    /**
+     * \brief Number of samples added.
+     */
+    std::uint64_t get_count() const noexcept { return count_; }
+
+    /**
+     * \brief Number of samples in one bucket.
+     */
+    std::uint64_t get_bucket(const std::size_t bucket) const noexcept
+    {
+        return (bucket < BUCKETS) ? buckets_[bucket] : 0U;
+    }
+
+    /**
+     * \brief The smallest latency added, zero if empty.
+     */
+    std::chrono::nanoseconds get_min() const noexcept
+    {
+        return std::chrono::nanoseconds{(count_ > 0U) ? min_ : 0};
+    }
+
+    /**
+     * \brief The biggest latency added.
+     */
+    std::chrono::nanoseconds get_max() const noexcept
+    {
+        return std::chrono::nanoseconds{max_};
+    }
+
+    /**
+     * \brief The mean of all latencies added, zero if empty.
+     */
+    std::chrono::nanoseconds get_mean() const noexcept
+    {
+        return std::chrono::nanoseconds{
+            (count_ > 0U) ? (sum_ / static_cast< std::int64_t >(count_)) : 0};
+    }
+
+    /**
+     * \brief Upper bound of the bucket that holds the given percentile.
+     * \param[in] percentile between 0.0 and 100.0
+     * \return the latency not exceeded by the percentile of the samples,
+     * limited by the maximum.
+     */
+    std::chrono::nanoseconds get_percentile(const double percentile) const
+        noexcept
+    {
+        const double wanted =
+            static_cast< double >(count_) * percentile / 100.0;
+        std::uint64_t seen{0U};
+        std::int64_t bound{max_};
+
+        for (std::size_t i = 0U; i < BUCKETS; ++i)
+        {
+            seen += buckets_[i];
+
+            if ((seen > 0U) && (static_cast< double >(seen) >= wanted))
+            {
+                // the last bucket has no upper bound.
+                const std::int64_t upper = (i < (BUCKETS - 1U))
+                                               ? ((std::int64_t{2} << i) - 1)
+                                               : max_;
+                bound = (upper < max_) ? upper : max_;
+                break;
+            }
+        }
+
+        return std::chrono::nanoseconds{bound};
+    }
+
+    /**
+     * \brief Prints count, min, mean, max and the buckets that are not empty.
+     * \param[in] out the stream to print to.
+     */
+    void print(std::ostream& out) const noexcept
+    {
+        out << "n=" << count_ << " min=" << get_min().count()
+            << "ns mean=" << get_mean().count() << "ns max=" << max_
+            << "ns p99=" << get_percentile(99.0).count() << "ns\n";
+
+        for (std::size_t i = 0U; i < BUCKETS; ++i)
+        {
+            // the last bucket holds everything from its lower bound on.
+            if ((buckets_[i] > 0U) && (i < (BUCKETS - 1U)))
+            {
+                out << "  < " << (std::uint64_t{2} << i)
+                    << "ns: " << buckets_[i] << "\n";
+            }
+            else if (buckets_[i] > 0U)
+            {
+                out << "  >= " << (std::uint64_t{1} << i)
+                    << "ns: " << buckets_[i] << "\n";
+            }
+        }
+    }
+
+  private:
+    /**
+     * \brief Index of the highest bit set, limited to the last bucket.
+     */
+    static std::size_t bucket_of(std::uint64_t ns) noexcept
+    {
+        std::size_t bucket{0U};
+
+        while ((ns > 1U) && (bucket < (BUCKETS - 1U)))
+        {
+            ns >>= 1U;
+            ++bucket;
+        }
+
+        return bucket;
+    }
+
+    /// number of samples per bucket.
+    std::array< std::uint64_t, BUCKETS > buckets_;
+
+    /// number of samples.
+    std::uint64_t count_;
+
+    /// sum of all samples in ns to get the mean.
+    std::int64_t sum_;
+
+    /// smallest sample in ns.
+    std::int64_t min_;
+
+    /// biggest sample in ns.
+    std::int64_t max_;
+};
+
+#endif /* LATENCYHISTOGRAM_H_ */
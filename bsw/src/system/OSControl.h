@@ -39,6 +39,8 @@
 #ifndef OSCONTROL_H_
 #define OSCONTROL_H_
 
+#include "TaskStats.h" // Statistics of each cycle.
+#include <alloca.h>    // Prefaulting the stack of the calling thread.
 #include <iostream>
 #include <limits>    // Check numeric limits of data types at compile-time.
 #include <pthread.h> // POSIX threads for send and receive thread.
@@ -46,6 +48,44 @@
 #include <string.h>
 #include <sys/mman.h> // Memory management for the real-time tasks.
 #include <time.h>     // Timestamps and nanosleep
+#include <unistd.h>   // Page size.
+
+/**
+ * @brief Defining a struct that holds the stack parameters of real-time
+ * tasks.
+ */
+struct OS_CONTROL
+{
+    // stack of a real-time thread, locked in memory as a whole.
+    static constexpr std::size_t DEFAULT_STACK_SIZE{128U * 1024U};
+
+    // unused stack is painted with this pattern.
+    static constexpr std::uint8_t STACK_PATTERN{0xA5U};
+
+    // a warning is printed at shutdown if more of the stack was used.
+    static constexpr std::size_t STACK_WARN_PERCENT{75U};
+};
+
+/**
+ * @brief The painted stack of a task.
+ */
+struct TaskStack
+{
+    /// the mapping incl. the guard page, nullptr if not owned.
+    void* m_mapping{nullptr};
+
+    /// size of the mapping.
+    std::size_t m_mapped{0U};
+
+    /// lowest address of the painted stack, nullptr if not painted.
+    std::uint8_t* m_base{nullptr};
+
+    /// size of the painted stack.
+    std::size_t m_size{0U};
+
+    /// the high-water mark measured when the task ended.
+    std::size_t m_high_water{0U};
+};
 
 /**
  *
@@ -61,6 +101,9 @@ struct TaskMutex
 struct TaskHandle
 {
     pthread_t m_handle;
+
+    /// the stack of the thread.
+    TaskStack m_stack;
 };
 
 /**
@@ -73,27 +116,71 @@ class OSControl
 {
   public:
     /**
-     * @brief Creates a real-time task as pthread.
+     * @brief Creates a real-time task as pthread on a stack of its own. The
+     * stack gets a guard page below it and is painted with
+     * OS_CONTROL::STACK_PATTERN, which faults in all of its pages: with
+     * mlockall() exactly this size is locked, not the default stack size.
      * @tparam F is the function called after pthread creation.
      * @param[in] context is a pointer to an object that is used to get access
      * to class methods within the pthread context.
+     * @param[in] stack_size the size of the stack, rounded up to pages.
      * @return true if the task has been created, false if the creation was
      * not successful.
      */
     template < void* F(void* context) >
-    bool create_rt_thread(void* context, TaskHandle& handle) noexcept
+    bool create_rt_thread(void* context, TaskHandle& handle,
+                          const std::size_t stack_size =
+                              OS_CONTROL::DEFAULT_STACK_SIZE) noexcept
     {
         bool created = false;
-        const auto thread_running =
-            pthread_create(&handle.m_handle, nullptr, F, context);
+        const auto page = static_cast< std::size_t >(sysconf(_SC_PAGESIZE));
+        std::size_t size = ((stack_size + page - 1U) / page) * page;
+        const auto minimum = static_cast< std::size_t >(PTHREAD_STACK_MIN);
+        size = (size < minimum) ? minimum : size;
+        TaskStack& stack = handle.m_stack;
+        stack.m_mapped = size + page;
+        stack.m_mapping =
+            mmap(nullptr, stack.m_mapped, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        pthread_attr_t attributes;
 
-        if (thread_running == 0)
+        if ((stack.m_mapping != MAP_FAILED) &&
+            (pthread_attr_init(&attributes) == 0))
         {
-            created = true;
+            stack.m_base = static_cast< std::uint8_t* >(stack.m_mapping) + page;
+            stack.m_size = size;
+            memset(stack.m_base, OS_CONTROL::STACK_PATTERN, size);
+
+            // the stack grows down, an overflow hits the guard page.
+            if (mprotect(stack.m_mapping, page, PROT_NONE) == -1)
+            {
+                std::cerr << "Protecting the stack guard page failed.\n";
+            }
+            else
+            {
+                // without the lock the thread still runs, but may fault.
+                if (mlock(stack.m_base, size) == -1)
+                {
+                    std::cerr << "Locking the stack of " << size
+                              << " bytes failed.\n";
+                }
+
+                pthread_attr_setstack(&attributes, stack.m_base, size);
+                created = (pthread_create(&handle.m_handle, &attributes, F,
+                                          context) == 0);
+            }
+
+            pthread_attr_destroy(&attributes);
         }
         else
         {
-            created = false;
+            stack.m_mapping = nullptr;
+        }
+
+        if (created == false)
+        {
+            std::cerr << "Creating the real-time thread failed.\n";
+            release_stack(stack);
         }
 
         return created;
@@ -110,6 +197,7 @@ class OSControl
 
         if (joined == 0)
         {
+            release_stack(handle.m_stack);
             closed = true;
         }
         else
@@ -128,6 +216,20 @@ class OSControl
      */
     template < int Priority, long int Period, typename T >
     void rt_task(bool& running, T& callee) noexcept
+    {
+        TaskStats stats;
+        rt_task< Priority, Period, T >(running, callee, stats);
+    }
+
+    /**
+     * @brief Same as above, sampling the statistics of every cycle.
+     * @param running
+     * @param callee
+     * @param stats collects the execution and CPU time, context switches
+     * and migrations of each cycle.
+     */
+    template < int Priority, long int Period, typename T >
+    void rt_task(bool& running, T& callee, TaskStats& stats) noexcept
     {
         struct timespec t;
         struct sched_param sched_param;
@@ -168,16 +270,13 @@ class OSControl
             return;
         }
 
-        /* Lock memory */
+        /* Lock memory, the stack has been prefaulted before. */
         if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1)
         {
             // destroy this thread if locking memory failed.
             return;
         }
 
-        /* Pre-fault our stack */
-        stack_prefault();
-
         // Write the time struct once.
         clock_gettime(CLOCK_MONOTONIC, &t);
 
@@ -191,6 +290,7 @@ class OSControl
             // @remark Use nanosleep for high precision. Uses the high
             // resolution timer.
             clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+            stats.begin_cycle(t);
 
             // The method must always be named like this!
             const auto call_ok = callee.update();
@@ -207,19 +307,81 @@ class OSControl
 
             // if the nanoseconds field exceeds 1s...
             normalize(t);
+
+            // the next wake-up is the deadline of this cycle.
+            stats.end_cycle(t);
         }
     }
 
     /**
-     * @brief tries to allocate memory within a pthread.
+     * @brief Prefaults and paints size bytes of the stack of the calling
+     * thread below the caller, for tasks that run on a thread they did not
+     * create. The frame of the caller stays live while the task runs, the
+     * frames of the functions it calls grow into the painted part.
+     * @param[out] stack describes the painted part.
+     * @param[in] size bytes to prefault, must fit the stack of the thread.
+     */
+    __attribute__((noinline)) void
+    stack_prefault(TaskStack& stack, const std::size_t size) noexcept
+    {
+        std::uint8_t* const base = static_cast< std::uint8_t* >(alloca(size));
+        memset(base, OS_CONTROL::STACK_PATTERN, size);
+        // the memory is dead when this frame returns: the barrier keeps the
+        // compiler from dropping the stores.
+        asm volatile("" : : "r"(base) : "memory");
+        stack.m_base = base;
+        stack.m_size = size;
+    }
+
+    /**
+     * @brief Measures the stack used so far: the painted bytes from the low
+     * end up to the first byte overwritten. May be called while the task
+     * runs, it only reads.
+     * @return the high-water mark in bytes, 0 if the stack is not painted.
      */
-    void stack_prefault() noexcept
+    static std::size_t get_stack_high_water(const TaskStack& stack) noexcept
     {
-        std::uint8_t stack[8 * 1024];
-        memset(stack, 0, 8 * 1024);
+        std::size_t untouched = (stack.m_base != nullptr) ? 0U : stack.m_size;
+
+        while ((untouched < stack.m_size) &&
+               (stack.m_base[untouched] == OS_CONTROL::STACK_PATTERN))
+        {
+            ++untouched;
+        }
+
+        return stack.m_size - untouched;
+    }
+
+    /**
+     * @brief Stores the high-water mark of a task that ends and warns if
+     * little of the stack was left.
+     */
+    static void report_stack(TaskStack& stack) noexcept
+    {
+        stack.m_high_water = get_stack_high_water(stack);
+
+        if ((stack.m_high_water * 100U) >
+            (stack.m_size * OS_CONTROL::STACK_WARN_PERCENT))
+        {
+            std::cerr << "Real-time task used " << stack.m_high_water
+                      << " of " << stack.m_size << " bytes of stack.\n";
+        }
     }
 
   private:
+    /**
+     * @brief Unmaps an owned stack after its thread has ended.
+     */
+    static void release_stack(TaskStack& stack) noexcept
+    {
+        if (stack.m_mapping != nullptr)
+        {
+            munmap(stack.m_mapping, stack.m_mapped);
+            stack.m_mapping = nullptr;
+            stack.m_base = nullptr;
+        }
+    }
+
     /**
      * @brief Necessary to calculate the time correctly for the next
      * nanosleep. If the field nanoseconds of structure timespec exceeds
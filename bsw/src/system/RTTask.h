@@ -50,13 +50,16 @@
  * @tparam Derived
  * @tparam Priority of this real-time task
  * @tparam PeriodMicro task period in microseconds
+ * @tparam StackSize the stack of the task in bytes, prefaulted and locked
+ * as a whole. Measure it with get_stack_high_water() to size it.
  */
-template < typename Derived, int Priority, long int PeriodMicro >
+template < typename Derived, int Priority, long int PeriodMicro,
+           std::size_t StackSize = OS_CONTROL::DEFAULT_STACK_SIZE >
 class RTTask : public OSControl
 {
   public:
     /// Get the type for giving it to the template method of OSControl.
-    using TaskType = RTTask< Derived, Priority, PeriodMicro >;
+    using TaskType = RTTask< Derived, Priority, PeriodMicro, StackSize >;
 
     /**
      * @brief Default constructor creating the real-time task.
@@ -115,6 +118,13 @@ class RTTask : public OSControl
      */
     void* task_entry() noexcept
     {
+        // a thread of its own has a painted stack already, the thread of
+        // the caller gets its stack prefaulted and painted here.
+        if (m_task_handle.m_stack.m_mapping == nullptr)
+        {
+            stack_prefault(m_task_handle.m_stack, StackSize);
+        }
+
         // before we enter the real-time task loop we will call the
         // pre-condition.
         const auto precond_ok = pre();
@@ -124,12 +134,37 @@ class RTTask : public OSControl
             // after the pre it will enter the periodic update.
             m_task_running = true;
             // calls the update method cyclically at a given rate.
-            rt_task< Priority, PeriodMicro, TaskType >(m_task_running, *this);
+            rt_task< Priority, PeriodMicro, TaskType >(m_task_running, *this,
+                                                        m_stats);
             // post-conditions after
             post();
         }
+
+        report_stack(m_task_handle.m_stack);
+        return nullptr;
+    }
+
+    /**
+     * @brief The statistics of the cycles run, see TaskStats.
+     */
+    const TaskStats& get_stats() const noexcept { return m_stats; }
+
+    /**
+     * @brief The most stack the task has used: measured now while the task
+     * runs, else the mark measured when it ended.
+     */
+    std::size_t get_stack_high_water() const noexcept
+    {
+        return m_task_running
+                   ? OSControl::get_stack_high_water(m_task_handle.m_stack)
+                   : m_task_handle.m_stack.m_high_water;
     }
 
+    /**
+     * @brief The size of the stack of the task.
+     */
+    static constexpr std::size_t get_stack_size() noexcept { return StackSize; }
+
     /**
      * @brief Helper function that calls the actual rt task,
      * @remark pthread can not handle member functions so we need this little
@@ -153,7 +188,8 @@ class RTTask : public OSControl
      */
     bool create_thread() noexcept
     {
-        return create_rt_thread< TaskType::thread_helper >(this, m_task_handle);
+        return create_rt_thread< TaskType::thread_helper >(this, m_task_handle,
+                                                           StackSize);
     }
 
     /**
@@ -167,6 +203,9 @@ class RTTask : public OSControl
     /// The handle to manage this task.
     TaskHandle m_task_handle;
 
+    /// The statistics of every cycle, sampled by the task itself.
+    TaskStats m_stats;
+
   private:
 };
 
@@ -175,8 +214,9 @@ class RTTask : public OSControl
  * Each thread can has only one task, but may spawn other threads which also
  * have their real-time tasks.
  */
-template < typename Derived, int Priority, int PeriodMicro >
-class RTThread : public RTTask< Derived, Priority, PeriodMicro >
+template < typename Derived, int Priority, int PeriodMicro,
+           std::size_t StackSize = OS_CONTROL::DEFAULT_STACK_SIZE >
+class RTThread : public RTTask< Derived, Priority, PeriodMicro, StackSize >
 {
   public:
     /**
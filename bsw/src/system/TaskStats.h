@@ -0,0 +1,313 @@
+/**
+ * @file      TaskStats.h
+ * @author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * @brief     Per-cycle statistics of a real-time task.
+ * @details   Separates the time a task computes from the time it was preempted or
+ *            blocked, and counts context switches and CPU migrations.
+ * @version   1.0
+ * @copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TASKSTATS_H_
+#define TASKSTATS_H_
+
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sched.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/**
+ * \brief TaskStats is sampled by the task itself at the begin and end of
+ * every cycle. Per cycle it takes two clock reads at the begin and two
+ * clock reads, one getrusage() and one sched_getcpu() at the end.
+ * The difference between the execution time (wall clock) and the CPU time
+ * of update() is the interference: the time the task was runnable but
+ * preempted, or blocked. Context switches are counted over the whole cycle:
+ * one voluntary switch per cycle is the sleep until the next period.
+ * \remarks Read the statistics after the task has stopped, they are written
+ * without synchronization.
+ */
+class TaskStats
+{
+  public:
+    /**
+     * \brief Default constructor, the statistics are empty.
+     */
+    TaskStats() noexcept { clear(); }
+
+    /**
+     * \brief Called by the task when it has woken up for a cycle.
+     * \param[in] planned the time it should have woken up (CLOCK_MONOTONIC).
+     */
+    void begin_cycle(const struct timespec& planned) noexcept
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start_);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start_cpu_);
+
+        if (started_ == false)
+        {
+            // the switches before the first cycle do not count.
+            struct rusage usage;
+            getrusage(RUSAGE_THREAD, &usage);
+            voluntary_base_ = usage.ru_nvcsw;
+            involuntary_base_ = usage.ru_nivcsw;
+            last_cpu_ = sched_getcpu();
+            started_ = true;
+        }
+
+        wake_up_.add(difference(start_, planned));
+    }
+
+    /**
+     * \brief Called by the task when update() has returned.
+     * \param[in] deadline the end of the period (CLOCK_MONOTONIC).
+     */
+    void end_cycle(const struct timespec& deadline) noexcept
+    {
+        struct timespec end;
+        struct timespec end_cpu;
+        struct rusage usage;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end_cpu);
+        getrusage(RUSAGE_THREAD, &usage);
+        const int cpu = sched_getcpu();
+
+        const std::chrono::nanoseconds wall = difference(end, start_);
+        const std::chrono::nanoseconds used = difference(end_cpu, start_cpu_);
+        execution_.add(wall);
+        cpu_time_.add(used);
+        interference_.add(wall - used);
+
+        const long involuntary = usage.ru_nivcsw - involuntary_base_;
+        voluntary_ += static_cast< std::uint64_t >(usage.ru_nvcsw -
+                                                   voluntary_base_);
+        involuntary_ += static_cast< std::uint64_t >(involuntary);
+        voluntary_base_ = usage.ru_nvcsw;
+        involuntary_base_ = usage.ru_nivcsw;
+
+        if (involuntary > 0)
+        {
+            ++preempted_cycles_;
+        }
+
+        if (cpu != last_cpu_)
+        {
+            ++migrations_;
+            last_cpu_ = cpu;
+        }
+
+        if (difference(end, deadline).count() > 0)
+        {
+            ++overruns_;
+        }
+
+        ++cycles_;
+    }
+
+    /**
+     * \brief Removes all samples.
+     */
+    void clear() noexcept
+    {
+        wake_up_.clear();
+        execution_.clear();
+        cpu_time_.clear();
+        interference_.clear();
+        start_ = timespec{0, 0};
+        start_cpu_ = timespec{0, 0};
+        started_ = false;
+        voluntary_base_ = 0;
+        involuntary_base_ = 0;
+        last_cpu_ = -1;
+        cycles_ = 0U;
+        voluntary_ = 0U;
+        involuntary_ = 0U;
+        preempted_cycles_ = 0U;
+        migrations_ = 0U;
+        overruns_ = 0U;
+    }
+
+    /**
+     * \brief Time from the planned wake-up until the task ran.
+     */
+    const LatencyHistogram& get_wake_up() const noexcept { return wake_up_; }
+
+    /**
+     * \brief Wall-clock time of update().
+     */
+    const LatencyHistogram& get_execution() const noexcept
+    {
+        return execution_;
+    }
+
+    /**
+     * \brief CPU time of update().
+     */
+    const LatencyHistogram& get_cpu_time() const noexcept { return cpu_time_; }
+
+    /**
+     * \brief Execution minus CPU time: preempted or blocked in update().
+     */
+    const LatencyHistogram& get_interference() const noexcept
+    {
+        return interference_;
+    }
+
+    /**
+     * \brief Number of cycles.
+     */
+    std::uint64_t get_cycles() const noexcept { return cycles_; }
+
+    /**
+     * \brief Voluntary context switches: sleeps and blocking calls.
+     */
+    std::uint64_t get_voluntary_switches() const noexcept
+    {
+        return voluntary_;
+    }
+
+    /**
+     * \brief Involuntary context switches: the task was preempted.
+     */
+    std::uint64_t get_involuntary_switches() const noexcept
+    {
+        return involuntary_;
+    }
+
+    /**
+     * \brief Number of cycles with at least one preemption.
+     */
+    std::uint64_t get_preempted_cycles() const noexcept
+    {
+        return preempted_cycles_;
+    }
+
+    /**
+     * \brief Number of times the task ran on another CPU than before.
+     */
+    std::uint64_t get_migrations() const noexcept { return migrations_; }
+
+    /**
+     * \brief Number of cycles update() ended after the end of the period.
+     */
+    std::uint64_t get_overruns() const noexcept { return overruns_; }
+
+    /**
+     * \brief The CPU the last cycle ended on, -1 before the first cycle.
+     */
+    int get_last_cpu() const noexcept { return last_cpu_; }
+
+    /**
+     * \brief Prints all statistics.
+     * \param[in] out the stream to print to.
+     */
+    void print(std::ostream& out) const noexcept
+    {
+        out << "cycles=" << cycles_ << " overruns=" << overruns_
+            << " migrations=" << migrations_ << " cpu=" << last_cpu_
+            << "\nswitches voluntary=" << voluntary_
+            << " involuntary=" << involuntary_
+            << " preempted cycles=" << preempted_cycles_ << "\nwake-up: ";
+        wake_up_.print(out);
+        out << "execution: ";
+        execution_.print(out);
+        out << "cpu time: ";
+        cpu_time_.print(out);
+        out << "interference: ";
+        interference_.print(out);
+    }
+
+  private:
+    /**
+     * \brief The time from b to a.
+     */
+    static std::chrono::nanoseconds difference(const struct timespec& a,
+                                               const struct timespec& b)
+        noexcept
+    {
+        return std::chrono::seconds{a.tv_sec - b.tv_sec} +
+               std::chrono::nanoseconds{a.tv_nsec - b.tv_nsec};
+    }
+
+    /// time from the planned wake-up until the task ran.
+    LatencyHistogram wake_up_;
+
+    /// wall-clock time of update().
+    LatencyHistogram execution_;
+
+    /// CPU time of update().
+    LatencyHistogram cpu_time_;
+
+    /// execution minus CPU time of update().
+    LatencyHistogram interference_;
+
+    /// wall-clock time the current cycle began.
+    struct timespec start_;
+
+    /// CPU time the current cycle began.
+    struct timespec start_cpu_;
+
+    /// true once the first cycle began.
+    bool started_;
+
+    /// voluntary switches at the end of the last cycle.
+    long voluntary_base_;
+
+    /// involuntary switches at the end of the last cycle.
+    long involuntary_base_;
+
+    /// the CPU the last cycle ended on.
+    int last_cpu_;
+
+    /// number of cycles.
+    std::uint64_t cycles_;
+
+    /// voluntary context switches.
+    std::uint64_t voluntary_;
+
+    /// involuntary context switches.
+    std::uint64_t involuntary_;
+
+    /// cycles with at least one preemption.
+    std::uint64_t preempted_cycles_;
+
+    /// number of CPU migrations.
+    std::uint64_t migrations_;
+
+    /// number of cycles that ended after their deadline.
+    std::uint64_t overruns_;
+};
+
+#endif /* TASKSTATS_H_ */
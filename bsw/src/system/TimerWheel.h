@@ -0,0 +1,243 @@
+/**
+ * @file      TimerWheel.h
+ * @author    dtuchscherer <daniel.tuchscherer@gmail.com>
+ * @brief     Hashed timer wheel with preallocated timers.
+ * @details   Schedules and expires timers in constant time per timer without
+ *            allocating memory after construction.
+ * @version   1.0
+ * @copyright Copyright (c) 2018, dtuchscherer.
+ *            All rights reserved.
+ *
+ *            Redistributions and use in source and binary forms, with
+ *            or without modifications, are permitted provided that the
+ *            following conditions are met: Redistributions of source code must
+ *            retain the above copyright notice, this list of conditions and the
+ *            following disclaimer.
+ *
+ *            Redistributions in binary form must reproduce the above copyright
+ *            notice, this list of conditions and the following disclaimer in
+ *            the documentation and/or other materials provided with the
+ *            distribution.
+ *
+ *            Neither the name of the Heilbronn University nor the name of its
+ *            contributors may be used to endorse or promote products derived
+ *            from this software without specific prior written permission.
+ *
+ *            THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS”
+ *            AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *            TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *            PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS
+ *            OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *            SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *            LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *            USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *            AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *            LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *            ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *            POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+/**
+ * \brief TimerWheel expires timers on ticks. Each slot of the wheel holds the
+ * timers of the ticks that map to it, a timer more than Slots ticks ahead
+ * stays in its slot for more rounds. Timers of the same tick expire in the
+ * order they were scheduled.
+ * \tparam Slots number of slots, the ticks of one round.
+ * \tparam Capacity number of timers that may be scheduled at once.
+ */
+template < std::size_t Slots, std::size_t Capacity > class TimerWheel
+{
+  public:
+    /**
+     * \brief Default constructor, the wheel is empty and at tick 0.
+     */
+    TimerWheel() noexcept : current_{0U}, free_{0U}, size_{0U}
+    {
+        heads_.fill(NONE);
+        tails_.fill(NONE);
+
+        // all timers are free.
+        for (std::uint32_t i = 0U; i < Capacity; ++i)
+        {
+            timers_[i].next = (i + 1U < Capacity) ? (i + 1U) : NONE;
+        }
+    }
+
+    /**
+     * \brief Schedules a timer. A tick already passed expires on the next
+     * advance(), also if a handler of advance() schedules it.
+     * \param[in] tick the tick the timer expires at.
+     * \param[in] id given to the handler of advance().
+     * \return false if all timers are in use.
+     */
+    bool schedule(std::uint64_t tick, const std::uint32_t id) noexcept
+    {
+        bool scheduled = false;
+
+        if (free_ != NONE)
+        {
+            tick = (tick < current_) ? current_ : tick;
+            const std::uint32_t index = free_;
+            Timer& timer = timers_[index];
+            free_ = timer.next;
+            timer.tick = tick;
+            timer.id = id;
+            timer.next = NONE;
+
+            // appended, so timers of one tick keep their order.
+            const std::size_t slot = tick % Slots;
+            if (tails_[slot] == NONE)
+            {
+                heads_[slot] = index;
+            }
+            else
+            {
+                timers_[tails_[slot]].next = index;
+            }
+            tails_[slot] = index;
+            ++size_;
+            scheduled = true;
+        }
+
+        return scheduled;
+    }
+
+    /**
+     * \brief Expires all timers up to the given tick.
+     * \param[in] now the current tick.
+     * \param[in] handler called as handler(id) for every expired timer. It
+     * may schedule new timers.
+     * \return the number of expired timers.
+     */
+    template < typename Handler >
+    std::size_t advance(const std::uint64_t now, Handler&& handler) noexcept
+    {
+        std::size_t expired = 0U;
+        std::size_t visited = 0U;
+        const std::uint64_t first = current_;
+
+        // moved on first: a handler that schedules a passed tick gets now + 1,
+        // so the timer does not expire again in this walk.
+        current_ = (now >= current_) ? (now + 1U) : current_;
+
+        // every slot is visited at most once, even after a long pause.
+        for (std::uint64_t tick = first;
+             (tick <= now) && (visited < Slots) && (size_ > 0U);
+             ++tick, ++visited)
+        {
+            expired += expire_slot(tick % Slots, now,
+                                   std::forward< Handler >(handler));
+        }
+
+        return expired;
+    }
+
+    /**
+     * \brief The next tick advance() looks at.
+     */
+    std::uint64_t get_current_tick() const noexcept { return current_; }
+
+    /**
+     * \brief Number of scheduled timers.
+     */
+    std::size_t get_size() const noexcept { return size_; }
+
+    /**
+     * \brief true if no timer is scheduled.
+     */
+    bool is_empty() const noexcept { return size_ == 0U; }
+
+  private:
+    /// marks the end of a list.
+    static constexpr std::uint32_t NONE{0xFFFFFFFFU};
+
+    /**
+     * \brief A timer in the list of a slot or in the free list.
+     */
+    struct Timer
+    {
+        std::uint64_t tick;
+        std::uint32_t id;
+        std::uint32_t next;
+    };
+
+    /**
+     * \brief Expires the timers of one slot that are due.
+     */
+    template < typename Handler >
+    std::size_t expire_slot(const std::size_t slot, const std::uint64_t now,
+                            Handler&& handler) noexcept
+    {
+        std::size_t expired = 0U;
+        std::uint32_t previous = NONE;
+        std::uint32_t index = heads_[slot];
+
+        while (index != NONE)
+        {
+            Timer& timer = timers_[index];
+            const std::uint32_t next = timer.next;
+
+            if (timer.tick <= now)
+            {
+                // unlinked and freed before the handler may schedule again.
+                if (previous == NONE)
+                {
+                    heads_[slot] = next;
+                }
+                else
+                {
+                    timers_[previous].next = next;
+                }
+                if (tails_[slot] == index)
+                {
+                    tails_[slot] = previous;
+                }
+                const std::uint32_t id = timer.id;
+                timer.next = free_;
+                free_ = index;
+                --size_;
+                ++expired;
+                handler(id);
+            }
+            else
+            {
+                // a timer of a later round.
+                previous = index;
+            }
+
+            index = next;
+        }
+
+        return expired;
+    }
+
+    /// the timers.
+    std::array< Timer, Capacity > timers_;
+
+    /// first timer of each slot.
+    std::array< std::uint32_t, Slots > heads_;
+
+    /// last timer of each slot.
+    std::array< std::uint32_t, Slots > tails_;
+
+    /// the next tick to expire.
+    std::uint64_t current_;
+
+    /// first free timer.
+    std::uint32_t free_;
+
+    /// number of scheduled timers.
+    std::size_t size_;
+};
+
+template < std::size_t Slots, std::size_t Capacity >
+constexpr std::uint32_t TimerWheel< Slots, Capacity >::NONE;
+
+#endif /* TIMERWHEEL_H_ */
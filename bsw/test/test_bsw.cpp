@@ -1,6 +1,40 @@
+#include "AesCmac.h"
+#include "ByteRing.h"
+#include "CanContainer.h"
+#include "CanLogReader.h"
+#include "CanSchedule.h"
 #include "CanSocket.h"
+#include "CanTxConfirmation.h"
+#include "EndpointResolver.h"
+#include "EventLoop.h"
+#include "Gorilla.h"
+#include "HugePageBuffer.h"
+#include "ImpairmentProxy.h"
+#include "LatencyHistogram.h"
+#include "LoadGenerator.h"
+#include "LoopbackSocket.h"
+#include "MdfReader.h"
+#include "MdfWriter.h"
+#include "PacketBatch.h"
+#include "PacketBits.h"
+#include "RTTask.h"
+#include "RawEthSocket.h"
+#include "SecOc.h"
 #include "Socket.h"
+#include "TaskStats.h"
+#include "TcpClient.h"
+#include "TcpMux.h"
+#include "TcpServer.h"
+#include "TcpTxTimestamps.h"
+#include "TimerWheel.h"
+#include "TokenBucket.h"
+#include "TxTime.h"
+#include "UdpSocket.h"
+#include "XdpSocket.h"
+#include <cstdlib>
 #include <gtest/gtest.h>
+#include <sstream>
+#include <unistd.h>
 
 TEST(Sockets, CreateSocket)
 {
@@ -52,6 +86,1709 @@ TEST(Sockets, SocketCanSendAndReceive)
     EXPECT_TRUE(can1.set_blocking(true));
 }
 
+TEST(Sockets, CanBusyPoll)
+{
+    using namespace std::chrono_literals;
+    CanSocket can{"vcan0"};
+    CanSocket can1{"vcan0"};
+    struct canfd_frame frame
+    {
+    };
+    frame.can_id = 0x07U;
+    frame.len = 8U;
+
+    EXPECT_TRUE(can1.set_receive_mode(CanReceiveMode::BUSY_POLL));
+    EXPECT_FALSE(can1.is_blocking());
+    EXPECT_EQ(can.send(frame, CAN_STD::MTU), 16);
+    EXPECT_EQ(can1.receive(frame), 16);
+    EXPECT_EQ(can1.get_poll_stats().spin_frames, 1U);
+
+    // nothing is sent for a while: the adaptive receive blocks.
+    EXPECT_TRUE(can1.set_receive_mode(CanReceiveMode::ADAPTIVE, 100us));
+    std::thread late_sender([&can, &frame]() {
+        std::this_thread::sleep_for(10ms);
+        can.send(frame, CAN_STD::MTU);
+    });
+    EXPECT_EQ(can1.receive(frame), 16);
+    late_sender.join();
+    EXPECT_EQ(can1.get_poll_stats().blocked_frames, 1U);
+    EXPECT_GE(can1.get_poll_stats().spin_time, 100us);
+    EXPECT_LT(can1.get_poll_stats().spin_time, 10ms);
+
+    EXPECT_TRUE(can1.set_receive_mode(CanReceiveMode::BLOCKING));
+    EXPECT_TRUE(can1.is_blocking());
+}
+
+TEST(Sockets, CanScheduleTable)
+{
+    using namespace std::chrono_literals;
+    constexpr std::array< CanScheduleEntry, 3U > TABLE{{
+        {500us, 0x20U, 8U, nullptr, nullptr},
+        {0us, 0x10U, 8U, nullptr, nullptr},
+        {500us, 0x21U, 4U, nullptr, nullptr},
+    }};
+    CanSchedule schedule{1000us, TABLE};
+
+    // sorted by offset, the same offset keeps the order of the table.
+    ASSERT_EQ(schedule.get_count(), 3U);
+    EXPECT_EQ(schedule.get_entry(0U).can_id, 0x10U);
+    EXPECT_EQ(schedule.get_entry(1U).can_id, 0x20U);
+    EXPECT_EQ(schedule.get_entry(2U).can_id, 0x21U);
+
+    EXPECT_FALSE(schedule.add({1000us, 0x30U, 8U, nullptr, nullptr}));
+    EXPECT_FALSE(schedule.add({100us, 0x30U, 65U, nullptr, nullptr}));
+    EXPECT_TRUE(schedule.add({100us, 0x30U, 8U, nullptr, nullptr}));
+    EXPECT_EQ(schedule.get_entry(1U).can_id, 0x30U);
+}
+
+TEST(Sockets, CanSchedule)
+{
+    using namespace std::chrono_literals;
+    CanSocket can{"vcan0"};
+    CanSocket can1{"vcan0"};
+    std::uint8_t counter{0U};
+    CanSchedule schedule{2000us};
+    schedule.add({1000us, 0x20U, 1U,
+                  [](void* context, struct canfd_frame& frame) {
+                      frame.data[0] = ++*static_cast< std::uint8_t* >(context);
+                  },
+                  &counter});
+    schedule.add({0us, 0x10U, 8U, nullptr, nullptr});
+    schedule.add({0us, 0x11U, 8U, nullptr, nullptr});
+    schedule.add({1500us, 0x30U, 12U, nullptr, nullptr});
+
+    for (int cycle = 0; cycle < 3; ++cycle)
+    {
+        EXPECT_TRUE(schedule.run_cycle(can));
+    }
+
+    // the frames arrive in the order of the slots, cycle by cycle. Up to 8
+    // bytes go on the bus as standard frames.
+    constexpr int standard{CAN_MTU};
+    constexpr int fd{CANFD_MTU};
+
+    for (std::uint8_t cycle = 1U; cycle <= 3U; ++cycle)
+    {
+        struct canfd_frame frame
+        {
+        };
+        EXPECT_EQ(can1.receive(frame), standard);
+        EXPECT_EQ(frame.can_id, 0x10U);
+        EXPECT_EQ(can1.receive(frame), standard);
+        EXPECT_EQ(frame.can_id, 0x11U);
+        EXPECT_EQ(can1.receive(frame), standard);
+        EXPECT_EQ(frame.can_id, 0x20U);
+        EXPECT_EQ(frame.len, 1U);
+        EXPECT_EQ(frame.data[0], cycle);
+        EXPECT_EQ(can1.receive(frame), fd);
+        EXPECT_EQ(frame.can_id, 0x30U);
+        EXPECT_EQ(frame.len, 12U);
+    }
+
+    EXPECT_EQ(schedule.get_cycles(), 3U);
+    EXPECT_EQ(schedule.get_timing_error(2U).get_count(), 3U);
+    EXPECT_LT(schedule.get_timing_error(2U).get_max(), 2000us);
+}
+
+TEST(Sockets, CanContainerUnpack)
+{
+    // two PDUs, followed by zero padding up to the next CAN FD length.
+    const std::array< std::uint8_t, 16U > container{
+        0x00U, 0x01U, 0x23U, 2U, 0xAAU, 0xBBU, 0x00U, 0x00U,
+        0x04U, 1U,    0xCCU, 0U, 0U,    0U,    0U,    0U};
+    std::array< CanIDType, 2U > ids{};
+    std::array< std::uint8_t, 2U > lens{};
+    std::size_t calls{0U};
+
+    const auto unpacked = CanContainerRx::unpack(
+        container.data(), container.size(),
+        [&](CanIDType id, const std::uint8_t* data, std::uint8_t len) {
+            ids[calls] = id;
+            lens[calls] = len;
+            EXPECT_EQ(data[0], (calls == 0U) ? 0xAAU : 0xCCU);
+            ++calls;
+        });
+
+    EXPECT_EQ(unpacked, 2);
+    EXPECT_EQ(ids[0], 0x0123U);
+    EXPECT_EQ(lens[0], 2U);
+    EXPECT_EQ(ids[1], 0x04U);
+    EXPECT_EQ(lens[1], 1U);
+
+    // length field pointing behind the end of the frame.
+    const std::array< std::uint8_t, 6U > malformed{0U, 0U, 1U, 8U, 0U, 0U};
+    const auto bad = CanContainerRx::unpack(
+        malformed.data(), malformed.size(),
+        [](CanIDType, const std::uint8_t*, std::uint8_t) {});
+    EXPECT_EQ(bad, -1);
+    EXPECT_EQ(canfd_padded_len(9U), 12U);
+    EXPECT_EQ(canfd_padded_len(33U), 48U);
+}
+
+TEST(Sockets, CanFrameFlags)
+{
+    struct canfd_frame frame
+    {
+    };
+    frame.can_id = 0x12345678U | CAN_EFF_FLAG;
+    frame.flags = CANFD_BRS;
+    EXPECT_TRUE(can_is_eff(frame));
+    EXPECT_FALSE(can_is_rtr(frame));
+    EXPECT_FALSE(can_is_err(frame));
+    EXPECT_EQ(can_get_id(frame), 0x12345678U);
+    EXPECT_TRUE(canfd_is_brs(frame));
+    EXPECT_FALSE(canfd_is_esi(frame));
+
+    frame.can_id = 0x7FFU | CAN_RTR_FLAG;
+    EXPECT_FALSE(can_is_eff(frame));
+    EXPECT_TRUE(can_is_rtr(frame));
+    EXPECT_EQ(can_get_id(frame), 0x7FFU);
+
+    // up to 8 bytes without FD flags is a standard frame.
+    frame.len = 8U;
+    EXPECT_EQ(can_get_mtu(frame), CAN_FD::MTU);
+    frame.flags = 0U;
+    EXPECT_EQ(can_get_mtu(frame), CAN_STD::MTU);
+    frame.flags = CANFD_FDF;
+    EXPECT_EQ(can_get_mtu(frame), CAN_FD::MTU);
+    frame.flags = 0U;
+    frame.len = 12U;
+    EXPECT_EQ(can_get_mtu(frame), CAN_FD::MTU);
+}
+
+#ifdef CANXL_MTU
+TEST(Sockets, CanXLFrame)
+{
+    CanXLFrame frame{};
+    frame.prio = 0x123U;
+    EXPECT_FALSE(canxl_is_xl(frame));
+    frame.flags = CANXL_XLF;
+    EXPECT_TRUE(canxl_is_xl(frame));
+
+    // the VCID leaves the priority as it is.
+    canxl_set_vcid(frame, 0xA5U);
+    EXPECT_EQ(canxl_get_vcid(frame), 0xA5U);
+    EXPECT_EQ(frame.prio & CANXL_PRIO_MASK, 0x123U);
+    canxl_set_vcid(frame, 0x01U);
+    EXPECT_EQ(canxl_get_vcid(frame), 0x01U);
+    EXPECT_EQ(frame.prio, 0x10123U);
+
+    // lengths out of range are rejected before anything is written.
+    CanSocket can{"vcan0"};
+    frame.len = 0U;
+    EXPECT_EQ(can.send(frame), -1);
+    EXPECT_EQ(can.get_last_error(), EINVAL);
+    frame.len = CAN_XL::DATA_LEN + 1U;
+    can.SetErrorNumber(0);
+    EXPECT_EQ(can.send(frame), -1);
+    EXPECT_EQ(can.get_last_error(), EINVAL);
+    frame.len = 8U;
+    frame.flags = 0U;
+    can.SetErrorNumber(0);
+    EXPECT_EQ(can.send(frame), -1);
+    EXPECT_EQ(can.get_last_error(), EINVAL);
+}
+#endif
+
+TEST(System, LatencyHistogram)
+{
+    using namespace std::chrono_literals;
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.get_count(), 0U);
+    EXPECT_EQ(histogram.get_mean().count(), 0);
+
+    histogram.add(0ns);
+    histogram.add(3ns);
+    histogram.add(1000ns);
+    histogram.add(-5ns);
+    EXPECT_EQ(histogram.get_count(), 4U);
+    EXPECT_EQ(histogram.get_bucket(0U), 2U);
+    EXPECT_EQ(histogram.get_bucket(1U), 1U);
+    EXPECT_EQ(histogram.get_bucket(9U), 1U);
+    EXPECT_EQ(histogram.get_min().count(), 0);
+    EXPECT_EQ(histogram.get_max().count(), 1000);
+    EXPECT_EQ(histogram.get_mean().count(), 250);
+    EXPECT_EQ(histogram.get_percentile(50.0).count(), 1);
+    EXPECT_EQ(histogram.get_percentile(100.0).count(), 1000);
+
+    // everything above one second ends up in the last bucket.
+    histogram.add(10s);
+    EXPECT_EQ(histogram.get_bucket(LatencyHistogram::BUCKETS - 1U), 1U);
+    EXPECT_EQ(histogram.get_percentile(100.0), 10s);
+    std::ostringstream printed;
+    histogram.print(printed);
+    EXPECT_NE(printed.str().find(">= 1073741824ns: 1"), std::string::npos);
+
+    histogram.clear();
+    EXPECT_EQ(histogram.get_count(), 0U);
+}
+
+TEST(Sockets, CanTxTracker)
+{
+    using namespace std::chrono_literals;
+    CanTxTracker tracker;
+    struct canfd_frame frame{};
+    frame.can_id = 0x123U;
+    frame.len = 8U;
+
+    // two frames of one ID are confirmed in the order they were sent.
+    tracker.add(frame, timespec{10, 0});
+    tracker.add(frame, timespec{10, 500000});
+    EXPECT_EQ(tracker.get_in_flight(), 2U);
+    std::chrono::nanoseconds latency{0};
+    EXPECT_TRUE(tracker.match(frame, timespec{10, 900000}, latency));
+    EXPECT_EQ(latency, 900us);
+    EXPECT_TRUE(tracker.match(frame, timespec{11, 0}, latency));
+    EXPECT_EQ(latency, 999500us);
+    ASSERT_NE(tracker.get_histogram(0x123U), nullptr);
+    EXPECT_EQ(tracker.get_histogram(0x123U)->get_count(), 2U);
+    EXPECT_EQ(tracker.get_histogram(0x124U), nullptr);
+
+    // another ID or length, or nothing in flight: unmatched.
+    tracker.add(frame, timespec{12, 0});
+    frame.len = 4U;
+    EXPECT_FALSE(tracker.match(frame, timespec{12, 1000}, latency));
+    frame.len = 8U;
+    frame.can_id = 0x124U;
+    EXPECT_FALSE(tracker.match(frame, timespec{12, 1000}, latency));
+    frame.can_id = 0x123U;
+    EXPECT_TRUE(tracker.match(frame, timespec{12, 1000}, latency));
+    EXPECT_FALSE(tracker.match(frame, timespec{12, 2000}, latency));
+    EXPECT_EQ(tracker.get_unmatched(), 3U);
+    EXPECT_EQ(tracker.get_in_flight(), 0U);
+
+    // a full table drops the oldest frame, which is counted as lost.
+    for (std::uint32_t i = 0U; i <= CAN_TX_CONFIRMATION::MAX_IN_FLIGHT; ++i)
+    {
+        frame.can_id = 0x200U + i;
+        tracker.add(frame, timespec{20, static_cast< long >(i)});
+    }
+    EXPECT_EQ(tracker.get_lost(), 1U);
+    EXPECT_EQ(tracker.get_in_flight(), CAN_TX_CONFIRMATION::MAX_IN_FLIGHT);
+    frame.can_id = 0x200U;
+    EXPECT_FALSE(tracker.match(frame, timespec{21, 0}, latency));
+    frame.can_id = 0x201U;
+    EXPECT_TRUE(tracker.match(frame, timespec{21, 0}, latency));
+}
+
+TEST(System, TaskStats)
+{
+    using namespace std::chrono_literals;
+    TaskStats stats;
+    struct timespec planned;
+    clock_gettime(CLOCK_MONOTONIC, &planned);
+    struct timespec deadline = planned;
+    deadline.tv_sec += 1;
+
+    // computes until it used 2 ms of CPU time, however long it is preempted.
+    stats.begin_cycle(planned);
+    struct timespec cpu;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    const auto busy_until = std::chrono::seconds{cpu.tv_sec} +
+                            std::chrono::nanoseconds{cpu.tv_nsec} + 2ms;
+    while ((std::chrono::seconds{cpu.tv_sec} +
+            std::chrono::nanoseconds{cpu.tv_nsec}) < busy_until)
+    {
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    }
+    stats.end_cycle(deadline);
+
+    // sleeps for 2 ms: no CPU time, a voluntary switch and an overrun.
+    stats.begin_cycle(planned);
+    std::this_thread::sleep_for(2ms);
+    stats.end_cycle(planned);
+
+    EXPECT_EQ(stats.get_cycles(), 2U);
+    EXPECT_EQ(stats.get_overruns(), 1U);
+    EXPECT_GE(stats.get_execution().get_min(), 2ms);
+    EXPECT_GE(stats.get_cpu_time().get_max(), 2ms);
+    EXPECT_LE(stats.get_cpu_time().get_max(), stats.get_execution().get_max());
+    EXPECT_LT(stats.get_cpu_time().get_min(), 1ms);
+    EXPECT_GE(stats.get_interference().get_max(), 1ms);
+    EXPECT_GE(stats.get_voluntary_switches(), 1U);
+    EXPECT_GE(stats.get_last_cpu(), 0);
+}
+
+/**
+ * \brief Uses 20 KiB of stack in pre() and ends there.
+ */
+class StackTask : public RTTask< StackTask, 10, 1000, 64U * 1024U >
+{
+  public:
+    bool start() noexcept { return create_thread(); }
+    bool join() noexcept { return close_thread(); }
+
+    bool pre() noexcept
+    {
+        volatile std::uint8_t buffer[20U * 1024U];
+        buffer[0] = 1U;
+        return buffer[0] == 0U;
+    }
+
+    bool update() noexcept { return false; }
+    void post() noexcept {}
+};
+
+TEST(System, RTTaskStack)
+{
+    // a thread of its own on a painted stack.
+    StackTask task;
+    ASSERT_TRUE(task.start());
+    ASSERT_TRUE(task.join());
+    EXPECT_GE(task.get_stack_high_water(), 16U * 1024U);
+    EXPECT_LT(task.get_stack_high_water(), StackTask::get_stack_size());
+
+    // the thread of the caller, painted by the prefault.
+    StackTask caller;
+    caller.task_entry();
+    EXPECT_GE(caller.get_stack_high_water(), 16U * 1024U);
+    EXPECT_LT(caller.get_stack_high_water(), StackTask::get_stack_size());
+}
+
+TEST(System, TimerWheel)
+{
+    TimerWheel< 8U, 4U > wheel;
+    std::array< std::uint32_t, 4U > expired{};
+    std::size_t count = 0U;
+    const auto collect = [&expired, &count](const std::uint32_t id) {
+        expired[count++] = id;
+    };
+
+    EXPECT_TRUE(wheel.schedule(3U, 1U));
+    EXPECT_TRUE(wheel.schedule(3U, 2U));
+    EXPECT_TRUE(wheel.schedule(1U, 3U));
+    // tick 11 maps to the slot of tick 3, but is one round later.
+    EXPECT_TRUE(wheel.schedule(11U, 4U));
+    EXPECT_FALSE(wheel.schedule(5U, 5U));
+    EXPECT_EQ(wheel.get_size(), 4U);
+
+    EXPECT_EQ(wheel.advance(0U, collect), 0U);
+    EXPECT_EQ(wheel.advance(4U, collect), 3U);
+    EXPECT_EQ(expired[0], 3U);
+    EXPECT_EQ(expired[1], 1U);
+    EXPECT_EQ(expired[2], 2U);
+
+    // a tick already passed expires on the next advance.
+    EXPECT_TRUE(wheel.schedule(2U, 6U));
+    EXPECT_EQ(wheel.advance(10U, collect), 1U);
+    EXPECT_EQ(expired[3], 6U);
+    count = 0U;
+    EXPECT_EQ(wheel.advance(100U, collect), 1U);
+    EXPECT_EQ(expired[0], 4U);
+    EXPECT_TRUE(wheel.is_empty());
+
+    // a handler that schedules a passed tick again expires once per advance.
+    std::size_t calls = 0U;
+    const auto reschedule = [&wheel, &calls](const std::uint32_t id) {
+        ++calls;
+        EXPECT_TRUE(wheel.schedule(0U, id));
+    };
+    EXPECT_TRUE(wheel.schedule(101U, 7U));
+    EXPECT_TRUE(wheel.schedule(101U, 8U));
+    EXPECT_EQ(wheel.advance(104U, reschedule), 2U);
+    EXPECT_EQ(calls, 2U);
+    EXPECT_EQ(wheel.get_size(), 2U);
+    EXPECT_EQ(wheel.advance(105U, reschedule), 2U);
+    EXPECT_EQ(calls, 4U);
+    EXPECT_EQ(wheel.advance(105U, collect), 0U);
+    EXPECT_EQ(wheel.advance(106U, collect), 2U);
+    EXPECT_TRUE(wheel.is_empty());
+}
+
+TEST(Sockets, ByteRing)
+{
+    ByteRing< 8U > ring;
+    std::array< std::uint8_t, 8U > out{};
+    const std::array< std::uint8_t, 6U > in{{1U, 2U, 3U, 4U, 5U, 6U}};
+    EXPECT_EQ(ring.get_free(), 8U);
+    EXPECT_EQ(ring.write(in.data(), in.size()), 6U);
+    EXPECT_EQ(ring.read(out.data(), 4U), 4U);
+    EXPECT_EQ(out[3], 4U);
+
+    // the second write wraps around the end of the buffer.
+    EXPECT_EQ(ring.write(in.data(), in.size()), 6U);
+    EXPECT_EQ(ring.write(in.data(), in.size()), 0U);
+    EXPECT_EQ(ring.peek(out.data(), out.size()), 8U);
+    EXPECT_EQ(ring.get_used(), 8U);
+    EXPECT_EQ(ring.skip(2U), 2U);
+    EXPECT_EQ(ring.read(out.data(), out.size()), 6U);
+    EXPECT_EQ(out[0], 1U);
+    EXPECT_EQ(out[5], 6U);
+    EXPECT_EQ(ring.get_used(), 0U);
+}
+
+TEST(Sockets, TcpMux)
+{
+    TcpServer server;
+    TcpClient client;
+    ASSERT_TRUE(server.reuse_addr());
+    ASSERT_TRUE(server.listen(IpAddress{"127.0.0.1"}, 5708U));
+    ASSERT_TRUE(client.connect(IpAddress{"127.0.0.1"}, 5708U));
+    ASSERT_TRUE(server.accept());
+    TcpMux sender{client};
+    TcpMux receiver{server.m_data};
+    const auto poll = [&sender, &receiver]() {
+        for (int i = 0; i < 20; ++i)
+        {
+            ASSERT_TRUE(sender.poll());
+            ASSERT_TRUE(receiver.poll());
+        }
+    };
+
+    // each stream gets its own data.
+    const std::array< std::uint8_t, 4U > ping{{'p', 'i', 'n', 'g'}};
+    std::array< std::uint8_t, 600U > bulk;
+    for (std::size_t i = 0U; i < bulk.size(); ++i)
+    {
+        bulk[i] = static_cast< std::uint8_t >(i % 251U);
+    }
+    EXPECT_EQ(sender.get_stream(1U).send(bulk.data(), 600U), 600);
+    EXPECT_EQ(sender.get_stream(0U).send(ping.data(), 4U), 4);
+    poll();
+    std::array< std::uint8_t, 600U > in{};
+    EXPECT_EQ(receiver.get_stream(0U).receive(in.data(), 600U), 4);
+    EXPECT_EQ(std::memcmp(in.data(), ping.data(), 4U), 0);
+    EXPECT_EQ(receiver.get_stream(1U).receive(in.data(), 600U), 600);
+    EXPECT_EQ(in, bulk);
+    EXPECT_EQ(receiver.get_stream(2U).receive(in.data(), 600U), 0);
+
+    // stream 1 is not read: once its window is used up it stalls, stream 0
+    // still gets through.
+    std::size_t queued = 0U;
+    for (int i = 0; (i < 100) && (queued < (3U * TCP_MUX::BUFFER_SIZE)); ++i)
+    {
+        const auto sent = sender.get_stream(1U).send(bulk.data(), 512U);
+        ASSERT_GE(sent, 0);
+        queued += static_cast< std::size_t >(sent);
+        poll();
+    }
+    // the window, less the 600 bytes read but not granted back yet, and the
+    // send buffer.
+    EXPECT_EQ(queued, 2U * TCP_MUX::BUFFER_SIZE - 600U);
+    EXPECT_EQ(sender.get_stream(1U).get_credit(), 0U);
+    EXPECT_GT(sender.get_stream(1U).get_pending(), 0U);
+    EXPECT_EQ(sender.get_stream(0U).send(ping.data(), 4U), 4);
+    poll();
+    EXPECT_EQ(receiver.get_stream(0U).receive(in.data(), 600U), 4);
+
+    // reading stream 1 grants more, all of its data arrives in order.
+    std::size_t received = 0U;
+    bool in_order = true;
+    for (int i = 0; (i < 100) && (received < queued); ++i)
+    {
+        const auto len = receiver.get_stream(1U).receive(in.data(), 600U);
+        ASSERT_GE(len, 0);
+        for (std::size_t b = 0U; b < static_cast< std::size_t >(len); ++b)
+        {
+            in_order = in_order && (in[b] == bulk[(received + b) % 512U]);
+        }
+        received += static_cast< std::size_t >(len);
+        poll();
+    }
+    EXPECT_EQ(received, queued);
+    EXPECT_TRUE(in_order);
+}
+
+TEST(Sockets, TcpMuxPriority)
+{
+    TcpServer server;
+    TcpClient client;
+    ASSERT_TRUE(server.reuse_addr());
+    ASSERT_TRUE(server.listen(IpAddress{"127.0.0.1"}, 5709U));
+    ASSERT_TRUE(client.connect(IpAddress{"127.0.0.1"}, 5709U));
+    ASSERT_TRUE(server.accept());
+
+    // the bucket lets 16 bytes pass, then the queued data waits.
+    TokenBucket bucket{1U, 16U};
+    client.enable_rate_limit(bucket);
+    TcpMux sender{client};
+    sender.get_stream(2U).set_priority(1U);
+    sender.get_stream(3U).set_priority(0U);
+    std::array< std::uint8_t, 100U > data{};
+    EXPECT_EQ(sender.get_stream(2U).send(data.data(), 100U), 100);
+    EXPECT_EQ(sender.get_stream(2U).send(data.data(), 100U), 100);
+    EXPECT_EQ(sender.get_stream(3U).send(data.data(), 100U), 100);
+
+    // the first chunk of stream 2 was on its way, then stream 3 goes first.
+    bucket.set_rate(TOKEN_BUCKET::UNLIMITED);
+    EXPECT_TRUE(sender.transmit());
+    std::array< std::uint8_t, 1024U > wire{};
+    std::size_t len = 0U;
+    while (len < (3U * TCP_MUX::HEADER_LEN + 300U))
+    {
+        const auto received =
+            server.m_data.receive(&wire[len], wire.size() - len);
+        ASSERT_GT(received, 0);
+        len += static_cast< std::size_t >(received);
+    }
+    // stream ID, type, length of each chunk.
+    EXPECT_EQ(wire[0], 2U);
+    EXPECT_EQ(wire[1], static_cast< std::uint8_t >(MuxChunk::DATA));
+    EXPECT_EQ(wire[3], 100U);
+    EXPECT_EQ(wire[104], 3U);
+    EXPECT_EQ(wire[107], 100U);
+    EXPECT_EQ(wire[208], 2U);
+    EXPECT_EQ(wire[211], 100U);
+}
+
+TEST(Sockets, TokenBucket)
+{
+    using namespace std::chrono_literals;
+    TokenBucket unlimited;
+    EXPECT_EQ(unlimited.take(1000000U), 1000000U);
+    EXPECT_EQ(unlimited.get_delay(1000000U).count(), 0);
+
+    // 1000 bytes per second: one byte takes one millisecond.
+    TokenBucket bucket{1000U, 100U};
+    EXPECT_EQ(bucket.take(150U), 100U);
+    EXPECT_EQ(bucket.take(10U), 0U);
+    EXPECT_EQ(bucket.get_limited(), 2U);
+    EXPECT_GT(bucket.get_delay(10U), 9ms);
+    EXPECT_LE(bucket.get_delay(10U), 10ms);
+    // more than the burst never fits at once.
+    EXPECT_LE(bucket.get_delay(1000U), 100ms);
+
+    bucket.refund(50U);
+    EXPECT_EQ(bucket.take(50U), 50U);
+
+    bucket.set_rate(TOKEN_BUCKET::UNLIMITED);
+    EXPECT_EQ(bucket.take(500U), 500U);
+}
+
+TEST(Sockets, TcpRateLimit)
+{
+    using namespace std::chrono_literals;
+    TcpServer server;
+    TcpClient client;
+    ASSERT_TRUE(server.reuse_addr());
+    ASSERT_TRUE(server.listen(IpAddress{"127.0.0.1"}, 5705U));
+    ASSERT_TRUE(client.connect(IpAddress{"127.0.0.1"}, 5705U));
+    ASSERT_TRUE(server.accept());
+
+    // a blocking send of 3 bursts sends all bytes, waiting for the last two.
+    TokenBucket bucket{10000U, 100U};
+    client.enable_rate_limit(bucket);
+    std::array< std::uint8_t, 300U > data{};
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(client.send(data.data(), 300U), 300);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 19ms);
+
+    // a non-blocking send gets the part the bucket allows, 1 byte per ms.
+    bucket.set_rate(1000U, 100U);
+    std::this_thread::sleep_for(20ms);
+    ASSERT_TRUE(client.set_blocking(false));
+    const auto sent = client.send(data.data(), 300U);
+    EXPECT_GT(sent, 0);
+    EXPECT_LT(sent, 300);
+    EXPECT_EQ(client.send(data.data(), 300U), -1);
+    EXPECT_EQ(client.get_last_error(), EAGAIN);
+
+    // a closed socket does not take tokens.
+    std::this_thread::sleep_for(150ms);
+    EXPECT_TRUE(client.close_socket());
+    EXPECT_EQ(client.send(data.data(), 100U), -1);
+    EXPECT_EQ(bucket.take(100U), 100U);
+}
+
+TEST(Sockets, LoopbackPair)
+{
+    using namespace std::chrono_literals;
+    LoopbackPair pair;
+    LoopbackSocket& client = pair.get_client();
+    LoopbackSocket& server = pair.get_server();
+    std::array< std::uint8_t, 16U > out{};
+    const std::array< std::uint8_t, 10U > in{{0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U,
+                                              8U, 9U}};
+
+    EXPECT_TRUE(server.set_blocking(false));
+    EXPECT_EQ(server.receive(out.data(), 16U), -1);
+    EXPECT_EQ(server.get_last_error(), EAGAIN);
+    EXPECT_FALSE(server.wait_for(1ms));
+
+    EXPECT_EQ(client.send(in.data(), 10U), 10);
+    EXPECT_TRUE(server.wait_for(1ms));
+    EXPECT_EQ(server.receive(out.data(), 16U), 10);
+    EXPECT_EQ(out[9], 9U);
+
+    // short reads: at most 4 bytes per receive.
+    LoopbackImpairment fragments;
+    fragments.max_read = 4U;
+    server.set_impairment(fragments);
+    EXPECT_EQ(client.send(in.data(), 10U), 10);
+    EXPECT_EQ(server.receive(out.data(), 16U), 4);
+    EXPECT_EQ(server.receive(out.data(), 16U), 4);
+    EXPECT_EQ(server.receive(out.data(), 16U), 2);
+    EXPECT_EQ(out[1], 9U);
+
+    // latency: nothing is received before it passed.
+    LoopbackImpairment delayed;
+    delayed.latency = 20ms;
+    client.set_impairment(delayed);
+    const auto sent_at = std::chrono::steady_clock::now();
+    EXPECT_EQ(client.send(in.data(), 10U), 10);
+    EXPECT_EQ(server.receive(out.data(), 16U), -1);
+    server.set_blocking(true);
+    EXPECT_EQ(server.receive(out.data(), 16U), 4);
+    EXPECT_GE(std::chrono::steady_clock::now() - sent_at, 20ms);
+
+    // rate: 100 bytes per second with a burst of 10 bytes.
+    LoopbackImpairment limited;
+    limited.rate = 100U;
+    limited.burst = 10U;
+    client.set_impairment(limited);
+    client.set_blocking(false);
+    EXPECT_EQ(client.send(in.data(), 10U), 10);
+    EXPECT_EQ(client.send(in.data(), 10U), -1);
+    EXPECT_EQ(client.get_last_error(), EAGAIN);
+
+    // a closed peer: the 16 bytes left, then the end of the stream.
+    EXPECT_TRUE(client.close_socket());
+    EXPECT_EQ(server.receive(out.data(), 16U), 4);
+    EXPECT_EQ(server.receive(out.data(), 16U), 4);
+    EXPECT_EQ(server.receive(out.data(), 16U), 4);
+    EXPECT_EQ(server.receive(out.data(), 16U), 4);
+    EXPECT_EQ(server.receive(out.data(), 16U), 0);
+    EXPECT_EQ(server.send(in.data(), 10U), -1);
+    EXPECT_EQ(server.get_last_error(), EPIPE);
+}
+
+TEST(Sockets, LoadSchedule)
+{
+    using namespace std::chrono_literals;
+    LoadSchedule schedule;
+    EXPECT_TRUE(schedule.parse_line(""));
+    EXPECT_TRUE(schedule.parse_line("# comment"));
+    EXPECT_TRUE(schedule.parse_line("can 0x100 1000 8"));
+    EXPECT_TRUE(schedule.parse_line("can 0x18FF0001 10000 64 500 20"));
+    EXPECT_TRUE(schedule.parse_line("tcp 127.0.0.1 5555 1000 256"));
+    ASSERT_EQ(schedule.can_count, 2U);
+    ASSERT_EQ(schedule.tcp_count, 1U);
+    EXPECT_EQ(schedule.can[0].can_id, 0x100U);
+    EXPECT_EQ(schedule.can[0].period, 1000us);
+    EXPECT_EQ(schedule.can[0].jitter, 0us);
+    EXPECT_EQ(schedule.can[0].burst, 1U);
+    EXPECT_EQ(schedule.can[1].len, 64U);
+    EXPECT_EQ(schedule.can[1].jitter, 500us);
+    EXPECT_EQ(schedule.can[1].burst, 20U);
+    EXPECT_STREQ(schedule.tcp[0].address.data(), "127.0.0.1");
+    EXPECT_EQ(schedule.tcp[0].port, 5555U);
+
+    // no CAN FD length, jitter longer than the period, unknown type.
+    EXPECT_FALSE(schedule.parse_line("can 0x100 1000 9"));
+    EXPECT_FALSE(schedule.parse_line("can 0x100 1000 8 2000"));
+    EXPECT_FALSE(schedule.parse_line("udp 127.0.0.1 5555 1000 256"));
+    EXPECT_EQ(schedule.can_count, 2U);
+}
+
+TEST(Sockets, EndpointResolver)
+{
+    using namespace std::chrono_literals;
+    EndpointResolver resolver;
+    std::uint32_t address{0U};
+
+    // addresses are not queued.
+    EXPECT_EQ(resolver.lookup("192.168.0.2", address),
+              ResolveState::RESOLVED);
+    EXPECT_EQ(address, 0xC0A80002U);
+
+    // "localhost" is resolved with /etc/hosts, no DNS server is needed.
+    address = 0U;
+    const ResolveState first = resolver.lookup("localhost", address);
+    EXPECT_TRUE((first == ResolveState::PENDING) ||
+                (first == ResolveState::RESOLVED));
+    EXPECT_EQ(resolver.wait_for("localhost", address, 5000ms),
+              ResolveState::RESOLVED);
+    EXPECT_EQ(address, 0x7F000001U);
+    // now it is read from the table.
+    EXPECT_EQ(resolver.lookup("localhost", address), ResolveState::RESOLVED);
+}
+
+TEST(System, HugePageBuffer)
+{
+    // normal pages are always available.
+    HugePageBuffer normal{1000U, false, false};
+    ASSERT_NE(normal.get_data(), nullptr);
+    EXPECT_EQ(normal.get_page_kind(), PageKind::NORMAL);
+    EXPECT_EQ(normal.get_size() % normal.get_page_size(), 0U);
+    EXPECT_GE(normal.get_size(), 1000U);
+    EXPECT_FALSE(normal.is_locked());
+
+    // huge pages fall back to normal pages if not available.
+    HugePageBuffer huge{4U * 1024U * 1024U};
+    ASSERT_NE(huge.get_data(), nullptr);
+    EXPECT_NE(huge.get_page_kind(), PageKind::NONE);
+    EXPECT_EQ(huge.get_size() % huge.get_page_size(), 0U);
+
+    ByteRingView ring{huge.get_data(), huge.get_size()};
+    const std::uint32_t value{0x12345678U};
+    std::uint32_t out{0U};
+    EXPECT_EQ(ring.write(&value, sizeof(value)), sizeof(value));
+    EXPECT_EQ(ring.read(&out, sizeof(out)), sizeof(out));
+    EXPECT_EQ(out, value);
+
+    // a buffer of page multiples is used up to a power of two.
+    HugePageBuffer pages{12U * 1024U, false, false};
+    ASSERT_NE(pages.get_data(), nullptr);
+    ByteRingView small{pages.get_data(), pages.get_size()};
+    EXPECT_EQ(small.get_size() & (small.get_size() - 1U), 0U);
+    EXPECT_LE(small.get_size(), pages.get_size());
+    EXPECT_GT(2U * small.get_size(), pages.get_size());
+    std::array< std::uint8_t, 3000U > block{};
+    for (std::uint32_t round = 0U; round < 10U; ++round)
+    {
+        block.fill(static_cast< std::uint8_t >(round));
+        ASSERT_EQ(small.write(block.data(), block.size()), block.size());
+        block.fill(0xFFU);
+        ASSERT_EQ(small.read(block.data(), block.size()), block.size());
+        EXPECT_EQ(block[0], round);
+        EXPECT_EQ(block[2999], round);
+    }
+}
+
+TEST(Sockets, PacketBatch)
+{
+    struct Sink
+    {
+        std::int16_t send(const void* message, const std::uint16_t len)
+        {
+            // accepts at most 7 bytes per call like a full socket buffer.
+            const std::uint16_t sent = (len < 7U) ? len : 7U;
+            std::memcpy(&buffer[length], message, sent);
+            length += sent;
+            return static_cast< std::int16_t >(sent);
+        }
+        std::array< std::uint8_t, 64 > buffer;
+        std::size_t length{0U};
+    } sink;
+
+    PacketBatch< 20 > batch;
+    EXPECT_TRUE(batch.encode([](PacketView& message) {
+        message << std::uint32_t{0xDEADBEEFU} << std::int16_t{-2};
+    }));
+    Packet< 32 > packet;
+    packet << 1.5F;
+    EXPECT_TRUE(batch.add(packet));
+    // does not fit anymore and is dropped completely.
+    EXPECT_FALSE(batch.encode(
+        [](PacketView& message) { message << std::uint64_t{1U}; }));
+    EXPECT_EQ(batch.get_count(), 2U);
+    EXPECT_EQ(batch.get_length(), 14U);
+    EXPECT_TRUE(batch.flush(sink));
+    EXPECT_EQ(sink.length, 14U);
+    EXPECT_EQ(batch.get_length(), 0U);
+
+    // the last message is cut off.
+    PacketBatchReader reader{sink.buffer.data(), sink.length - 1U};
+    EXPECT_EQ(reader.get_count(), 1U);
+    EXPECT_EQ(reader.get_consumed(), 8U);
+
+    reader = PacketBatchReader{sink.buffer.data(), sink.length};
+    EXPECT_EQ(reader.get_count(), 2U);
+    auto message = reader.begin();
+    std::uint32_t word{0U};
+    std::int16_t signed_word{0};
+    (*message) >> word >> signed_word;
+    EXPECT_EQ(word, 0xDEADBEEFU);
+    EXPECT_EQ(signed_word, -2);
+    ++message;
+    float value{0.0F};
+    PacketView view = *message;
+    view >> value >> word;
+    EXPECT_EQ(value, 1.5F);
+    EXPECT_TRUE(view.has_overflow());
+}
+
+TEST(Sockets, EventLoop)
+{
+    struct Source
+    {
+        std::array< int, 2 > pair;
+        char name;
+        std::string* log;
+        int wake_up;
+    };
+
+    // reads one byte per call, the bulk source wakes up the control source.
+    const EventHandler read_one = [](void* context) {
+        Source& source = *static_cast< Source* >(context);
+        char byte = 0;
+        const bool read = (::read(source.pair[0], &byte, 1U) == 1);
+
+        if (read)
+        {
+            source.log->push_back(source.name);
+
+            if (source.wake_up >= 0)
+            {
+                EXPECT_EQ(::write(source.wake_up, "x", 1U), 1);
+                source.wake_up = -1;
+            }
+        }
+
+        return read;
+    };
+
+    std::string log;
+    Source control{{-1, -1}, 'c', &log, -1};
+    Source bulk{{-1, -1}, 'b', &log, -1};
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, control.pair.data()), 0);
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, bulk.pair.data()), 0);
+    bulk.wake_up = control.pair[1];
+
+    EventLoop loop;
+    ASSERT_TRUE(loop.is_ok());
+    EXPECT_TRUE(loop.add(control.pair[0], EventPriority::CONTROL, read_one,
+                         &control));
+    EXPECT_TRUE(loop.add(bulk.pair[0], EventPriority::BULK, read_one, &bulk));
+    loop.set_budget(EventPriority::BULK, 4U);
+    EXPECT_EQ(loop.run_once(0), 0);
+
+    EXPECT_EQ(::write(bulk.pair[1], "123456", 6U), 6);
+    EXPECT_EQ(loop.run_once(0), 5);
+    EXPECT_EQ(log, "bcbbb");
+    EXPECT_EQ(loop.get_preemptions(), 1U);
+    EXPECT_EQ(loop.run_once(0), 2);
+    EXPECT_EQ(loop.get_handled(EventPriority::BULK), 6U);
+    EXPECT_EQ(loop.get_handled(EventPriority::CONTROL), 1U);
+
+    // end of file: the handler removes the source.
+    ::close(bulk.pair[1]);
+    EXPECT_EQ(loop.run_once(0), 1);
+    EXPECT_FALSE(loop.remove(bulk.pair[0]));
+    EXPECT_TRUE(loop.remove(control.pair[0]));
+
+    for (const int handle : {control.pair[0], control.pair[1], bulk.pair[0]})
+    {
+        ::close(handle);
+    }
+}
+
+TEST(Sockets, XdpParseUdp)
+{
+    // Ethernet, IPv4 from 10.0.0.2, UDP 4000 -> 5600 with 4 bytes payload.
+    std::array< std::uint8_t, 60U > frame{};
+    frame[12] = 0x08U;
+    frame[14] = 0x45U;
+    frame[23] = IPPROTO_UDP;
+    frame[26] = 10U;
+    frame[29] = 2U;
+    frame[34] = 0x0FU;
+    frame[35] = 0xA0U;
+    frame[36] = 0x15U;
+    frame[37] = 0xE0U;
+    frame[39] = 12U;
+    frame[42] = 0xCAU;
+    frame[43] = 0xFEU;
+
+    PacketView payload{nullptr, 0U};
+    XdpFrameInfo info;
+    // Ethernet pads the frame to 60 bytes, the UDP length counts.
+    ASSERT_TRUE(XdpSocket::parse_udp(frame.data(), 60U, payload, info));
+    EXPECT_EQ(info.source.get_ip_address(), 0x0A000002U);
+    EXPECT_EQ(info.source_port, 4000U);
+    EXPECT_EQ(info.destination_port, 5600U);
+    EXPECT_EQ(info.payload_length, 4U);
+    std::uint16_t value{0U};
+    payload >> value;
+    EXPECT_EQ(value, 0xCAFEU);
+
+    EXPECT_FALSE(XdpSocket::parse_udp(frame.data(), 45U, payload, info));
+    frame[23] = IPPROTO_TCP;
+    EXPECT_FALSE(XdpSocket::parse_udp(frame.data(), 60U, payload, info));
+}
+
+TEST(Sockets, RawEthLoopback)
+{
+    // needs CAP_NET_RAW; the loopback device reflects every frame.
+    RawEthSocket receiver;
+    RawEthSocket sender;
+    ASSERT_TRUE(receiver.bind("lo", 0x88B5U));
+    ASSERT_TRUE(sender.bind("lo", 0x88B5U));
+
+    std::uint16_t index{0U};
+    const int sent = sender.send_batch(3U, [&index](PacketView& frame) {
+        const std::array< std::uint8_t, 12U > addresses{};
+        frame.append(addresses);
+        frame << std::uint16_t{0x88B5U} << index;
+        ++index;
+    });
+    ASSERT_EQ(sent, 3);
+
+    std::uint16_t expected{0U};
+    for (int round = 0; (round < 10) && (expected < 3U); ++round)
+    {
+        receiver.receive_batch(
+            [&expected](PacketView& frame, const RawEthFrameInfo& info) {
+                EXPECT_EQ(info.length, 16U);
+                EXPECT_FALSE(info.vlan_valid);
+                std::uint16_t ether_type{0U};
+                std::uint16_t index{0U};
+                frame.skip(12U);
+                frame >> ether_type >> index;
+                EXPECT_EQ(ether_type, 0x88B5U);
+                EXPECT_EQ(index, expected);
+                ++expected;
+            });
+    }
+    EXPECT_EQ(expected, 3U);
+}
+
+TEST(Sockets, TxTimeSend)
+{
+    UdpSocket receiver;
+    UdpSocket sender;
+    ASSERT_TRUE(receiver.bind(IpAddress{"127.0.0.1"}, 5701U));
+    ASSERT_TRUE(sender.connect(IpAddress{"127.0.0.1"}, 5701U));
+
+    // a launch time needs SO_TXTIME first.
+    const std::uint32_t value{0xCAFEU};
+    const std::chrono::nanoseconds launch =
+        TxTime::now(CLOCK_MONOTONIC) + std::chrono::milliseconds{1};
+    EXPECT_EQ(sender.send_at(&value, sizeof(value), launch), -1);
+    EXPECT_EQ(sender.get_last_error(), EINVAL);
+
+    // the loopback device has no ETF qdisc, the datagram leaves at once.
+    ASSERT_TRUE(sender.enable_txtime(CLOCK_MONOTONIC));
+    EXPECT_EQ(sender.send_at(&value, sizeof(value), launch), 4);
+    std::uint32_t received{0U};
+    EXPECT_EQ(receiver.receive(&received, sizeof(received)), 4);
+    EXPECT_EQ(received, value);
+    EXPECT_EQ(sender.drain_txtime_reports([](const TxTimeReport&) {}), 0);
+
+    // raw Ethernet frames take the same control message through the ring.
+    RawEthSocket raw;
+    ASSERT_TRUE(raw.bind("lo", 0x88B5U));
+    ASSERT_TRUE(raw.enable_txtime(CLOCK_MONOTONIC));
+    std::array< std::uint8_t, 16U > frame{};
+    frame[12] = 0x88U;
+    frame[13] = 0xB5U;
+    EXPECT_EQ(raw.send_at(frame.data(), frame.size(), launch), 16);
+
+    EXPECT_FALSE(TxTime::configure_etf("nonexistent0", TX_TIME::ROOT,
+                                       TX_TIME::ETF_DELTA_NS, false, false));
+}
+
+TEST(Sockets, TcpTxTimestamps)
+{
+    using namespace std::chrono_literals;
+    // the key is the offset of the last byte and wraps like the kernel's.
+    EXPECT_EQ(TcpTxTimestamps::get_key(0U, 100U), 99U);
+    EXPECT_EQ(TcpTxTimestamps::get_key(99U, 1U), 99U);
+    EXPECT_EQ(TcpTxTimestamps::get_key(0xFFFFFFF0U, 0x20U), 0x0FU);
+
+    TcpTxTimestamps timestamps{2U};
+    EXPECT_FALSE(timestamps.is_sample_due());
+    EXPECT_TRUE(timestamps.is_sample_due());
+
+    const struct timespec sent{10, 999990000};
+    timestamps.add_sample(99U, sent);
+    EXPECT_TRUE(timestamps.has_pending());
+    EXPECT_FALSE(timestamps.add_report(98U, TxStage::SCHED, sent));
+    EXPECT_TRUE(timestamps.add_report(99U, TxStage::SCHED,
+                                      timespec{11, 0}));
+    EXPECT_TRUE(timestamps.add_report(99U, TxStage::ACK,
+                                      timespec{11, 1000000}));
+    EXPECT_FALSE(timestamps.has_pending());
+    // after the ACK the send is done.
+    EXPECT_FALSE(timestamps.add_report(99U, TxStage::SOFTWARE, sent));
+    EXPECT_EQ(timestamps.get_histogram(TxStage::SCHED).get_count(), 1U);
+    EXPECT_EQ(timestamps.get_histogram(TxStage::SOFTWARE).get_count(), 0U);
+
+    std::size_t messages{0U};
+    EXPECT_EQ(timestamps.drain_messages(
+                  [&messages](const TxMessageLatency& message) {
+                      EXPECT_EQ(message.key, 99U);
+                      EXPECT_EQ(message.latency[0], 10us);
+                      EXPECT_LT(message.latency[1], 0ns);
+                      EXPECT_EQ(message.latency[2], 1010us);
+                      ++messages;
+                  }),
+              1U);
+    EXPECT_EQ(messages, 1U);
+    EXPECT_EQ(timestamps.drain_messages([](const TxMessageLatency&) {}), 0U);
+
+    // a full table drops the oldest sample.
+    for (std::uint32_t i = 0U; i <= TCP_TX_TIMESTAMPS::MAX_PENDING; ++i)
+    {
+        timestamps.add_sample(i, sent);
+    }
+    EXPECT_EQ(timestamps.get_dropped(), 1U);
+    EXPECT_FALSE(timestamps.add_report(0U, TxStage::ACK, sent));
+    EXPECT_TRUE(timestamps.add_report(1U, TxStage::ACK, sent));
+}
+
+TEST(Sockets, TcpTxTimestampsSend)
+{
+    using namespace std::chrono_literals;
+    TcpServer server;
+    TcpClient client;
+    ASSERT_TRUE(server.reuse_addr());
+    ASSERT_TRUE(server.listen(IpAddress{"127.0.0.1"}, 5704U));
+    ASSERT_TRUE(client.connect(IpAddress{"127.0.0.1"}, 5704U));
+    ASSERT_TRUE(server.accept());
+
+    // all sends are sampled, the kernel reports each stage of loopback.
+    TcpTxTimestamps timestamps{1U};
+    ASSERT_TRUE(client.enable_tx_timestamps(timestamps));
+    std::array< std::uint8_t, 100U > data{};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ(client.send(data.data(), 100U), 100);
+    }
+
+    std::array< std::uint8_t, 300U > received{};
+    std::size_t received_bytes{0U};
+    while (received_bytes < received.size())
+    {
+        const auto bytes = server.m_data.receive(
+            &received[received_bytes],
+            static_cast< std::uint16_t >(received.size() - received_bytes));
+        ASSERT_GT(bytes, 0);
+        received_bytes += static_cast< std::size_t >(bytes);
+    }
+
+    // the ACK may be delayed.
+    for (int round = 0; (round < 100) && timestamps.has_pending(); ++round)
+    {
+        client.drain_tx_timestamps();
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_FALSE(timestamps.has_pending());
+
+    std::uint32_t key{99U};
+    EXPECT_EQ(timestamps.drain_messages(
+                  [&key](const TxMessageLatency& message) {
+                      EXPECT_EQ(message.key, key);
+                      EXPECT_GE(message.latency[0], 0ns);
+                      EXPECT_GE(message.latency[1], message.latency[0]);
+                      EXPECT_GE(message.latency[2], message.latency[1]);
+                      key += 100U;
+                  }),
+              3U);
+    EXPECT_EQ(timestamps.get_histogram(TxStage::ACK).get_count(), 3U);
+    client.disable_tx_timestamps();
+}
+
+TEST(Sockets, ImpairmentProxy)
+{
+    using namespace std::chrono_literals;
+    UdpSocket server;
+    UdpSocket client;
+    ASSERT_TRUE(server.bind(IpAddress{"127.0.0.1"}, 5702U));
+    ASSERT_TRUE(client.connect(IpAddress{"127.0.0.1"}, 5703U));
+
+    ImpairmentProxy proxy;
+    LinkImpairment delayed;
+    delayed.delay = 5ms;
+    proxy.set_impairment(ProxyDirection::UPSTREAM, delayed);
+    ASSERT_TRUE(proxy.open_udp(IpAddress{"127.0.0.1"}, 5703U,
+                               IpAddress{"127.0.0.1"}, 5702U));
+    std::thread forwarder{[&proxy]() { proxy.run(); }};
+
+    // the request is delayed, the answer is not.
+    const std::uint32_t request{0xCAFEU};
+    const auto sent_at = std::chrono::steady_clock::now();
+    EXPECT_EQ(client.send(&request, sizeof(request)), 4);
+    std::uint32_t received{0U};
+    sockaddr_in from{};
+    ASSERT_TRUE(server.wait_for(1s));
+    EXPECT_GE(std::chrono::steady_clock::now() - sent_at, 5ms);
+    EXPECT_EQ(server.receive_from(&received, sizeof(received), from), 4);
+    EXPECT_EQ(received, request);
+    EXPECT_EQ(server.send_to(&received, sizeof(received), from), 4);
+    ASSERT_TRUE(client.wait_for(1s));
+    EXPECT_EQ(client.receive(&received, sizeof(received)), 4);
+
+    proxy.stop();
+    forwarder.join();
+    EXPECT_EQ(proxy.get_stats(ProxyDirection::UPSTREAM).forwarded, 1U);
+    EXPECT_EQ(proxy.get_stats(ProxyDirection::DOWNSTREAM).forwarded, 1U);
+    EXPECT_GE(proxy.get_stats(ProxyDirection::UPSTREAM).delay.get_min(), 5ms);
+
+    // everything is lost.
+    LinkImpairment lossy;
+    lossy.loss = 1.0;
+    proxy.set_impairment(ProxyDirection::UPSTREAM, lossy);
+    EXPECT_EQ(client.send(&request, sizeof(request)), 4);
+    proxy.run_once(100);
+    EXPECT_EQ(proxy.get_stats(ProxyDirection::UPSTREAM).lost, 1U);
+    EXPECT_FALSE(server.wait_for(10ms));
+}
+
+TEST(Sockets, ImpairmentProxyTcp)
+{
+    using namespace std::chrono_literals;
+    TcpServer server;
+    ASSERT_TRUE(server.reuse_addr());
+    ASSERT_TRUE(server.listen(IpAddress{"127.0.0.1"}, 5707U));
+
+    ImpairmentProxy proxy;
+    LinkImpairment delayed;
+    delayed.delay = 1ms;
+    proxy.set_impairment(ProxyDirection::UPSTREAM, delayed);
+    std::thread forwarder{[&proxy]() {
+        if (proxy.open_tcp(IpAddress{"127.0.0.1"}, 5706U,
+                           IpAddress{"127.0.0.1"}, 5707U))
+        {
+            proxy.run();
+        }
+    }};
+
+    TcpClient client;
+    bool connected = false;
+    for (int i = 0; (i < 100) && (connected == false); ++i)
+    {
+        std::this_thread::sleep_for(10ms);
+        connected = client.connect(IpAddress{"127.0.0.1"}, 5706U);
+    }
+    ASSERT_TRUE(connected);
+    ASSERT_TRUE(server.accept());
+
+    // more than the socket buffers hold while the server does not read: the
+    // proxy keeps what the server does not take and loses no byte.
+    constexpr std::size_t TOTAL{4U * 1024U * 1024U};
+    std::thread sender{[&client]() {
+        std::array< std::uint8_t, 4096U > block;
+        std::size_t offset = 0U;
+        while (offset < TOTAL)
+        {
+            for (std::size_t i = 0U; i < block.size(); ++i)
+            {
+                block[i] = static_cast< std::uint8_t >((offset + i) % 251U);
+            }
+            const auto sent = client.send(block.data(), block.size());
+            if (sent <= 0)
+            {
+                break;
+            }
+            offset += static_cast< std::size_t >(sent);
+        }
+        EXPECT_TRUE(client.close_socket());
+    }};
+
+    std::this_thread::sleep_for(200ms);
+    std::array< std::uint8_t, 4096U > received;
+    std::size_t total = 0U;
+    bool in_order = true;
+    std::int16_t len = 0;
+    while ((total < TOTAL) && ((len = server.m_data.receive(
+                                    received.data(), received.size())) > 0))
+    {
+        for (std::int16_t i = 0; i < len; ++i)
+        {
+            in_order = in_order &&
+                       (received[static_cast< std::size_t >(i)] ==
+                        static_cast< std::uint8_t >(
+                            (total + static_cast< std::size_t >(i)) % 251U));
+        }
+        total += static_cast< std::size_t >(len);
+    }
+
+    sender.join();
+    forwarder.join();
+    EXPECT_EQ(total, TOTAL);
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(proxy.get_stats(ProxyDirection::UPSTREAM).bytes, TOTAL);
+    EXPECT_EQ(proxy.get_stats(ProxyDirection::UPSTREAM).unsent, 0U);
+}
+
+TEST(Sockets, CanLogReader)
+{
+    // 2020-01-01 00:00:00 UTC, the start of the BLF below.
+    constexpr std::uint64_t start{1577836800000000000U};
+    std::FILE* text = std::fopen("/tmp/bsw_test_can.log", "w");
+    ASSERT_NE(text, nullptr);
+    std::fputs("(1577836800.000000) can0 123#DEADBEEF\n"
+               "(1577836800.000002) can0 12345678#0102 T\n"
+               "\n"
+               "(1577836800.000004) can1 321##3112233\n"
+               "no frame\n",
+               text);
+    std::fclose(text);
+
+    // three CAN messages at 1, 3 and 5 us in two containers, the second
+    // message starts in the first container and ends in the second.
+    std::vector< std::uint8_t > objects;
+    const auto put = [](std::vector< std::uint8_t >& out, std::uint64_t value,
+                        std::size_t bytes) {
+        for (; bytes > 0U; --bytes, value >>= 8U)
+        {
+            out.push_back(static_cast< std::uint8_t >(value));
+        }
+    };
+    for (std::uint32_t i = 0U; i < 3U; ++i)
+    {
+        objects.insert(objects.end(), {'L', 'O', 'B', 'J'});
+        put(objects, 32U, 2U);
+        put(objects, 1U, 2U);
+        put(objects, 48U, 4U);
+        put(objects, 1U, 4U);
+        put(objects, 2U, 4U);
+        put(objects, 0U, 4U);
+        put(objects, 1000U + (i * 2000U), 8U);
+        put(objects, 1U, 2U);
+        put(objects, 0U, 1U);
+        put(objects, 2U, 1U);
+        put(objects, 0x100U + i, 4U);
+        put(objects, 0xABCDU, 8U);
+    }
+    std::vector< std::uint8_t > blf{'L', 'O', 'G', 'G'};
+    put(blf, 144U, 4U);
+    blf.resize(40U);
+    for (const std::uint16_t field : {2020U, 1U, 3U, 1U, 0U, 0U, 0U, 0U})
+    {
+        put(blf, field, 2U);
+    }
+    blf.resize(144U);
+    for (const std::size_t split : {std::size_t{0U}, std::size_t{60U}})
+    {
+        const std::size_t size =
+            (split == 0U) ? 60U : (objects.size() - split);
+        blf.insert(blf.end(), {'L', 'O', 'B', 'J'});
+        put(blf, 16U, 2U);
+        put(blf, 1U, 2U);
+        put(blf, 32U + size, 4U);
+        put(blf, 10U, 4U);
+        put(blf, 0U, 8U);
+        put(blf, size, 4U);
+        put(blf, 0U, 4U);
+        blf.insert(blf.end(), objects.begin() + split,
+                   objects.begin() + split + size);
+    }
+    std::FILE* binary = std::fopen("/tmp/bsw_test_can.blf", "wb");
+    ASSERT_NE(binary, nullptr);
+    std::fwrite(blf.data(), 1U, blf.size(), binary);
+    std::fclose(binary);
+
+    // small chunks: the lines and the containers are spread over chunks.
+    CanLogReader reader{16U};
+    EXPECT_FALSE(reader.open("/tmp/bsw_test_missing.log"));
+    ASSERT_TRUE(reader.open("/tmp/bsw_test_can.log"));
+    ASSERT_TRUE(reader.open("/tmp/bsw_test_can.blf"));
+    EXPECT_EQ(reader.get_format(0U), CanLogFormat::CANDUMP);
+    EXPECT_EQ(reader.get_format(1U), CanLogFormat::BLF);
+
+    std::vector< CanLogRecord > records;
+    EXPECT_EQ(reader.read([&records](const CanLogRecord& record) {
+        records.push_back(record);
+    }, 2U),
+              6U);
+    ASSERT_EQ(records.size(), 6U);
+    for (std::size_t i = 0U; i < records.size(); ++i)
+    {
+        EXPECT_EQ(records[i].timestamp, start + (i * 1000U));
+    }
+    EXPECT_EQ(reader.get_errors(), 1U);
+    EXPECT_EQ(reader.get_chunks(), 6U);
+
+    EXPECT_EQ(records[0].frame.can_id, 0x123U);
+    EXPECT_EQ(records[0].frame.len, 4U);
+    EXPECT_EQ(records[0].frame.data[0], 0xDEU);
+    EXPECT_EQ(records[0].channel, 1U);
+    EXPECT_EQ(records[2].frame.can_id, 0x12345678U | CAN_EFF_FLAG);
+    EXPECT_TRUE(records[2].tx);
+    EXPECT_TRUE(records[4].fd);
+    EXPECT_EQ(records[4].frame.flags, CANFD_BRS | CANFD_ESI);
+    EXPECT_EQ(records[4].frame.len, 3U);
+    EXPECT_EQ(records[4].channel, 2U);
+    // the message split over both containers.
+    EXPECT_EQ(records[3].frame.can_id, 0x101U);
+    EXPECT_EQ(records[3].frame.len, 2U);
+    EXPECT_EQ(records[3].frame.data[0], 0xCDU);
+    EXPECT_EQ(records[3].frame.data[1], 0xABU);
+    EXPECT_EQ(records[5].frame.can_id, 0x102U);
+
+    std::remove("/tmp/bsw_test_can.log");
+    std::remove("/tmp/bsw_test_can.blf");
+}
+
+TEST(Sockets, MdfWriterReader)
+{
+    constexpr std::uint64_t start{1577836800000000000U};
+    constexpr std::uint64_t ms{1000000U};
+
+    // a file of its own, so test runs in parallel don't share it.
+    char path[] = "/tmp/bsw_test_mdf_XXXXXX";
+    const int file = mkstemp(path);
+    ASSERT_GE(file, 0);
+    close(file);
+
+    // small blocks, so the groups have many of them.
+    MdfWriter writer{256U, true};
+    ASSERT_TRUE(writer.open(path, start));
+    const auto can = writer.add_can_group(false);
+    const std::array< MdfSignal, 2U > signals{
+        {{"speed", "rpm"}, {"temperature", "degC"}}};
+    const auto engine =
+        writer.add_signal_group("Engine", signals.data(), signals.size());
+    ASSERT_NE(can, MDF_WRITER::NO_GROUP);
+    ASSERT_NE(engine, MDF_WRITER::NO_GROUP);
+
+    for (std::uint32_t i = 0U; i < 100U; ++i)
+    {
+        CanLogRecord record{};
+        record.timestamp = start + (i * ms);
+        record.frame.can_id = (i % 2U) ? (0x1234567U | CAN_EFF_FLAG) : 0x123U;
+        record.frame.len = static_cast< std::uint8_t >(i % 9U);
+        record.frame.data[0] = static_cast< std::uint8_t >(i);
+        record.channel = 2U;
+        record.tx = (i % 3U) == 0U;
+        EXPECT_TRUE(writer.write_can(can, record));
+
+        const std::array< double, 2U > values{{i * 10.0, -0.5 * i}};
+        EXPECT_TRUE(writer.write_signals(engine, start + (i * ms) + 500U,
+                                         values.data()));
+    }
+
+    EXPECT_FALSE(writer.write_signals(can, start, nullptr));
+    EXPECT_EQ(writer.add_can_group(), MDF_WRITER::NO_GROUP);
+    EXPECT_TRUE(writer.close());
+
+    MdfReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.get_start_time(), start);
+    ASSERT_EQ(reader.get_group_count(), 2U);
+    EXPECT_EQ(reader.find_group("CAN_DataFrame"), can);
+    EXPECT_EQ(reader.find_group("Engine"), engine);
+    EXPECT_TRUE(reader.is_can_group(can));
+    EXPECT_FALSE(reader.is_can_group(engine));
+    EXPECT_EQ(reader.get_record_count(can), 100U);
+    EXPECT_EQ(reader.get_record_count(engine), 100U);
+
+    // a seek only decodes the blocks the binary search looks at.
+    EXPECT_EQ(reader.seek(can, start + (50U * ms) + 1U), 51U);
+    EXPECT_LE(reader.get_inflated(), 7U);
+    EXPECT_EQ(reader.seek(can, start + (200U * ms)), 100U);
+
+    std::vector< CanLogRecord > frames;
+    EXPECT_EQ(reader.read(can, start + (10U * ms), start + (20U * ms),
+                          [&](std::uint64_t, const std::uint8_t* record) {
+                              frames.emplace_back();
+                              reader.get_can_frame(can, record,
+                                                   frames.back());
+                          }),
+              10U);
+    ASSERT_EQ(frames.size(), 10U);
+    EXPECT_EQ(frames[0].timestamp, start + (10U * ms));
+    EXPECT_EQ(frames[0].frame.can_id, 0x123U);
+    EXPECT_EQ(frames[0].frame.len, 1U);
+    EXPECT_EQ(frames[0].frame.data[0], 10U);
+    EXPECT_EQ(frames[0].channel, 2U);
+    EXPECT_FALSE(frames[0].tx);
+    EXPECT_EQ(frames[1].frame.can_id, 0x1234567U | CAN_EFF_FLAG);
+    EXPECT_EQ(frames[1].frame.len, 2U);
+    EXPECT_TRUE(frames[2].tx);
+
+    const auto temperature = reader.find_channel(engine, "temperature");
+    ASSERT_NE(temperature, MDF_READER::NOT_FOUND);
+    const std::uint8_t* const record = reader.get_record(engine, 42U);
+    ASSERT_NE(record, nullptr);
+    EXPECT_EQ(reader.get_time(engine, record), start + (42U * ms) + 500U);
+    EXPECT_DOUBLE_EQ(reader.get_value(engine, temperature, record), -21.0);
+    EXPECT_DOUBLE_EQ(reader.get_value(engine, temperature - 1U, record),
+                     420.0);
+
+    std::remove(path);
+}
+
+TEST(Sockets, AesCmac)
+{
+    // FIPS-197 C.1 and the examples of RFC 4493.
+    const AesKey fips_key{{0x00U, 0x01U, 0x02U, 0x03U, 0x04U, 0x05U, 0x06U,
+                           0x07U, 0x08U, 0x09U, 0x0AU, 0x0BU, 0x0CU, 0x0DU,
+                           0x0EU, 0x0FU}};
+    const AesBlock plain{{0x00U, 0x11U, 0x22U, 0x33U, 0x44U, 0x55U, 0x66U,
+                          0x77U, 0x88U, 0x99U, 0xAAU, 0xBBU, 0xCCU, 0xDDU,
+                          0xEEU, 0xFFU}};
+    const AesBlock cipher{{0x69U, 0xC4U, 0xE0U, 0xD8U, 0x6AU, 0x7BU, 0x04U,
+                           0x30U, 0xD8U, 0xCDU, 0xB7U, 0x80U, 0x70U, 0xB4U,
+                           0xC5U, 0x5AU}};
+    const AesKey key{{0x2BU, 0x7EU, 0x15U, 0x16U, 0x28U, 0xAEU, 0xD2U, 0xA6U,
+                      0xABU, 0xF7U, 0x15U, 0x88U, 0x09U, 0xCFU, 0x4FU,
+                      0x3CU}};
+    const std::array< std::uint8_t, 64U > message{
+        {0x6BU, 0xC1U, 0xBEU, 0xE2U, 0x2EU, 0x40U, 0x9FU, 0x96U, 0xE9U, 0x3DU,
+         0x7EU, 0x11U, 0x73U, 0x93U, 0x17U, 0x2AU, 0xAEU, 0x2DU, 0x8AU, 0x57U,
+         0x1EU, 0x03U, 0xACU, 0x9CU, 0x9EU, 0xB7U, 0x6FU, 0xACU, 0x45U, 0xAFU,
+         0x8EU, 0x51U, 0x30U, 0xC8U, 0x1CU, 0x46U, 0xA3U, 0x5CU, 0xE4U, 0x11U,
+         0xE5U, 0xFBU, 0xC1U, 0x19U, 0x1AU, 0x0AU, 0x52U, 0xEFU, 0xF6U, 0x9FU,
+         0x24U, 0x45U, 0xDFU, 0x4FU, 0x9BU, 0x17U, 0xADU, 0x2BU, 0x41U, 0x7BU,
+         0xE6U, 0x6CU, 0x37U, 0x10U}};
+    const std::array< std::size_t, 4U > lengths{{0U, 16U, 40U, 64U}};
+    const std::array< AesBlock, 4U > expected{
+        {{{0xBBU, 0x1DU, 0x69U, 0x29U, 0xE9U, 0x59U, 0x37U, 0x28U, 0x7FU,
+           0xA3U, 0x7DU, 0x12U, 0x9BU, 0x75U, 0x67U, 0x46U}},
+         {{0x07U, 0x0AU, 0x16U, 0xB4U, 0x6BU, 0x4DU, 0x41U, 0x44U, 0xF7U,
+           0x9BU, 0xDDU, 0x9DU, 0xD0U, 0x4AU, 0x28U, 0x7CU}},
+         {{0xDFU, 0xA6U, 0x67U, 0x47U, 0xDEU, 0x9AU, 0xE6U, 0x30U, 0x30U,
+           0xCAU, 0x32U, 0x61U, 0x14U, 0x97U, 0xC8U, 0x27U}},
+         {{0x51U, 0xF0U, 0xBEU, 0xBFU, 0x7EU, 0x3BU, 0x9DU, 0x92U, 0xFCU,
+           0x49U, 0x74U, 0x17U, 0x79U, 0x36U, 0x3CU, 0xFEU}}}};
+
+    EXPECT_TRUE(AesCmac::is_supported(AesBackend::PORTABLE));
+
+    for (const auto backend :
+         {AesBackend::AES_NI, AesBackend::ARMV8, AesBackend::PORTABLE})
+    {
+        if (!AesCmac::is_supported(backend))
+        {
+            continue;
+        }
+
+        AesBlock out;
+        AesCmac fips{fips_key, backend};
+        EXPECT_EQ(fips.get_backend(), backend);
+        fips.encrypt(plain.data(), out.data());
+        EXPECT_EQ(out, cipher);
+
+        AesCmac cmac{key, backend};
+        std::array< const std::uint8_t*, 4U > messages;
+        std::array< AesBlock, 4U > macs;
+
+        for (std::size_t i = 0U; i < lengths.size(); ++i)
+        {
+            cmac.sign(message.data(), lengths[i], out);
+            EXPECT_EQ(out, expected[i]);
+            messages[i] = message.data();
+        }
+
+        // messages of different lengths in one batch.
+        cmac.sign_batch(messages.data(), lengths.data(), lengths.size(),
+                        macs.data());
+        EXPECT_EQ(macs, expected);
+    }
+}
+
+TEST(Sockets, SecOc)
+{
+    const AesKey key{{0x2BU, 0x7EU, 0x15U, 0x16U, 0x28U, 0xAEU, 0xD2U, 0xA6U,
+                      0xABU, 0xF7U, 0x15U, 0x88U, 0x09U, 0xCFU, 0x4FU,
+                      0x3CU}};
+    const canid_t fd_id{0x1ABCDEU | CAN_EFF_FLAG};
+    SecOc sender{key};
+    SecOc receiver{key, AesBackend::PORTABLE};
+
+    // 1 byte of freshness, 3 bytes of MAC; a fixed length CAN FD PDU.
+    for (auto secoc : {&sender, &receiver})
+    {
+        EXPECT_TRUE(secoc->add_pdu({0x123U, 0x0042U, 0U, 1U, 3U, 0U}));
+        EXPECT_TRUE(secoc->add_pdu({fd_id, 0x0007U, 8U, 2U, 8U, 100U}));
+        EXPECT_FALSE(secoc->add_pdu({0x123U, 0x0001U, 0U, 1U, 3U, 0U}));
+        EXPECT_FALSE(secoc->add_pdu({0x124U, 0x0001U, 0U, 1U, 17U, 0U}));
+    }
+
+    struct canfd_frame frame{};
+    struct canfd_frame secured{};
+    struct canfd_frame authentic{};
+    frame.can_id = 0x123U;
+    frame.len = 4U;
+    frame.data[0] = 0xDEU;
+    frame.data[3] = 0xEFU;
+
+    ASSERT_TRUE(sender.protect(frame, secured));
+    EXPECT_EQ(secured.len, 8U);
+    EXPECT_EQ(secured.data[4], 1U);
+    // send() and send_batch() put it on the bus as a standard frame.
+    EXPECT_EQ(can_get_mtu(secured), CAN_STD::MTU);
+    EXPECT_EQ(receiver.verify(secured, authentic), SecOcResult::AUTHENTIC);
+    EXPECT_EQ(authentic.len, 4U);
+    EXPECT_EQ(authentic.data[0], 0xDEU);
+    EXPECT_EQ(authentic.data[3], 0xEFU);
+    // a replayed frame is taken for a frame 256 values ahead, without a
+    // window only its MAC tells.
+    EXPECT_EQ(receiver.verify(secured, authentic), SecOcResult::MAC_FAILED);
+    EXPECT_EQ(authentic.len, 0U);
+
+    // a tampered frame leaves the freshness value as it is.
+    ASSERT_TRUE(sender.protect(frame, secured));
+    secured.data[0] ^= 0x01U;
+    EXPECT_EQ(receiver.verify(secured, authentic), SecOcResult::MAC_FAILED);
+    secured.data[0] ^= 0x01U;
+    EXPECT_EQ(receiver.verify(secured, authentic), SecOcResult::AUTHENTIC);
+
+    // the freshness value sent wraps around several times.
+    for (std::size_t i = 0U; i < 300U; ++i)
+    {
+        frame.data[1] = static_cast< std::uint8_t >(i);
+        ASSERT_TRUE(sender.protect(frame, secured));
+        ASSERT_EQ(receiver.verify(secured, authentic), SecOcResult::AUTHENTIC);
+        EXPECT_EQ(authentic.data[1], frame.data[1]);
+    }
+
+    std::uint64_t tx{0U};
+    std::uint64_t rx{0U};
+    EXPECT_TRUE(receiver.get_freshness(0x123U, tx, rx));
+    EXPECT_EQ(rx, 302U);
+    EXPECT_TRUE(sender.get_freshness(0x123U, tx, rx));
+    EXPECT_EQ(tx, 302U);
+
+    // a PDU of 8 bytes with 10 bytes behind it is padded to 20 bytes.
+    frame.can_id = fd_id;
+    frame.len = 8U;
+    ASSERT_TRUE(sender.protect(frame, secured));
+    EXPECT_EQ(secured.len, 20U);
+    EXPECT_EQ(can_get_mtu(secured), CAN_FD::MTU);
+    EXPECT_EQ(receiver.verify(secured, authentic), SecOcResult::AUTHENTIC);
+    EXPECT_EQ(authentic.len, 8U);
+
+    // too far ahead of the window.
+    EXPECT_TRUE(sender.set_freshness(fd_id, 500U, 0U));
+    ASSERT_TRUE(sender.protect(frame, secured));
+    EXPECT_EQ(receiver.verify(secured, authentic), SecOcResult::REPLAYED);
+    EXPECT_TRUE(sender.set_freshness(fd_id, 1U, 0U));
+
+    // a batch with a tampered frame, a replayed one and an unknown CAN ID.
+    std::array< struct canfd_frame, 40U > frames{};
+    std::array< struct canfd_frame, 40U > batch{};
+    std::array< struct canfd_frame, 40U > received{};
+    std::array< SecOcResult, 40U > results{};
+
+    for (std::size_t i = 0U; i < frames.size(); ++i)
+    {
+        frames[i].can_id = (i % 3U) ? 0x123U : fd_id;
+        frames[i].len = 6U;
+        frames[i].data[0] = static_cast< std::uint8_t >(i);
+    }
+
+    frames[7].can_id = 0x200U;
+    ASSERT_EQ(sender.protect_batch(frames.data(), frames.size(), batch.data()),
+              39U);
+    batch[39] = batch[3];
+    batch[5].data[2] ^= 0x80U;
+    EXPECT_EQ(receiver.verify_batch(batch.data(), batch.size(),
+                                    received.data(), results.data()),
+              38U);
+
+    for (std::size_t i = 0U; i < batch.size(); ++i)
+    {
+        SecOcResult result = SecOcResult::AUTHENTIC;
+        result = (i == 5U) ? SecOcResult::MAC_FAILED : result;
+        result = (i == 39U) ? SecOcResult::REPLAYED : result;
+        EXPECT_EQ(results[i], result) << i;
+
+        if (result == SecOcResult::AUTHENTIC)
+        {
+            const std::size_t source = (i < 7U) ? i : (i + 1U);
+            EXPECT_EQ(received[i].data[0], frames[source].data[0]);
+        }
+    }
+
+    frame.can_id = 0x200U;
+    EXPECT_EQ(receiver.verify(frame, authentic), SecOcResult::NOT_SECURED);
+    EXPECT_EQ(authentic.len, frame.len);
+    EXPECT_EQ(receiver.get_count(SecOcResult::NOT_SECURED), 1U);
+    EXPECT_EQ(receiver.get_count(SecOcResult::MAC_FAILED), 3U);
+}
+
+TEST(Sockets, Gorilla)
+{
+    Packet< 16 > bits;
+    PacketBitWriter writer{bits};
+    EXPECT_TRUE(writer.write(0x5U, 3U));
+    EXPECT_TRUE(writer.write(0x0123456789ABCDEFU, 64U));
+    EXPECT_TRUE(writer.write(0x1U, 1U));
+    EXPECT_TRUE(writer.write(0x1ABCU, 13U));
+    writer.flush();
+    EXPECT_EQ(writer.get_bits(), 88U);
+    EXPECT_EQ(bits.get_length(), 11U);
+    EXPECT_EQ(bits.get_data()[0], 0xA0U);
+
+    PacketBitReader reader{bits};
+    EXPECT_EQ(reader.read(3U), 0x5U);
+    EXPECT_EQ(reader.read(64U), 0x0123456789ABCDEFU);
+    EXPECT_TRUE(reader.read_bit());
+    EXPECT_EQ(reader.read(13U), 0x1ABCU);
+    EXPECT_FALSE(reader.has_overflow());
+    reader.read(64U);
+    EXPECT_TRUE(reader.has_overflow());
+
+    // 10 ms with some jitter, a gap, a step back and special values.
+    constexpr std::size_t count{1000U};
+    std::array< std::uint64_t, count > times;
+    std::array< double, count > values;
+
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+        times[i] = 1600000000000000000U + (i * 10000000U) +
+                   (((i % 7U) == 0U) ? 1500U : 0U);
+        values[i] = 20.0 + (0.1 * static_cast< double >(i / 25U));
+    }
+
+    times[500] += 3600000000000U;
+    times[501] = times[500] - 1U;
+    values[100] = std::numeric_limits< double >::quiet_NaN();
+    values[101] = -0.0;
+    values[102] = std::numeric_limits< double >::infinity();
+    values[103] = -1.0e300;
+
+    Packet< 8192 > packet;
+    GorillaEncoder encoder{packet};
+
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+        ASSERT_TRUE(encoder.append(times[i], values[i]));
+    }
+
+    encoder.finish();
+    EXPECT_EQ(encoder.get_count(), count);
+    EXPECT_EQ(packet.get_length(), (encoder.get_bits() + 7U) / 8U);
+    // 16 bytes raw per point.
+    EXPECT_LT(packet.get_length(), (count * 16U) / 4U);
+
+    GorillaDecoder decoder{packet, count};
+    std::uint64_t time{0U};
+    double value{0.0};
+
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+        ASSERT_TRUE(decoder.next(time, value)) << i;
+        EXPECT_EQ(time, times[i]) << i;
+        EXPECT_EQ(std::memcmp(&value, &values[i], sizeof(value)), 0) << i;
+    }
+
+    EXPECT_FALSE(decoder.next(time, value));
+    EXPECT_FALSE(decoder.has_overflow());
+
+    // a full packet takes no partial point.
+    Packet< 48 > small;
+    GorillaEncoder small_encoder{small};
+    std::size_t appended = 0U;
+
+    while (small_encoder.append(times[appended], values[appended + 200U]))
+    {
+        ++appended;
+    }
+
+    small_encoder.finish();
+    EXPECT_EQ(small_encoder.get_count(), appended);
+    EXPECT_GT(appended, 2U);
+
+    GorillaDecoder small_decoder{small, appended};
+
+    for (std::size_t i = 0U; i < appended; ++i)
+    {
+        ASSERT_TRUE(small_decoder.next(time, value));
+        EXPECT_EQ(time, times[i]);
+        EXPECT_EQ(value, values[i + 200U]);
+    }
+
+    EXPECT_FALSE(small_decoder.next(time, value));
+
+    // the padding may look like a point, a cut packet does not.
+    PacketView cut{packet.get_data().data(), packet.get_length() / 2U};
+    GorillaDecoder cut_decoder{cut, count};
+    std::size_t decoded = 0U;
+
+    while (cut_decoder.next(time, value))
+    {
+        ++decoded;
+    }
+
+    EXPECT_LT(decoded, count);
+    EXPECT_TRUE(cut_decoder.has_overflow());
+}
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example measures the time from sending a CAN frame until the receiver
+// has read it, with a blocking, a busy-polling and an adaptive receive. A frame
+// is sent every millisecond with the send time as payload. For each mode the
+// latencies are printed, together with the time the receiver spent spinning
+// against the time it spent between the receive calls.
+// For this example to run you must create a virtual SocketCAN "vcan0"
+// with CAN FD support, see scripts/vcan0_cfg.sh. Pass the number of an
+// isolated core to pin the receiver to it: ./can_busy_poll 3
+////////////////////////////////////////////////////////////////////////////////
+
+#include "CanSocket.h"
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <pthread.h>
+#include <thread>
+
+constexpr std::uint32_t FRAMES = 2000U;
+constexpr CanIDType CAN_ID = 0x123U;
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+void sender() noexcept
+{
+    using namespace std::chrono_literals;
+    CanSocket can{"vcan0"};
+    struct canfd_frame frame
+    {
+    };
+    frame.can_id = CAN_ID;
+    frame.len = 8U;
+
+    for (std::uint32_t i = 0U; i < FRAMES; ++i)
+    {
+        const std::int64_t now = Clock::now().time_since_epoch().count();
+        std::memcpy(frame.data, &now, sizeof(now));
+        can.send(frame, CAN_STD::MTU);
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void measure(const char* name, const CanReceiveMode mode) noexcept
+{
+    CanSocket can{"vcan0"};
+    LatencyHistogram latency;
+    can.set_receive_mode(mode);
+    std::thread send(sender);
+
+    for (std::uint32_t i = 0U; i < FRAMES; ++i)
+    {
+        struct canfd_frame frame;
+
+        if (can.receive(frame) <= 0)
+        {
+            break;
+        }
+
+        const Clock::time_point received = Clock::now();
+        std::int64_t sent = 0;
+        std::memcpy(&sent, frame.data, sizeof(sent));
+        latency.add(received - Clock::time_point{Clock::duration{sent}});
+    }
+
+    send.join();
+    const CanPollStats& stats = can.get_poll_stats();
+    std::cout << name << ":\n";
+    latency.print(std::cout);
+
+    if (mode != CanReceiveMode::BLOCKING)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        std::cout << "  spinning "
+                  << duration_cast< milliseconds >(stats.spin_time).count()
+                  << " ms, working "
+                  << duration_cast< milliseconds >(stats.work_time).count()
+                  << " ms, frames found spinning " << stats.spin_frames
+                  << ", after blocking " << stats.blocked_frames << "\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    if (argc > 1)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(std::atoi(argv[1]), &cpus);
+
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+        {
+            std::cerr << "Pinning to core " << argv[1] << " failed.\n";
+        }
+    }
+
+    measure("blocking", CanReceiveMode::BLOCKING);
+    measure("busy-poll", CanReceiveMode::BUSY_POLL);
+    measure("adaptive", CanReceiveMode::ADAPTIVE);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example compares the bus load of sending every PDU in its own CAN FD
+// frame with packing the PDUs into container frames. A second socket listens
+// on the bus and sums up the estimated time every frame occupies the bus.
+// For this example to run you must create a virtual SocketCAN "vcan0" with
+// CAN FD support, see scripts/vcan0_cfg.sh
+////////////////////////////////////////////////////////////////////////////////
+
+#include "CanContainer.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// arbitration bit rate and data bit rate of the CAN FD bus we estimate.
+constexpr double NOMINAL_BITRATE = 500000.0;
+constexpr double DATA_BITRATE = 2000000.0;
+
+// number of PDUs sent per cycle, each of them with 8 bytes.
+constexpr std::uint8_t PDUS_PER_CYCLE = 6U;
+constexpr std::uint32_t CYCLES = 1000U;
+constexpr CanIDType CONTAINER_ID = 0x100U;
+
+////////////////////////////////////////////////////////////////////////////////
+// Estimated time in seconds a CAN FD frame with bit rate switch occupies the
+// bus. Bit stuffing is ignored.
+double frame_time(const std::size_t len) noexcept
+{
+    // SOF, ID, control bits until BRS and ACK, EOF, IFS at nominal rate.
+    constexpr double arbitration_bits = 29.0;
+    // ESI, DLC, stuff count and CRC delimiter at the data rate.
+    const double crc_bits = (len <= 16U) ? 17.0 : 21.0;
+    const double data_bits = 10.0 + crc_bits + 8.0 * static_cast< double >(len);
+    return arbitration_bits / NOMINAL_BITRATE + data_bits / DATA_BITRATE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads all frames pending on the listener socket and adds their bus time.
+void drain(CanSocket& listener, double& bus_time, std::uint32_t& frames,
+           std::uint32_t& pdus) noexcept
+{
+    using namespace std::chrono_literals;
+    CanIDType id{0U};
+    CanFDData data{};
+
+    while (listener.wait_for(0us))
+    {
+        const auto len = listener.receive(id, data);
+
+        if (len < 0)
+        {
+            break;
+        }
+
+        // the frame is on the bus with its padded length, including the
+        // container headers.
+        bus_time += frame_time(canfd_padded_len(len));
+        ++frames;
+
+        if (id == CONTAINER_ID)
+        {
+            pdus += CanContainerRx::unpack(
+                data.data(), len,
+                [](CanIDType, const std::uint8_t*, std::uint8_t) {});
+        }
+        else
+        {
+            ++pdus;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void report(const char* name, const double bus_time, const double elapsed,
+            const std::uint32_t frames, const std::uint32_t pdus) noexcept
+{
+    std::cout << name << ": " << frames << " frames, " << pdus << " PDUs, "
+              << "bus time " << bus_time * 1000.0 << " ms, bus load "
+              << 100.0 * bus_time / elapsed << " %\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    using namespace std::chrono_literals;
+    CanSocket sender{"vcan0"};
+    CanSocket listener{"vcan0"};
+    const CanFDData payload{1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U};
+
+    // 1. every PDU in its own frame.
+    {
+        double bus_time{0.0};
+        std::uint32_t frames{0U};
+        std::uint32_t pdus{0U};
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t cycle = 0U; cycle < CYCLES; ++cycle)
+        {
+            for (std::uint8_t pdu = 1U; pdu <= PDUS_PER_CYCLE; ++pdu)
+            {
+                sender.send(pdu, payload, 8U);
+            }
+
+            drain(listener, bus_time, frames, pdus);
+            std::this_thread::sleep_for(1ms);
+        }
+
+        const std::chrono::duration< double > elapsed =
+            std::chrono::steady_clock::now() - start;
+        report("single frames", bus_time, elapsed.count(), frames, pdus);
+    }
+
+    // 2. PDUs packed into containers.
+    {
+        double bus_time{0.0};
+        std::uint32_t frames{0U};
+        std::uint32_t pdus{0U};
+        CanContainerTx container{sender, CONTAINER_ID, 500us};
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t cycle = 0U; cycle < CYCLES; ++cycle)
+        {
+            for (std::uint8_t pdu = 1U; pdu <= PDUS_PER_CYCLE; ++pdu)
+            {
+                container.add(pdu, payload, 8U);
+            }
+
+            container.flush();
+            drain(listener, bus_time, frames, pdus);
+            std::this_thread::sleep_for(1ms);
+        }
+
+        const std::chrono::duration< double > elapsed =
+            std::chrono::steady_clock::now() - start;
+        report("containers", bus_time, elapsed.count(), frames, pdus);
+    }
+
+    return 0;
+}
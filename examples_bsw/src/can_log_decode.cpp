@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example decodes CAN logs with one worker and then with one worker per
+// core and compares the time:
+//   ./can_log_decode drive.blf can0.log can1.log
+// merges the frames of all files in timestamp order. Without files it writes
+// a candump log of two million frames to /tmp first. A checksum over the
+// merged frames shows that both runs hand out the same frames in the same
+// order.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "CanLogReader.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+constexpr std::size_t GENERATED_FRAMES = 2000000U;
+constexpr const char* GENERATED_LOG = "/tmp/can_log_decode.log";
+
+////////////////////////////////////////////////////////////////////////////////
+bool generate_log() noexcept
+{
+    std::FILE* log = std::fopen(GENERATED_LOG, "w");
+
+    for (std::size_t i = 0U; (log != nullptr) && (i < GENERATED_FRAMES); ++i)
+    {
+        // a frame every 100 us on two channels.
+        std::fprintf(log, "(%zu.%06zu) can%zu %03zX#%016zX\n",
+                     1600000000U + (i / 10000U), (i % 10000U) * 100U, i % 2U,
+                     i % 0x7FFU, i);
+    }
+
+    return (log != nullptr) && (std::fclose(log) == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void run(int argc, char** argv, const std::size_t workers) noexcept
+{
+    CanLogReader reader;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        reader.open(argv[i]);
+    }
+
+    if (argc <= 1)
+    {
+        reader.open(GENERATED_LOG);
+    }
+
+    std::uint64_t checksum = 0U;
+    const auto started = std::chrono::steady_clock::now();
+    const auto frames = reader.read(
+        [&checksum](const CanLogRecord& record) {
+            checksum = (checksum * 31U) + record.timestamp +
+                       record.frame.can_id + record.frame.data[0];
+        },
+        workers);
+    const std::chrono::duration< double > took =
+        std::chrono::steady_clock::now() - started;
+
+    std::cout << workers << " worker(s): " << frames << " frames in "
+              << took.count() << " s, " << (frames / took.count())
+              << " frames/s, " << reader.get_chunks() << " chunks, "
+              << reader.get_errors() << " errors, checksum " << std::hex
+              << checksum << std::dec << '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    if ((argc <= 1) && (generate_log() == false))
+    {
+        std::cerr << "Could not write " << GENERATED_LOG << ".\n";
+        return 1;
+    }
+
+    const unsigned int cores = std::thread::hardware_concurrency();
+    run(argc, argv, 1U);
+    run(argc, argv, (cores > 0U) ? cores : 1U);
+
+    return 0;
+}
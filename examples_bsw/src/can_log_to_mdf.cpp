@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example converts CAN logs into an MDF4 file that calibration tools
+// open directly:
+//   ./can_log_to_mdf drive.mf4 can0.log can1.blf
+// merges the frames of the logs into a CAN bus logging group of drive.mf4.
+// Without logs it writes one million generated frames at 1 kHz. The data
+// blocks are deflated. Then the file is opened again, and the frames of one
+// second in the middle are read by time without decoding the blocks before.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MdfReader.h"
+#include "MdfWriter.h"
+#include <chrono>
+#include <iostream>
+
+constexpr std::uint64_t GENERATED_FRAMES = 1000000U;
+constexpr std::uint64_t NS_PER_MS = 1000000U;
+
+////////////////////////////////////////////////////////////////////////////////
+bool write_file(int argc, char** argv) noexcept
+{
+    MdfWriter writer{MDF_WRITER::BLOCK_SIZE, true};
+    CanLogReader logs;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        logs.open(argv[i]);
+    }
+
+    if (writer.open(argv[1]) == false)
+    {
+        return false;
+    }
+
+    const std::size_t can = writer.add_can_group(true);
+    const auto started = std::chrono::steady_clock::now();
+
+    if (argc > 2)
+    {
+        logs.read([&writer, can](const CanLogRecord& record) {
+            writer.write_can(can, record);
+        });
+    }
+    else
+    {
+        CanLogRecord record{};
+        record.channel = 1U;
+        record.frame.len = 8U;
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        const auto first = static_cast< std::uint64_t >(
+            std::chrono::duration_cast< std::chrono::nanoseconds >(now)
+                .count());
+
+        for (std::uint64_t i = 0U; i < GENERATED_FRAMES; ++i)
+        {
+            record.timestamp = first + (i * NS_PER_MS);
+            record.frame.can_id = static_cast< canid_t >(0x100U + (i % 16U));
+            record.frame.data[0] = static_cast< std::uint8_t >(i);
+            record.frame.data[1] = static_cast< std::uint8_t >(i >> 8U);
+            writer.write_can(can, record);
+        }
+    }
+
+    const std::uint64_t frames = writer.get_records(can);
+    const bool closed = writer.close();
+    const std::chrono::duration< double > took =
+        std::chrono::steady_clock::now() - started;
+    std::cout << "wrote " << frames << " frames in " << took.count()
+              << " s, waited " << writer.get_stalls()
+              << " times for the disk\n";
+    return closed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <file.mf4> [CAN logs]\n";
+        return 1;
+    }
+
+    if (write_file(argc, argv) == false)
+    {
+        return 1;
+    }
+
+    MdfReader reader;
+    const std::size_t can = reader.open(argv[1])
+                                ? reader.find_group("CAN_DataFrame")
+                                : MDF_READER::NOT_FOUND;
+
+    if (can == MDF_READER::NOT_FOUND)
+    {
+        return 1;
+    }
+
+    // one second in the middle of the measurement.
+    const std::uint64_t count = reader.get_record_count(can);
+    const std::uint8_t* const middle = reader.get_record(can, count / 2U);
+    const std::uint64_t begin = reader.get_time(can, middle);
+    const auto started = std::chrono::steady_clock::now();
+    CanLogRecord frame{};
+    const std::uint64_t read = reader.read(
+        can, begin, begin + (1000U * NS_PER_MS),
+        [&reader, &frame, can](std::uint64_t, const std::uint8_t* record) {
+            reader.get_can_frame(can, record, frame);
+        });
+    const std::chrono::duration< double, std::micro > took =
+        std::chrono::steady_clock::now() - started;
+
+    std::cout << "read " << read << " of " << count << " frames in "
+              << took.count() << " us, inflated " << reader.get_inflated()
+              << " blocks, last ID 0x" << std::hex << frame.frame.can_id
+              << std::dec << '\n';
+    return 0;
+}
@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example sends a TT-CAN like schedule table on "vcan0" with a cycle of
+// 10 ms: frames at fixed offsets in the cycle, two of them sharing a slot.
+// One real-time task runs the table for five seconds, then the timing error
+// of every entry is printed: the time from its planned offset until the
+// socket has taken the frame.
+// For this example to run you must create a virtual SocketCAN "vcan0"
+// with CAN FD support, see scripts/vcan0_cfg.sh. Watch the bus with
+// "candump -td vcan0" to see the fixed phase of every frame.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "CanSchedule.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+constexpr int PRIORITY = 80;
+constexpr long int CYCLE_US = 10000;
+
+////////////////////////////////////////////////////////////////////////////////
+void fill_counter(void* context, struct canfd_frame& frame) noexcept
+{
+    std::uint32_t& counter = *static_cast< std::uint32_t* >(context);
+    ++counter;
+    std::memcpy(frame.data, &counter, sizeof(counter));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    std::uint32_t counter = 0U;
+    // offset, CAN ID, length, payload source.
+    const std::array< CanScheduleEntry, 4U > table{{
+        {0us, 0x100U, 8U, fill_counter, &counter},
+        {2500us, 0x200U, 8U, nullptr, nullptr},
+        {2500us, 0x201U, 8U, nullptr, nullptr},
+        {7000us, 0x300U, 4U, nullptr, nullptr},
+    }};
+    CanSocket can{"vcan0"};
+    CanSchedule schedule{std::chrono::microseconds{CYCLE_US}, table};
+    CanScheduleTask< PRIORITY, CYCLE_US > task{schedule, can};
+
+    std::thread runner([&task]() { task.task_entry(); });
+    std::this_thread::sleep_for(6s);
+    task.stop();
+    runner.join();
+
+    schedule.print(std::cout);
+    return 0;
+}
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example measures the time from sending a CAN frame until the interface
+// confirms its transmission. Two CAN IDs are sent every millisecond, a third
+// socket loads the bus with bursts. The latencies are printed per CAN ID.
+// For this example to run you must create a virtual SocketCAN "vcan0"
+// with CAN FD support, see scripts/vcan0_cfg.sh. Use a real CAN interface to
+// see the actual queue-to-bus latency.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "CanTxConfirmation.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+constexpr std::uint32_t CYCLES = 2000U;
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    using namespace std::chrono_literals;
+    CanSocket can{"vcan0"};
+    CanSocket load{"vcan0"};
+    CanTxConfirmation tx{can};
+
+    if (tx.is_enabled() == false)
+    {
+        std::cerr << "Receiving own messages is not supported.\n";
+        return 1;
+    }
+
+    std::uint32_t confirmed{0U};
+    auto on_confirm = [&](CanIDType, std::chrono::nanoseconds) {
+        ++confirmed;
+    };
+
+    struct canfd_frame frame
+    {
+    };
+    frame.len = 8U;
+
+    for (std::uint32_t cycle = 0U; cycle < CYCLES; ++cycle)
+    {
+        // bus load in bursts of 20 frames every 10th cycle.
+        if ((cycle % 10U) == 0U)
+        {
+            for (std::uint8_t i = 0U; i < 20U; ++i)
+            {
+                load.send(0x700U, CanFDData{i}, 64U);
+            }
+        }
+
+        frame.can_id = 0x100U;
+        tx.send(frame, CAN_STD::MTU);
+        frame.can_id = 0x200U;
+        tx.send(frame, CAN_FD::MTU);
+
+        // take all frames received: confirmations and frames of others.
+        CanFrameInfo info{};
+        struct canfd_frame rx_frame;
+
+        while (can.wait_for(0us) && (can.receive(rx_frame, info) > 0))
+        {
+            tx.confirm(rx_frame, info, on_confirm);
+        }
+
+        std::this_thread::sleep_for(1ms);
+    }
+
+    std::cout << "confirmed: " << confirmed << "\n";
+    tx.print(std::cout);
+    return 0;
+}
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example measures the throughput of bulk data over CAN FD frames
+// compared to CAN XL frames. Both use batched I/O. One thread sends the data,
+// the main thread receives it and measures the time until all data arrived.
+// For this example to run you must create a virtual SocketCAN "vcan0" with
+// CAN XL support (Linux 6.2 or newer):
+// $ sudo modprobe vcan
+// $ sudo ip link add dev vcan0 type vcan
+// $ sudo ip link set vcan0 mtu 2060
+// $ sudo ip link set vcan0 up
+////////////////////////////////////////////////////////////////////////////////
+
+#include "CanSocket.h"
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#ifdef CANXL_MTU
+
+// amount of bulk data to transfer.
+constexpr std::size_t BULK_BYTES = 16U * 1024U * 1024U;
+
+////////////////////////////////////////////////////////////////////////////////
+// Receives frames until all bulk data arrived or nothing arrives for a second.
+template < typename Frame, typename LenFunc >
+std::size_t receive_bulk(CanSocket& rx, LenFunc&& payload_len) noexcept
+{
+    using namespace std::chrono_literals;
+    static std::array< Frame, CAN_BATCH::MAX_FRAMES > frames;
+    std::size_t bytes{0U};
+
+    while ((bytes < BULK_BYTES) && rx.wait_for(1s))
+    {
+        const int received = rx.receive_batch(frames.data(), frames.size());
+
+        for (int i = 0; i < received; ++i)
+        {
+            bytes += payload_len(frames[static_cast< std::size_t >(i)]);
+        }
+    }
+
+    return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Sends all bulk data in frames of the given type.
+template < typename Frame >
+void send_bulk(CanSocket& tx,
+               std::array< Frame, CAN_BATCH::MAX_FRAMES >& frames,
+               const std::size_t payload) noexcept
+{
+    using namespace std::chrono_literals;
+    std::size_t bytes{0U};
+
+    while (bytes < BULK_BYTES)
+    {
+        const int sent = tx.send_batch(frames.data(), frames.size());
+
+        if (sent > 0)
+        {
+            bytes += static_cast< std::size_t >(sent) * payload;
+        }
+        else
+        {
+            // the socket buffer is full, let the receiver catch up.
+            std::this_thread::sleep_for(50us);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void report(const char* name, const std::size_t bytes,
+            const std::chrono::duration< double > elapsed) noexcept
+{
+    std::cout << name << ": " << bytes << " bytes in " << elapsed.count()
+              << " s, " << static_cast< double >(bytes) / elapsed.count() / 1e6
+              << " MB/s\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    CanSocket tx{"vcan0"};
+    CanSocket rx{"vcan0"};
+
+    if (!tx.enable_canxl() || !rx.enable_canxl())
+    {
+        std::cerr << "vcan0 is not CAN XL capable. Set the mtu to 2060.\n";
+        return 1;
+    }
+
+    // bulk data in CAN FD frames of 64 bytes
+    {
+        static std::array< struct canfd_frame, CAN_BATCH::MAX_FRAMES > frames{};
+
+        for (auto& frame : frames)
+        {
+            frame.can_id = 0x10U;
+            frame.len = CANFD_MAX_DLEN;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::thread sender{[&]() { send_bulk(tx, frames, CANFD_MAX_DLEN); }};
+        const auto bytes = receive_bulk< struct canfd_frame >(
+            rx, [](const struct canfd_frame& f) { return f.len; });
+        sender.join();
+        report("CAN FD", bytes, std::chrono::steady_clock::now() - start);
+    }
+
+    // bulk data in CAN XL frames of 2048 bytes
+    {
+        static std::array< CanXLFrame, CAN_BATCH::MAX_FRAMES > frames{};
+
+        for (auto& frame : frames)
+        {
+            frame.prio = 0x10U;
+            frame.flags = CANXL_XLF;
+            frame.sdt = 0x01U;
+            frame.af = 0x12345678U;
+            frame.len = CANXL_MAX_DLEN;
+            canxl_set_vcid(frame, 0x01U);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::thread sender{[&]() { send_bulk(tx, frames, CANXL_MAX_DLEN); }};
+        const auto bytes = receive_bulk< CanXLFrame >(
+            rx, [](const CanXLFrame& f) {
+                return canxl_is_xl(f) ? static_cast< std::size_t >(f.len) : 0U;
+            });
+        sender.join();
+        report("CAN XL", bytes, std::chrono::steady_clock::now() - start);
+    }
+
+    return 0;
+}
+
+#else
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    std::cerr << "CAN XL needs kernel headers of Linux 6.2 or newer.\n";
+    return 1;
+}
+
+#endif
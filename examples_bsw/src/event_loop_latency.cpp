@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example measures the round trip time of a control connection that
+// shares one event loop with three bulk connections on localhost. First all
+// sockets are in the same class, then the control socket gets the class
+// CONTROL and the bulk sockets the class BULK. The round trip times are
+// printed for both runs.
+// A CanSocket of a control loop is added to the loop the same way, the TCP
+// ping-pong stands in for it because it runs without a CAN interface.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "EventLoop.h"
+#include "LatencyHistogram.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+constexpr std::uint16_t CONTROL_PORT = 5560U;
+constexpr std::size_t BULK_CONNECTIONS = 3U;
+constexpr std::uint32_t PINGS = 1000U;
+
+static std::atomic< bool > bulk_running{false};
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+bool echo_control(void* context) noexcept
+{
+    TcpSocket& socket = *static_cast< TcpSocket* >(context);
+    std::array< std::uint8_t, 8U > ping;
+    const std::int16_t received = socket.receive(ping.data(), ping.size());
+
+    if (received > 0)
+    {
+        socket.send(ping.data(), static_cast< std::uint16_t >(received));
+    }
+
+    return received > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool drain_bulk(void* context) noexcept
+{
+    // one receive is one batch, the loop decides who is next.
+    TcpSocket& socket = *static_cast< TcpSocket* >(context);
+    std::array< std::uint8_t, 16384U > data;
+    return socket.receive(data.data(), data.size()) > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void bulk_client(const std::uint16_t port) noexcept
+{
+    TcpClient client;
+
+    if (client.connect("127.0.0.1", port))
+    {
+        std::array< std::uint8_t, 16384U > data{};
+
+        while (bulk_running)
+        {
+            client.send(data.data(), data.size());
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void control_client(LatencyHistogram& rtt) noexcept
+{
+    using namespace std::chrono_literals;
+    TcpClient client;
+
+    if (client.connect("127.0.0.1", CONTROL_PORT))
+    {
+        client.set_nodelay(true);
+        std::array< std::uint8_t, 8U > ping{};
+
+        for (std::uint32_t i = 0U; i < PINGS; ++i)
+        {
+            const Clock::time_point sent = Clock::now();
+            client.send(ping.data(), ping.size());
+
+            if (client.receive(ping.data(), ping.size()) <= 0)
+            {
+                break;
+            }
+
+            rtt.add(Clock::now() - sent);
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void measure(const char* mode, const bool priority_classes) noexcept
+{
+    std::array< TcpServer, BULK_CONNECTIONS + 1U > servers;
+    std::array< std::thread, BULK_CONNECTIONS > bulk;
+    LatencyHistogram rtt;
+    EventLoop loop;
+
+    for (std::size_t i = 0U; i < servers.size(); ++i)
+    {
+        servers[i].reuse_addr();
+        servers[i].listen("255.255.255.0",
+                          static_cast< std::uint16_t >(CONTROL_PORT + i));
+    }
+
+    bulk_running = true;
+
+    for (std::size_t i = 0U; i < bulk.size(); ++i)
+    {
+        bulk[i] = std::thread(
+            bulk_client, static_cast< std::uint16_t >(CONTROL_PORT + i + 1U));
+    }
+
+    std::thread control(control_client, std::ref(rtt));
+
+    // the pending connections are accepted in any order of the clients.
+    for (std::size_t i = 0U; i < servers.size(); ++i)
+    {
+        servers[i].accept();
+        const bool control_socket = (i == 0U);
+        EventPriority priority = EventPriority::NORMAL;
+
+        if (priority_classes)
+        {
+            priority =
+                control_socket ? EventPriority::CONTROL : EventPriority::BULK;
+        }
+
+        servers[i].m_data.set_nodelay(true);
+        loop.add(servers[i].m_data, priority,
+                 control_socket ? echo_control : drain_bulk,
+                 &servers[i].m_data);
+    }
+
+    loop.set_budget(EventPriority::BULK, 4U);
+
+    // the handlers remove the sockets when the clients close them.
+    std::thread runner([&loop]() { loop.run(); });
+    control.join();
+    bulk_running = false;
+
+    for (std::thread& client : bulk)
+    {
+        client.join();
+    }
+
+    loop.stop();
+    runner.join();
+    std::cout << "round trip time, " << mode << " (" << loop.get_preemptions()
+              << " preemptions):\n";
+    rtt.print(std::cout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    measure("one class", false);
+    measure("priority classes", true);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example compresses a series of a slowly changing temperature sampled
+// every 10 ms into uplink packets of 1400 bytes with Gorilla encoding and
+// compares it with deflate (LZ77) of the same points:
+//   ./gorilla_benchmark
+// Each packet starts with the number of points in it. Printed are the bytes
+// per point and the points decoded per second.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Gorilla.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#ifdef BSW_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+constexpr std::size_t POINTS = 2000000U;
+constexpr std::size_t PACKET_SIZE = 1400U;
+constexpr std::size_t RAW_POINT = 16U;
+
+using UplinkPacket = Packet< PACKET_SIZE >;
+
+////////////////////////////////////////////////////////////////////////////////
+template < typename Handler > double measure(Handler&& handler)
+{
+    const auto started = std::chrono::steady_clock::now();
+    handler();
+    const std::chrono::duration< double > took =
+        std::chrono::steady_clock::now() - started;
+    return took.count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void report(const char* name, const std::size_t bytes, const double encode,
+            const double decode, const double checksum) noexcept
+{
+    std::cout << name << ": "
+              << (static_cast< double >(bytes) / POINTS) << " bytes/point, "
+              << "encode " << (POINTS / encode) << " points/s, decode "
+              << (POINTS / decode) << " points/s, checksum " << checksum
+              << '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void run_gorilla(const std::vector< std::uint64_t >& times,
+                 const std::vector< double >& values) noexcept
+{
+    std::vector< UplinkPacket > packets;
+    std::size_t bytes = 0U;
+    double checksum = 0.0;
+
+    const double encode = measure([&]() {
+        for (std::size_t i = 0U; i < POINTS;)
+        {
+            // the count in front is set when the packet is full.
+            UplinkPacket packet;
+            packet << std::uint16_t{0U};
+            GorillaEncoder encoder{packet};
+
+            while ((i < POINTS) && encoder.append(times[i], values[i]))
+            {
+                ++i;
+            }
+
+            encoder.finish();
+            packet.store< std::uint16_t, 0U >(
+                static_cast< std::uint16_t >(encoder.get_count()));
+            bytes += packet.get_length();
+            packets.push_back(packet);
+        }
+    });
+
+    const double decode = measure([&]() {
+        for (auto& packet : packets)
+        {
+            std::uint16_t count = 0U;
+            packet >> count;
+            GorillaDecoder decoder{packet, count};
+            std::uint64_t time = 0U;
+            double value = 0.0;
+
+            while (decoder.next(time, value))
+            {
+                checksum += value;
+            }
+        }
+    });
+
+    std::cout << packets.size() << " packets of up to " << PACKET_SIZE
+              << " bytes\n";
+    report("gorilla", bytes, encode, decode, checksum);
+}
+
+#ifdef BSW_WITH_ZLIB
+////////////////////////////////////////////////////////////////////////////////
+void run_deflate(const std::vector< std::uint64_t >& times,
+                 const std::vector< double >& values, const int level,
+                 const char* name) noexcept
+{
+    // the points as they go into a packet without compression.
+    std::vector< std::uint8_t > raw(POINTS * RAW_POINT);
+    PacketView raw_view{raw.data(), raw.size()};
+
+    for (std::size_t i = 0U; i < POINTS; ++i)
+    {
+        raw_view << times[i] << values[i];
+    }
+
+    // deflated in blocks of 4096 points, so a block fits into a few packets.
+    constexpr std::size_t block = 4096U * RAW_POINT;
+    std::vector< std::vector< std::uint8_t > > blocks;
+    std::vector< std::uint8_t > inflated(block);
+    std::size_t bytes = 0U;
+    double checksum = 0.0;
+
+    const double encode = measure([&]() {
+        for (std::size_t offset = 0U; offset < raw.size(); offset += block)
+        {
+            const std::size_t length =
+                ((raw.size() - offset) < block) ? (raw.size() - offset) : block;
+            uLongf deflated_length = compressBound(length);
+            std::vector< std::uint8_t > deflated(deflated_length);
+            compress2(deflated.data(), &deflated_length, &raw[offset], length,
+                      level);
+            deflated.resize(deflated_length);
+            bytes += deflated_length;
+            blocks.push_back(deflated);
+        }
+    });
+
+    const double decode = measure([&]() {
+        for (const auto& deflated : blocks)
+        {
+            uLongf length = inflated.size();
+            uncompress(inflated.data(), &length, deflated.data(),
+                       deflated.size());
+            PacketView points{inflated.data(), length};
+
+            for (std::size_t i = 0U; i < (length / RAW_POINT); ++i)
+            {
+                std::uint64_t time = 0U;
+                double value = 0.0;
+                points >> time >> value;
+                checksum += value;
+            }
+        }
+    });
+
+    report(name, bytes, encode, decode, checksum);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    std::vector< std::uint64_t > times(POINTS);
+    std::vector< double > values(POINTS);
+
+    for (std::size_t i = 0U; i < POINTS; ++i)
+    {
+        // 10 ms in nanoseconds with a little jitter, a sensor of 0.01 degC.
+        times[i] = 1600000000000000000U + (i * 10000000U) + ((i * 7919U) % 5U);
+        values[i] =
+            std::round(2000.0 + (500.0 * std::sin(i / 100000.0))) / 100.0;
+    }
+
+    std::cout << POINTS << " points, " << RAW_POINT << " bytes/point raw\n";
+    run_gorilla(times, values);
+#ifdef BSW_WITH_ZLIB
+    run_deflate(times, values, Z_BEST_SPEED, "deflate -1");
+    run_deflate(times, values, Z_DEFAULT_COMPRESSION, "deflate -6");
+#else
+    std::cout << "deflate needs zlib, see BSW_WITH_ZLIB.\n";
+#endif
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example puts an impaired link between a client and a server on one
+// machine, without tc netem and root rights. The client connects to the
+// listen port of the proxy instead of the server:
+//   ./impairment_proxy udp 6000 127.0.0.1 5000 40 10 2 1000
+// forwards UDP from port 6000 to 127.0.0.1:5000 with a delay of 40 ms, a
+// heavy-tailed jitter of 10 ms on average, 2 % loss and a rate of 1000 kbit/s
+// in both directions. With "tcp" the proxy waits for one client, connects to
+// the server and forwards the stream; lost chunks are retransmitted 200 ms
+// late instead of dropped. Ctrl+C stops the proxy and prints the statistics.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ImpairmentProxy.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//! the proxy stopped by Ctrl+C.
+static ImpairmentProxy* running_proxy{nullptr};
+
+////////////////////////////////////////////////////////////////////////////////
+void on_signal(int) noexcept
+{
+    if (running_proxy != nullptr)
+    {
+        running_proxy->stop();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    if (argc < 5)
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " udp|tcp <listen port> <server ip> <server port> "
+                     "[delay ms] [jitter ms] [loss %] [rate kbit/s]\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::string mode{argv[1]};
+    const auto listen_port = static_cast< std::uint16_t >(std::atoi(argv[2]));
+    const auto server_port = static_cast< std::uint16_t >(std::atoi(argv[4]));
+
+    LinkImpairment link;
+    link.delay = std::chrono::milliseconds{(argc > 5) ? std::atoi(argv[5]) : 0};
+    link.jitter =
+        std::chrono::milliseconds{(argc > 6) ? std::atoi(argv[6]) : 0};
+    link.distribution = DelayDistribution::PARETO;
+    link.loss = ((argc > 7) ? std::atof(argv[7]) : 0.0) / 100.0;
+
+    if (argc > 8)
+    {
+        link.rate = static_cast< std::uint64_t >(std::atoll(argv[8])) * 125U;
+    }
+
+    // the object is big, it holds the timer wheel.
+    static ImpairmentProxy proxy;
+    proxy.set_impairment(ProxyDirection::UPSTREAM, link);
+    proxy.set_impairment(ProxyDirection::DOWNSTREAM, link);
+
+    // 255.255.255.0 listens on all addresses.
+    const char* any = "255.255.255.0";
+    const bool opened =
+        (mode == "tcp")
+            ? proxy.open_tcp(any, listen_port, argv[3], server_port)
+            : proxy.open_udp(any, listen_port, argv[3], server_port);
+
+    if (opened)
+    {
+        running_proxy = &proxy;
+        std::signal(SIGINT, on_signal);
+        proxy.run();
+        proxy.print(std::cout);
+    }
+
+    return opened ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+// This tool generates a reproducible CAN and TCP load to stress test gateways.
+// The load is read from a schedule file, see docs/loadgenerator.md:
+//
+//     can 0x100 1000 8          # ID 0x100 every 1 ms, 8 bytes
+//     can 0x200 10000 64 500    # CAN FD, every 10 ms, up to 500 us jitter
+//     can 0x300 100000 8 0 20   # a burst of 20 frames every 100 ms
+//     tcp 127.0.0.1 5555 1000 256
+//
+// Usage: load_generator <schedule> [<seconds> [<seed>]]
+// The CAN frames are sent on "vcan0", use a real interface to load a bus. Run
+// it with real-time priority (e.g. as root), else the achieved rates show the
+// scheduling of the generator rather than the load.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "LoadGenerator.h"
+#include <cstdlib>
+#include <fstream>
+#include <sched.h>
+#include <sys/mman.h>
+
+constexpr int GENERATOR_PRIO = 80;
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <schedule> [<seconds> [<seed>]]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file{argv[1]};
+    LoadSchedule schedule;
+
+    if ((file.is_open() == false) || (schedule.load(file) == false))
+    {
+        std::cerr << "Could not read the schedule " << argv[1] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    const long seconds = (argc > 2) ? std::strtol(argv[2], nullptr, 0) : 10;
+    const unsigned long seed =
+        (argc > 3) ? std::strtoul(argv[3], nullptr, 0) : 1U;
+
+    // the same set-up as a RTTask: fixed priority and no page faults.
+    struct sched_param param;
+    param.sched_priority = GENERATOR_PRIO;
+
+    if ((sched_setscheduler(0, SCHED_FIFO, &param) == -1) ||
+        (mlockall(MCL_CURRENT | MCL_FUTURE) == -1))
+    {
+        std::cerr << "Running without real-time priority.\n";
+    }
+
+    CanSocket can{"vcan0"};
+    LoadGenerator generator{can, schedule,
+                            static_cast< std::uint32_t >(seed)};
+    const bool ok = generator.run(std::chrono::seconds{seconds});
+    generator.print(std::cout);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
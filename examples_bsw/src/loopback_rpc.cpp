@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example benchmarks a small request/response protocol over a
+// LoopbackPair instead of TCP. Each message has a length of two bytes in front
+// of its payload. A client sends 64 byte requests, a server thread sends them
+// back. The round trips are measured three times: over plain memory, with
+// reads split randomly into pieces of up to 7 bytes, and with a latency of
+// 50 us in both directions. The framing must handle the short reads, and the
+// latency shows up in the round trip without any noise of the network stack.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "LatencyHistogram.h"
+#include "LoopbackSocket.h"
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+constexpr std::uint16_t PAYLOAD_SIZE = 64U;
+constexpr std::size_t ROUND_TRIPS = 10000U;
+
+using Message = std::array< std::uint8_t, 2U + PAYLOAD_SIZE >;
+
+////////////////////////////////////////////////////////////////////////////////
+bool receive_all(LoopbackSocket& socket, std::uint8_t* data,
+                 const std::uint16_t len) noexcept
+{
+    std::uint16_t received = 0U;
+
+    // a receive may return any part of the data.
+    while (received < len)
+    {
+        const auto now_received = socket.receive(
+            &data[received], static_cast< std::uint16_t >(len - received));
+
+        if (now_received <= 0)
+        {
+            break;
+        }
+
+        received = static_cast< std::uint16_t >(received + now_received);
+    }
+
+    return received == len;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool receive_message(LoopbackSocket& socket, Message& message) noexcept
+{
+    bool received = receive_all(socket, message.data(), 2U);
+    const auto len =
+        static_cast< std::uint16_t >((message[0] << 8U) | message[1]);
+
+    if (received && (len <= PAYLOAD_SIZE))
+    {
+        received = receive_all(socket, &message[2], len);
+    }
+
+    return received;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void server_thread(LoopbackSocket& server,
+                   const LoopbackImpairment impairment) noexcept
+{
+    Message message{};
+    server.set_impairment(impairment);
+
+    // echoes until the client closes.
+    while (receive_message(server, message))
+    {
+        server.send(message.data(),
+                    static_cast< std::uint16_t >(message.size()));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void run(const char* name, const LoopbackImpairment& impairment) noexcept
+{
+    LoopbackPair pair;
+    LoopbackSocket& client = pair.get_client();
+    client.set_impairment(impairment);
+    std::thread server{server_thread, std::ref(pair.get_server()), impairment};
+
+    LatencyHistogram round_trips;
+    Message request{};
+    Message response{};
+    request[1] = static_cast< std::uint8_t >(PAYLOAD_SIZE);
+
+    for (std::size_t i = 0U; i < ROUND_TRIPS; ++i)
+    {
+        request[2] = static_cast< std::uint8_t >(i);
+        const auto sent_at = std::chrono::steady_clock::now();
+        client.send(request.data(),
+                    static_cast< std::uint16_t >(request.size()));
+
+        if ((receive_message(client, response) == false) ||
+            (response[2] != request[2]))
+        {
+            std::cerr << name << ": wrong response\n";
+            break;
+        }
+
+        round_trips.add(std::chrono::steady_clock::now() - sent_at);
+    }
+
+    client.close_socket();
+    server.join();
+
+    std::cout << name << ":\n";
+    round_trips.print(std::cout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    LoopbackImpairment plain;
+    run("plain", plain);
+
+    LoopbackImpairment fragmented;
+    fragmented.max_read = 7U;
+    fragmented.random_reads = true;
+    run("fragmented", fragmented);
+
+    LoopbackImpairment delayed;
+    delayed.latency = 50us;
+    run("latency 50 us", delayed);
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example emulates a field device that sends a custom EtherType frame
+// every millisecond, and a monitor that receives the cycle through the RX
+// ring and prints the latency from send to receive and the lost frames.
+// A veth pair is enough to try it, the device runs in its own namespace:
+//   ip netns add device
+//   ip link add eth0l2 type veth peer name eth1l2
+//   ip link set eth1l2 netns device
+//   ip link set eth0l2 up
+//   ip netns exec device ip link set eth1l2 up
+// Then run the monitor and the device at the same time, optionally on a VLAN:
+//   ./raw_eth_cycle monitor eth0l2 [vlan]
+//   ip netns exec device ./raw_eth_cycle device eth1l2 [vlan]
+// The device sends when its thread wakes up. With "txtime" instead of
+// "device" it queues each frame two cycles ahead with a launch time, and an
+// ETF qdisc sends it; the wake-up jitter of the thread no longer matters.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "LatencyHistogram.h"
+#include "RawEthSocket.h"
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+constexpr std::uint16_t ETHER_TYPE = 0x88B5U;
+constexpr std::uint16_t ETHER_TYPE_VLAN = 0x8100U;
+constexpr std::chrono::milliseconds CYCLE{1};
+constexpr std::chrono::seconds DURATION{5};
+constexpr int LEAD_CYCLES = 2;
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+std::uint64_t get_now() noexcept
+{
+    return static_cast< std::uint64_t >(
+        std::chrono::duration_cast< std::chrono::nanoseconds >(
+            Clock::now().time_since_epoch())
+            .count());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void write_frame(PacketView& frame, const MacAddress& source,
+                 const std::int32_t vlan, const std::uint32_t sequence,
+                 const std::uint64_t sent) noexcept
+{
+    const MacAddress broadcast{{0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU}};
+    frame.append(broadcast);
+    frame.append(source);
+
+    if (vlan != RAW_ETH::NO_VLAN)
+    {
+        frame << ETHER_TYPE_VLAN << static_cast< std::uint16_t >(vlan);
+    }
+
+    frame << ETHER_TYPE << sequence << sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void run_device(const char* interface, const std::int32_t vlan) noexcept
+{
+    RawEthSocket socket;
+
+    if (socket.bind(interface, ETHER_TYPE) && socket.enable_qdisc_bypass())
+    {
+        const MacAddress source = socket.get_mac_address();
+        std::uint32_t sequence = 0U;
+        Clock::time_point next = Clock::now();
+        const Clock::time_point end = next + DURATION;
+
+        while (next < end)
+        {
+            next += CYCLE;
+            std::this_thread::sleep_until(next);
+            // the frame is written straight into the TX ring.
+            socket.send_batch(1U, [&](PacketView& frame) {
+                write_frame(frame, source, vlan, sequence, get_now());
+            });
+            ++sequence;
+        }
+
+        std::cout << "sent " << sequence << " frames\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void run_txtime(const char* interface, const std::int32_t vlan) noexcept
+{
+    RawEthSocket socket;
+    // without ETF the frames leave at once, the example still runs.
+    const bool etf = TxTime::configure_etf(
+        interface, TX_TIME::ROOT, TX_TIME::ETF_DELTA_NS, false, false);
+
+    if (socket.bind(interface, ETHER_TYPE) && socket.enable_txtime())
+    {
+        const MacAddress source = socket.get_mac_address();
+        std::array< std::uint8_t, 64U > buffer{};
+        std::uint32_t sequence = 0U;
+        std::uint32_t missed = 0U;
+        Clock::time_point next = Clock::now();
+        const Clock::time_point end = next + DURATION;
+        // launch times are on CLOCK_TAI, the cycle runs on the steady clock.
+        const std::chrono::nanoseconds tai_offset =
+            TxTime::now(CLOCK_TAI) - Clock::now().time_since_epoch();
+
+        while (next < end)
+        {
+            next += CYCLE;
+            std::this_thread::sleep_until(next);
+            const Clock::time_point launch = next + (LEAD_CYCLES * CYCLE);
+            PacketView frame{buffer.data(), buffer.size()};
+            write_frame(frame, source, vlan, sequence,
+                        static_cast< std::uint64_t >(
+                            launch.time_since_epoch().count()));
+            socket.send_at(buffer.data(),
+                           static_cast< std::uint16_t >(frame.get_length()),
+                           launch.time_since_epoch() + tai_offset);
+            ++sequence;
+            missed += static_cast< std::uint32_t >(
+                socket.drain_txtime_reports([](const TxTimeReport&) {}));
+        }
+
+        std::cout << "queued " << sequence << " frames, " << missed
+                  << " missed their launch time\n";
+    }
+
+    if (etf)
+    {
+        TxTime::remove_qdisc(interface, TX_TIME::ROOT);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void run_monitor(const char* interface, const std::int32_t vlan) noexcept
+{
+    RawEthSocket socket;
+
+    if (socket.bind(interface, ETHER_TYPE, vlan))
+    {
+        LatencyHistogram latency;
+        LatencyHistogram jitter;
+        std::int64_t last_arrival = 0;
+        std::uint32_t expected = 0U;
+        std::uint32_t lost = 0U;
+        const Clock::time_point end = Clock::now() + DURATION + DURATION;
+        socket.set_blocking(false);
+
+        // a block becomes readable when it is full or the retire timeout hits.
+        while (Clock::now() < end)
+        {
+            socket.wait_for(std::chrono::milliseconds{100});
+            socket.receive_batch([&](PacketView& frame,
+                                     const RawEthFrameInfo& info) {
+                const std::uint64_t now = get_now();
+                // the kernel stamps the arrival, the block timeout is not in.
+                const std::int64_t arrival =
+                    (static_cast< std::int64_t >(info.timestamp.tv_sec) *
+                     1000000000) +
+                    info.timestamp.tv_nsec;
+                std::uint32_t sequence{0U};
+                std::uint64_t sent{0U};
+                // the kernel has removed a VLAN tag already.
+                frame.skip(RAW_ETH::HEADER_LEN);
+                frame >> sequence >> sent;
+
+                if ((sequence == expected) && (last_arrival != 0))
+                {
+                    const std::int64_t interval = arrival - last_arrival;
+                    jitter.add(std::chrono::nanoseconds{
+                        std::abs(interval - std::chrono::nanoseconds{CYCLE}
+                                                .count())});
+                }
+
+                lost += sequence - expected;
+                expected = sequence + 1U;
+                last_arrival = arrival;
+                latency.add(std::chrono::nanoseconds{
+                    static_cast< std::int64_t >(now - sent)});
+            });
+        }
+
+        std::cout << "send to receive: ";
+        latency.print(std::cout);
+        std::cout << "cycle jitter: ";
+        jitter.print(std::cout);
+        std::cout << "lost frames: " << lost << "\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    const std::string mode = (argc > 2) ? argv[1] : "";
+    const std::int32_t vlan =
+        (argc > 3) ? std::atoi(argv[3]) : RAW_ETH::NO_VLAN;
+
+    if (mode == "device")
+    {
+        run_device(argv[2], vlan);
+    }
+    else if (mode == "txtime")
+    {
+        run_txtime(argv[2], vlan);
+    }
+    else if (mode == "monitor")
+    {
+        run_monitor(argv[2], vlan);
+    }
+    else
+    {
+        std::cerr << "usage: raw_eth_cycle device <interface> [vlan]\n"
+                     "       raw_eth_cycle txtime <interface> [vlan]\n"
+                     "       raw_eth_cycle monitor <interface> [vlan]\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
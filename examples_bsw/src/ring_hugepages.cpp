@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example measures the throughput of a 256 MiB ring on normal pages and
+// on huge pages. A writer thread fills the ring with blocks of 1500 bytes, the
+// main thread reads them. With huge pages the ring needs fewer TLB entries.
+// To get pages of the huge page pool run as root:
+//     echo 256 > /proc/sys/vm/nr_hugepages
+// Else transparent huge pages are used if enabled in
+// /sys/kernel/mm/transparent_hugepage/enabled.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ByteRing.h"
+#include "HugePageBuffer.h"
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+constexpr std::size_t RING_SIZE = 256U * 1024U * 1024U;
+constexpr std::size_t BLOCK = 1500U;
+constexpr std::size_t TOTAL = std::size_t{4096U} * 1024U * 1024U;
+
+////////////////////////////////////////////////////////////////////////////////
+void measure(const bool huge_pages) noexcept
+{
+    HugePageBuffer buffer{RING_SIZE, huge_pages};
+
+    if (buffer.get_data() == nullptr)
+    {
+        return;
+    }
+
+    buffer.print(std::cout);
+    ByteRingView ring{buffer.get_data(), RING_SIZE};
+
+    std::thread writer([&ring]() {
+        std::array< std::uint8_t, BLOCK > block{};
+        std::size_t written{0U};
+
+        while (written < TOTAL)
+        {
+            written += ring.write(block.data(), block.size());
+        }
+    });
+
+    std::array< std::uint8_t, BLOCK > block;
+    std::size_t read{0U};
+    const auto start = std::chrono::steady_clock::now();
+
+    while (read < TOTAL)
+    {
+        read += ring.read(block.data(), block.size());
+    }
+
+    const std::chrono::duration< double > took =
+        std::chrono::steady_clock::now() - start;
+    writer.join();
+    std::cout << "  " << (static_cast< double >(TOTAL) / took.count() / 1e9)
+              << " GB/s\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    measure(false);
+    measure(true);
+    return EXIT_SUCCESS;
+}
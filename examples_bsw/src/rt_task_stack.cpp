@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example sizes the stack of a real-time task. The task runs in a thread
+// of its own with a stack of 32 KiB, which is painted with a pattern and
+// locked in memory as a whole before the thread starts. Every cycle update()
+// fills a buffer of 8 KiB on the stack. The high-water mark is printed while
+// the task runs and after it ended, together with the locked memory of the
+// process. A stack far above the high-water mark wastes locked memory, a
+// high-water mark close to the size risks an overflow into the guard page.
+// Run it as root (or with CAP_SYS_NICE and CAP_IPC_LOCK).
+////////////////////////////////////////////////////////////////////////////////
+
+#include "RTTask.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+constexpr int TASK_PRIO = 80;
+constexpr long int PERIOD_US = 1000;
+constexpr std::size_t STACK_SIZE = 32U * 1024U;
+constexpr std::size_t BUFFER_SIZE = 8U * 1024U;
+
+/**
+ * @brief A task that uses 8 KiB of its stack every cycle.
+ */
+class BufferTask : public RTTask< BufferTask, TASK_PRIO, PERIOD_US, STACK_SIZE >
+{
+  public:
+    bool start() noexcept { return create_thread(); }
+
+    bool join() noexcept { return close_thread(); }
+
+    bool pre() noexcept { return true; }
+
+    bool update() noexcept
+    {
+        volatile std::uint8_t buffer[BUFFER_SIZE];
+        std::memset(const_cast< std::uint8_t* >(buffer), 0, sizeof(buffer));
+        return m_task_running;
+    }
+
+    void post() noexcept {}
+
+    void stop() noexcept { m_task_running = false; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+void print_locked_memory() noexcept
+{
+    std::ifstream status{"/proc/self/status"};
+    std::string line;
+
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmLck:") == 0)
+        {
+            std::cout << line << '\n';
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    BufferTask task;
+
+    if (task.start())
+    {
+        // the task starts one second after the thread.
+        std::this_thread::sleep_for(2s);
+        std::cout << "stack " << BufferTask::get_stack_size()
+                  << " bytes, high-water mark while running "
+                  << task.get_stack_high_water() << " bytes\n";
+        print_locked_memory();
+
+        task.stop();
+        task.join();
+        std::cout << "high-water mark at the end "
+                  << task.get_stack_high_water() << " bytes\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example shows why a real-time task is late: its own compute or
+// preemption. A task with a period of 1 ms computes for 200 us per cycle.
+// A thread with a higher priority computes for 300 us every 5 ms on the same
+// CPU. After three seconds the statistics of the task are printed: the CPU
+// time stays at 200 us, the execution time grows by the preemption, which
+// shows up as interference and as involuntary context switches.
+// Run it as root (or with CAP_SYS_NICE) for the real-time priorities.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "RTTask.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <pthread.h>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+constexpr int TASK_PRIO = 80;
+constexpr int INTERFERER_PRIO = 90;
+constexpr long int PERIOD_US = 1000;
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+void compute(const std::chrono::microseconds duration) noexcept
+{
+    // spins on the CPU time, so a preemption does not shorten the work.
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    const std::chrono::nanoseconds end = std::chrono::seconds{now.tv_sec} +
+                                         std::chrono::nanoseconds{now.tv_nsec} +
+                                         duration;
+
+    while ((std::chrono::seconds{now.tv_sec} +
+            std::chrono::nanoseconds{now.tv_nsec}) < end)
+    {
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    }
+}
+
+/**
+ * @brief The task under observation.
+ */
+class ComputeTask : public RTTask< ComputeTask, TASK_PRIO, PERIOD_US >
+{
+  public:
+    bool pre() noexcept { return true; }
+
+    bool update() noexcept
+    {
+        compute(200us);
+        return m_task_running;
+    }
+
+    void post() noexcept {}
+
+    void stop() noexcept { m_task_running = false; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+void pin_to_cpu0(std::thread& thread) noexcept
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(0, &cpus);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    ComputeTask task;
+    std::atomic< bool > running{true};
+
+    std::thread interferer([&running]() {
+        struct sched_param param;
+        param.sched_priority = INTERFERER_PRIO;
+        sched_setscheduler(0, SCHED_FIFO, &param);
+
+        while (running)
+        {
+            compute(300us);
+            std::this_thread::sleep_for(5ms);
+        }
+    });
+    std::thread runner([&task]() { task.task_entry(); });
+    pin_to_cpu0(interferer);
+    pin_to_cpu0(runner);
+
+    // the task starts one second after task_entry().
+    std::this_thread::sleep_for(4s);
+    task.stop();
+    runner.join();
+    running = false;
+    interferer.join();
+
+    task.get_stats().print(std::cout);
+    return 0;
+}
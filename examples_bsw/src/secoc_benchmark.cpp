@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example measures how many CAN frames SecOC protects and verifies per
+// second with each AES implementation the CPU supports:
+//   ./secoc_benchmark
+// The frames carry 4 bytes of data, 1 byte of freshness and 3 bytes of MAC,
+// so they fit into a standard CAN frame. No CAN interface is needed, the
+// frames are protected and verified in memory only.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "SecOc.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+constexpr std::size_t FRAMES = 200000U;
+constexpr canid_t CAN_ID = 0x123U;
+
+////////////////////////////////////////////////////////////////////////////////
+template < typename Handler > void measure(const char* name, Handler&& handler)
+{
+    const auto started = std::chrono::steady_clock::now();
+    const std::size_t frames = handler();
+    const std::chrono::duration< double > took =
+        std::chrono::steady_clock::now() - started;
+
+    std::cout << "  " << name << ": " << (FRAMES / took.count())
+              << " frames/s, " << frames << " of " << FRAMES << " frames\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void run(const AesBackend backend, const char* name) noexcept
+{
+    const AesKey key{{0x2BU, 0x7EU, 0x15U, 0x16U, 0x28U, 0xAEU, 0xD2U, 0xA6U,
+                      0xABU, 0xF7U, 0x15U, 0x88U, 0x09U, 0xCFU, 0x4FU,
+                      0x3CU}};
+    SecOc sender{key, backend};
+    SecOc receiver{key, backend};
+    sender.add_pdu({CAN_ID, 0x0042U, 0U, 1U, 3U, 0U});
+    receiver.add_pdu({CAN_ID, 0x0042U, 0U, 1U, 3U, 0U});
+
+    std::vector< struct canfd_frame > authentic(FRAMES);
+    std::vector< struct canfd_frame > secured(FRAMES);
+    std::vector< struct canfd_frame > received(FRAMES);
+    std::vector< SecOcResult > results(FRAMES);
+
+    for (std::size_t i = 0U; i < FRAMES; ++i)
+    {
+        authentic[i].can_id = CAN_ID;
+        authentic[i].len = 4U;
+        authentic[i].data[0] = static_cast< std::uint8_t >(i);
+    }
+
+    std::cout << name << ":\n";
+    measure("protect", [&]() {
+        std::size_t count = 0U;
+
+        for (std::size_t i = 0U; i < FRAMES; ++i)
+        {
+            count += sender.protect(authentic[i], secured[i]) ? 1U : 0U;
+        }
+
+        return count;
+    });
+
+    sender.set_freshness(CAN_ID, 0U, 0U);
+    measure("protect_batch", [&]() {
+        return sender.protect_batch(authentic.data(), FRAMES, secured.data());
+    });
+
+    measure("verify", [&]() {
+        std::size_t count = 0U;
+
+        for (std::size_t i = 0U; i < FRAMES; ++i)
+        {
+            count += (receiver.verify(secured[i], received[i]) ==
+                      SecOcResult::AUTHENTIC)
+                         ? 1U
+                         : 0U;
+        }
+
+        return count;
+    });
+
+    // as the frames of one receive_batch() come in.
+    receiver.set_freshness(CAN_ID, 0U, 0U);
+    measure("verify_batch", [&]() {
+        std::size_t count = 0U;
+
+        for (std::size_t i = 0U; i < FRAMES; i += SECOC::MAX_BATCH)
+        {
+            const std::size_t batch = ((FRAMES - i) < SECOC::MAX_BATCH)
+                                          ? (FRAMES - i)
+                                          : SECOC::MAX_BATCH;
+            count += receiver.verify_batch(&secured[i], batch, &received[i],
+                                           &results[i]);
+        }
+
+        return count;
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    if (AesCmac::is_supported(AesBackend::AES_NI))
+    {
+        run(AesBackend::AES_NI, "AES-NI");
+    }
+
+    if (AesCmac::is_supported(AesBackend::ARMV8))
+    {
+        run(AesBackend::ARMV8, "ARMv8 crypto extensions");
+    }
+
+    run(AesBackend::PORTABLE, "portable");
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example runs two streams over one TCP connection on localhost. The
+// client sends bulk data on a low priority stream as fast as it can and a
+// small control message every millisecond on a high priority stream. The
+// server prints how long the control messages took and how much bulk data
+// got through. Set CONTROL_PRIORITY to 1U to see the control messages wait
+// behind the bulk data. Run it on a machine with at least two cores, else
+// the latency shows the scheduling of the two threads only.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "LatencyHistogram.h"
+#include "TcpClient.h"
+#include "TcpMux.h"
+#include "TcpServer.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+constexpr std::uint8_t CONTROL_STREAM = 0U;
+constexpr std::uint8_t BULK_STREAM = 1U;
+constexpr std::uint8_t CONTROL_PRIORITY = 0U;
+constexpr std::uint8_t BULK_PRIORITY = 1U;
+constexpr std::uint32_t MESSAGES = 2000U;
+
+static std::atomic< bool > server_running{false};
+static std::atomic< bool > client_done{false};
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+void server_thread() noexcept
+{
+    TcpServer server;
+    server.reuse_addr();
+    const bool listening = server.listen("127.0.0.1", 5556U);
+    server_running = true;
+
+    if (listening && server.accept())
+    {
+        TcpMux mux{server.m_data};
+        TcpMuxStream& control = mux.get_stream(CONTROL_STREAM);
+        TcpMuxStream& bulk = mux.get_stream(BULK_STREAM);
+        LatencyHistogram latency;
+        std::uint64_t bulk_bytes{0U};
+        std::array< std::uint8_t, 1024U > data;
+        Clock::rep sent_at{0};
+
+        while ((client_done == false) && mux.is_ok())
+        {
+            if (server.m_data.wait_for(std::chrono::milliseconds{10}) ==
+                false)
+            {
+                continue;
+            }
+
+            mux.poll();
+
+            // the control message carries the time it was sent.
+            while (control.receive(&sent_at, sizeof(sent_at)) ==
+                   static_cast< std::int16_t >(sizeof(sent_at)))
+            {
+                latency.add(Clock::now() -
+                            Clock::time_point{Clock::duration{sent_at}});
+            }
+
+            std::int16_t received = 0;
+
+            while ((received = bulk.receive(data.data(), data.size())) > 0)
+            {
+                bulk_bytes += static_cast< std::uint64_t >(received);
+            }
+        }
+
+        std::cout << "bulk bytes: " << bulk_bytes << "\n";
+        std::cout << "control latency:\n";
+        latency.print(std::cout);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    using namespace std::chrono_literals;
+    TcpClient client;
+    std::thread st(server_thread);
+
+    while (server_running == false)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    if (client.connect("127.0.0.1", 5556U))
+    {
+        TcpMux mux{client};
+        TcpMuxStream& control = mux.get_stream(CONTROL_STREAM);
+        TcpMuxStream& bulk = mux.get_stream(BULK_STREAM);
+        control.set_priority(CONTROL_PRIORITY);
+        bulk.set_priority(BULK_PRIORITY);
+        std::array< std::uint8_t, 1024U > data{};
+        Clock::time_point next = Clock::now();
+        std::uint32_t messages{0U};
+
+        while ((messages < MESSAGES) && mux.is_ok())
+        {
+            // keep the bulk stream busy.
+            bulk.send(data.data(), data.size());
+
+            if (Clock::now() >= next)
+            {
+                const Clock::rep now = Clock::now().time_since_epoch().count();
+                control.send(&now, sizeof(now));
+                next += 1ms;
+                ++messages;
+            }
+
+            // take the window updates of the server.
+            mux.poll();
+        }
+    }
+    else
+    {
+        std::cerr << "Connection has not been established!\n";
+    }
+
+    client_done = true;
+    st.join();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example measures how a bulk transfer delays a ping-pong on a second
+// TCP connection, without a limit, with kernel pacing (SO_MAX_PACING_RATE) and
+// with a token bucket in user space. The round trip times of the ping-pong are
+// printed for each mode.
+// Both connections run over localhost by default, where the bulk transfer
+// mostly competes for the CPU. To see the queueing on a real link, run
+// "tc qdisc replace dev eth0 root fq" and pass the address of a host that runs
+// this example as well: ./tcp_pacing 192.168.0.2
+////////////////////////////////////////////////////////////////////////////////
+
+#include "LatencyHistogram.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+constexpr std::uint16_t BULK_PORT = 5557U;
+constexpr std::uint16_t PING_PORT = 5558U;
+// 80 Mbit/s leave some room on a 100 Mbit link.
+constexpr std::uint64_t RATE = 10000000U;
+constexpr std::uint32_t PINGS = 1000U;
+
+static std::atomic< bool > servers_running{false};
+static std::atomic< bool > bulk_running{false};
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+void bulk_server() noexcept
+{
+    TcpServer server;
+    server.reuse_addr();
+    server.listen("255.255.255.0", BULK_PORT);
+    servers_running = true;
+
+    // one connection per mode.
+    while (server.accept())
+    {
+        std::array< std::uint8_t, 4096U > data;
+
+        while (server.m_data.receive(data.data(), data.size()) > 0)
+        {
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ping_server() noexcept
+{
+    TcpServer server;
+    server.reuse_addr();
+    server.listen("255.255.255.0", PING_PORT);
+
+    while (server.accept())
+    {
+        server.m_data.set_nodelay(true);
+        std::array< std::uint8_t, 8U > ping;
+
+        while (server.m_data.receive(ping.data(), ping.size()) > 0)
+        {
+            server.m_data.send(ping.data(), ping.size());
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void bulk_client(const char* address, const char* mode) noexcept
+{
+    TcpClient client;
+    TokenBucket bucket{RATE};
+
+    if (client.connect(address, BULK_PORT))
+    {
+        if (std::string{mode} == "pacing")
+        {
+            client.set_max_pacing_rate(RATE);
+        }
+        else if (std::string{mode} == "bucket")
+        {
+            client.enable_rate_limit(bucket);
+        }
+
+        std::array< std::uint8_t, 4096U > data{};
+
+        while (bulk_running)
+        {
+            client.send(data.data(), data.size());
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void measure(const char* address, const char* mode) noexcept
+{
+    using namespace std::chrono_literals;
+    bulk_running = true;
+    std::thread bulk(bulk_client, address, mode);
+    TcpClient client;
+    LatencyHistogram rtt;
+
+    if (client.connect(address, PING_PORT))
+    {
+        client.set_nodelay(true);
+        std::array< std::uint8_t, 8U > ping{};
+
+        for (std::uint32_t i = 0U; i < PINGS; ++i)
+        {
+            const Clock::time_point sent = Clock::now();
+            client.send(ping.data(), ping.size());
+            std::int16_t received = 0;
+
+            while (received < static_cast< std::int16_t >(ping.size()))
+            {
+                const std::int16_t res = client.receive(
+                    &ping[received],
+                    static_cast< std::uint16_t >(ping.size() - received));
+
+                if (res <= 0)
+                {
+                    break;
+                }
+
+                received += res;
+            }
+
+            rtt.add(Clock::now() - sent);
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    bulk_running = false;
+    bulk.join();
+    std::cout << "round trip time, " << mode << ":\n";
+    rtt.print(std::cout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    using namespace std::chrono_literals;
+    const char* address = "127.0.0.1";
+
+    if (argc > 1)
+    {
+        address = argv[1];
+    }
+
+    std::thread bulk(bulk_server);
+    std::thread ping(ping_server);
+    bulk.detach();
+    ping.detach();
+
+    while (servers_running == false)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    measure(address, "unlimited");
+    measure(address, "pacing");
+    measure(address, "bucket");
+    return EXIT_SUCCESS;
+}
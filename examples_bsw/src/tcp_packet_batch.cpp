@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example sends 100 small messages per cycle over localhost, once with
+// one send() per message and once batched into one PacketBatch per cycle.
+// The server decodes the received stream with a PacketBatchReader and answers
+// after the last message, so the printed time covers both sides.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "PacketBatch.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+constexpr std::uint16_t PORT = 5559U;
+constexpr std::uint32_t MESSAGES_PER_CYCLE = 100U;
+constexpr std::uint32_t CYCLES = 2000U;
+
+static std::atomic< bool > server_running{false};
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+void server() noexcept
+{
+    TcpServer server;
+    server.reuse_addr();
+    server.listen("255.255.255.0", PORT);
+    server_running = true;
+
+    // one connection per mode.
+    while (server.accept())
+    {
+        std::array< std::uint8_t, 8192U > data;
+        std::size_t length = 0U;
+        std::uint32_t messages = 0U;
+        std::uint64_t checksum = 0U;
+
+        while (messages < (MESSAGES_PER_CYCLE * CYCLES))
+        {
+            const std::int16_t received = server.m_data.receive(
+                &data[length],
+                static_cast< std::uint16_t >(data.size() - length));
+
+            if (received <= 0)
+            {
+                break;
+            }
+
+            length += static_cast< std::size_t >(received);
+            PacketBatchReader reader{data.data(), length};
+
+            for (PacketView message : reader)
+            {
+                std::uint32_t cycle{0U};
+                std::uint16_t index{0U};
+                float value{0.0F};
+                message >> cycle >> index >> value;
+                checksum += cycle + index;
+                ++messages;
+            }
+
+            // keep a message that is not complete yet.
+            length -= reader.get_consumed();
+            std::memmove(data.data(), &data[reader.get_consumed()], length);
+        }
+
+        const std::uint8_t ack = 1U;
+        server.m_data.send(&ack, 1U);
+        std::cout << "server decoded " << messages << " messages, checksum "
+                  << checksum << "\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void measure(const char* mode, const std::uint32_t messages_per_flush) noexcept
+{
+    TcpClient client;
+
+    if (client.connect("127.0.0.1", PORT))
+    {
+        PacketBatch< 2048U > batch;
+        const Clock::time_point start = Clock::now();
+
+        for (std::uint32_t cycle = 0U; cycle < CYCLES; ++cycle)
+        {
+            for (std::uint16_t i = 0U; i < MESSAGES_PER_CYCLE; ++i)
+            {
+                Packet< 32U > packet;
+                packet << cycle << i << 0.5F;
+                batch.add(packet);
+
+                if (batch.get_count() == messages_per_flush)
+                {
+                    batch.flush(client);
+                }
+            }
+
+            batch.flush(client);
+        }
+
+        std::uint8_t ack = 0U;
+        client.receive(&ack, 1U);
+        const auto duration = std::chrono::duration_cast<
+            std::chrono::microseconds >(Clock::now() - start);
+        std::cout << mode << ": " << duration.count() / CYCLES
+                  << " us per cycle of " << MESSAGES_PER_CYCLE
+                  << " messages\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main() noexcept
+{
+    using namespace std::chrono_literals;
+    std::thread receiver(server);
+    receiver.detach();
+
+    while (server_running == false)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    measure("one send per message", 1U);
+    measure("one send per cycle", MESSAGES_PER_CYCLE);
+    return EXIT_SUCCESS;
+}
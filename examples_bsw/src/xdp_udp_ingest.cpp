@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+// This example receives a UDP stream once through the kernel UDP stack and
+// once through an XdpSocket, and prints the packet rate and the CPU time per
+// packet of the receiver. The same binary sends the stream.
+// A veth pair is enough to try it, the sender runs in its own namespace:
+//   ip netns add sensor
+//   ip link add xdp0 type veth peer name xdp1
+//   ip link set xdp1 netns sensor
+//   ip addr add 10.77.0.1/24 dev xdp0 && ip link set xdp0 up
+//   ip netns exec sensor ip addr add 10.77.0.2/24 dev xdp1
+//   ip netns exec sensor ip link set xdp1 up
+// Then run the receiver and the sender at the same time:
+//   ./xdp_udp_ingest xdp xdp0 5600     (or: ./xdp_udp_ingest udp 5600)
+//   ip netns exec sensor ./xdp_udp_ingest send 10.77.0.1 5600
+////////////////////////////////////////////////////////////////////////////////
+
+#include "XdpSocket.h"
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+
+constexpr std::uint32_t PAYLOAD = 64U;
+constexpr unsigned int BATCH = 64U;
+constexpr std::chrono::seconds DURATION{5};
+
+using Clock = std::chrono::steady_clock;
+
+////////////////////////////////////////////////////////////////////////////////
+std::chrono::microseconds get_cpu_time() noexcept
+{
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return std::chrono::seconds{usage.ru_utime.tv_sec + usage.ru_stime.tv_sec} +
+           std::chrono::microseconds{usage.ru_utime.tv_usec +
+                                     usage.ru_stime.tv_usec};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void print(const char* mode, const std::uint64_t packets,
+           const std::chrono::microseconds cpu, const std::uint64_t sum)
+{
+    const std::uint64_t cpu_ns = static_cast< std::uint64_t >(cpu.count()) *
+                                 1000U;
+    std::cout << mode << ": " << packets / DURATION.count() << " packets/s, "
+              << ((packets > 0U) ? (cpu_ns / packets) : 0U)
+              << " ns CPU per packet (sequence sum " << sum << ")\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void receive_xdp(const char* interface, const std::uint16_t port) noexcept
+{
+    XdpSocket socket;
+
+    if (socket.bind(interface, port))
+    {
+        std::cout << (socket.is_zero_copy() ? "zero-copy\n" : "copy mode\n");
+        std::uint64_t packets = 0U;
+        std::uint64_t sum = 0U;
+        const std::chrono::microseconds cpu = get_cpu_time();
+        const Clock::time_point end = Clock::now() + DURATION;
+        socket.set_blocking(false);
+
+        // the payload is decoded in place, nothing is copied.
+        while (Clock::now() < end)
+        {
+            packets += static_cast< std::uint64_t >(socket.receive_batch(
+                [&sum](PacketView& payload, const XdpFrameInfo&) {
+                    std::uint32_t sequence{0U};
+                    payload >> sequence;
+                    sum += sequence;
+                }));
+        }
+
+        print("AF_XDP", packets, get_cpu_time() - cpu, sum);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void receive_udp(const std::uint16_t port) noexcept
+{
+    const int handle = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    IpAddress any{"255.255.255.0"};
+    sockaddr_in address;
+    any.create_address_struct(any.get_ip_address(), port, address);
+
+    if (::bind(handle, reinterpret_cast< sockaddr* >(&address),
+               sizeof(address)) == 0)
+    {
+        std::array< std::array< std::uint8_t, PAYLOAD >, BATCH > buffers;
+        std::array< iovec, BATCH > iov;
+        std::array< mmsghdr, BATCH > messages{};
+
+        for (std::size_t i = 0U; i < BATCH; ++i)
+        {
+            iov[i] = iovec{buffers[i].data(), PAYLOAD};
+            messages[i].msg_hdr.msg_iov = &iov[i];
+            messages[i].msg_hdr.msg_iovlen = 1U;
+        }
+
+        std::uint64_t packets = 0U;
+        std::uint64_t sum = 0U;
+        const std::chrono::microseconds cpu = get_cpu_time();
+        const Clock::time_point end = Clock::now() + DURATION;
+
+        // the fair comparison: batched receive with recvmmsg.
+        while (Clock::now() < end)
+        {
+            const int received =
+                recvmmsg(handle, messages.data(), BATCH, 0, nullptr);
+
+            for (int i = 0; i < received; ++i)
+            {
+                const std::size_t index = static_cast< std::size_t >(i);
+                PacketView payload{buffers[index].data(),
+                                   messages[index].msg_len};
+                std::uint32_t sequence{0U};
+                payload >> sequence;
+                sum += sequence;
+                ++packets;
+            }
+        }
+
+        print("UDP socket", packets, get_cpu_time() - cpu, sum);
+    }
+
+    ::close(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void send(const char* receiver, const std::uint16_t port) noexcept
+{
+    const int handle = ::socket(AF_INET, SOCK_DGRAM, 0);
+    IpAddress ip{receiver};
+    sockaddr_in address;
+    ip.create_address_struct(ip.get_ip_address(), port, address);
+    std::array< std::array< std::uint8_t, PAYLOAD >, BATCH > buffers{};
+    std::array< iovec, BATCH > iov;
+    std::array< mmsghdr, BATCH > messages{};
+
+    for (std::size_t i = 0U; i < BATCH; ++i)
+    {
+        iov[i] = iovec{buffers[i].data(), PAYLOAD};
+        messages[i].msg_hdr.msg_name = &address;
+        messages[i].msg_hdr.msg_namelen = sizeof(address);
+        messages[i].msg_hdr.msg_iov = &iov[i];
+        messages[i].msg_hdr.msg_iovlen = 1U;
+    }
+
+    std::uint32_t sequence = 0U;
+    const Clock::time_point end = Clock::now() + DURATION + DURATION;
+
+    while (Clock::now() < end)
+    {
+        for (std::size_t i = 0U; i < BATCH; ++i)
+        {
+            PacketView payload{buffers[i].data(), PAYLOAD};
+            payload << sequence++;
+        }
+
+        sendmmsg(handle, messages.data(), BATCH, 0);
+    }
+
+    ::close(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) noexcept
+{
+    const std::string mode = (argc > 1) ? argv[1] : "";
+
+    if ((mode == "xdp") && (argc > 3))
+    {
+        receive_xdp(argv[2], static_cast< std::uint16_t >(std::atoi(argv[3])));
+    }
+    else if ((mode == "udp") && (argc > 2))
+    {
+        receive_udp(static_cast< std::uint16_t >(std::atoi(argv[2])));
+    }
+    else if ((mode == "send") && (argc > 3))
+    {
+        send(argv[2], static_cast< std::uint16_t >(std::atoi(argv[3])));
+    }
+    else
+    {
+        std::cerr << "usage: xdp_udp_ingest xdp <interface> <port>\n"
+                     "       xdp_udp_ingest udp <port>\n"
+                     "       xdp_udp_ingest send <receiver> <port>\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}